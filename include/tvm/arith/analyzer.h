@@ -28,6 +28,7 @@
 #include <tvm/ir/expr.h>
 #include <tvm/support/with.h>
 
+#include <functional>
 #include <limits>
 #include <memory>
 #include <unordered_map>
@@ -161,6 +162,8 @@ class ConstIntBoundAnalyzer {
   std::function<void()> EnterConstraint(const PrimExpr& constraint);
   struct Entry;
   class Impl;
+  /*! \brief The parent analyzer */
+  Analyzer* parent_;
   /*! \brief Internal impl */
   Impl* impl_;
 };
@@ -242,6 +245,8 @@ class ModularSetAnalyzer {
   std::function<void()> EnterConstraint(const PrimExpr& constraint);
   struct Entry;
   class Impl;
+  /*! \brief The parent analyzer */
+  Analyzer* parent_;
   /*! \brief Internal impl */
   Impl* impl_;
 };
@@ -276,6 +281,8 @@ class RewriteSimplifier {
   explicit RewriteSimplifier(Analyzer* parent);
   TVM_DLL ~RewriteSimplifier();
   class Impl;
+  /*! \brief The parent analyzer */
+  Analyzer* parent_;
   /*! \brief Internal impl */
   Impl* impl_;
 };
@@ -307,6 +314,8 @@ class CanonicalSimplifier {
   explicit CanonicalSimplifier(Analyzer* parent);
   TVM_DLL ~CanonicalSimplifier();
   class Impl;
+  /*! \brief The parent analyzer */
+  Analyzer* parent_;
   /*! \brief Internal impl */
   Impl* impl_;
 };
@@ -374,6 +383,64 @@ class IntSetAnalyzer {
   Impl* impl_;
 };
 
+/*! \brief The facts known by an analyzer, see AnalyzerCache. */
+class AnalyzerFacts;
+
+/*!
+ * \brief Bounded memo table of the results of the rewrite and canonical
+ *  simplifiers and of the constant integer bound analysis.
+ *
+ *  The analyzers created while a cache is in scope share it. Results are keyed
+ *  by the structure of the expression and by the facts known to the analyzer
+ *  when computing them, i.e. its bindings and active constraints, so that the
+ *  passes of one lowering pipeline reuse the results computed in the same
+ *  context. The least recently used results are dropped beyond the capacity.
+ *  Lowering only puts a cache in scope when the "tir.analyzer_cache_size" pass
+ *  config is positive.
+ *
+ * \code
+ *
+ *  With<arith::AnalyzerCache> cache(1 << 16);
+ *  arith::Analyzer analyzer;  // looks up its results in cache
+ *
+ * \endcode
+ */
+class AnalyzerCache {
+ public:
+  /*! \brief The kinds of results held by the cache. */
+  enum Kind : int {
+    kRewriteSimplify = 0,
+    kCanonicalSimplify = 1,
+    kConstIntBound = 2,
+  };
+  /*! \brief The default number of results held by a cache constructed without a capacity. */
+  static constexpr size_t kDefaultCapacity = 1 << 16;
+  /*!
+   * \brief Construct a cache.
+   * \param capacity The maximum number of results held, 0 disables the cache.
+   */
+  TVM_DLL explicit AnalyzerCache(size_t capacity = kDefaultCapacity);
+  /*! \return The innermost cache in scope on this thread, nullptr if there is none. */
+  TVM_DLL static AnalyzerCache* Current();
+  /*! \return The number of results held. */
+  TVM_DLL size_t size() const;
+  /*! \return The number of lookups which found a result. */
+  TVM_DLL size_t hits() const;
+  /*! \return The number of lookups which did not find a result. */
+  TVM_DLL size_t misses() const;
+
+ private:
+  friend class Analyzer;
+  friend class With<AnalyzerCache>;
+  // enter the scope.
+  TVM_DLL void EnterWithScope();
+  // exit the scope.
+  TVM_DLL void ExitWithScope();
+  class Impl;
+  /*! \brief Internal impl, shared with the analyzers which may outlive the scope */
+  std::shared_ptr<Impl> impl_;
+};
+
 /*!
  * \brief Analyzer that contains bunch of sub-analyzers.
  *
@@ -491,6 +558,39 @@ class TVM_DLL Analyzer {
    * \note Analyzer will call into sub-analyzers to get the result.
    */
   PrimExpr Simplify(const PrimExpr& expr, int steps = 2);
+
+ private:
+  friend class ConstIntBoundAnalyzer;
+  friend class ModularSetAnalyzer;
+  friend class RewriteSimplifier;
+  friend class CanonicalSimplifier;
+  friend class ConstraintContext;
+  /*!
+   * \brief Record a fact changing the results of the sub-analyzers.
+   * \param fact The fact, with structural hash and equality.
+   */
+  void AddFact(const ObjectRef& fact);
+  /*!
+   * \brief Record that a constraint is entered.
+   * \param constraint The constraint.
+   * \return The function recording that the constraint is exited, can be nullptr.
+   */
+  std::function<void()> EnterConstraintFact(const PrimExpr& constraint);
+  /*!
+   * \brief Look up a result in the cache, or compute and cache it.
+   * \param kind The kind of the result.
+   * \param expr The expression of interest.
+   * \param compute The function computing the result.
+   * \return The result.
+   */
+  ObjectRef Memoize(AnalyzerCache::Kind kind, const PrimExpr& expr,
+                    const std::function<ObjectRef()>& compute);
+  /*! \brief The cache in scope at construction, nullptr if there is none */
+  std::shared_ptr<AnalyzerCache::Impl> cache_;
+  /*! \brief The facts known to the sub-analyzers, the newest first */
+  std::shared_ptr<const AnalyzerFacts> facts_;
+  /*! \brief The number of results being computed by Memoize */
+  int memo_depth_{0};
 };
 
 }  // namespace arith
@@ -30,6 +30,7 @@
 #include <tvm/node/node.h>
 #include <tvm/runtime/packed_func.h>
 
+#include <random>
 #include <vector>
 
 namespace tvm {
@@ -118,6 +119,94 @@ class RandomModel : public CostModel {
   using ContainerType = RandomModelNode;
 };
 
+/*!
+ * \brief A gradient boosted decision tree model trained and evaluated natively.
+ *
+ *  Like the python XGBModel, it predicts a score for every buffer store statement from the
+ *  per-store features of `feature.h` and sums them up as the score of the program. The trees fit
+ *  the throughput normalized by the best one of the task, with the squared error on these sums.
+ *  Feature extraction, training and prediction run on parallel_for threads and never enter
+ *  python, so the search does not wait for the GIL.
+ *
+ *  An update extracts the features of the new measurements only. It adds a few trees fitted on
+ *  all measurements to the ensemble, and retrains it from scratch once the number of
+ *  measurements has grown enough since the last full training.
+ */
+class GBDTModelNode : public CostModelNode {
+ public:
+  /*! \brief The number of measurements to start to use the model, it predicts random scores
+   *  before. */
+  int num_warmup_sample;
+  /*! \brief The maximum depth of the trees. */
+  int max_depth;
+  /*! \brief The number of trees of a full training. */
+  int num_rounds;
+  /*! \brief The number of trees added by an update between full trainings. */
+  int num_incremental_rounds;
+  /*! \brief The shrinkage applied to the leaf values. */
+  double learning_rate;
+  /*! \brief Retrain from scratch once the number of measurements is this many times the one of
+   *  the last full training. */
+  double retrain_growth;
+
+  void Update(const Array<MeasureInput>& inputs, const Array<MeasureResult>& results) final;
+
+  void Predict(const SearchTask& task, const Array<State>& states,
+               std::vector<float>* scores) final;
+
+  /*! \brief A node of a tree, a leaf when feature is negative. Rows with the feature below the
+   *  threshold go left. */
+  struct TreeNode {
+    int feature;
+    float threshold;
+    int left;
+    int right;
+    float value;
+  };
+
+  static constexpr const char* _type_key = "auto_scheduler.GBDTModel";
+  TVM_DECLARE_FINAL_OBJECT_INFO(GBDTModelNode, CostModelNode);
+
+ private:
+  friend class GBDTModel;
+
+  /*! \brief Add trees fitted on all measurements. */
+  void Train(bool from_scratch);
+  /*! \brief The sum of the predictions of all trees for the features of a buffer store. */
+  float PredictStore(const float* feature) const;
+
+  /*! \brief All measurements so far. */
+  Array<MeasureInput> inputs_;
+  Array<MeasureResult> results_;
+  /*! \brief The per-store features and normalized throughputs of the measurements. */
+  std::vector<std::vector<float>> features_;
+  std::vector<float> throughputs_;
+  /*! \brief The bin boundaries of every feature, fixed between full trainings. */
+  std::vector<std::vector<float>> cuts_;
+  /*! \brief The trees of the ensemble. */
+  std::vector<std::vector<TreeNode>> trees_;
+  /*! \brief The number of measurements of the last full training. */
+  size_t last_train_size_ = 0;
+  /*! \brief The random number generator of the predictions of an untrained model. */
+  std::mt19937 rand_gen_;
+};
+
+/*!
+ * \brief Managed reference to GBDTModelNode.
+ * \sa GBDTModelNode
+ */
+class GBDTModel : public CostModel {
+ public:
+  /*!
+   * \brief The constructor.
+   * \param num_warmup_sample The number of measurements to start to use the model.
+   * \param seed The random seed.
+   */
+  GBDTModel(int num_warmup_sample, int seed);
+
+  TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(GBDTModel, CostModel, GBDTModelNode);
+};
+
 /*! \brief A wrapper for cost model defined by python code
  *  This class will call functions defined in the python */
 class PythonBasedModelNode : public CostModelNode {
@@ -41,6 +41,7 @@
 #include <tvm/auto_scheduler/loop_state.h>
 #include <tvm/auto_scheduler/search_task.h>
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -126,6 +127,8 @@ class BuildResultNode : public Object {
   String error_msg;
   /*! \brief The time cost of build. */
   double time_cost;
+  /*! \brief The time cost of each stage of the build, only reported by native builds. */
+  Map<String, FloatImm> stage_costs;
 
   void VisitAttrs(tvm::AttrVisitor* v) {
     v->Visit("filename", &filename);
@@ -133,6 +136,7 @@ class BuildResultNode : public Object {
     v->Visit("error_no", &error_no);
     v->Visit("error_msg", &error_msg);
     v->Visit("time_cost", &time_cost);
+    v->Visit("stage_costs", &stage_costs);
   }
 
   static constexpr const char* _type_key = "auto_scheduler.BuildResult";
@@ -335,7 +339,15 @@ class ProgramRunner : public ObjectRef {
 
 // Implementation of various builders and runners
 
-/*! \brief LocalBuilder use local CPU cores to build programs in parallel */
+class NativeBuildCache;
+
+/*!
+ * \brief LocalBuilder use local CPU cores to build programs in parallel
+ *
+ *  With the build function "native", programs are lowered and compiled by
+ *  threads of this process instead of the Python builder, and programs that
+ *  lower to the same module reuse the artifact built for the first one.
+ */
 class LocalBuilderNode : public ProgramBuilderNode {
  public:
   /*! \brief Build function. */
@@ -343,8 +355,17 @@ class LocalBuilderNode : public ProgramBuilderNode {
 
   Array<BuildResult> Build(const Array<MeasureInput>& inputs, int verbose) final;
 
+  /*! \brief The build function selecting the native build. */
+  static constexpr const char* kNativeBuildFunc = "native";
+
   static constexpr const char* _type_key = "auto_scheduler.LocalBuilder";
   TVM_DECLARE_FINAL_OBJECT_INFO(LocalBuilderNode, ProgramBuilderNode);
+
+ private:
+  Array<BuildResult> BuildNative(const Array<MeasureInput>& inputs, int verbose);
+
+  /*! \brief The artifacts of native builds, kept across calls to Build. */
+  std::shared_ptr<NativeBuildCache> native_cache_;
 };
 
 /*!
@@ -358,7 +379,7 @@ class LocalBuilder : public ProgramBuilder {
    * \param timeout The timeout limit (in second) for each build thread.
    * This will be used in a wrapper of the multiprocessing.Process.join().
    * \param n_parallel The number of threads used to build in parallel.
-   * \param build_func The name of the registered build function.
+   * \param build_func The name of the registered build function, or "native".
    */
   LocalBuilder(int timeout, int n_parallel, const String& build_func);
 
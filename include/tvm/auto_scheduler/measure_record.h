@@ -28,8 +28,10 @@
 #include <tvm/auto_scheduler/measure.h>
 
 #include <fstream>
+#include <mutex>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace tvm {
 namespace auto_scheduler {
@@ -113,6 +115,144 @@ class RecordReader : public ObjectRef {
   TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(RecordReader, ObjectRef, RecordReaderNode);
 };
 
+/*!
+ * \brief An append-only binary database of measure records.
+ *
+ *  The data file holds the records one after another. Each record starts with a small binary
+ *  header carrying the hash of its workload key and target, its mean cost and its error number,
+ *  followed by the workload key, the target and the record in the json log format. A sidecar
+ *  index file `<filename>.idx` stores one fixed size entry per record, so that queries only
+ *  read the index and parse the few records they return.
+ *
+ *  Several processes can append to the same database. Writers serialize on a file lock and
+ *  append the records before their index entries, so readers never see an index entry of a
+ *  partial record. A missing or stale index is rebuilt from the data file, and a partial record
+ *  left by a crashed writer is dropped.
+ */
+class RecordDatabaseNode : public Object {
+ public:
+  /*! \brief The name of the data file. */
+  String filename;
+
+  void VisitAttrs(tvm::AttrVisitor* v) { v->Visit("filename", &filename); }
+
+  /*!
+   * \brief Append measure records to the database.
+   * \param inputs The MeasureInputs to be written.
+   * \param results The MeasureResults to be written.
+   */
+  void Append(const Array<MeasureInput>& inputs, const Array<MeasureResult>& results);
+
+  /*!
+   * \brief Get the k valid records of a task with the lowest mean cost.
+   * \param workload_key The workload key of the task.
+   * \param target The target of the task, as its string in the json log.
+   * \param k The maximum number of records to return.
+   * \return The MeasureInputs and MeasureResults, sorted by increasing mean cost.
+   */
+  std::pair<Array<MeasureInput>, Array<MeasureResult>> QueryTopK(const String& workload_key,
+                                                                 const String& target, int k);
+
+  /*!
+   * \brief Get the valid record with the lowest mean cost of every workload key and target.
+   * \return The MeasureInputs and MeasureResults in the order they were appended.
+   */
+  std::pair<Array<MeasureInput>, Array<MeasureResult>> BestRecords();
+
+  /*!
+   * \brief Write all records to an output stream in the json log format.
+   * \param os A pointer to a output stream.
+   */
+  void ExportJSON(std::ostream* os);
+
+  /*! \brief The number of records in the database. */
+  int64_t Size();
+
+  static constexpr const char* _type_key = "auto_scheduler.RecordDatabase";
+  TVM_DECLARE_FINAL_OBJECT_INFO(RecordDatabaseNode, Object);
+
+ private:
+  friend class RecordDatabase;
+  /*! \brief An entry of the index file. */
+  struct IndexEntry {
+    uint64_t key_hash;
+    double cost;
+    uint64_t offset;
+    int32_t error_no;
+    uint32_t size;
+  };
+
+  /*! \brief Bring the index up to date with the data file, under the file lock. */
+  void SyncIndex();
+  /*! \brief Load the index entries appended by other writers since the last read. */
+  void RefreshIndex();
+  /*! \brief Read the record of an index entry, return its workload key and target. */
+  std::pair<std::string, std::string> ReadKey(const IndexEntry& entry);
+  /*! \brief Read the json payload of the record of an index entry. */
+  std::string ReadPayload(const IndexEntry& entry);
+  /*! \brief Parse the records of index entries. */
+  std::pair<Array<MeasureInput>, Array<MeasureResult>> ParseRecords(
+      const std::vector<IndexEntry>& entries);
+
+  /*! \brief The index entries loaded so far. */
+  std::vector<IndexEntry> index_;
+  /*! \brief The size of the index file loaded so far. */
+  uint64_t index_size_ = 0;
+  /*! \brief The reading stream of the data file. */
+  std::ifstream data_in_;
+  /*! \brief Serializes the users of one database object. */
+  std::mutex mutex_;
+};
+
+/*!
+ * \brief Managed reference to RecordDatabaseNode.
+ * \sa RecordDatabaseNode
+ */
+class RecordDatabase : public ObjectRef {
+ public:
+  /*!
+   * \brief The constructor. Create the database if it does not exist.
+   * \param filename The name of the data file.
+   */
+  explicit RecordDatabase(String filename);
+
+  TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(RecordDatabase, ObjectRef, RecordDatabaseNode);
+};
+
+/*! \brief Callback for appending the input and results of measurements to a record database */
+class RecordToDatabaseNode : public MeasureCallbackNode {
+ public:
+  /*! \brief The database to append to. */
+  RecordDatabase database;
+
+  void Callback(const SearchPolicy& policy, const Array<MeasureInput>& inputs,
+                const Array<MeasureResult>& results) final;
+
+  static constexpr const char* _type_key = "auto_scheduler.RecordToDatabase";
+  TVM_DECLARE_FINAL_OBJECT_INFO(RecordToDatabaseNode, MeasureCallbackNode);
+};
+
+/*!
+ * \brief Managed reference to RecordToDatabaseNode.
+ * \sa RecordToDatabaseNode
+ */
+class RecordToDatabase : public MeasureCallback {
+ public:
+  /*!
+   * \brief The constructor.
+   * \param filename The name of the database file
+   */
+  explicit RecordToDatabase(String filename);
+
+  TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(RecordToDatabase, MeasureCallback, RecordToDatabaseNode);
+};
+
+/*!
+ * \brief Check whether a file is a record database rather than a json log.
+ * \param filename The name of the file.
+ */
+bool IsRecordDatabase(const std::string& filename);
+
 /*!
  * \brief Append measure records to an output stream.
  * \param os A pointer to a output stream.
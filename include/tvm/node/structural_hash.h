@@ -27,6 +27,7 @@
 #include <tvm/runtime/data_type.h>
 
 #include <functional>
+#include <memory>
 #include <string>
 
 namespace tvm {
@@ -83,6 +84,44 @@ class StructuralHash : public BaseValueHash {
   TVM_DLL size_t operator()(const ObjectRef& key) const;
 };
 
+/*!
+ * \brief Structural hashing which caches the hash of every node it visits, so
+ *  that hashing an IR again after a few rewrites only visits the new nodes.
+ *
+ *  The cache holds a reference to the visited nodes, so that copy on write
+ *  copies them instead of modifying them in place. IRModules are modified in
+ *  place by Add, Update and Remove and are never cached: the hash of a module
+ *  is combined again from the cached hashes of its functions on every call.
+ *  Variables are hashed by their positions in each subtree, as if map_free_vars
+ *  is set, so that the hash of a subtree does not depend on the rest of the IR,
+ *  and graph nodes are hashed as trees.
+ *  The values thus differ from StructuralHash, but still agree with
+ *  StructuralEqual: structurally equal objects have equal hashes.
+ *
+ * \note The cache is not thread safe.
+ */
+class StructuralHashCache {
+ public:
+  TVM_DLL StructuralHashCache();
+  TVM_DLL ~StructuralHashCache();
+  /*!
+   * \brief Compute the structural hash value of an object.
+   * \param key The object to hash.
+   * \param map_free_vars Whether the object is compared with map_free_vars set.
+   * \return The hash value.
+   */
+  TVM_DLL size_t operator()(const ObjectRef& key, bool map_free_vars = false);
+  /*! \return The number of cached nodes. */
+  TVM_DLL size_t size() const;
+  /*! \brief Drop the cached hashes and the references to the nodes. */
+  TVM_DLL void Clear();
+
+ private:
+  class Impl;
+  /*! \brief Internal impl */
+  std::unique_ptr<Impl> impl_;
+};
+
 /*!
  * \brief A Reducer class to reduce the structural hash value.
  *
@@ -30,6 +30,10 @@
 #include <tvm/runtime/packed_func.h>
 #include <tvm/runtime/registry.h>
 
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <stack>
 #include <string>
 #include <unordered_map>
@@ -151,6 +155,105 @@ Timer DefaultTimer(Device dev);
 
 namespace profiling {
 
+/*! \brief A span on the timeline of one thread. */
+struct TraceEvent {
+  /*! \brief The name of the span, e.g. the operator. */
+  std::string name;
+  /*! \brief The kind of span: "op", "parallel", "copy", ... */
+  std::string category;
+  /*! \brief Start and end in nanoseconds of the steady clock, see `TraceRecorder::Now`. */
+  int64_t begin_ns;
+  int64_t end_ns;
+  /*! \brief The id of the thread, the kernel thread id on Linux. */
+  uint64_t tid;
+  /*! \brief Additional information shown with the span. */
+  std::vector<std::pair<std::string, std::string>> args;
+};
+
+/*!
+ * \brief Process wide recorder of per-thread timeline events.
+ *
+ *  Recording is enabled while at least one `Start` has not been matched by a
+ *  `Stop`; until then `Enabled` is a single relaxed atomic load, which keeps
+ *  the instrumentation of hot paths such as the thread pool cheap. Every
+ *  thread appends to its own buffer so threads do not contend with each
+ *  other. The buffers are cleared once the last recording stops.
+ */
+class TVM_DLL TraceRecorder {
+ public:
+  /*! \return The global recorder. */
+  static TraceRecorder* Global();
+  /*! \return Whether events are being recorded. */
+  static bool Enabled() { return active_.load(std::memory_order_relaxed) != 0; }
+  /*! \return The current time in nanoseconds of the steady clock, CLOCK_MONOTONIC on Linux. */
+  static int64_t Now();
+  /*! \brief Start recording. */
+  void Start();
+  /*! \brief Stop recording, dropping all events when no other recording remains. */
+  void Stop();
+  /*! \brief Record a span of the calling thread, its `tid` is filled in. */
+  void Record(TraceEvent event);
+  /*! \brief Name the calling thread in the exported traces. */
+  void SetThreadName(const std::string& name);
+  /*!
+   * \brief Get the events of all threads overlapping a time range.
+   * \param begin_ns The start of the range.
+   * \param end_ns The end of the range.
+   * \return The events ordered by thread and start time.
+   */
+  std::vector<TraceEvent> Collect(int64_t begin_ns, int64_t end_ns);
+  /*!
+   * \brief Serialize events in the Chrome Trace Event format, which can be
+   *  loaded into chrome://tracing or Perfetto.
+   * \param events The events.
+   * \return The JSON trace, including the names of the threads.
+   */
+  std::string AsChromeTrace(const std::vector<TraceEvent>& events);
+
+ private:
+  struct ThreadBuffer;
+  /*! \return The buffer of the calling thread, created on first use. */
+  ThreadBuffer* LocalBuffer();
+
+  static std::atomic<int> active_;
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+};
+
+/*!
+ * \brief Record the lifetime of the scope as a span when tracing is enabled.
+ *
+ * \code{.cpp}
+ *  {
+ *    TraceScope scope("my_kernel", "op");
+ *    my_kernel();
+ *  }
+ * \endcode
+ */
+class TraceScope {
+ public:
+  TraceScope(const char* name, const char* category) {
+    if (TraceRecorder::Enabled()) {
+      event_.reset(new TraceEvent{name, category, TraceRecorder::Now(), 0, 0, {}});
+    }
+  }
+  ~TraceScope() {
+    if (event_) {
+      event_->end_ns = TraceRecorder::Now();
+      TraceRecorder::Global()->Record(std::move(*event_));
+    }
+  }
+  /*! \return Whether the scope is being recorded, only then `AddArg` has an effect. */
+  bool active() const { return event_ != nullptr; }
+  /*! \brief Attach information to the span. */
+  void AddArg(const std::string& key, const std::string& value) {
+    if (event_) event_->args.emplace_back(key, value);
+  }
+
+ private:
+  std::unique_ptr<TraceEvent> event_;
+};
+
 /*! \brief Data collected from a profiling run. Includes per-call metrics and per-device metrics.
  */
 class ReportNode : public Object {
@@ -160,7 +263,8 @@ class ReportNode : public Object {
    * Each element is a mapping from metric name to value. Some metrics that
    * appear in every call are "Name" (the function name), "Argument Shapes",
    * and "Duration (us)". Values are one of `String`, `PercentNode`,
-   * `DurationNode`, or `CountNode`.
+   * `DurationNode`, `CountNode`, or `BytesNode`. When calls are aggregated,
+   * `BytesNode` metrics keep their maximum rather than their sum.
    */
   Array<Map<String, ObjectRef>> calls;
   /*! \brief Metrics collected for the entire run of the model on a per-device basis.
@@ -184,6 +288,12 @@ class ReportNode : public Object {
    *  `aggregate` is true.
    */
   String AsTable(bool sort = true, bool aggregate = true) const;
+  /*! \brief The timeline of the run, every call and the thread pool and copy
+   *  activity of all threads, in the Chrome Trace Event format.
+   */
+  String AsChromeTrace() const;
+  /*! \brief The spans recorded on all threads during the run. */
+  std::vector<TraceEvent> trace_events;
 
   static constexpr const char* _type_key = "runtime.profiling.Report";
   TVM_DECLARE_FINAL_OBJECT_INFO(ReportNode, Object);
@@ -196,10 +306,53 @@ class Report : public ObjectRef {
    * \param device_metrics Per-device metrics for overall execution.
    */
   explicit Report(Array<Map<String, ObjectRef>> calls,
-                  Map<String, Map<String, ObjectRef>> device_metrics);
+                  Map<String, Map<String, ObjectRef>> device_metrics,
+                  std::vector<TraceEvent> trace_events = {});
   TVM_DEFINE_NOTNULLABLE_OBJECT_REF_METHODS(Report, ObjectRef, ReportNode);
 };
 
+/*! \brief Interface for user defined profiling metric collection.
+ *
+ * Users can register their own collector by subclassing this interface and
+ * passing it to the `Profiler`. Collectors are started around every call and
+ * around the whole run on each device, the metrics they return become columns
+ * of the `Report`.
+ *
+ * As with `TimerNode`, `Start` and `Stop` should be as lightweight as
+ * possible because they surround every call.
+ */
+class MetricCollectorNode : public Object {
+ public:
+  /*! \brief Initialization call, made once before any `Start`.
+   * \param devs The devices the profiler will be running on.
+   */
+  virtual void Init(const std::vector<Device>& devs) = 0;
+  /*! \brief Start collecting metrics for a function call.
+   * \param dev The device the call will run on.
+   * \returns An object holding the state of the collection, passed back to
+   * `Stop`. An undefined object means the device is not supported and no
+   * metrics are recorded.
+   */
+  virtual ObjectRef Start(Device dev) = 0;
+  /*! \brief Stop collecting metrics.
+   * \param obj The object returned by the matching `Start`.
+   * \returns A mapping from metric name to value, `CountNode` values are
+   * summed when calls are aggregated.
+   */
+  virtual Map<String, ObjectRef> Stop(ObjectRef obj) = 0;
+
+  virtual ~MetricCollectorNode() {}
+
+  static constexpr const char* _type_key = "runtime.profiling.MetricCollector";
+  TVM_DECLARE_BASE_OBJECT_INFO(MetricCollectorNode, Object);
+};
+
+/*! \brief Wrapper for `MetricCollectorNode`. */
+class MetricCollector : public ObjectRef {
+ public:
+  TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(MetricCollector, ObjectRef, MetricCollectorNode);
+};
+
 /*! Information about a single function or operator call. */
 struct CallFrame {
   /*! Device on which the call was made */
@@ -210,6 +363,12 @@ struct CallFrame {
   Timer timer;
   /*! Extra performance metrics */
   std::unordered_map<std::string, ObjectRef> extra_metrics;
+  /*! Metric collectors running for this call and their state */
+  std::vector<std::pair<MetricCollector, ObjectRef>> extra_collectors;
+  /*! Start of the call on the host, see `TraceRecorder::Now` */
+  int64_t begin_ns{0};
+  /*! Workspace bytes of the device at the start of the call */
+  int64_t begin_workspace_bytes{0};
 };
 
 /*! Runtime profiler for function and/or operator calls. Used in the graph
@@ -229,9 +388,21 @@ struct CallFrame {
  * prof.Stop();
  * std::cout << prof.Report << std::endl; // print profiling report
  * \endcode
+ *
+ * Between `Start` and `Stop` the `TraceRecorder` is enabled, so the report
+ * also holds the timeline of all threads of the process, and the
+ * `MemoryTracker` maintains peaks. Every call reports the workspace it used,
+ * the live tensor bytes after it and the peak memory during it on its
+ * device, the devices report their peak and live bytes over the run.
  */
 class Profiler {
  public:
+  Profiler() = default;
+  /*! \brief Create a profiler recording additional metrics.
+   * \param collectors Metric collectors started around every call and around
+   * the whole run on every device.
+   */
+  explicit Profiler(std::vector<MetricCollector> collectors) : collectors_(collectors) {}
   /*! \brief Start the profiler.
    * \param devs The list of devices the profiler will be running on. Should
    *             include all devices used by profiled operators.
@@ -242,6 +413,8 @@ class Profiler {
   /*! \brief Stop the profiler.
    *
    * This function should only be called once per object after start has been called.
+   * It must be called even when a profiled call throws, `Start` turns on global
+   * trace recording and memory tracking which only `Stop` turns off.
    */
   void Stop();
   /*! \brief Start a function call.
@@ -270,12 +443,23 @@ class Profiler {
   /*! \brief Check if the profiler is currently running.
    * \returns Whether or not the profiler is running.
    */
-  bool IsRunning() const { return !global_timers_.empty(); }
+  bool IsRunning() const { return running_; }
 
  private:
   std::vector<std::pair<Device, Timer>> global_timers_;
   std::vector<CallFrame> calls_;
   std::stack<CallFrame> in_flight_;
+  std::vector<MetricCollector> collectors_;
+  /*! \brief Collectors running for the whole run and the device they run on. */
+  std::vector<std::pair<Device, std::pair<MetricCollector, ObjectRef>>> global_collectors_;
+  /*! \brief Metrics of the whole run, by device. */
+  std::unordered_map<std::string, Map<String, ObjectRef>> global_metrics_;
+  /*! \brief Start of the run, see `TraceRecorder::Now`. */
+  int64_t begin_ns_{0};
+  /*! \brief The spans of all threads during the run. */
+  std::vector<TraceEvent> trace_events_;
+  /*! \brief Whether the profiler has been started and not stopped yet. */
+  bool running_{false};
 };
 
 /* \brief A duration in time. */
@@ -323,6 +507,161 @@ class CountNode : public Object {
   TVM_DECLARE_FINAL_OBJECT_INFO(CountNode, Object);
 };
 
+/*!
+ * \brief Per-operator timing of every Nth run, cheap enough to stay enabled in
+ *  production executors.
+ *
+ *  Executors call `SampleRun` when a run starts and only time their operators
+ *  when it returns true. With sampling disabled this costs a single relaxed
+ *  atomic load per run. Timings are pushed into a fixed size lock-free ring
+ *  buffer, so `Record` never blocks, and are folded into per-operator
+ *  histograms when the statistics are read or when the ring fills up, so the
+ *  statistics need not be polled. Samples are only dropped, and counted, when
+ *  the ring is full while another thread holds the histograms.
+ *
+ *  Histogram buckets are log-linear: 8 buckets per power of two of
+ *  nanoseconds, so percentiles are accurate to about 6%.
+ */
+class SamplingProfiler {
+ public:
+  /*! \param capacity The number of samples the ring buffer holds, rounded up to a power of two. */
+  explicit SamplingProfiler(size_t capacity = 1 << 14);
+  /*!
+   * \brief Set the sampling interval.
+   * \param interval Time every interval-th run, 0 disables sampling.
+   */
+  void SetInterval(int64_t interval);
+  /*! \return The sampling interval, 0 when disabled. */
+  int64_t interval() const { return interval_.load(std::memory_order_relaxed); }
+  /*! \return Whether the run starting now should be timed. */
+  bool SampleRun() {
+    int64_t interval = interval_.load(std::memory_order_relaxed);
+    if (interval <= 0) return false;
+    if (runs_.fetch_add(1, std::memory_order_relaxed) % interval != 0) return false;
+    sampled_runs_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  /*!
+   * \brief Record the duration of an operator, safe to call from any thread.
+   * \param op The index of the operator.
+   * \param nanos The duration in nanoseconds.
+   */
+  void Record(uint32_t op, int64_t nanos);
+  /*!
+   * \brief Aggregate the samples recorded so far.
+   * \param op_names The name of every operator index.
+   * \return For every sampled operator the sample count, the mean, minimum,
+   *  maximum and p50/p90/p99 durations in microseconds and the non-empty
+   *  histogram buckets, as JSON.
+   */
+  std::string GetStats(const std::vector<std::string>& op_names);
+  /*! \brief Discard all samples, the interval is kept. */
+  void Reset();
+
+ private:
+  struct Slot {
+    std::atomic<uint64_t> seq;
+    uint32_t op;
+    int64_t nanos;
+  };
+  struct Histogram {
+    uint64_t count{0};
+    int64_t total{0};
+    int64_t min{0};
+    int64_t max{0};
+    std::map<int, uint64_t> buckets;
+  };
+  /*! \brief Move the samples from the ring into the histograms, mutex_ held. */
+  void Drain();
+
+  std::atomic<int64_t> interval_{0};
+  std::atomic<uint64_t> runs_{0};
+  std::atomic<uint64_t> sampled_runs_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::unique_ptr<Slot[]> ring_;
+  uint64_t mask_;
+  std::atomic<uint64_t> write_pos_{0};
+  /*! \brief Consumer side, guarded by mutex_. */
+  std::mutex mutex_;
+  uint64_t read_pos_{0};
+  std::map<uint32_t, Histogram> histograms_;
+};
+
+/* A number of bytes of memory */
+class BytesNode : public Object {
+ public:
+  /* The number of bytes */
+  int64_t bytes;
+
+  /* \brief Construct a new memory size.
+   * \param a The number of bytes.
+   */
+  explicit BytesNode(int64_t a) : bytes(a) {}
+
+  static constexpr const char* _type_key = "runtime.profiling.Bytes";
+  TVM_DECLARE_FINAL_OBJECT_INFO(BytesNode, Object);
+};
+
+/*!
+ * \brief Accounting of the memory allocated by the runtime, per device.
+ *
+ *  Tensors, created by `NDArray::Empty` or held by the storage of the VM
+ *  allocators, and workspaces of the `WorkspacePool` are counted at all
+ *  times with relaxed atomic additions, so the live bytes include memory
+ *  allocated before profiling started such as the storage pool of a graph
+ *  executor. Peaks are only maintained while tracking is on, which the
+ *  `Profiler` turns on between `Start` and `Stop`. Devices of a type or id
+ *  beyond the fixed table, e.g. remote devices, are not counted.
+ */
+class TVM_DLL MemoryTracker {
+ public:
+  /*! \brief The kind of memory. */
+  enum Kind : int { kTensor = 0, kWorkspace = 1 };
+
+  /*! \brief The memory of one device. */
+  struct Usage {
+    /*! \brief The bytes of live tensors. */
+    int64_t tensor_bytes{0};
+    /*! \brief The bytes of workspaces in use. */
+    int64_t workspace_bytes{0};
+    /*! \brief The highest total since `ResetPeak`. */
+    int64_t peak_bytes{0};
+    /*! \brief The highest total since `ResetWindow`. */
+    int64_t window_peak_bytes{0};
+    /*! \brief The highest workspace bytes since `ResetWindow`. */
+    int64_t window_peak_workspace_bytes{0};
+  };
+
+  /*! \brief Count an allocation. */
+  static void Alloc(Kind kind, Device dev, size_t bytes);
+  /*! \brief Count the release of an allocation. */
+  static void Free(Kind kind, Device dev, size_t bytes);
+  /*! \return The memory usage of a device. */
+  static Usage Get(Device dev);
+  /*! \brief Start maintaining peaks, calls nest. */
+  static void StartTracking();
+  /*! \brief Stop maintaining peaks once every `StartTracking` has been matched. */
+  static void StopTracking();
+  /*! \brief Set all peaks of a device to its current usage. */
+  static void ResetPeak(Device dev);
+  /*! \brief Set the window peaks of a device to its current usage. */
+  static void ResetWindow(Device dev);
+};
+
+/*! \brief Create a metric collector reading the CPU performance counters
+ *  of the process through the Linux `perf_event_open` interface.
+ *  \param events The names of the events to count. Supported are the generic
+ *  hardware events of `perf` ("cycles", "instructions", "cache-references",
+ *  "cache-misses", "branch-instructions", "branch-misses", "LLC-load-misses",
+ *  "L1-dcache-load-misses", ...), the software events ("task-clock",
+ *  "page-faults", "context-switches", ...) and raw events of the form "rNNNN"
+ *  with NNNN the hexadecimal event code, for example the floating point
+ *  operation counters of the CPU. An empty list counts cycles, instructions,
+ *  cache misses and branch misses.
+ *  \return The collector, counting on CPU devices only.
+ */
+MetricCollector PerfEventMetricCollector(Array<String> events);
+
 /*! \brief String representation of an array or NDArray shapes
  *  \param shapes Array of NDArrays to get the shapes of.
  *  \return A textual representation of the shapes. For example: `float32[2], int64[1, 2]`.
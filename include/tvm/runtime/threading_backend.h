@@ -64,21 +64,28 @@ class ThreadGroup {
   enum AffinityMode : int {
     kBig = 1,
     kLittle = -1,
+    /*! \brief Bind each worker thread to its own core out of the given CPU list. */
+    kSpecifyOneCorePerThread = -2,
+    /*! \brief Let all worker threads float over the cores of the given CPU list. */
+    kSpecifyThreadShareAllCore = -3,
   };
 
   /*!
    * \brief configure the CPU id affinity
    *
-   * \param mode The preferred CPU type (1 = big, -1 = little).
+   * \param mode The preferred CPU type (1 = big, -1 = little, -2 = one core per thread
+   *        from `cpus`, -3 = all threads share the cores in `cpus`).
    * \param nthreads The number of threads to use (0 = use all).
    * \param exclude_worker0 Whether to use the main thread as a worker.
    *        If  `true`, worker0 will not be launched in a new thread and
    *        `worker_callback` will only be called for values >= 1. This
    *        allows use of the main thread as a worker.
+   * \param cpus The CPU ids to run on, only used by the kSpecify* modes.
    *
    * \return The number of workers to use.
    */
-  int Configure(AffinityMode mode, int nthreads, bool exclude_worker0);
+  int Configure(AffinityMode mode, int nthreads, bool exclude_worker0,
+                std::vector<unsigned int> cpus = {});
 
  private:
   Impl* impl_;
@@ -94,6 +101,38 @@ void Yield();
  */
 int MaxConcurrency();
 
+/*!
+ * \brief Configure the thread pool of the calling thread.
+ *
+ *  Every thread calling into the runtime owns its own thread pool, so giving each
+ *  serving thread a disjoint CPU list (see PartitionCpus) keeps concurrently running
+ *  executors from competing for the same cores. The process-wide work-stealing pool
+ *  (TVM_THREAD_POOL_KIND=work_stealing) is not affected by this configuration.
+ *
+ * \param mode The affinity mode, see ThreadGroup::AffinityMode.
+ * \param nthreads The number of threads to use (0 = use all).
+ * \param cpus The CPU ids to run on, only used by the kSpecify* modes.
+ */
+void Configure(ThreadGroup::AffinityMode mode, int nthreads, std::vector<unsigned int> cpus = {});
+
+/*!
+ * \return The CPU ids this process may run on, grouped by NUMA node. When the
+ *         topology is unknown all CPUs are reported as a single node.
+ */
+std::vector<std::vector<unsigned int>> NumaNodeCpus();
+
+/*!
+ * \brief Split the available CPUs into disjoint sets, one per executor session.
+ *
+ *  A set is taken from a single NUMA node whenever one still has enough free cores,
+ *  otherwise it spills over the remaining cores of the following nodes.
+ *
+ * \param num_sessions The number of sessions.
+ * \param cores_per_session The number of cores given to every session.
+ * \return The CPU ids of each session.
+ */
+std::vector<std::vector<unsigned int>> PartitionCpus(int num_sessions, int cores_per_session);
+
 }  // namespace threading
 }  // namespace runtime
 }  // namespace tvm
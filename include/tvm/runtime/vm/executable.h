@@ -32,12 +32,16 @@
 #include <tvm/runtime/vm/bytecode.h>
 
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 namespace tvm {
 namespace runtime {
+
+class MappedFile;
+
 namespace vm {
 
 struct VMFunction;
@@ -97,6 +101,20 @@ class Executable : public ModuleNode {
    */
   static runtime::Module Load(const std::string& code, const runtime::Module lib);
 
+  /*!
+   * \brief Load a VM executable saved to a file without copying its constants.
+   *
+   * The file holds the bytes returned by Save. It is mapped into memory and
+   * the constants point into the mapping, so processes loading the same file
+   * share the constant data through the page cache.
+   *
+   * \param file_name The file containing the bytecode.
+   * \param lib The compiled runtime library.
+   *
+   * \return exe The constructed executable.
+   */
+  static runtime::Module LoadFromFile(const std::string& file_name, const runtime::Module lib);
+
   /*!
    * \brief Get the serialized form of the `functions`. This is
    * essentially bytecode serialization.
@@ -200,11 +218,12 @@ class Executable : public ModuleNode {
   void SaveGlobalSection(dmlc::Stream* strm);
 
   /*!
-   * \brief Save the constant pool.
+   * \brief Save the constant pool, the data of every constant being aligned
+   *  relative to the start of the stream.
    *
    * \param strm The input stream.
    */
-  void SaveConstantSection(dmlc::Stream* strm);
+  void SaveConstantSection(dmlc::SeekStream* strm);
 
   /*!
    * \brief Save primitive op names.
@@ -231,8 +250,10 @@ class Executable : public ModuleNode {
    * \brief Load the constant pool.
    *
    * \param strm The input stream.
+   * \param file The mapped file strm reads, nullptr to copy the constants.
    */
-  void LoadConstantSection(dmlc::Stream* strm);
+  void LoadConstantSection(dmlc::SeekStream* strm,
+                           const std::shared_ptr<MappedFile>& file = nullptr);
 
   /*!
    * \brief Load primitive op names.
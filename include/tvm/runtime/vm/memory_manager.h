@@ -27,6 +27,7 @@
 #include <tvm/runtime/c_runtime_api.h>
 #include <tvm/runtime/ndarray.h>
 #include <tvm/runtime/object.h>
+#include <tvm/runtime/profiling.h>
 
 #include <functional>
 #include <memory>
@@ -50,6 +51,7 @@ struct Buffer {
 enum AllocatorType {
   kNaive = 1,
   kPooled,
+  kBestFit,
 };
 
 class Allocator {
@@ -117,7 +119,7 @@ class StorageObj : public Object {
   Buffer buffer;
 
   /*! \brief Allocate an NDArray from a given piece of storage. */
-  NDArray AllocNDArray(size_t offset, std::vector<int64_t> shape, DLDataType dtype);
+  NDArray AllocNDArray(size_t offset, ShapeTuple shape, DLDataType dtype);
 
   /*! \brief The deleter for an NDArray when allocated from underlying storage. */
   static void Deleter(Object* ptr);
@@ -125,6 +127,7 @@ class StorageObj : public Object {
   ~StorageObj() {
     auto alloc = MemoryManager::Global()->GetAllocator(buffer.device);
     alloc->Free(buffer);
+    profiling::MemoryTracker::Free(profiling::MemoryTracker::kTensor, buffer.device, buffer.size);
   }
 
   static constexpr const uint32_t _type_index = TypeIndex::kDynamic;
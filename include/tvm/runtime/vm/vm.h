@@ -28,6 +28,7 @@
 #include <tvm/runtime/module.h>
 #include <tvm/runtime/object.h>
 #include <tvm/runtime/packed_func.h>
+#include <tvm/runtime/profiling.h>
 #include <tvm/runtime/registry.h>
 #include <tvm/runtime/vm/bytecode.h>
 #include <tvm/runtime/vm/executable.h>
@@ -100,6 +101,68 @@ struct VMFunction {
   friend std::ostream& operator<<(std::ostream& os, const VMFunction&);
 };
 
+/*!
+ * \brief Operands of an instruction that only depend on the executable,
+ *  decoded once when the executable is loaded.
+ */
+struct DecodedInstruction {
+  /*! \brief The static shape of AllocTensor. */
+  ShapeTuple shape;
+  /*! \brief The scalar tensor of LoadConsti. */
+  ObjectRef constant;
+};
+
+/*!
+ * \brief An executable prepared to run on a set of devices.
+ *
+ * It holds the part of the virtual machine state that only depends on the
+ * executable and the devices: the kernels looked up in the library, the
+ * decoded instructions and the constants copied to their devices. Once
+ * initialized for a set of devices it is immutable, so any number of VMs on
+ * any number of threads can run it with one copy of the constants. Creating
+ * such a VM only allocates its call stack.
+ */
+class LoadedExecutable : public ModuleNode {
+ public:
+  /*!
+   * \brief Look up the kernels and decode the instructions of an executable.
+   * \param exec The executable.
+   * \param exec_module The module of the executable, kept alive if defined.
+   */
+  LoadedExecutable(const Executable* exec, Module exec_module);
+
+  /*!
+   * \brief Copy every constant to its device so that the loaded executable
+   *  can be shared.
+   * \param devices The set of TVM devices.
+   * \param alloc_types The allocator types for each device.
+   */
+  void Init(const std::vector<Device>& devices, const std::vector<AllocatorType>& alloc_types);
+
+  const char* type_key() const final { return "VMLoadedExecutable"; }
+  PackedFunc GetFunction(const std::string& name, const ObjectPtr<Object>& sptr_to_self) final;
+
+  /*! \brief The executable. */
+  const Executable* exec;
+  /*! \brief The module of the executable when the loaded executable owns it. */
+  Module exec_module;
+  /*! \brief The kernels, indexed by packed index. */
+  std::vector<PackedFunc> packed_funcs;
+  /*! \brief The decoded operands of every function, indexed by function and pc. */
+  std::vector<std::vector<DecodedInstruction>> decoded_functions;
+  /*! \brief The devices, indexed by device type, empty until initialized. */
+  std::vector<Device> devices;
+  /*! \brief The allocator of every device. */
+  std::vector<Allocator*> allocators;
+  /*!
+   * \brief The constants on their devices. An uninitialized loaded executable
+   *  is private to one VM, which fills them lazily.
+   */
+  std::vector<ObjectRef> constants;
+  /*! \brief Whether Init has run, the loaded executable is immutable afterwards. */
+  bool initialized{false};
+};
+
 /*!
  * \brief A representation of a stack frame.
  *
@@ -176,6 +239,27 @@ class VirtualMachine : public runtime::ModuleNode {
    */
   virtual void LoadExecutable(const Executable* exec);
 
+  /*!
+   * \brief Run a loaded executable, sharing its kernels, constants and devices.
+   *  The VM cannot be initialized for other devices afterwards.
+   * \param loaded The loaded executable.
+   */
+  void LoadShared(ObjectPtr<LoadedExecutable> loaded);
+
+  /*!
+   * \brief Time the packed functions of every interval-th invocation.
+   *
+   *  The durations are recorded into per-function histograms, non-CPU
+   *  devices are synchronized after every call of a sampled invocation.
+   *
+   * \param interval The sampling interval, 0 disables sampling.
+   */
+  void SetSamplingInterval(int64_t interval) { sampling_.SetInterval(interval); }
+  /*! \return The packed function timing histograms of the sampled invocations as JSON. */
+  std::string GetSamplingStats();
+  /*! \brief Discard the samples recorded so far. */
+  void ResetSamplingStats() { sampling_.Reset(); }
+
  protected:
   /*! \brief Push a call frame on to the call stack. */
   void PushFrame(Index arg_count, Index ret_pc, const VMFunction& vm_func);
@@ -198,7 +282,7 @@ class VirtualMachine : public runtime::ModuleNode {
    * \param reg The register to read from.
    * \return The read object.
    */
-  inline ObjectRef ReadRegister(RegName reg) const;
+  inline const ObjectRef& ReadRegister(RegName reg) const;
 
   /*!
    * \brief Read a VM register and cast it to int32_t
@@ -238,6 +322,10 @@ class VirtualMachine : public runtime::ModuleNode {
   virtual void InvokePacked(Index packed_index, const PackedFunc& func, Index arg_count,
                             Index output_size, const std::vector<ObjectRef>& args);
 
+  /*! \brief InvokePacked recording the duration of the call into sampling_. */
+  void InvokePackedSampled(Index packed_index, const PackedFunc& func, Index arg_count,
+                           Index output_size, const std::vector<ObjectRef>& args);
+
   /*!
    * \brief Initialize the virtual machine for a set of devices.
    * \param devices The set of TVM devices.
@@ -256,17 +344,19 @@ class VirtualMachine : public runtime::ModuleNode {
    *
    * This does not begin execution of the VM.
    */
-  void InvokeGlobal(const VMFunction& func, const std::vector<ObjectRef>& args);
+  void InvokeGlobal(Index func_index, const std::vector<ObjectRef>& args);
 
  protected:
-  /*! \brief The virtual machine's packed function table. */
-  std::vector<PackedFunc> packed_funcs_;
+  /*! \brief The state shared with other VMs running the same executable. */
+  ObjectPtr<LoadedExecutable> loaded_;
   /*! \brief The current stack of call frames. */
   std::vector<VMFrame> frames_;
   /*! \brief The fuction table index of the current function. */
   Index func_index_;
   /*! \brief The current pointer to the code section. */
   const Instruction* code_;
+  /*! \brief The decoded operands of code_, indexed by pc. */
+  const DecodedInstruction* decoded_{nullptr};
   /*! \brief The virtual machine PC. */
   Index pc_;
   /*! \brief The special return register. */
@@ -280,10 +370,18 @@ class VirtualMachine : public runtime::ModuleNode {
   /*! \brief The cached memory allocators. */
   std::vector<Allocator*> allocators_;
   /*!
-   * \brief The constant pool for runtime. It caches the device dependent
-   * object to avoid rellocation of constants during inference.
+   * \brief Scratch buffers reused by the dispatch loop so that calls do not
+   *  allocate once they have grown to the largest call.
    */
-  std::vector<ObjectRef> const_pool_;
+  std::vector<ObjectRef> call_args_;
+  std::vector<TVMValue> packed_values_;
+  std::vector<int> packed_codes_;
+  /*! \brief Register files of popped frames, reused by the next calls. */
+  std::vector<std::vector<ObjectRef>> register_pool_;
+  /*! \brief Sampling profiler of the packed functions, disabled by default. */
+  profiling::SamplingProfiler sampling_;
+  /*! \brief Whether the running invocation is sampled. */
+  bool sampled_{false};
 };
 
 }  // namespace vm
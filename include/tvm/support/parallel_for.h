@@ -67,6 +67,20 @@ TVM_DLL std::vector<std::vector<int>> rr_partitioner(int begin, int end, int ste
 TVM_DLL void parallel_for(int begin, int end, const std::function<void(int)>& f, int step = 1,
                           const PartitionerFuncType partitioner = rr_partitioner);
 
+/*!
+ * \brief Run the task function in parallel on a fixed number of threads, each thread takes
+ *  the next index as soon as it is done, like the dynamic schedule of OpenMP.
+ * \param begin The start index of this parallel loop(inclusive).
+ * \param end The end index of this parallel loop(exclusive).
+ * \param num_threads The number of threads, including the calling thread.
+ * \param f The task function taking the thread id and the loop index.
+ * \note Unlike parallel_for, it may be called from several threads at once. A call made from a
+ *  worker of parallel_for or parallel_for_dynamic runs serially on that worker. The first
+ *  exception thrown by a task is rethrown once all threads are done.
+ */
+TVM_DLL void parallel_for_dynamic(int begin, int end, int num_threads,
+                                  const std::function<void(int thread_id, int index)>& f);
+
 }  // namespace support
 }  // namespace tvm
 
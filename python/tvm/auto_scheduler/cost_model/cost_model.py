@@ -22,6 +22,7 @@ import numpy as np
 import tvm._ffi
 from tvm.runtime import Object
 from .. import _ffi_api
+from ..measure_record import RecordReader
 
 
 @tvm._ffi.register_object("auto_scheduler.CostModel")
@@ -66,6 +67,71 @@ class RandomModel(CostModel):
         return [x.value for x in _ffi_api.CostModelPredict(self, search_task, states)]
 
 
+@tvm._ffi.register_object("auto_scheduler.GBDTModel")
+class GBDTModel(CostModel):
+    """A gradient boosted tree model trained and evaluated in C++.
+
+    It uses the same features and pack-sum loss as XGBModel, but does not call into python
+    during the search. Updates only extract the features of new measurements and add a few trees
+    to the ensemble, which is retrained from scratch whenever the number of measurements doubles.
+
+    Parameters
+    ----------
+    num_warmup_sample: int = 100
+        The minimum number of samples to start to use the trained model.
+        If the number of samples is less than this number, the model outputs random predictions.
+    seed: Optional[int]
+        The random seed
+    """
+
+    def __init__(self, num_warmup_sample=100, seed=None):
+        self.__init_handle_by_constructor__(
+            _ffi_api.GBDTModel, num_warmup_sample, seed if seed is not None else 43
+        )
+
+    def update(self, inputs, results):
+        """Update the cost model according to new measurement results (training data).
+
+        Parameters
+        ----------
+        inputs : List[auto_scheduler.measure.MeasureInput]
+            The measurement inputs
+        results : List[auto_scheduler.measure.MeasureResult]
+            The measurement results
+        """
+        _ffi_api.CostModelUpdate(self, inputs, results)
+
+    def predict(self, search_task, states):
+        """Predict the scores of states
+
+        Parameters
+        ----------
+        search_task : SearchTask
+            The search task of states
+        states : List[State]
+            The input states
+
+        Returns
+        -------
+        scores: List[float]
+            The predicted scores for all states
+        """
+        return [x.value for x in _ffi_api.CostModelPredict(self, search_task, states)]
+
+    def update_from_file(self, file_name, n_lines=None):
+        """Load measure records from a log file to update the cost model.
+
+        Parameters
+        ----------
+        file_name: str
+            The filename
+        n_lines: Optional[int]
+            Only load first n lines of the log file
+        """
+        inputs, results = RecordReader(file_name).read_lines(n_lines)
+        self.update(inputs, results)
+
+
 @tvm._ffi.register_func("auto_scheduler.cost_model.random_fill_float")
 def random_fill_float(size, return_ptr):
     """Fills a c++ float array with random numbers in [0, 1]
@@ -327,6 +327,10 @@ class LocalBuilder(ProgramBuilder):
     build_func: callable or str = "default"
         If is 'default', use default build function
         If is 'ndk', use function for android ndk
+        If is 'native', lower and compile in threads of the C++ builder, without Python.
+        Programs lowering to a module built before reuse its binary, and the build results
+        report the time of each stage in stage_costs. Needs an llvm host target. Programs
+        for non-CPU targets are built by the 'default' build function.
         If is callable, use it as custom build function, expect lib_format field.
     """
 
@@ -337,6 +341,10 @@ class LocalBuilder(ProgramBuilder):
         elif build_func == "ndk":
             BuildFunc.name = "ndk"
             BuildFunc.build_func = ndk.create_shared
+        elif build_func == "native":
+            # Programs for non-CPU targets fall back to the default build function.
+            BuildFunc.name = "default"
+            BuildFunc.build_func = tar.tar
         elif callable(build_func):
             BuildFunc.name = "custom"
             BuildFunc.build_func = build_func
@@ -344,7 +352,10 @@ class LocalBuilder(ProgramBuilder):
             raise ValueError("Invalid build_func" + build_func)
 
         self.__init_handle_by_constructor__(
-            _ffi_api.LocalBuilder, timeout, n_parallel, BuildFunc.name
+            _ffi_api.LocalBuilder,
+            timeout,
+            n_parallel,
+            "native" if build_func == "native" else BuildFunc.name,
         )
 
 
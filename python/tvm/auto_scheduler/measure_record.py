@@ -134,6 +134,137 @@ class RecordReader(Object):
             yield ret[0], ret[1]  # (input, result)
 
 
+@tvm._ffi.register_object("auto_scheduler.RecordDatabase")
+class RecordDatabase(Object):
+    """
+    An append-only binary database of measure records, indexed by workload key and target.
+
+    Unlike a json log, looking up the best records of a task only reads the index and parses
+    the returned records. Several processes can append to the same database concurrently.
+
+    Parameters
+    ----------
+    filename : str
+        File name of the database. It is created if it does not exist.
+        The index is stored next to it in `filename + ".idx"`.
+    """
+
+    def __init__(self, filename):
+        dirname = os.path.dirname(os.path.abspath(filename))
+        if not os.path.exists(dirname):
+            os.makedirs(dirname)
+        self.__init_handle_by_constructor__(_ffi_api.RecordDatabase, filename)
+
+    def append(self, inputs, results):
+        """Append measure records to the database.
+
+        Parameters
+        ----------
+        inputs: List[MeasureInput]
+            The MeasureInputs to be written.
+        results: List[MeasureResult]
+            The MeasureResults to be written.
+        """
+        _ffi_api.RecordDatabaseAppend(self, inputs, results)
+
+    def query_top_k(self, workload_key, target, k=1):
+        """Get the valid records of a task with the lowest mean cost.
+
+        Parameters
+        ----------
+        workload_key : str
+            The workload key of the task.
+        target : Union[str, tvm.target.Target]
+            The target of the task.
+        k : int = 1
+            The maximum number of records to return.
+
+        Returns
+        -------
+        inputs : List[auto_scheduler.measure.MeasureInput]
+            The MeasureInputs, sorted by increasing mean cost.
+        results : List[auto_scheduler.measure.MeasureResult]
+            The MeasureResults, sorted by increasing mean cost.
+        """
+        inputs, results = _ffi_api.RecordDatabaseQueryTopK(self, workload_key, str(target), k)
+        return list(inputs), list(results)
+
+    def best_records(self):
+        """Get the valid record with the lowest mean cost of every workload key and target.
+
+        Returns
+        -------
+        logs : List[auto_scheduler.measure.MeasureInput, auto_scheduler.measure.MeasureResult]
+        """
+        return list(zip(*_ffi_api.RecordDatabaseBestRecords(self)))
+
+    def __len__(self):
+        return _ffi_api.RecordDatabaseSize(self)
+
+
+@tvm._ffi.register_object("auto_scheduler.RecordToDatabase")
+class RecordToDatabase(MeasureCallback):
+    """
+    A measurement callback that appends measurement records to a record database.
+
+    Parameters
+    ----------
+    filename : str
+        File name of the database to append to.
+    """
+
+    def __init__(self, filename):
+        dirname = os.path.dirname(os.path.abspath(filename))
+        if not os.path.exists(dirname):
+            os.makedirs(dirname)
+        self.__init_handle_by_constructor__(_ffi_api.RecordToDatabase, filename)
+
+
+def is_record_database(filename):
+    """
+    Check whether a file is a record database rather than a json log.
+
+    Parameters
+    ----------
+    filename : str
+        The file name to check.
+
+    Returns
+    -------
+    ret: bool
+        Whether the file is a record database.
+    """
+    return bool(_ffi_api.IsRecordDatabase(filename))
+
+
+def convert_records_to_database(log_file, db_file):
+    """
+    Append the records of a json log file to a record database.
+
+    Parameters
+    ----------
+    log_file : str
+        File name of the json log.
+    db_file : str
+        File name of the database. It is created if it does not exist.
+    """
+    _ffi_api.ConvertRecordsToDatabase(log_file, db_file)
+
+
+def convert_database_to_records(db_file, log_file):
+    """
+    Append the records of a record database to a json log file.
+
+    Parameters
+    ----------
+    db_file : str
+        File name of the database.
+    log_file : str
+        File name of the json log.
+    """
+    _ffi_api.ConvertDatabaseToRecords(db_file, log_file)
+
+
 def load_record_from_string(record):
     """
     Load the measure record from string.
@@ -344,7 +475,7 @@ def distill_record_file(in_file, out_file):
 def main():
     """The main function for CLI."""
     parser = argparse.ArgumentParser()
-    parser.add_argument("--mode", choices=["distill"], default="distill")
+    parser.add_argument("--mode", choices=["distill", "to-db", "from-db"], default="distill")
     parser.add_argument("-i", "--input", type=str, help="input file")
     parser.add_argument("-o", "--output", type=str, default=None, help="output file")
 
@@ -355,12 +486,21 @@ def main():
     if args.mode == "distill":
         args.output = args.output or args.input + ".best.json"
         distill_record_file(args.input, args.output)
+    elif args.mode == "to-db":
+        args.output = args.output or os.path.splitext(args.input)[0] + ".db"
+        convert_records_to_database(args.input, args.output)
+    elif args.mode == "from-db":
+        args.output = args.output or os.path.splitext(args.input)[0] + ".json"
+        convert_database_to_records(args.input, args.output)
 
 
 """
 Usage:
 * Distill the best entries from a large log file
 e.g. python -m tvm.auto_scheduler.measure_record --mode distill -i input.json
+* Convert a log file to a record database and back
+e.g. python -m tvm.auto_scheduler.measure_record --mode to-db -i input.json -o input.db
+e.g. python -m tvm.auto_scheduler.measure_record --mode from-db -i input.db -o input.json
 """
 if __name__ == "__main__":
     main()
@@ -30,7 +30,7 @@ import logging
 import numpy as np
 
 from .search_policy import SearchPolicy, SketchPolicy, PreloadMeasuredStates
-from .cost_model import RandomModel, XGBModel
+from .cost_model import RandomModel, XGBModel, GBDTModel
 from .utils import array_mean
 from .measure import ProgramMeasurer
 from .measure_record import RecordReader
@@ -97,6 +97,11 @@ def make_search_policies(
             elif load_log_file:
                 logger.info("TaskScheduler: Reload measured states and train the model...")
                 cost_model.update_from_file(load_log_file)
+        elif model_type == "gbdt":
+            cost_model = GBDTModel(num_warmup_sample=len(tasks) * num_measures_per_round)
+            if load_log_file:
+                logger.info("TaskScheduler: Reload measured states and train the model...")
+                cost_model.update_from_file(load_log_file)
         elif model_type == "random":
             cost_model = RandomModel()
         else:
@@ -297,6 +302,7 @@ class TaskScheduler:
             If it is str,
             "default" for the default policy (SketchPolicy + XGBModel),
             "sketch.xgb" for SketchPolicy + XGBModel,
+            "sketch.gbdt" for SketchPolicy + GBDTModel,
             "sketch.random" for SketchPolicy + RandomModel.
         search_policy_params : Optional[Dict[str, Any]]
             The parameters of the search policy
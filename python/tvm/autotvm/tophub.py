@@ -96,6 +96,7 @@ def context(target, extra_files=None):
         return EmptyContext()
 
     best_context = ApplyHistoryBest([])
+    packages = []
 
     targets = target if isinstance(target, (list, tuple)) else [target]
 
@@ -118,11 +119,15 @@ def context(target, extra_files=None):
 
                 filename = "%s_%s.log" % (name, PACKAGE_VERSION[name])
                 best_context.load(Path(AUTOTVM_TOPHUB_ROOT_PATH, filename))
+                packages.append(filename)
                 break  # only load one file to avoid some fallback template mismatch problem
 
     if extra_files:
         for filename in extra_files:
             best_context.load(filename)
+    else:
+        # Identifies the loaded records, e.g. for the persistent compile cache.
+        best_context.tophub_packages = packages
 
     return best_context
 
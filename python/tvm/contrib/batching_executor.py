@@ -0,0 +1,156 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Batching front-end that coalesces single-sample requests for graph executors."""
+import json
+
+import numpy as np
+import tvm._ffi
+from tvm.relay.backend.executor_factory import GraphExecutorFactoryModule
+
+from .graph_executor import get_device
+
+
+def create(factories, device, input_names, max_delay_ms=1.0):
+    """Create a batching executor from a model compiled for several batch sizes.
+
+    Parameters
+    ----------
+    factories : List[Union[GraphExecutorFactoryModule, tvm.runtime.Module]]
+        The output of relay.build for every batch size, or the loaded
+        libraries. Axis 0 of every batched input and of every output must be
+        the batch axis.
+
+    device : Device or list of Device
+        The device(s) to run on.
+
+    input_names : List[str]
+        The inputs provided with every request. The remaining inputs keep the
+        values of the params baked into the factories.
+
+    max_delay_ms : float
+        The longest time a request waits for others to join its batch.
+
+    Returns
+    -------
+    module : BatchingModule
+        Runtime batching module.
+    """
+    modules = []
+    for factory in factories:
+        if isinstance(factory, GraphExecutorFactoryModule):
+            factory = factory.module
+        modules.append(factory)
+    _, _, device_type_id = get_device(modules[0], device)
+    fcreate = tvm._ffi.get_global_func("tvm.batching_executor.create")
+    return BatchingModule(
+        fcreate(modules, input_names, int(max_delay_ms * 1000), *device_type_id), input_names
+    )
+
+
+class BatchingModule(object):
+    """Wrapper runtime module of a batching executor.
+
+    Requests carry one sample for every batched input and return one sample
+    of every output. Requests submitted within ``max_delay_ms`` of each other
+    are run as one batch using the smallest compiled batch size that fits them.
+
+    Parameters
+    ----------
+    module : tvm.runtime.Module
+        The internal tvm module that holds the actual batching functions.
+
+    input_names : List[str]
+        The batched inputs in the order the module expects them.
+    """
+
+    def __init__(self, module, input_names):
+        self.module = module
+        self.input_names = list(input_names)
+        self._submit = module["submit"]
+        self._get_result = module["get_result"]
+        self._run = module["run"]
+        self._get_stats = module["get_stats"]
+
+    def _inputs(self, input_dict):
+        inputs = []
+        for name in self.input_names:
+            value = input_dict[name]
+            if isinstance(value, np.ndarray):
+                value = tvm.nd.array(value)
+            inputs.append(value)
+        return inputs
+
+    def submit(self, **input_dict):
+        """Queue a request without waiting for it
+
+        Parameters
+        ----------
+        input_dict: dict of str to NDArray
+            One sample of every batched input
+
+        Returns
+        -------
+        request_id : int
+            The id to pass to :py:meth:`get_result`.
+        """
+        return self._submit(*self._inputs(input_dict))
+
+    def get_result(self, request_id):
+        """Wait for a request to finish
+
+        Parameters
+        ----------
+        request_id : int
+            The id returned by :py:meth:`submit`.
+
+        Returns
+        -------
+        outputs : List[NDArray]
+            One sample of every output, with a leading batch axis of 1.
+        """
+        return list(self._get_result(request_id))
+
+    def run(self, **input_dict):
+        """Queue a request and wait for it
+
+        Parameters
+        ----------
+        input_dict: dict of str to NDArray
+            One sample of every batched input
+
+        Returns
+        -------
+        outputs : List[NDArray]
+            One sample of every output, with a leading batch axis of 1.
+        """
+        return list(self._run(*self._inputs(input_dict)))
+
+    @property
+    def max_batch_size(self):
+        """The largest compiled batch size."""
+        return self.module["get_max_batch_size"]()
+
+    def get_stats(self):
+        """Get the batching counters
+
+        Returns
+        -------
+        stats : dict
+            The number of requests and batches so far, the number of requests
+            waiting, and the number of batches run with every batch size.
+        """
+        return json.loads(self._get_stats())
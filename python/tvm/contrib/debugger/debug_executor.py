@@ -268,12 +268,16 @@ class GraphModuleDebug(graph_executor.GraphModule):
         ret = self._run_individual(number, repeat, min_repeat_ms)
         return ret.strip(",").split(",") if ret else []
 
-    def profile(self, **input_dict):
+    def profile(self, collectors=None, **input_dict):
         """Run forward execution of the graph and collect overall and per-op
         performance metrics.
 
         Parameters
         ----------
+        collectors : Optional[Sequence[MetricCollector]]
+            Extra metrics to collect, e.g. hardware counters with
+            :py:class:`tvm.runtime.profiling.PerfEventMetricCollector`.
+
         input_dict : dict of str to NDArray
             List of input values to be feed to
         Return
@@ -284,7 +288,7 @@ class GraphModuleDebug(graph_executor.GraphModule):
         if input_dict:
             self.set_input(**input_dict)
 
-        return self._profile()
+        return self._profile(collectors or [])
 
     def exit(self):
         """Exits the dump folder and all its contents"""
@@ -15,6 +15,8 @@
 # specific language governing permissions and limitations
 # under the License.
 """Minimum graph executor that executes graph containing TVM PackedFunc."""
+import json
+
 import numpy as np
 import tvm._ffi
 
@@ -159,6 +161,7 @@ class GraphModule(object):
         self._get_num_outputs = module["get_num_outputs"]
         self._get_num_inputs = module["get_num_inputs"]
         self._load_params = module["load_params"]
+        self._load_params_from_file = module["load_params_from_file"]
         self._share_params = module["share_params"]
 
     def set_input(self, key=None, value=None, **params):
@@ -205,6 +208,53 @@ class GraphModule(object):
             self.set_input(**input_dict)
         self._run()
 
+    def set_concurrency(self, num_workers):
+        """Set the maximum number of operators that run at the same time
+
+        Operators are dispatched as soon as the operators they depend on
+        have finished, including dependencies introduced by storage reuse,
+        so the outputs are identical to a sequential run. Only graphs placed
+        entirely on the CPU run concurrently.
+
+        Parameters
+        ----------
+        num_workers : int
+            The maximum number of concurrent operators, 0 or 1 selects
+            sequential execution.
+        """
+        self.module["set_concurrency"](num_workers)
+
+    def set_sampling_interval(self, interval):
+        """Time the operators of every interval-th run
+
+        Sampling is cheap enough to leave enabled in production. Devices other
+        than the CPU are synchronized after every operator of a sampled run.
+
+        Parameters
+        ----------
+        interval : int
+            The sampling interval, 0 disables sampling.
+        """
+        self.module["set_sampling_interval"](interval)
+
+    def get_sampling_stats(self):
+        """Get the operator timings of the sampled runs
+
+        Returns
+        -------
+        stats : dict
+            The sampling interval, the number of sampled runs, the number of
+            samples dropped because they were not read in time, and under
+            "ops" for every graph node the sample count, the mean, minimum,
+            maximum, p50, p90 and p99 durations in microseconds and the
+            histogram as a list of [bucket lower bound in microseconds, count].
+        """
+        return json.loads(self.module["get_sampling_stats"]())
+
+    def reset_sampling_stats(self):
+        """Discard the operator timings recorded so far."""
+        self.module["reset_sampling_stats"]()
+
     def get_num_outputs(self):
         """Get the number of outputs from the graph
 
@@ -282,6 +332,21 @@ class GraphModule(object):
         """
         self._load_params(bytearray(params_bytes))
 
+    def load_params_from_file(self, file_name):
+        """Load parameters from a file holding a serialized parameter dict.
+
+        The file is memory-mapped. When it was saved with
+        ``tvm.runtime.save_param_dict(params, aligned=True)`` the parameters of
+        a CPU graph are used in place, so processes loading the same file share
+        them through the page cache.
+
+        Parameters
+        ----------
+        file_name : str
+            The path to the parameter file.
+        """
+        self._load_params_from_file(file_name)
+
     def share_params(self, other, params_bytes):
         """Share parameters from pre-existing GraphExecutor instance.
 
@@ -0,0 +1,336 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Pipeline executor that runs a model split into stages on separate core groups."""
+import json
+
+import numpy as np
+import tvm._ffi
+from tvm import relay
+from tvm.relay.expr_functor import ExprMutator
+from tvm.runtime import container
+
+from . import graph_executor
+
+
+def _topological_nodes(body):
+    nodes = []
+
+    def _collect(expr):
+        if isinstance(expr, (relay.Let, relay.If, relay.Function)):
+            raise ValueError("pipeline partitioning only supports dataflow graphs")
+        if isinstance(expr, (relay.Call, relay.Tuple, relay.TupleGetItem)):
+            nodes.append(expr)
+
+    relay.analysis.post_order_visit(body, _collect)
+    return nodes
+
+
+def _is_reshape(expr):
+    """Whether expr may be built as a nop aliasing its input, which writes no output."""
+    return (
+        isinstance(expr, relay.Call)
+        and isinstance(expr.op, tvm.ir.Op)
+        and bool(expr.op.get_attr("TReshapeOp"))
+    )
+
+
+def _children(expr):
+    if isinstance(expr, relay.Call):
+        return list(expr.args)
+    if isinstance(expr, relay.Tuple):
+        return list(expr.fields)
+    return [expr.tuple_value]
+
+
+class _StageBuilder(ExprMutator):
+    """Copy the part of the graph computed by one stage, cutting at its inputs."""
+
+    def __init__(self, inputs):
+        super().__init__()
+        for value, var in inputs:
+            self.memo_map[value] = var
+
+
+def partition(mod, num_stages=None, split_points=None, params=None):
+    """Split the main function of a module into a chain of pipeline stages.
+
+    Every value flowing from a stage into any later stage is passed through the
+    stages in between, so output ``j`` of a stage is input ``j`` of the next one.
+    Without explicit split points the operator calls are spread evenly over the
+    stages. Use the stage latencies reported by
+    :py:meth:`PipelineModule.get_stage_stats` to pick better split points.
+
+    Parameters
+    ----------
+    mod : tvm.IRModule
+        The module to split. Its main function must be a dataflow graph.
+
+    num_stages : Optional[int]
+        The number of stages, ignored when split_points is given.
+
+    split_points : Optional[List[int]]
+        The number of operator calls before each cut, in increasing order.
+
+    params : Optional[Dict[str, NDArray]]
+        The parameters that will be bound at build time. They are used directly
+        by every stage that needs them instead of flowing through the pipeline.
+
+    Returns
+    -------
+    stages : List[tvm.IRModule]
+        The module of every stage.
+
+    input_names : List[List[str]]
+        The input names of every stage, in the order of the outputs of the
+        previous stage. The names of the first stage are the pipeline inputs.
+    """
+    mod = relay.transform.InferType()(mod)
+    func = mod["main"]
+    weights = set(params.keys()) if params else set()
+    runtime_inputs = [v for v in func.params if v.name_hint not in weights]
+    nodes = _topological_nodes(func.body)
+    index = {node: i for i, node in enumerate(nodes)}
+
+    # The index of the last node using each value, the graph output uses it last.
+    last_use = {}
+    for i, node in enumerate(nodes):
+        for child in _children(node):
+            last_use[child] = i
+    last_use[func.body] = len(nodes)
+
+    def live_values(boundary):
+        live = [v for v in runtime_inputs if last_use.get(v, -1) >= boundary]
+        live += [n for n in nodes[:boundary] if last_use.get(n, -1) >= boundary]
+        return live
+
+    def valid_cut(boundary):
+        return all(isinstance(v.checked_type, relay.TensorType) for v in live_values(boundary))
+
+    call_positions = [i + 1 for i, node in enumerate(nodes) if isinstance(node, relay.Call)]
+    if split_points is None:
+        if not num_stages or num_stages < 1:
+            raise ValueError("either num_stages or split_points must be given")
+        step = len(call_positions) / num_stages
+        split_points = [int(round(step * k)) for k in range(1, num_stages)]
+    boundaries = [0]
+    for num_calls in split_points:
+        if num_calls <= 0 or num_calls >= len(call_positions):
+            raise ValueError("split point %d is out of range" % num_calls)
+        boundary = call_positions[num_calls - 1]
+        # Only tensors can cross stages, move the cut past tuple values.
+        while boundary < len(nodes) and not valid_cut(boundary):
+            boundary += 1
+        if boundary <= boundaries[-1] or boundary >= len(nodes):
+            raise ValueError("cannot cut the graph after %d operator calls" % num_calls)
+        boundaries.append(boundary)
+    boundaries.append(len(nodes))
+
+    stages = []
+    input_names = []
+    for sid in range(len(boundaries) - 1):
+        live_in = live_values(boundaries[sid])
+        if sid == 0:
+            inputs = [(v, v) for v in live_in]
+            names = [v.name_hint for v in live_in]
+        else:
+            names = ["pipeline_in_%d" % j for j in range(len(live_in))]
+            inputs = [
+                (v, relay.var(name, type_annotation=v.checked_type))
+                for v, name in zip(live_in, names)
+            ]
+        builder = _StageBuilder(inputs)
+        # Every stage output must be written by an operator so that the executor
+        # can redirect it to the buffer of the next stage or of the caller.
+        if sid == len(boundaries) - 2:
+            body = builder.visit(func.body)
+            if isinstance(func.body, relay.Tuple):
+                fields = zip(func.body.fields, body.fields)
+                body = relay.Tuple([relay.copy(b) if _is_reshape(f) else b for f, b in fields])
+            elif _is_reshape(func.body):
+                body = relay.copy(body)
+        else:
+            outputs = []
+            for value in live_values(boundaries[sid + 1]):
+                out = builder.visit(value)
+                if value not in index or index[value] < boundaries[sid] or _is_reshape(value):
+                    out = relay.copy(out)
+                outputs.append(out)
+            body = outputs[0] if len(outputs) == 1 else relay.Tuple(outputs)
+        stage_params = [var for _, var in inputs]
+        stage_params += [v for v in relay.analysis.free_vars(body) if v not in stage_params]
+        stage_mod = tvm.IRModule.from_expr(relay.Function(stage_params, body))
+        stages.append(relay.transform.InferType()(stage_mod))
+        input_names.append(names)
+    return stages, input_names
+
+
+def create(stage_modules, input_names, cpu_groups=None, queue_depth=2):
+    """Create a pipeline executor from graph executors of every stage.
+
+    Parameters
+    ----------
+    stage_modules : List[Union[GraphModule, tvm.runtime.Module]]
+        The graph executor of every stage.
+
+    input_names : List[List[str]]
+        The input names of every stage, as returned by :py:func:`partition`.
+
+    cpu_groups : Optional[List[List[int]]]
+        The CPU ids every stage runs on. The stage thread pools are left
+        unpinned by default. ``runtime.threading.PartitionCpus`` computes
+        NUMA-aware groups.
+
+    queue_depth : int
+        The maximum number of requests waiting in front of each stage.
+
+    Returns
+    -------
+    module : PipelineModule
+        Runtime pipeline module.
+    """
+    stages = [m.module if isinstance(m, graph_executor.GraphModule) else m for m in stage_modules]
+    cpus = [container.ShapeTuple(group) for group in cpu_groups] if cpu_groups else []
+    fcreate = tvm._ffi.get_global_func("tvm.pipeline_executor.create")
+    return PipelineModule(fcreate(stages, input_names, cpus, queue_depth))
+
+
+def build(mod, target, device, num_stages=None, split_points=None, params=None, **kwargs):
+    """Partition, build and create a pipeline executor in one go.
+
+    Parameters
+    ----------
+    mod : tvm.IRModule
+        The module to run as a pipeline.
+
+    target : str or tvm.target.Target
+        The target every stage is built for.
+
+    device : Device
+        The device every stage runs on.
+
+    num_stages, split_points, params :
+        See :py:func:`partition`.
+
+    kwargs :
+        Forwarded to :py:func:`create`.
+
+    Returns
+    -------
+    module : PipelineModule
+        Runtime pipeline module.
+    """
+    stages, input_names = partition(mod, num_stages, split_points, params)
+    modules = []
+    for stage in stages:
+        lib = relay.build(stage, target=target, params=params)
+        modules.append(lib["default"](device))
+    return create(modules, input_names, **kwargs)
+
+
+class PipelineModule(object):
+    """Wrapper runtime module of a pipeline executor.
+
+    Requests are submitted with :py:meth:`run` and their outputs are returned
+    in submission order by :py:meth:`get_output`. Up to ``queue_depth``
+    requests wait in front of every stage, so callers should keep several
+    requests in flight to keep all the stages busy.
+
+    Parameters
+    ----------
+    module : tvm.runtime.Module
+        The internal tvm module that holds the actual pipeline functions.
+    """
+
+    def __init__(self, module):
+        self.module = module
+        self._set_input = module["set_input"]
+        self._run = module["run"]
+        self._get_output = module["get_output"]
+        self._get_stage_stats = module["get_stage_stats"]
+        self._reset_stage_stats = module["reset_stage_stats"]
+        self._get_num_stages = module["get_num_stages"]
+
+    def set_input(self, key, value):
+        """Set an input of the next request
+
+        The array is referenced rather than copied until the first stage has
+        run the request, so it must not be modified in the meantime.
+
+        Parameters
+        ----------
+        key : str
+            The input name
+
+        value : NDArray or numpy.ndarray
+            The input value
+        """
+        if isinstance(value, np.ndarray):
+            value = tvm.nd.array(value)
+        self._set_input(key, value)
+
+    def run(self, **input_dict):
+        """Submit a request using the inputs set so far
+
+        Parameters
+        ----------
+        input_dict: dict of str to NDArray
+            Inputs to set before submitting
+        """
+        for key, value in input_dict.items():
+            self.set_input(key, value)
+        self._run()
+
+    def get_output(self):
+        """Wait for the oldest request in flight
+
+        Returns
+        -------
+        outputs : List[NDArray]
+            The outputs of the request.
+        """
+        return list(self._get_output())
+
+    @property
+    def num_stages(self):
+        """The number of stages of the pipeline."""
+        return self._get_num_stages()
+
+    def get_stage_stats(self):
+        """Get the latency counters of every stage
+
+        Returns
+        -------
+        stats : List[dict]
+            For every stage the number of runs and the total, mean and maximum
+            run time, plus the time spent waiting for a free output buffer, all
+            in microseconds.
+        """
+        return json.loads(self._get_stage_stats())
+
+    def reset_stage_stats(self):
+        """Clear the latency counters of every stage."""
+        self._reset_stage_stats()
+
+    def __getitem__(self, key):
+        """Get internal module function
+
+        Parameters
+        ----------
+        key : str
+            The key to the module.
+        """
+        return self.module[key]
@@ -0,0 +1,44 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+# pylint: disable=protected-access
+"""Serve the RPC session of a client on the same host over shared memory.
+
+Started by tvm.rpc.ShmSession, which passes the name of the shared memory
+segment as the last argument.
+"""
+import argparse
+from ..rpc import server, _ffi_api
+
+
+def main(args):
+    """Main function
+
+    Parameters
+    ----------
+    args : argparse.Namespace
+        parsed args from command-line invocation
+    """
+    temp = server._server_env(args.load_library)
+    _ffi_api.ShmServerLoop(args.segment)
+    temp.remove()
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--load-library", type=str, help="Additional library to load")
+    parser.add_argument("segment", type=str, help="The shared memory segment of the session")
+    main(parser.parse_args())
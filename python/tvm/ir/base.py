@@ -277,3 +277,49 @@ def structural_hash(node, map_free_vars=False):
     structrual_equal
     """
     return tvm.runtime._ffi_node_api.StructuralHash(node, map_free_vars)
+
+
+class StructuralHashCache:
+    """Structural hash reusing the hashes of the nodes seen by earlier calls.
+
+    Hashing a node which shares subtrees with previously hashed nodes, such as
+    the result of a pass rewriting a small part of a function, only visits the
+    new nodes. Variables are hashed by their position in the subtree, so the
+    hash values differ from the ones of structural_hash but are consistent with
+    structural_equal as well.
+
+    The cache keeps the hashed nodes alive, call clear to release them. Modules
+    are modified in place and thus never cached, only their functions are.
+    """
+
+    def __init__(self):
+        _mod = tvm.runtime._ffi_node_api.CreateStructuralHashCache()
+        self._hash = _mod("hash")
+        self._size = _mod("size")
+        self._clear = _mod("clear")
+
+    def __call__(self, node, map_free_vars=False):
+        """Compute the structural hash of node.
+
+        Parameters
+        ----------
+        node : Object
+            The input to be hashed.
+
+        map_free_vars : bool
+            Whether free variables are mapped by the order of their occurences,
+            see structural_hash.
+
+        Returns
+        -------
+        result : int
+            The hash result
+        """
+        return self._hash(node, map_free_vars)
+
+    def __len__(self):
+        return self._size()
+
+    def clear(self):
+        """Release the cached hashes."""
+        self._clear()
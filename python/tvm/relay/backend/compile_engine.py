@@ -322,6 +322,32 @@ def lower_call(call, inputs, target):
     return LoweredOutput(outputs, best_impl)
 
 
+@tvm._ffi.register_func("relay.backend._tuning_context_key")
+def _tuning_context_key():
+    """Identify the tuning records the schedules are picked from, for the persistent
+    compile cache. Returns an empty string when no records are used, and None when the
+    records cannot be identified or schedules must be created, e.g. to extract tasks."""
+    # pylint: disable=import-outside-toplevel
+    from tvm import auto_scheduler
+
+    env = autotvm.task.TaskExtractEnv.current
+    if env is not None and env.tracing:
+        return None
+    if auto_scheduler.relay_integration.TracingEnvironment.current is not None:
+        return None
+    ansor_ctx = auto_scheduler.DispatchContext.current
+    if not isinstance(ansor_ctx, auto_scheduler.dispatcher.FallbackContext):
+        return None
+    ctx = autotvm.DispatchContext.current
+    if isinstance(ctx, autotvm.FallbackContext):
+        return ""
+    # The records relay.build loads from TopHub are fixed by the package versions.
+    packages = getattr(ctx, "tophub_packages", None)
+    if packages is None:
+        return None
+    return "tophub:" + ",".join(packages)
+
+
 @tvm._ffi.register_object("relay.CompileEngine")
 class CompileEngine(Object):
     """CompileEngine to get lowered code."""
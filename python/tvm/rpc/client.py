@@ -19,12 +19,14 @@ import os
 import stat
 import socket
 import struct
+import sys
 import time
 
 import tvm._ffi
 from tvm.contrib import utils
 from tvm._ffi.base import TVMError
 from tvm.runtime import ndarray as nd
+from tvm.runtime.container import ShapeTuple
 
 from . import base
 from . import server
@@ -92,6 +94,45 @@ class RPCSession(object):
         dev._rpc_sess = self
         return dev
 
+    def set_copy_chunking(self, chunk_bytes, window):
+        """Set how tensor copies to and from the remote are split.
+
+        Copies are sent in packets of at most chunk_bytes, and up to window
+        packets are in flight, so that the remote stores one chunk while the
+        next ones are on the wire.
+
+        Parameters
+        ----------
+        chunk_bytes : int
+            The largest number of bytes in one packet.
+
+        window : int
+            The number of packets in flight. microTVM servers always use 1.
+        """
+        _ffi_api.SetCopyChunking(self._sess, chunk_bytes, window)
+
+    def start_call(self, func, *args):
+        """Send a call to a remote function without waiting for it to return.
+
+        The remote runs calls in the order they are sent, so several calls can
+        be in flight and overlap with the round trips of the session.
+
+        Parameters
+        ----------
+        func : PackedFunc
+            A function obtained from this session.
+
+        args : list
+            The arguments of the call.
+
+        Returns
+        -------
+        wait : PackedFunc
+            A function waiting for the call and returning its result, raising
+            the error of the call if it failed.
+        """
+        return _ffi_api.StartCall(func, *args)
+
     def upload(self, data, target=None):
         """Upload file to remote runtime temp folder
 
@@ -276,6 +317,52 @@ class PopenSession(RPCSession):
         RPCSession.__init__(self, _popen_session(binary))
 
 
+class ShmSession(RPCSession):
+    """RPCSession with a server process on the same host, talking over shared memory.
+
+    Requests and replies go through ring buffers in a POSIX shared memory
+    segment instead of the kernel, and arrays made with shared_empty are
+    seen by both processes without any copy.
+
+    Parameters
+    ----------
+    cmd : List[str], optional
+        The command starting the server, the segment name is appended to it.
+        Defaults to a Python RPC server.
+
+    capacity : int, optional
+        The size in bytes of the ring of each direction, 0 for the default.
+    """
+
+    def __init__(self, cmd=None, capacity=0):
+        if cmd is None:
+            cmd = [sys.executable, "-m", "tvm.exec.rpc_shm_server"]
+        RPCSession.__init__(self, _ffi_api.CreateShmClient(capacity, *cmd))
+
+    def shared_empty(self, shape, dtype="float32"):
+        """Create an empty CPU array in shared memory.
+
+        Parameters
+        ----------
+        shape : tuple of int
+            The shape of the array.
+
+        dtype : str
+            The data type of the array.
+
+        Returns
+        -------
+        local : NDArray
+            The array in this process.
+
+        remote : NDArray
+            The same memory in the server process.
+        """
+        local = _ffi_api.ShmNDArrayEmpty(ShapeTuple(shape), dtype)
+        remote = self.get_function("rpc.ShmNDArrayOpen")(_ffi_api.ShmNDArrayName(local))
+        return local, remote
+
+
 class TrackerSession(object):
     """Tracker client session.
 
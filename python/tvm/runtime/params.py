@@ -19,7 +19,7 @@
 from . import _ffi_api, ndarray
 
 
-def save_param_dict(params):
+def save_param_dict(params, aligned=False):
     """Save parameter dictionary to binary bytes.
 
     The result binary bytes can be loaded by the
@@ -30,6 +30,11 @@ def save_param_dict(params):
     params : dict of str to NDArray
         The parameter dictionary.
 
+    aligned : bool
+        Pad the data of every array to an aligned offset. Files holding such
+        bytes are used in place by :py:func:`load_param_dict_from_file`
+        instead of being copied. The C runtime cannot read this layout.
+
     Returns
     -------
     param_bytes: bytearray
@@ -48,6 +53,8 @@ def save_param_dict(params):
        tvm.runtime.load_param_dict(param_bytes)
     """
     transformed = {k: ndarray.array(v) for (k, v) in params.items()}
+    if aligned:
+        return _ffi_api.SaveParamsAligned(transformed)
     return _ffi_api.SaveParams(transformed)
 
 
@@ -67,3 +74,23 @@ def load_param_dict(param_bytes):
     if isinstance(param_bytes, (bytes, str)):
         param_bytes = bytearray(param_bytes)
     return _ffi_api.LoadParams(param_bytes)
+
+
+def load_param_dict_from_file(file_name):
+    """Load parameter dictionary from a file.
+
+    The file is memory-mapped. When it was saved with ``aligned=True`` the
+    returned arrays point into the mapping rather than being copied, and the
+    mapping stays alive as long as any of them does.
+
+    Parameters
+    ----------
+    file_name: str
+        The path to the serialized parameters.
+
+    Returns
+    -------
+    params : dict of str to NDArray
+        The parameter dictionary.
+    """
+    return _ffi_api.LoadParamsFromFile(file_name)
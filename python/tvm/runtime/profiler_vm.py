@@ -50,7 +50,7 @@ class VirtualMachineProfiler(vm.VirtualMachine):
         warnings.warn("get_stat has been removed, use profile instead")
         return ""
 
-    def profile(self, *args, func_name="main", **kwargs):
+    def profile(self, *args, func_name="main", collectors=None, **kwargs):
         """Profile a function call.
 
         Parameters
@@ -58,6 +58,10 @@ class VirtualMachineProfiler(vm.VirtualMachine):
         func_name : str
             The name of the function.
 
+        collectors : Optional[Sequence[MetricCollector]]
+            Extra metrics to collect, e.g. hardware counters with
+            :py:class:`tvm.runtime.profiling.PerfEventMetricCollector`.
+
         args : list[tvm.runtime.NDArray] or list[np.ndarray]
             The arguments to the function.
 
@@ -71,4 +75,4 @@ class VirtualMachineProfiler(vm.VirtualMachine):
         """
         if args or kwargs:
             self.set_input(func_name, *args, **kwargs)
-        return self._profile(func_name)
+        return self._profile(func_name, collectors or [])
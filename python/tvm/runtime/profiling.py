@@ -46,3 +46,74 @@ class Report(Object):
             `calls` in CSV format.
         """
         return AsCSV(self)
+
+    def chrome_trace(self):
+        """Get the timeline of the profiling run.
+
+        Besides every call, the timeline holds the tasks run by the runtime
+        thread pool and the array copies of all threads. The trace can be
+        opened with chrome://tracing or https://ui.perfetto.dev.
+
+        Returns
+        -------
+        trace : str
+            The trace in the Chrome Trace Event JSON format.
+        """
+        return AsChromeTrace(self)
+
+
+@_ffi.register_object("runtime.profiling.MetricCollector")
+class MetricCollector(Object):
+    """Interface for user defined profiling metric collection."""
+
+
+@_ffi.register_object("runtime.profiling.PerfEventMetricCollector")
+class PerfEventMetricCollector(MetricCollector):
+    """Collects CPU performance counters of the process with Linux ``perf_event_open``.
+
+    The counts of every CPU call show up as columns of the profiling report.
+
+    Parameters
+    ----------
+    events : Optional[List[str]]
+        The events to count, named as in the ``perf`` tool, e.g. ``"cycles"``,
+        ``"instructions"``, ``"LLC-load-misses"``, ``"branch-misses"`` or
+        ``"page-faults"``. Raw events are given as ``"rNNNN"`` with ``NNNN``
+        the hexadecimal event code, for instance to count the floating point
+        operations retired by the CPU. By default cycles, instructions, cache
+        misses and branch misses are counted.
+    """
+
+    def __init__(self, events=None):
+        self.__init_handle_by_constructor__(
+            _ffi.get_global_func("runtime.profiling.PerfEventMetricCollector"), events or []
+        )
+
+
+class Trace(object):
+    """Record the timeline of all runtime threads while in scope.
+
+    Unlike the profiling report, tracing works with any executor. It records
+    the thread pool tasks and the array copies, with timestamps of the
+    monotonic clock so they line up with other traces of the process.
+
+    Example
+    -------
+    .. code-block:: python
+
+        with profiling.Trace() as trace:
+            module.run()
+        with open("trace.json", "w") as f:
+            f.write(trace.json)
+    """
+
+    def __init__(self):
+        self.json = None
+        self._begin = None
+
+    def __enter__(self):
+        self._begin = StartTrace()
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        self.json = StopTrace(self._begin)
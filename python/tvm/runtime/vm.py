@@ -20,6 +20,8 @@ The Relay Virtual Machine runtime.
 
 Implements a Python interface to executing the compiled VM object.
 """
+import json
+
 import numpy as np
 
 import tvm
@@ -172,6 +174,36 @@ class Executable(object):
 
         return Executable(_ffi_api.Load_Executable(bytecode, lib))
 
+    @staticmethod
+    def load_exec_from_file(file_name, lib):
+        """Construct an executable from bytecode saved to a file.
+
+        The file is memory-mapped and the constants of the executable point
+        into the mapping instead of being copied. Constants used on the CPU
+        are therefore shared through the page cache by every process loading
+        the same file.
+
+        Parameters
+        ----------
+        file_name : str
+            The path to a file holding the bytecode returned by :py:meth:`save`.
+
+        lib : :py:class:`~tvm.runtime.Module`
+            The runtime module that contains the generated code.
+
+        Returns
+        -------
+        exec: Executable
+            An executable constructed using the provided artifacts.
+        """
+        if lib is not None and not isinstance(lib, tvm.runtime.Module):
+            raise TypeError(
+                "lib is expected to be the type of tvm.runtime.Module"
+                + ", but received {}".format(type(lib))
+            )
+
+        return Executable(_ffi_api.Load_Executable_From_File(file_name, lib))
+
     @property
     def lib(self):
         """Get the library that contains hardware dependent code.
@@ -277,37 +309,126 @@ class Executable(object):
         return params
 
 
-class VirtualMachine(object):
-    """Relay VM runtime.
+def _device_init_args(dev, memory_cfg):
+    """Get the arguments of the VM init function for a set of devices."""
+    devs = dev
+    if not isinstance(dev, (list, tuple)):
+        if not isinstance(dev, tvm.runtime.Device):
+            raise TypeError(
+                "dev is expected to be Device or \
+                            List[Device]"
+            )
+        devs = [dev]
+
+    # CPU is required for executing shape functions
+    if not any(c.device_type % RPC_SESS_MASK == tvm.cpu().device_type for c in devs):
+        devs.append(tvm.cpu())
+
+    default_alloc_type = VirtualMachine.POOLED_ALLOCATOR
+    if memory_cfg is None:
+        memory_cfg = {}
+    elif isinstance(memory_cfg, str):
+        assert memory_cfg in VirtualMachine._ALLOCATOR_TYPES
+        default_alloc_type = VirtualMachine._ALLOCATOR_TYPES[memory_cfg]
+        memory_cfg = {}
+    elif not isinstance(memory_cfg, dict):
+        raise TypeError(
+            "memory_cfg is expected be string or dictionary, "
+            + "but received {}".format(type(memory_cfg))
+        )
+    init_args = []
+    for device in devs:
+        init_args.append(device.device_type % RPC_SESS_MASK)
+        init_args.append(device.device_id)
+        alloc_type = memory_cfg[device] if device in memory_cfg else default_alloc_type
+        if isinstance(alloc_type, str):
+            alloc_type = VirtualMachine._ALLOCATOR_TYPES[alloc_type]
+        init_args.append(alloc_type)
+    return init_args
+
+
+class LoadedExecutable(object):
+    """An executable prepared to run on a set of devices, shared by many VMs.
+
+    Loading looks up the kernels, decodes the instructions and copies the
+    constants to their devices once. The VMs created from it only hold their
+    own call stack, so serving concurrent requests with one VM per thread
+    keeps a single copy of the weights.
 
     Parameters
     ----------
-    exe : Executable
+    exe : Union[Executable, Module]
         The VM executable.
 
     device : tvm.runtime.Device or List[tvm.runtime.Device]
         The device to deploy the module
 
+    memory_cfg : str or Dict[tvm.runtime.Device, str], optional
+        The allocator type of every device, see :py:class:`VirtualMachine`.
+    """
+
+    def __init__(self, exe, device, memory_cfg=None):
+        if not isinstance(exe, Executable):
+            exe = Executable(exe)
+        self.executable = exe
+        self.module = exe.mod["vm_load_shared"](*_device_init_args(device, memory_cfg))
+
+    def create_vm(self):
+        """Create a VM running the loaded executable.
+
+        A VM runs one request at a time, create one for every thread.
+
+        Returns
+        -------
+        vm : VirtualMachine
+            The new VM.
+        """
+        return VirtualMachine(self)
+
+
+class VirtualMachine(object):
+    """Relay VM runtime.
+
+    Parameters
+    ----------
+    exe : Executable or LoadedExecutable
+        The VM executable. VMs created from a LoadedExecutable share its
+        kernels and constants and run on its devices.
+
+    device : tvm.runtime.Device or List[tvm.runtime.Device]
+        The device to deploy the module, ignored for a LoadedExecutable
+
     memory_cfg : str or Dict[tvm.runtime.Device, str], optional
         Config the type of memory allocator. The allocator type can be ["naive",
-        "pooled"]. If memory_cfg is None, all devices will use pooled allocator
+        "pooled", "best_fit"]. If memory_cfg is None, all devices will use pooled allocator
         by default. If memory_cfg is string, all devices will use the specified
         allocator type. If memory_cfg is a dict, each device uses the allocator
         type specified in the dict, or pooled allocator if not specified in the
         dict.
+
+        The "best_fit" allocator reuses freed memory for requests of any smaller size,
+        which bounds the memory of models with dynamic shapes. Its high-water mark of
+        free memory and thread-local cache size are set with the environment variables
+        TVM_VM_ALLOCATOR_MAX_FREE_BYTES and TVM_VM_ALLOCATOR_THREAD_CACHE_BYTES.
     """
 
     NAIVE_ALLOCATOR = 1
     POOLED_ALLOCATOR = 2
-
-    def __init__(self, exe, device, memory_cfg=None):
+    BEST_FIT_ALLOCATOR = 3
+    _ALLOCATOR_TYPES = {
+        "naive": NAIVE_ALLOCATOR,
+        "pooled": POOLED_ALLOCATOR,
+        "best_fit": BEST_FIT_ALLOCATOR,
+    }
+
+    def __init__(self, exe, device=None, memory_cfg=None):
         """
         Construct a VirtualMachine wrapper class which provides a simple
         interface over the raw C++ Module based API.
 
         Parameters
         ----------
-        exe: Union[Executable, Module]
+        exe: Union[Executable, LoadedExecutable, Module]
             The executable either with the wrapper Python type or the raw runtime.Module.
 
             In most cases this will be the Python wrapper class tvm.runtime.vm.Executable but
@@ -329,16 +450,22 @@ class VirtualMachine(object):
         vm: VirtualMachine
             A VM wrapper object.
         """
-        if not isinstance(exe, Executable) and not isinstance(exe, Module):
-            raise TypeError(
-                "exe is expected to be the type of Executable, "
-                + "but received {}".format(type(exe))
-            )
-
-        if not isinstance(exe, Executable):
-            exe = Executable(exe)
+        shared = isinstance(exe, LoadedExecutable)
+        if shared:
+            self.module = exe.module["create_vm"]()
+            exe = exe.executable
+        else:
+            if not isinstance(exe, Executable) and not isinstance(exe, Module):
+                raise TypeError(
+                    "exe is expected to be the type of Executable, "
+                    + "but received {}".format(type(exe))
+                )
+            if not isinstance(exe, Executable):
+                exe = Executable(exe)
+            if device is None:
+                raise ValueError("device is required to run an Executable")
+            self.module = exe.mod["vm_load_executable"]()
 
-        self.module = exe.mod["vm_load_executable"]()
         self._exec = exe
         self._init = self.module["init"]
         self._invoke = self.module["invoke"]
@@ -346,43 +473,12 @@ class VirtualMachine(object):
         self._get_output = self.module["get_output"]
         self._get_num_outputs = self.module["get_num_outputs"]
         self._set_input = self.module["set_input"]
-        self._setup_device(device, memory_cfg)
+        if not shared:
+            self._setup_device(device, memory_cfg)
 
     def _setup_device(self, dev, memory_cfg):
         """Init devices and allocators."""
-        devs = dev
-        if not isinstance(dev, (list, tuple)):
-            if not isinstance(dev, tvm.runtime.Device):
-                raise TypeError(
-                    "dev is expected to be Device or \
-                                List[Device]"
-                )
-            devs = [dev]
-
-        # CPU is required for executing shape functions
-        if not any(c.device_type % RPC_SESS_MASK == tvm.cpu().device_type for c in devs):
-            devs.append(tvm.cpu())
-
-        default_alloc_type = VirtualMachine.POOLED_ALLOCATOR
-        if memory_cfg is None:
-            memory_cfg = {}
-        elif isinstance(memory_cfg, str):
-            assert memory_cfg in ["naive", "pooled"]
-            if memory_cfg == "naive":
-                default_alloc_type = VirtualMachine.NAIVE_ALLOCATOR
-            memory_cfg = {}
-        elif not isinstance(memory_cfg, dict):
-            raise TypeError(
-                "memory_cfg is expected be string or dictionary, "
-                + "but received {}".format(type(memory_cfg))
-            )
-        init_args = []
-        for device in devs:
-            init_args.append(device.device_type % RPC_SESS_MASK)
-            init_args.append(device.device_id)
-            alloc_type = memory_cfg[device] if device in memory_cfg else default_alloc_type
-            init_args.append(alloc_type)
-        self._init(*init_args)
+        self._init(*_device_init_args(dev, memory_cfg))
 
     def set_input(self, func_name, *args, **kwargs):
         """Set the input to a function.
@@ -490,3 +586,53 @@ class VirtualMachine(object):
         outputs : List[NDArray]
         """
         return [self._get_output(i) for i in range(self._get_num_outputs())]
+
+    def set_sampling_interval(self, interval):
+        """Time the operators of every interval-th invocation
+
+        Sampling is cheap enough to leave enabled in production. Devices other
+        than the CPU are synchronized after every operator of a sampled
+        invocation.
+
+        Parameters
+        ----------
+        interval : int
+            The sampling interval, 0 disables sampling.
+        """
+        self.module["set_sampling_interval"](interval)
+
+    def get_sampling_stats(self):
+        """Get the operator timings of the sampled invocations
+
+        Returns
+        -------
+        stats : dict
+            The sampling interval, the number of sampled runs, the number of
+            samples dropped because they were not read in time, and under
+            "ops" for every operator the sample count, the mean, minimum,
+            maximum, p50, p90 and p99 durations in microseconds and the
+            histogram as a list of [bucket lower bound in microseconds, count].
+        """
+        return json.loads(self.module["get_sampling_stats"]())
+
+    def reset_sampling_stats(self):
+        """Discard the operator timings recorded so far."""
+        self.module["reset_sampling_stats"]()
+
+    @staticmethod
+    def allocator_stats(device):
+        """Get the statistics of the memory allocator of a device.
+
+        Parameters
+        ----------
+        device : tvm.runtime.Device
+            The device whose allocator is queried.
+
+        Returns
+        -------
+        stats : Dict[str, Union[int, float]]
+            The allocator type and the bytes it holds. The "best_fit" allocator also
+            reports free blocks, peak usage and fragmentation.
+        """
+        stats = tvm.get_global_func("vm.GetAllocatorStats")(device.device_type, device.device_id)
+        return json.loads(stats)
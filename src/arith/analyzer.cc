@@ -20,20 +20,228 @@
 /*!
  * \file tvm/arith/analyzer.cc
  */
+#include <dmlc/thread_local.h>
 #include <tvm/arith/analyzer.h>
+#include <tvm/node/structural_equal.h>
+#include <tvm/node/structural_hash.h>
 #include <tvm/runtime/registry.h>
 #include <tvm/tir/expr.h>
 #include <tvm/tir/op.h>
 
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../support/utils.h"
+
 namespace tvm {
 namespace arith {
 
+/*!
+ * \brief Persistent list of the facts known by an analyzer. The analyzers which
+ *  learnt the same facts in the same order have equal lists.
+ */
+class AnalyzerFacts {
+ public:
+  AnalyzerFacts(ObjectRef fact, std::shared_ptr<const AnalyzerFacts> parent)
+      : fact(std::move(fact)), parent(std::move(parent)) {
+    hash = support::HashCombine(this->parent ? this->parent->hash : 0,
+                                StructuralHash()(this->fact));
+  }
+  /*! \brief Whether the lists a and b are equal, either may be nullptr for the empty list. */
+  static bool Equal(const AnalyzerFacts* a, const AnalyzerFacts* b) {
+    while (a != b) {
+      if (a == nullptr || b == nullptr || a->hash != b->hash) return false;
+      if (!a->fact.same_as(b->fact) && !StructuralEqual()(a->fact, b->fact)) return false;
+      a = a->parent.get();
+      b = b->parent.get();
+    }
+    return true;
+  }
+
+  /*! \brief The newest fact */
+  ObjectRef fact;
+  /*! \brief The older facts */
+  std::shared_ptr<const AnalyzerFacts> parent;
+  /*! \brief The hash of the list */
+  uint64_t hash;
+};
+
+class AnalyzerCache::Impl {
+ public:
+  struct Key {
+    AnalyzerCache::Kind kind;
+    PrimExpr expr;
+    std::shared_ptr<const AnalyzerFacts> facts;
+    uint64_t expr_hash;
+    uint64_t hash;
+  };
+
+  explicit Impl(size_t capacity) : capacity_(capacity) {}
+
+  bool Lookup(const Key& key, ObjectRef* result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      ++misses_;
+      return false;
+    }
+    ++hits_;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    *result = it->second->second;
+    return true;
+  }
+
+  void Insert(const Key& key, ObjectRef result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_.count(key)) return;
+    entries_.emplace_front(key, std::move(result));
+    index_.emplace(key, entries_.begin());
+    auto& expr_hash = expr_hashes_[key.expr.get()];
+    expr_hash.first = key.expr_hash;
+    ++expr_hash.second;
+    while (entries_.size() > capacity_) {
+      const Key& last = entries_.back().first;
+      auto it = expr_hashes_.find(last.expr.get());
+      if (--it->second.second == 0) expr_hashes_.erase(it);
+      index_.erase(last);
+      entries_.pop_back();
+    }
+  }
+
+  /*! \brief The structural hash of expr, reusing the hash of the held expressions. */
+  uint64_t ExprHash(const PrimExpr& expr) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = expr_hashes_.find(expr.get());
+      if (it != expr_hashes_.end()) return it->second.first;
+    }
+    return StructuralHash()(expr);
+  }
+
+  size_t capacity() const { return capacity_; }
+
+ private:
+  friend class AnalyzerCache;
+  struct KeyHash {
+    size_t operator()(const Key& key) const { return key.hash; }
+  };
+  struct KeyEqual {
+    bool operator()(const Key& a, const Key& b) const {
+      return a.kind == b.kind && a.hash == b.hash &&
+             AnalyzerFacts::Equal(a.facts.get(), b.facts.get()) &&
+             (a.expr.same_as(b.expr) || StructuralEqual()(a.expr, b.expr));
+    }
+  };
+  using Entry = std::pair<Key, ObjectRef>;
+
+  mutable std::mutex mutex_;
+  size_t capacity_;
+  /*! \brief The results, the most recently used first */
+  std::list<Entry> entries_;
+  std::unordered_map<Key, std::list<Entry>::iterator, KeyHash, KeyEqual> index_;
+  /*! \brief The structural hash of the held expressions and their number of entries */
+  std::unordered_map<const Object*, std::pair<uint64_t, size_t>> expr_hashes_;
+  size_t hits_{0};
+  size_t misses_{0};
+};
+
+/*! \brief Thread local stack of the caches in scope. */
+struct AnalyzerCacheThreadLocalEntry {
+  std::vector<AnalyzerCache*> scopes;
+};
+
+using AnalyzerCacheThreadLocalStore = dmlc::ThreadLocalStore<AnalyzerCacheThreadLocalEntry>;
+
+AnalyzerCache::AnalyzerCache(size_t capacity) : impl_(std::make_shared<Impl>(capacity)) {}
+
+AnalyzerCache* AnalyzerCache::Current() {
+  const auto& scopes = AnalyzerCacheThreadLocalStore::Get()->scopes;
+  return scopes.empty() ? nullptr : scopes.back();
+}
+
+size_t AnalyzerCache::size() const {
+  std::lock_guard<std::mutex> lock(impl_->mutex_);
+  return impl_->entries_.size();
+}
+
+size_t AnalyzerCache::hits() const {
+  std::lock_guard<std::mutex> lock(impl_->mutex_);
+  return impl_->hits_;
+}
+
+size_t AnalyzerCache::misses() const {
+  std::lock_guard<std::mutex> lock(impl_->mutex_);
+  return impl_->misses_;
+}
+
+void AnalyzerCache::EnterWithScope() { AnalyzerCacheThreadLocalStore::Get()->scopes.push_back(this); }
+
+void AnalyzerCache::ExitWithScope() {
+  auto* entry = AnalyzerCacheThreadLocalStore::Get();
+  ICHECK(!entry->scopes.empty() && entry->scopes.back() == this);
+  entry->scopes.pop_back();
+}
+
 Analyzer::Analyzer()
     : const_int_bound(this),
       modular_set(this),
       rewrite_simplify(this),
       canonical_simplify(this),
-      int_set(this) {}
+      int_set(this) {
+  AnalyzerCache* cache = AnalyzerCache::Current();
+  if (cache != nullptr && cache->impl_->capacity() != 0) {
+    cache_ = cache->impl_;
+  }
+}
+
+void Analyzer::AddFact(const ObjectRef& fact) {
+  if (cache_ == nullptr) return;
+  facts_ = std::make_shared<const AnalyzerFacts>(fact, facts_);
+}
+
+std::function<void()> Analyzer::EnterConstraintFact(const PrimExpr& constraint) {
+  if (cache_ == nullptr) return nullptr;
+  std::shared_ptr<const AnalyzerFacts> outer = facts_;
+  AddFact(Array<ObjectRef>({String("constraint"), constraint}));
+  std::shared_ptr<const AnalyzerFacts> inner = facts_;
+  return [this, outer, inner, constraint]() {
+    // Bindings made in the scope outlive it, then only the constraint is dropped.
+    if (facts_ == inner) {
+      facts_ = outer;
+    } else {
+      AddFact(Array<ObjectRef>({String("exit_constraint"), constraint}));
+    }
+  };
+}
+
+ObjectRef Analyzer::Memoize(AnalyzerCache::Kind kind, const PrimExpr& expr,
+                            const std::function<ObjectRef()>& compute) {
+  // Leaves are cheaper to analyze than to look up, and so are the subexpressions
+  // analyzed while computing another result.
+  if (cache_ == nullptr || memo_depth_ != 0 || expr.as<IntImmNode>() || expr.as<VarNode>()) {
+    return compute();
+  }
+  uint64_t expr_hash = cache_->ExprHash(expr);
+  uint64_t hash = support::HashCombine(facts_ ? facts_->hash : 0, expr_hash);
+  AnalyzerCache::Impl::Key key{kind, expr, facts_, expr_hash, support::HashCombine(hash, kind)};
+  ObjectRef result;
+  if (cache_->Lookup(key, &result)) return result;
+  {
+    struct DepthScope {
+      explicit DepthScope(int* depth) : depth(depth) { ++*depth; }
+      ~DepthScope() { --*depth; }
+      int* depth;
+    } scope(&memo_depth_);
+    result = compute();
+  }
+  // Results which taught the analyzer new facts, e.g. by inlining lets, are
+  // not reproduced by a lookup.
+  if (facts_ == key.facts) cache_->Insert(key, result);
+  return result;
+}
 
 void Analyzer::Bind(const Var& var, const PrimExpr& expr, bool allow_override) {
   PrimExpr new_expr = expr;
@@ -69,8 +277,10 @@ void ConstraintContext::EnterWithScope() {
   auto f0 = analyzer_->const_int_bound.EnterConstraint(constraint_);
   auto f1 = analyzer_->modular_set.EnterConstraint(constraint_);
   auto f2 = analyzer_->rewrite_simplify.EnterConstraint(constraint_);
+  auto f3 = analyzer_->EnterConstraintFact(constraint_);
   // recovery function.
-  exit_ = [f0, f1, f2]() {
+  exit_ = [f0, f1, f2, f3]() {
+    if (f3 != nullptr) f3();
     if (f2 != nullptr) f2();
     if (f1 != nullptr) f1();
     if (f0 != nullptr) f0();
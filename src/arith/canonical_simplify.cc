@@ -1233,14 +1233,17 @@ PrimExpr CanonicalSimplifier::Impl::VisitExpr_(const CastNode* op) {
 }
 
 PrimExpr CanonicalSimplifier::operator()(const PrimExpr& expr) {
-  return impl_->CanonicalSimplify(expr);
+  return Downcast<PrimExpr>(parent_->Memoize(AnalyzerCache::kCanonicalSimplify, expr,
+                                             [&]() { return impl_->CanonicalSimplify(expr); }));
 }
 
 void CanonicalSimplifier::Update(const Var& var, const PrimExpr& info, bool override) {
+  parent_->AddFact(Array<ObjectRef>({String("canonical_simplify"), var, info}));
   impl_->Update(var, info, override);
 }
 
-CanonicalSimplifier::CanonicalSimplifier(Analyzer* parent) : impl_(new Impl(parent)) {}
+CanonicalSimplifier::CanonicalSimplifier(Analyzer* parent)
+    : parent_(parent), impl_(new Impl(parent)) {}
 
 CanonicalSimplifier::~CanonicalSimplifier() { delete impl_; }
 
@@ -605,8 +605,10 @@ class ConstIntBoundAnalyzer::Impl
 };
 
 ConstIntBound ConstIntBoundAnalyzer::operator()(const PrimExpr& expr) {
-  Entry ret = impl_->VisitExpr(expr);
-  return ConstIntBound(ret.min_value, ret.max_value);
+  return Downcast<ConstIntBound>(parent_->Memoize(AnalyzerCache::kConstIntBound, expr, [&]() {
+    Entry ret = impl_->VisitExpr(expr);
+    return ConstIntBound(ret.min_value, ret.max_value);
+  }));
 }
 
 ConstIntBound ConstIntBoundAnalyzer::operator()(const PrimExpr& expr, BoundMapType* bound) {
@@ -617,10 +619,14 @@ ConstIntBound ConstIntBoundAnalyzer::operator()(const PrimExpr& expr, BoundMapTy
 }
 
 void ConstIntBoundAnalyzer::Update(const Var& var, const ConstIntBound& info, bool allow_override) {
+  parent_->AddFact(Array<ObjectRef>({String("const_int_bound"), var,
+                                     IntImm(DataType::Int(64), info->min_value),
+                                     IntImm(DataType::Int(64), info->max_value)}));
   impl_->Update(var, info, allow_override);
 }
 
 void ConstIntBoundAnalyzer::Bind(const Var& var, const Range& range, bool allow_override) {
+  parent_->AddFact(Array<ObjectRef>({String("const_int_bound"), var, range}));
   impl_->Bind(var, range, allow_override);
 }
 
@@ -628,7 +634,8 @@ std::function<void()> ConstIntBoundAnalyzer::EnterConstraint(const PrimExpr& con
   return impl_->EnterConstraint(constraint);
 }
 
-ConstIntBoundAnalyzer::ConstIntBoundAnalyzer(Analyzer* parent) : impl_(new Impl()) {}
+ConstIntBoundAnalyzer::ConstIntBoundAnalyzer(Analyzer* parent)
+    : parent_(parent), impl_(new Impl()) {}
 
 ConstIntBoundAnalyzer::~ConstIntBoundAnalyzer() { delete impl_; }
 
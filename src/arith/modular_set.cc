@@ -329,6 +329,9 @@ ModularSet ModularSetAnalyzer::operator()(const PrimExpr& expr) {
 }
 
 void ModularSetAnalyzer::Update(const Var& var, const ModularSet& info, bool allow_override) {
+  parent_->AddFact(Array<ObjectRef>({String("modular_set"), var,
+                                     IntImm(DataType::Int(64), info->coeff),
+                                     IntImm(DataType::Int(64), info->base)}));
   impl_->Update(var, info, allow_override);
 }
 
@@ -336,7 +339,8 @@ std::function<void()> ModularSetAnalyzer::EnterConstraint(const PrimExpr& constr
   return impl_->EnterConstraint(constraint);
 }
 
-ModularSetAnalyzer::ModularSetAnalyzer(Analyzer* parent) : impl_(new Impl(parent)) {}
+ModularSetAnalyzer::ModularSetAnalyzer(Analyzer* parent)
+    : parent_(parent), impl_(new Impl(parent)) {}
 
 ModularSetAnalyzer::~ModularSetAnalyzer() { delete impl_; }
 
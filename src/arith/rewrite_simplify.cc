@@ -1595,18 +1595,21 @@ PrimExpr RewriteSimplifier::Impl::VisitExpr_(const LetNode* op) {
 }
 
 PrimExpr RewriteSimplifier::operator()(const PrimExpr& expr) {
-  // Run simplification in post order
-  PrimExpr res = expr;
-  int max_iter = 2;
-  for (int i = 0; i < max_iter; ++i) {
-    PrimExpr new_expr = impl_->operator()(res);
-    if (new_expr.same_as(res)) return res;
-    res = new_expr;
-  }
-  return res;
+  return Downcast<PrimExpr>(parent_->Memoize(AnalyzerCache::kRewriteSimplify, expr, [&]() {
+    // Run simplification in post order
+    PrimExpr res = expr;
+    int max_iter = 2;
+    for (int i = 0; i < max_iter; ++i) {
+      PrimExpr new_expr = impl_->operator()(res);
+      if (new_expr.same_as(res)) return res;
+      res = new_expr;
+    }
+    return res;
+  }));
 }
 
 void RewriteSimplifier::Update(const Var& var, const PrimExpr& info, bool allow_override) {
+  parent_->AddFact(Array<ObjectRef>({String("rewrite_simplify"), var, info}));
   impl_->Update(var, info, allow_override);
 }
 
@@ -1614,7 +1617,8 @@ std::function<void()> RewriteSimplifier::EnterConstraint(const PrimExpr& constra
   return impl_->EnterConstraint(constraint);
 }
 
-RewriteSimplifier::RewriteSimplifier(Analyzer* parent) : impl_(new Impl(parent)) {}
+RewriteSimplifier::RewriteSimplifier(Analyzer* parent)
+    : parent_(parent), impl_(new Impl(parent)) {}
 
 RewriteSimplifier::~RewriteSimplifier() { delete impl_; }
 
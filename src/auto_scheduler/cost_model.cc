@@ -23,6 +23,15 @@
  */
 
 #include <tvm/auto_scheduler/cost_model.h>
+#include <tvm/auto_scheduler/feature.h>
+#include <tvm/support/parallel_for.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 namespace tvm {
 namespace auto_scheduler {
@@ -30,6 +39,7 @@ namespace auto_scheduler {
 TVM_REGISTER_OBJECT_TYPE(CostModelNode);
 TVM_REGISTER_OBJECT_TYPE(RandomModelNode);
 TVM_REGISTER_OBJECT_TYPE(PythonBasedModelNode);
+TVM_REGISTER_OBJECT_TYPE(GBDTModelNode);
 
 RandomModel::RandomModel() {
   ObjectPtr<RandomModelNode> node = make_object<RandomModelNode>();
@@ -145,6 +155,334 @@ void PythonBasedModelNode::PredictStages(const SearchTask& task, const Array<Sta
   }
 }
 
+namespace {
+
+/*! \brief The same as DEFAULT_MAX_N_BUFS of the python feature extraction. */
+constexpr int kMaxNBufs = 5;
+/*! \brief The maximum number of bins of a feature, so that a bin index fits in a byte. */
+constexpr int kMaxBins = 64;
+/*! \brief The L2 regularization of the leaf values. */
+constexpr double kLambda = 1.0;
+/*! \brief The minimum gain of a split. */
+constexpr double kGamma = 1e-3;
+/*! \brief The size of a histogram pass worth running on several threads. */
+constexpr size_t kParallelThreshold = 1 << 16;
+
+using TreeNode = GBDTModelNode::TreeNode;
+
+/*! \brief The number of buffer stores and the length of their features in a feature vector. */
+std::pair<int, int> StoreShape(const std::vector<float>& feature) {
+  if (feature.empty() || feature[0] < 1) {
+    return {0, 0};
+  }
+  int n_stores = static_cast<int>(feature[0]);
+  return {n_stores, static_cast<int>((feature.size() - 1) / n_stores)};
+}
+
+float PredictTree(const std::vector<TreeNode>& tree, const float* feature) {
+  int i = 0;
+  while (tree[i].feature >= 0) {
+    i = feature[tree[i].feature] < tree[i].threshold ? tree[i].left : tree[i].right;
+  }
+  return tree[i].value;
+}
+
+/*! \brief Bin boundaries splitting the values of a feature into at most kMaxBins quantiles. */
+std::vector<float> ComputeCuts(std::vector<float> values) {
+  std::sort(values.begin(), values.end());
+  values.erase(std::unique(values.begin(), values.end()), values.end());
+  std::vector<float> cuts;
+  if (values.size() <= static_cast<size_t>(kMaxBins)) {
+    // One bin per distinct value.
+    if (!values.empty()) cuts.assign(values.begin() + 1, values.end());
+    return cuts;
+  }
+  for (int k = 1; k < kMaxBins; ++k) {
+    float value = values[k * values.size() / kMaxBins];
+    if (cuts.empty() || value > cuts.back()) cuts.push_back(value);
+  }
+  return cuts;
+}
+
+/*!
+ * \brief Grows a regression tree on the gradients of binned rows.
+ *  The bin of a value is the number of boundaries not above it, so that splitting after a bin
+ *  is the same as comparing the value with the next boundary.
+ */
+class TreeBuilder {
+ public:
+  TreeBuilder(const std::vector<uint8_t>& bins, size_t num_rows,
+              const std::vector<std::vector<float>>& cuts, const std::vector<float>& grad,
+              const std::vector<float>& hess, int max_depth, double learning_rate)
+      : bins_(bins),
+        num_rows_(num_rows),
+        cuts_(cuts),
+        grad_(grad),
+        hess_(hess),
+        max_depth_(max_depth),
+        learning_rate_(learning_rate) {}
+
+  std::vector<TreeNode> Build() {
+    std::vector<int> rows(num_rows_);
+    std::iota(rows.begin(), rows.end(), 0);
+    Grow(&rows, 0);
+    return std::move(tree_);
+  }
+
+ private:
+  struct Split {
+    double gain = 0;
+    int bin = -1;
+  };
+
+  Split FindSplit(const std::vector<int>& rows, int feature, double sum_grad, double sum_hess) {
+    double grad[kMaxBins] = {0};
+    double hess[kMaxBins] = {0};
+    size_t count[kMaxBins] = {0};
+    const uint8_t* column = &bins_[feature * num_rows_];
+    for (int row : rows) {
+      uint8_t bin = column[row];
+      grad[bin] += grad_[row];
+      hess[bin] += hess_[row];
+      count[bin]++;
+    }
+    Split best;
+    double parent_score = sum_grad * sum_grad / (sum_hess + kLambda);
+    double grad_left = 0, hess_left = 0;
+    size_t count_left = 0;
+    for (size_t bin = 0; bin < cuts_[feature].size(); ++bin) {
+      grad_left += grad[bin];
+      hess_left += hess[bin];
+      count_left += count[bin];
+      if (count_left == 0) continue;
+      if (count_left == rows.size()) break;
+      double grad_right = sum_grad - grad_left, hess_right = sum_hess - hess_left;
+      double gain = grad_left * grad_left / (hess_left + kLambda) +
+                    grad_right * grad_right / (hess_right + kLambda) - parent_score;
+      if (gain > best.gain) {
+        best.gain = gain;
+        best.bin = bin;
+      }
+    }
+    return best;
+  }
+
+  int Grow(std::vector<int>* rows, int depth) {
+    double sum_grad = 0, sum_hess = 0;
+    for (int row : *rows) {
+      sum_grad += grad_[row];
+      sum_hess += hess_[row];
+    }
+    int id = tree_.size();
+    float value = static_cast<float>(-learning_rate_ * sum_grad / (sum_hess + kLambda));
+    tree_.push_back({-1, 0.0f, -1, -1, value});
+    if (depth >= max_depth_ || rows->size() < 2) {
+      return id;
+    }
+
+    int num_features = cuts_.size();
+    std::vector<Split> splits(num_features);
+    auto find_split = [&](int feature) {
+      splits[feature] = FindSplit(*rows, feature, sum_grad, sum_hess);
+    };
+    if (rows->size() * num_features >= kParallelThreshold) {
+      support::parallel_for(0, num_features, find_split);
+    } else {
+      for (int feature = 0; feature < num_features; ++feature) find_split(feature);
+    }
+    int best = -1;
+    for (int feature = 0; feature < num_features; ++feature) {
+      if (splits[feature].bin >= 0 && splits[feature].gain > kGamma &&
+          (best < 0 || splits[feature].gain > splits[best].gain)) {
+        best = feature;
+      }
+    }
+    if (best < 0) {
+      return id;
+    }
+
+    int bin = splits[best].bin;
+    const uint8_t* column = &bins_[best * num_rows_];
+    std::vector<int> left, right;
+    for (int row : *rows) {
+      (column[row] <= bin ? left : right).push_back(row);
+    }
+    std::vector<int>().swap(*rows);
+    tree_[id].feature = best;
+    tree_[id].threshold = cuts_[best][bin];
+    int left_id = Grow(&left, depth + 1);
+    tree_[id].left = left_id;
+    int right_id = Grow(&right, depth + 1);
+    tree_[id].right = right_id;
+    return id;
+  }
+
+  const std::vector<uint8_t>& bins_;
+  size_t num_rows_;
+  const std::vector<std::vector<float>>& cuts_;
+  const std::vector<float>& grad_;
+  const std::vector<float>& hess_;
+  int max_depth_;
+  double learning_rate_;
+  std::vector<TreeNode> tree_;
+};
+
+}  // namespace
+
+GBDTModel::GBDTModel(int num_warmup_sample, int seed) {
+  auto node = make_object<GBDTModelNode>();
+  node->num_warmup_sample = num_warmup_sample;
+  node->max_depth = 6;
+  node->num_rounds = 200;
+  node->num_incremental_rounds = 20;
+  node->learning_rate = 0.2;
+  node->retrain_growth = 2.0;
+  node->rand_gen_.seed(seed);
+  data_ = std::move(node);
+}
+
+void GBDTModelNode::Update(const Array<MeasureInput>& inputs,
+                           const Array<MeasureResult>& results) {
+  if (inputs.empty()) {
+    return;
+  }
+  ICHECK_EQ(inputs.size(), results.size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    inputs_.push_back(inputs[i]);
+    results_.push_back(results[i]);
+  }
+
+  // Only extract the features of the new measurements, the normalized throughputs of all of
+  // them change with the best cost of their task.
+  size_t n_cached = features_.size();
+  std::vector<std::vector<float>> features;
+  std::vector<int> task_ids;
+  GetPerStoreFeaturesFromMeasurePairs(inputs_, results_, n_cached, kMaxNBufs, &features,
+                                      &throughputs_, &task_ids);
+  for (size_t i = 0; i < n_cached && i < features.size(); ++i) {
+    features[i] = std::move(features_[i]);
+  }
+  features_ = std::move(features);
+
+  bool from_scratch = trees_.empty() || features_.size() >= last_train_size_ * retrain_growth;
+  if (from_scratch) {
+    last_train_size_ = features_.size();
+  }
+  Train(from_scratch);
+}
+
+void GBDTModelNode::Train(bool from_scratch) {
+  // Every buffer store of a valid measurement is a row, the sum of the predictions of the rows
+  // of a measurement fits its normalized throughput.
+  std::vector<const float*> rows;
+  std::vector<int> pack_ids;
+  std::vector<float> labels;
+  size_t num_features = 0;
+  for (size_t i = 0; i < features_.size(); ++i) {
+    int n_stores, length;
+    std::tie(n_stores, length) = StoreShape(features_[i]);
+    if (n_stores == 0) continue;
+    ICHECK(num_features == 0 || num_features == static_cast<size_t>(length));
+    num_features = length;
+    for (int j = 0; j < n_stores; ++j) {
+      rows.push_back(&features_[i][1 + j * length]);
+      pack_ids.push_back(labels.size());
+    }
+    labels.push_back(throughputs_[i]);
+  }
+  if (rows.empty()) {
+    return;
+  }
+  size_t num_rows = rows.size();
+
+  if (from_scratch || cuts_.size() != num_features) {
+    from_scratch = true;
+    trees_.clear();
+    cuts_.assign(num_features, std::vector<float>());
+    // The quantiles of a subsample are good enough as bin boundaries.
+    size_t stride = std::max<size_t>(1, num_rows / 16384);
+    support::parallel_for(0, num_features, [&](int feature) {
+      std::vector<float> values;
+      for (size_t row = 0; row < num_rows; row += stride) {
+        values.push_back(rows[row][feature]);
+      }
+      cuts_[feature] = ComputeCuts(std::move(values));
+    });
+  }
+  std::vector<uint8_t> bins(num_rows * num_features);
+  support::parallel_for(0, num_features, [&](int feature) {
+    const std::vector<float>& cuts = cuts_[feature];
+    for (size_t row = 0; row < num_rows; ++row) {
+      float value = rows[row][feature];
+      bins[feature * num_rows + row] = std::upper_bound(cuts.begin(), cuts.end(), value) -
+                                       cuts.begin();
+    }
+  });
+
+  std::vector<float> preds(num_rows, 0.0f);
+  if (!trees_.empty()) {
+    support::parallel_for(0, num_rows, [&](int row) { preds[row] = PredictStore(rows[row]); });
+  }
+  std::vector<float> grad(num_rows), hess(num_rows);
+  std::vector<double> sums(labels.size());
+  int num_new_trees = from_scratch ? num_rounds : num_incremental_rounds;
+  for (int round = 0; round < num_new_trees; ++round) {
+    // The squared error of the sums, weighted by the label to focus on the fast programs.
+    std::fill(sums.begin(), sums.end(), 0.0);
+    for (size_t row = 0; row < num_rows; ++row) {
+      sums[pack_ids[row]] += preds[row];
+    }
+    for (size_t row = 0; row < num_rows; ++row) {
+      float label = labels[pack_ids[row]];
+      grad[row] = label * (sums[pack_ids[row]] - label);
+      hess[row] = label;
+    }
+    std::vector<TreeNode> tree =
+        TreeBuilder(bins, num_rows, cuts_, grad, hess, max_depth, learning_rate).Build();
+    for (size_t row = 0; row < num_rows; ++row) {
+      preds[row] += PredictTree(tree, rows[row]);
+    }
+    trees_.push_back(std::move(tree));
+  }
+}
+
+float GBDTModelNode::PredictStore(const float* feature) const {
+  float score = 0.0f;
+  for (const auto& tree : trees_) {
+    score += PredictTree(tree, feature);
+  }
+  return score;
+}
+
+void GBDTModelNode::Predict(const SearchTask& task, const Array<State>& states,
+                            std::vector<float>* scores) {
+  std::vector<std::vector<float>> features;
+  GetPerStoreFeaturesFromStates(states, task, 0, kMaxNBufs, &features);
+  scores->assign(states.size(), 0.0f);
+  if (trees_.empty() || static_cast<int64_t>(inputs_.size()) <= num_warmup_sample) {
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    for (float& score : *scores) {
+      score = dist(rand_gen_);
+    }
+  } else {
+    support::parallel_for(0, states.size(), [&](int i) {
+      int n_stores, length;
+      std::tie(n_stores, length) = StoreShape(features[i]);
+      float score = 0.0f;
+      for (int j = 0; j < n_stores; ++j) {
+        score += PredictStore(&features[i][1 + j * length]);
+      }
+      (*scores)[i] = score;
+    });
+  }
+  // Predict -inf for invalid states that failed to be lowered.
+  for (size_t i = 0; i < features.size(); ++i) {
+    if (features[i].empty()) {
+      (*scores)[i] = -std::numeric_limits<float>::infinity();
+    }
+  }
+}
+
 TVM_REGISTER_GLOBAL("auto_scheduler.RandomModel").set_body_typed([]() { return RandomModel(); });
 
 TVM_REGISTER_GLOBAL("auto_scheduler.PythonBasedModel")
@@ -153,6 +491,11 @@ TVM_REGISTER_GLOBAL("auto_scheduler.PythonBasedModel")
       return PythonBasedModel(update_func, predict_func, predict_stage_func);
     });
 
+TVM_REGISTER_GLOBAL("auto_scheduler.GBDTModel")
+    .set_body_typed([](int num_warmup_sample, int seed) {
+      return GBDTModel(num_warmup_sample, seed);
+    });
+
 TVM_REGISTER_GLOBAL("auto_scheduler.CostModelUpdate")
     .set_body_typed([](CostModel model, Array<MeasureInput> inputs, Array<MeasureResult> results) {
       model->Update(inputs, results);
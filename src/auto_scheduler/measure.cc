@@ -23,10 +23,23 @@
  */
 
 #include <tvm/auto_scheduler/measure.h>
+#include <tvm/driver/driver_api.h>
+#include <tvm/node/structural_equal.h>
+#include <tvm/node/structural_hash.h>
 #include <tvm/runtime/registry.h>
+#include <tvm/support/parallel_for.h>
+#include <tvm/target/codegen.h>
 
 #include <algorithm>
-
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+
+#include "../runtime/file_utils.h"
 #include "search_policy/empty_policy.h"
 #include "search_policy/sketch_policy.h"
 #include "utils.h"
@@ -115,6 +128,9 @@ LocalBuilder::LocalBuilder(int timeout, int n_parallel, const String& build_func
 }
 
 Array<BuildResult> LocalBuilderNode::Build(const Array<MeasureInput>& inputs, int verbose) {
+  if (build_func == kNativeBuildFunc) {
+    return BuildNative(inputs, verbose);
+  }
   if (const auto* f = runtime::Registry::Get("auto_scheduler.local_builder.build")) {
     Array<BuildResult> results = (*f)(inputs, timeout, n_parallel, build_func, verbose);
     return results;
@@ -125,6 +141,254 @@ Array<BuildResult> LocalBuilderNode::Build(const Array<MeasureInput>& inputs, in
   throw;
 }
 
+/*!
+ * \brief Artifacts of native builds by lowered module.
+ *
+ *  Different states often lower to the same module, e.g. when they only
+ *  differ by a split of factor one, and the same state may be measured
+ *  again by later rounds. Those skip code generation and reuse the artifact.
+ */
+class NativeBuildCache {
+ public:
+  /*! \return The artifact built for an equal module and target, nullptr if there is none. */
+  std::shared_ptr<const std::string> Find(const IRModule& mod, const std::string& target,
+                                          size_t hash) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Entry& entry : entries_) {
+      if (entry.hash == hash && entry.target == target && StructuralEqual()(entry.mod, mod)) {
+        return entry.artifact;
+      }
+    }
+    return nullptr;
+  }
+
+  void Insert(IRModule mod, std::string target, size_t hash,
+              std::shared_ptr<const std::string> artifact) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_back(Entry{std::move(mod), std::move(target), hash, std::move(artifact)});
+    if (entries_.size() > kCapacity) {
+      entries_.pop_front();
+    }
+  }
+
+ private:
+  struct Entry {
+    IRModule mod;
+    std::string target;
+    size_t hash;
+    std::shared_ptr<const std::string> artifact;
+  };
+  /*! \brief The number of artifacts kept, the oldest ones are dropped first. */
+  static constexpr size_t kCapacity = 1024;
+
+  std::mutex mutex_;
+  std::deque<Entry> entries_;
+};
+
+namespace {
+
+/*! \brief Create a fresh directory for the artifact of one build, the runners remove it. */
+std::string MakeBuildDir() {
+#ifndef _WIN32
+  const char* tmp = std::getenv("TMPDIR");
+  std::string dir =
+      std::string(tmp != nullptr && *tmp != '\0' ? tmp : "/tmp") + "/tvm_build_XXXXXX";
+  ICHECK(mkdtemp(&dir[0]) != nullptr) << "Cannot create a build directory in " << dir;
+  return dir;
+#else
+  LOG(FATAL) << "The native LocalBuilder is not supported on Windows";
+  return "";
+#endif
+}
+
+/*! \brief Append a file to a tar archive in the ustar format. */
+void AppendTarEntry(std::string* tar, const std::string& name, const std::string& data) {
+  char header[512] = {0};
+  ICHECK_LT(name.size(), 100U);
+  std::memcpy(header, name.data(), name.size());
+  std::snprintf(header + 100, 8, "%07o", 0644);
+  std::snprintf(header + 108, 8, "%07o", 0);
+  std::snprintf(header + 116, 8, "%07o", 0);
+  std::snprintf(header + 124, 12, "%011llo", static_cast<unsigned long long>(data.size()));
+  std::snprintf(header + 136, 12, "%011o", 0);
+  header[156] = '0';
+  std::memcpy(header + 257, "ustar", 6);
+  std::memcpy(header + 263, "00", 2);
+  // The checksum is computed with its own field filled with spaces.
+  std::memset(header + 148, ' ', 8);
+  unsigned checksum = 0;
+  for (char c : header) {
+    checksum += static_cast<unsigned char>(c);
+  }
+  std::snprintf(header + 148, 8, "%06o", checksum);
+  tar->append(header, sizeof(header));
+  tar->append(data);
+  tar->append((512 - data.size() % 512) % 512, '\0');
+}
+
+/*!
+ * \brief Pack a built module the way export_library does with tar.tar.
+ * \param mod The built module, with an llvm host module.
+ * \param dir A directory for the temporary object files.
+ * \return The bytes of the tar archive.
+ */
+std::string PackArtifact(runtime::Module mod, const std::string& dir) {
+  ICHECK_EQ(std::string(mod->type_key()), "llvm")
+      << "The native LocalBuilder needs an llvm host target, got " << mod->type_key();
+  std::string tar, data;
+  std::string file_name = dir + "/lib0.o";
+  mod->SaveToFile(file_name, "o");
+  runtime::LoadBinaryFromFile(file_name, &data);
+  runtime::RemoveFile(file_name);
+  AppendTarEntry(&tar, "lib0.o", data);
+  if (!mod->imports().empty()) {
+    std::string triple = mod.GetFunction("_get_target_triple")();
+    file_name = dir + "/devc.o";
+    codegen::PackImportsToLLVM(mod, false, triple)->SaveToFile(file_name, "o");
+    runtime::LoadBinaryFromFile(file_name, &data);
+    runtime::RemoveFile(file_name);
+    AppendTarEntry(&tar, "devc.o", data);
+  }
+  tar.append(1024, '\0');
+  return tar;
+}
+
+/*! \brief Build one program with the targets of its task already resolved. */
+BuildResult NativeBuild(const MeasureInput& input, const Target& target, const Target& target_host,
+                        int timeout, NativeBuildCache* cache) {
+  using Clock = std::chrono::high_resolution_clock;
+  auto t_begin = Clock::now();
+  auto t_stage = t_begin;
+  auto node = make_object<BuildResultNode>();
+  auto end_stage = [&t_stage, &node](const char* stage) {
+    auto now = Clock::now();
+    double cost = std::chrono::duration_cast<std::chrono::duration<double>>(now - t_stage).count();
+    node->stage_costs.Set(stage, FloatImm(DataType::Float(64), cost));
+    t_stage = now;
+  };
+  node->error_no = static_cast<int>(MeasureErrorNO::kNoError);
+
+  const SearchTask& task = input->task;
+  te::Schedule sch;
+  try {
+    std::tie(sch, node->args) = task->compute_dag.ApplySteps(
+        input->state->transform_steps, nullptr, nullptr, task->layout_rewrite_option);
+  } catch (const std::exception& e) {
+    node->error_no = static_cast<int>(MeasureErrorNO::kInstantiationError);
+    node->error_msg = e.what();
+  }
+  end_stage("instantiate");
+
+  std::string dir;
+  if (node->error_no == static_cast<int>(MeasureErrorNO::kNoError)) {
+    try {
+      IRModule lowered = LowerSchedule(sch, node->args, "default_function", {});
+      end_stage("lower");
+      std::string target_key = target->str() + " -host=" + target_host->str();
+      size_t hash = StructuralHash()(lowered);
+      std::shared_ptr<const std::string> artifact = cache->Find(lowered, target_key, hash);
+      dir = MakeBuildDir();
+      if (artifact == nullptr) {
+        runtime::Module mod = build(lowered, target, target_host);
+        artifact = std::make_shared<const std::string>(PackArtifact(mod, dir));
+        cache->Insert(lowered, target_key, hash, artifact);
+      }
+      end_stage("codegen");
+      node->filename = dir + "/tmp_func.tar";
+      runtime::SaveBinaryToFile(node->filename, *artifact);
+      end_stage("export");
+    } catch (const std::exception& e) {
+      node->error_no = static_cast<int>(MeasureErrorNO::kCompileHostError);
+      node->error_msg = e.what();
+      node->filename = "";
+      if (!dir.empty()) std::remove(dir.c_str());
+      dir.clear();
+    }
+  }
+  node->time_cost =
+      std::chrono::duration_cast<std::chrono::duration<double>>(Clock::now() - t_begin).count();
+  // Threads cannot be stopped, a build running over time is reported as if it had been.
+  if (timeout > 0 && node->time_cost > timeout) {
+    if (!dir.empty()) {
+      runtime::RemoveFile(node->filename);
+      std::remove(dir.c_str());
+    }
+    node->filename = "";
+    node->args = Array<te::Tensor>();
+    node->error_no = static_cast<int>(MeasureErrorNO::kBuildTimeoutError);
+    node->error_msg = "";
+    node->time_cost = timeout;
+  }
+  return BuildResult(node);
+}
+
+}  // namespace
+
+Array<BuildResult> LocalBuilderNode::BuildNative(const Array<MeasureInput>& inputs, int verbose) {
+  if (native_cache_ == nullptr) {
+    native_cache_ = std::make_shared<NativeBuildCache>();
+  }
+  // Resolve the targets once per task rather than once per program.
+  std::unordered_map<const SearchTaskNode*, std::pair<Target, Target>> task_targets;
+  for (const MeasureInput& input : inputs) {
+    const SearchTaskNode* task = input->task.get();
+    if (!task_targets.count(task)) {
+      Target target = task->target, target_host = task->target_host;
+      CheckAndUpdateHostConsistency(&target, &target_host);
+      task_targets[task] = {target, target_host};
+    }
+  }
+
+  std::vector<BuildResult> results(inputs.size());
+  // The code generators of device targets call back into Python (e.g. to run nvcc), which
+  // deadlocks on the worker threads while the calling thread holds the GIL. Those programs
+  // go through the process pool of the default builder instead.
+  std::vector<size_t> native, fallback;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    const Target& target = task_targets.at(inputs[i]->task.get()).first;
+    (target->kind->device_type == kDLCPU ? native : fallback).push_back(i);
+  }
+  if (!fallback.empty()) {
+    const auto* f = runtime::Registry::Get("auto_scheduler.local_builder.build");
+    ICHECK(f != nullptr) << "auto_scheduler.local_builder.build is not registered, "
+                         << "the native builder only builds programs for CPU targets";
+    Array<MeasureInput> fallback_inputs;
+    for (size_t i : fallback) fallback_inputs.push_back(inputs[i]);
+    Array<BuildResult> fallback_results = (*f)(fallback_inputs, timeout, n_parallel, "default", 0);
+    for (size_t k = 0; k < fallback.size(); ++k) results[fallback[k]] = fallback_results[k];
+  }
+
+  int num_threads =
+      std::max(1, std::min(n_parallel > 0 ? n_parallel : 1, static_cast<int>(native.size())));
+  // Builds take very different times, every thread takes the next program when it is done.
+  std::atomic<size_t> next{0};
+  support::parallel_for(
+      0, num_threads,
+      [&](int thread) {
+        for (size_t k = next++; k < native.size(); k = next++) {
+          size_t i = native[k];
+          const auto& targets = task_targets.at(inputs[i]->task.get());
+          results[i] = NativeBuild(inputs[i], targets.first, targets.second, timeout,
+                                   native_cache_.get());
+        }
+      },
+      1, [](int begin, int end, int step, int) {
+        return support::rr_partitioner(begin, end, step, end - begin);
+      });
+
+  for (const BuildResult& res : results) {
+    if (res->error_no == static_cast<int>(MeasureErrorNO::kNoError)) {
+      StdCout(verbose) << ".";
+    } else if (res->error_no == static_cast<int>(MeasureErrorNO::kBuildTimeoutError)) {
+      StdCout(verbose) << ".T";
+    } else {
+      StdCout(verbose) << ".E";
+    }
+  }
+  StdCout(verbose) << std::flush;
+  return Array<BuildResult>(results.begin(), results.end());
+}
+
 /********** LocalRunner **********/
 LocalRunner::LocalRunner(int timeout, int number, int repeat, int min_repeat_ms,
                          double cooldown_interval, bool enable_cpu_cache_flush) {
@@ -28,9 +28,20 @@
 #include <tvm/auto_scheduler/transform_step.h>
 #include <tvm/runtime/registry.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
+#include <limits>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -309,6 +320,8 @@ namespace auto_scheduler {
 
 TVM_REGISTER_OBJECT_TYPE(RecordToFileNode);
 TVM_REGISTER_OBJECT_TYPE(RecordReaderNode);
+TVM_REGISTER_NODE_TYPE(RecordDatabaseNode);
+TVM_REGISTER_OBJECT_TYPE(RecordToDatabaseNode);
 
 RecordToFile::RecordToFile(String filename) {
   auto node = make_object<RecordToFileNode>();
@@ -403,6 +416,407 @@ std::pair<Array<MeasureInput>, Array<MeasureResult>> RecordReaderNode::ReadLines
   return std::make_pair(inputs, results);
 }
 
+/********** Record database **********/
+
+namespace {
+
+/*! \brief The magic and version at the start of the data file and the index file. */
+struct DatabaseFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+};
+
+const char kDataMagic[8] = {'T', 'V', 'M', 'A', 'R', 'D', 'B', '\0'};
+const char kIndexMagic[8] = {'T', 'V', 'M', 'A', 'R', 'I', 'X', '\0'};
+constexpr uint32_t kDatabaseVersion = 1;
+constexpr uint32_t kRecordMagic = 0x44524352;  // "RCRD"
+
+/*! \brief The header of a record in the data file, followed by the key, target and payload. */
+struct RecordHeader {
+  uint32_t magic;
+  uint32_t workload_key_size;
+  uint32_t target_size;
+  uint32_t payload_size;
+  uint64_t key_hash;
+  double cost;
+  int32_t error_no;
+  uint32_t reserved;
+};
+
+static_assert(sizeof(DatabaseFileHeader) == 16, "The file header must be packed");
+static_assert(sizeof(RecordHeader) == 40, "The record header must be packed");
+
+/*! \brief FNV-1a hash of the workload key and target, stable across platforms and runs. */
+uint64_t RecordKeyHash(const std::string& workload_key, const std::string& target) {
+  uint64_t hash = 14695981039346656037ULL;
+  auto update = [&hash](const std::string& str) {
+    for (unsigned char c : str) {
+      hash = (hash ^ c) * 1099511628211ULL;
+    }
+  };
+  update(workload_key);
+  hash = hash * 1099511628211ULL;  // A zero byte separating the two strings.
+  update(target);
+  return hash;
+}
+
+/*! \brief The mean of the costs of a valid record, infinity for an error. */
+double RecordCost(const MeasureResult& res) {
+  double sum = 0;
+  int count = 0;
+  for (const auto& cost : res->costs) {
+    if (const auto* imm = cost.as<FloatImmNode>()) {
+      sum += imm->value;
+      count++;
+    }
+  }
+  if (res->error_no != static_cast<int>(MeasureErrorNO::kNoError) || count == 0) {
+    return std::numeric_limits<double>::infinity();
+  }
+  return sum / count;
+}
+
+uint64_t FileSize(const std::string& filename) {
+  std::ifstream fin(filename, std::ifstream::binary | std::ifstream::ate);
+  return fin ? static_cast<uint64_t>(fin.tellg()) : 0;
+}
+
+void WriteFileHeader(const std::string& filename, const char* magic) {
+  DatabaseFileHeader header;
+  std::memcpy(header.magic, magic, sizeof(header.magic));
+  header.version = kDatabaseVersion;
+  header.reserved = 0;
+  std::ofstream fout(filename, std::ofstream::binary | std::ofstream::trunc);
+  fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  ICHECK(fout) << "Cannot write " << filename;
+}
+
+bool CheckFileHeader(std::istream* is, const char* magic) {
+  DatabaseFileHeader header;
+  is->seekg(0);
+  is->read(reinterpret_cast<char*>(&header), sizeof(header));
+  return *is && std::memcmp(header.magic, magic, sizeof(header.magic)) == 0 &&
+         header.version == kDatabaseVersion;
+}
+
+/*! \brief Drop the bytes of a file beyond a size. */
+void TruncateFile(const std::string& filename, uint64_t size) {
+#ifndef _WIN32
+  ICHECK_EQ(truncate(filename.c_str(), static_cast<off_t>(size)), 0)
+      << "Cannot truncate " << filename << ": " << strerror(errno);
+#else
+  std::string data(size, '\0');
+  {
+    std::ifstream fin(filename, std::ifstream::binary);
+    fin.read(&data[0], size);
+  }
+  std::ofstream fout(filename, std::ofstream::binary | std::ofstream::trunc);
+  fout.write(data.data(), data.size());
+#endif
+}
+
+/*!
+ * \brief Exclusive lock of a database file shared by the writers of all processes.
+ *  Without flock on Windows, only the writers of one process are serialized.
+ */
+class DatabaseFileLock {
+ public:
+  explicit DatabaseFileLock(const std::string& filename) {
+#ifndef _WIN32
+    fd_ = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    ICHECK_GE(fd_, 0) << "Cannot open " << filename << ": " << strerror(errno);
+    while (flock(fd_, LOCK_EX) != 0) {
+      ICHECK_EQ(errno, EINTR) << "Cannot lock " << filename << ": " << strerror(errno);
+    }
+#endif
+  }
+
+  ~DatabaseFileLock() {
+#ifndef _WIN32
+    // Closing the descriptor releases the lock.
+    close(fd_);
+#endif
+  }
+
+ private:
+  int fd_ = -1;
+};
+
+}  // namespace
+
+RecordDatabase::RecordDatabase(String filename) {
+  auto node = make_object<RecordDatabaseNode>();
+  node->filename = std::move(filename);
+  {
+    DatabaseFileLock lock(node->filename);
+    node->SyncIndex();
+  }
+  data_ = std::move(node);
+}
+
+void RecordDatabaseNode::SyncIndex() {
+  std::string idx_filename = std::string(filename) + ".idx";
+  uint64_t data_size = FileSize(filename);
+  if (data_size == 0) {
+    WriteFileHeader(filename, kDataMagic);
+    data_size = sizeof(DatabaseFileHeader);
+  }
+  data_in_.close();
+  data_in_.open(filename, std::ifstream::binary);
+  ICHECK(CheckFileHeader(&data_in_, kDataMagic))
+      << filename << " is not an auto_scheduler record database of version " << kDatabaseVersion;
+
+  index_.clear();
+  index_size_ = 0;
+  RefreshIndex();
+  // Start over when the index is missing or does not match the data file.
+  bool stale = index_size_ == 0;
+  if (!stale && !index_.empty()) {
+    const IndexEntry& last = index_.back();
+    RecordHeader header;
+    stale = last.offset + last.size > data_size;
+    if (!stale) {
+      data_in_.clear();
+      data_in_.seekg(last.offset);
+      data_in_.read(reinterpret_cast<char*>(&header), sizeof(header));
+      stale = !data_in_ || header.magic != kRecordMagic || header.key_hash != last.key_hash;
+    }
+  }
+  if (stale) {
+    WriteFileHeader(idx_filename, kIndexMagic);
+    index_.clear();
+    index_size_ = sizeof(DatabaseFileHeader);
+  } else if (FileSize(idx_filename) != index_size_) {
+    // A partial entry left by a crashed writer.
+    TruncateFile(idx_filename, index_size_);
+  }
+
+  // Index the records written after the last index entry.
+  uint64_t end = index_.empty() ? sizeof(DatabaseFileHeader)
+                                : index_.back().offset + index_.back().size;
+  std::vector<IndexEntry> added;
+  RecordHeader header;
+  while (end + sizeof(header) <= data_size) {
+    data_in_.clear();
+    data_in_.seekg(end);
+    data_in_.read(reinterpret_cast<char*>(&header), sizeof(header));
+    ICHECK(data_in_ && header.magic == kRecordMagic)
+        << "Corrupted record at offset " << end << " of " << filename;
+    uint64_t size = sizeof(header) + static_cast<uint64_t>(header.workload_key_size) +
+                    header.target_size + header.payload_size;
+    if (end + size > data_size) break;
+    added.push_back({header.key_hash, header.cost, end, header.error_no,
+                     static_cast<uint32_t>(size)});
+    end += size;
+  }
+  if (end < data_size) {
+    // A partial record left by a crashed writer.
+    TruncateFile(filename, end);
+  }
+  if (!added.empty()) {
+    std::ofstream fout(idx_filename, std::ofstream::binary | std::ofstream::app);
+    fout.write(reinterpret_cast<const char*>(added.data()), added.size() * sizeof(IndexEntry));
+    ICHECK(fout) << "Cannot write " << idx_filename;
+    index_.insert(index_.end(), added.begin(), added.end());
+    index_size_ += added.size() * sizeof(IndexEntry);
+  }
+}
+
+void RecordDatabaseNode::RefreshIndex() {
+  std::ifstream fin(std::string(filename) + ".idx", std::ifstream::binary | std::ifstream::ate);
+  if (!fin) return;
+  uint64_t size = fin.tellg();
+  if (index_size_ == 0) {
+    if (!CheckFileHeader(&fin, kIndexMagic)) return;
+    index_size_ = sizeof(DatabaseFileHeader);
+  }
+  if (size <= index_size_) return;
+  // Only whole entries, a writer may be in the middle of appending one.
+  size_t count = (size - index_size_) / sizeof(IndexEntry);
+  if (count == 0) return;
+  size_t begin = index_.size();
+  index_.resize(begin + count);
+  fin.seekg(index_size_);
+  fin.read(reinterpret_cast<char*>(&index_[begin]), count * sizeof(IndexEntry));
+  ICHECK(fin) << "Cannot read the index of " << filename;
+  index_size_ += count * sizeof(IndexEntry);
+}
+
+std::pair<std::string, std::string> RecordDatabaseNode::ReadKey(const IndexEntry& entry) {
+  RecordHeader header;
+  data_in_.clear();
+  data_in_.seekg(entry.offset);
+  data_in_.read(reinterpret_cast<char*>(&header), sizeof(header));
+  std::string workload_key(header.workload_key_size, '\0');
+  std::string target(header.target_size, '\0');
+  data_in_.read(&workload_key[0], workload_key.size());
+  data_in_.read(&target[0], target.size());
+  ICHECK(data_in_) << "Cannot read the record at offset " << entry.offset << " of " << filename;
+  return {workload_key, target};
+}
+
+std::string RecordDatabaseNode::ReadPayload(const IndexEntry& entry) {
+  RecordHeader header;
+  data_in_.clear();
+  data_in_.seekg(entry.offset);
+  data_in_.read(reinterpret_cast<char*>(&header), sizeof(header));
+  std::string payload(header.payload_size, '\0');
+  data_in_.seekg(entry.offset + sizeof(header) + header.workload_key_size + header.target_size);
+  data_in_.read(&payload[0], payload.size());
+  ICHECK(data_in_) << "Cannot read the record at offset " << entry.offset << " of " << filename;
+  return payload;
+}
+
+std::pair<Array<MeasureInput>, Array<MeasureResult>> RecordDatabaseNode::ParseRecords(
+    const std::vector<IndexEntry>& entries) {
+  Array<MeasureInput> inputs;
+  Array<MeasureResult> results;
+  std::string log_version;
+  for (const IndexEntry& entry : entries) {
+    auto inp = make_object<MeasureInputNode>();
+    auto res = make_object<MeasureResultNode>();
+    ReadMeasureRecord(ReadPayload(entry), inp.get(), res.get(), &log_version);
+    inputs.push_back(MeasureInput(inp));
+    results.push_back(MeasureResult(res));
+  }
+  return std::make_pair(inputs, results);
+}
+
+void RecordDatabaseNode::Append(const Array<MeasureInput>& inputs,
+                                const Array<MeasureResult>& results) {
+  ICHECK_EQ(inputs.size(), results.size());
+  std::lock_guard<std::mutex> guard(mutex_);
+  DatabaseFileLock lock(filename);
+  SyncIndex();
+
+  uint64_t offset = index_.empty() ? sizeof(DatabaseFileHeader)
+                                   : index_.back().offset + index_.back().size;
+  std::string data;
+  std::vector<IndexEntry> added;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    std::ostringstream os;
+    WriteMeasureRecords(&os, {inputs[i]}, {results[i]});
+    std::string payload = os.str();
+    payload.pop_back();  // The line break.
+    const std::string& workload_key = inputs[i]->task->workload_key;
+    const std::string& target = inputs[i]->task->target->str();
+
+    RecordHeader header;
+    header.magic = kRecordMagic;
+    header.workload_key_size = workload_key.size();
+    header.target_size = target.size();
+    header.payload_size = payload.size();
+    header.key_hash = RecordKeyHash(workload_key, target);
+    header.cost = RecordCost(results[i]);
+    header.error_no = results[i]->error_no;
+    header.reserved = 0;
+    uint64_t size = sizeof(header) + workload_key.size() + target.size() + payload.size();
+    added.push_back({header.key_hash, header.cost, offset, header.error_no,
+                     static_cast<uint32_t>(size)});
+    offset += size;
+
+    data.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    data.append(workload_key);
+    data.append(target);
+    data.append(payload);
+  }
+
+  // The records go first, so that an index entry never refers to a partial record.
+  {
+    std::ofstream fout(filename, std::ofstream::binary | std::ofstream::app);
+    fout.write(data.data(), data.size());
+    ICHECK(fout) << "Cannot write " << filename;
+  }
+  std::string idx_filename = std::string(filename) + ".idx";
+  std::ofstream fout(idx_filename, std::ofstream::binary | std::ofstream::app);
+  fout.write(reinterpret_cast<const char*>(added.data()), added.size() * sizeof(IndexEntry));
+  ICHECK(fout) << "Cannot write " << idx_filename;
+  index_.insert(index_.end(), added.begin(), added.end());
+  index_size_ += added.size() * sizeof(IndexEntry);
+}
+
+std::pair<Array<MeasureInput>, Array<MeasureResult>> RecordDatabaseNode::QueryTopK(
+    const String& workload_key, const String& target, int k) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  RefreshIndex();
+  uint64_t key_hash = RecordKeyHash(workload_key, target);
+  std::vector<IndexEntry> candidates;
+  for (const IndexEntry& entry : index_) {
+    if (entry.key_hash == key_hash && entry.error_no == 0) {
+      candidates.push_back(entry);
+    }
+  }
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const IndexEntry& a, const IndexEntry& b) { return a.cost < b.cost; });
+  std::vector<IndexEntry> selected;
+  for (const IndexEntry& entry : candidates) {
+    if (static_cast<int>(selected.size()) >= k) break;
+    // Rule out hash collisions.
+    auto key = ReadKey(entry);
+    if (key.first == workload_key && key.second == target) {
+      selected.push_back(entry);
+    }
+  }
+  return ParseRecords(selected);
+}
+
+std::pair<Array<MeasureInput>, Array<MeasureResult>> RecordDatabaseNode::BestRecords() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  RefreshIndex();
+  std::unordered_map<uint64_t, size_t> best;
+  for (size_t i = 0; i < index_.size(); ++i) {
+    const IndexEntry& entry = index_[i];
+    if (entry.error_no != 0) continue;
+    auto it = best.find(entry.key_hash);
+    if (it == best.end()) {
+      best.emplace(entry.key_hash, i);
+    } else if (entry.cost < index_[it->second].cost) {
+      it->second = i;
+    }
+  }
+  std::vector<size_t> positions;
+  for (const auto& kv : best) {
+    positions.push_back(kv.second);
+  }
+  std::sort(positions.begin(), positions.end());
+  std::vector<IndexEntry> selected;
+  for (size_t i : positions) {
+    selected.push_back(index_[i]);
+  }
+  return ParseRecords(selected);
+}
+
+void RecordDatabaseNode::ExportJSON(std::ostream* os) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  RefreshIndex();
+  for (const IndexEntry& entry : index_) {
+    *os << ReadPayload(entry) << "\n";
+  }
+}
+
+int64_t RecordDatabaseNode::Size() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  RefreshIndex();
+  return index_.size();
+}
+
+RecordToDatabase::RecordToDatabase(String filename) {
+  auto node = make_object<RecordToDatabaseNode>();
+  node->database = RecordDatabase(std::move(filename));
+  data_ = std::move(node);
+}
+
+void RecordToDatabaseNode::Callback(const SearchPolicy& policy, const Array<MeasureInput>& inputs,
+                                    const Array<MeasureResult>& results) {
+  database->Append(inputs, results);
+}
+
+bool IsRecordDatabase(const std::string& filename) {
+  std::ifstream fin(filename, std::ifstream::binary);
+  return fin && CheckFileHeader(&fin, kDataMagic);
+}
+
 TVM_REGISTER_GLOBAL("auto_scheduler.RecordToFile").set_body_typed([](const String& filename) {
   return RecordToFile(filename);
 });
@@ -450,6 +864,57 @@ TVM_REGISTER_GLOBAL("auto_scheduler.SaveRecords")
       WriteMeasureRecords(&ofs, in, res);
     });
 
+TVM_REGISTER_GLOBAL("auto_scheduler.RecordDatabase").set_body_typed([](const String& filename) {
+  return RecordDatabase(filename);
+});
+
+TVM_REGISTER_GLOBAL("auto_scheduler.RecordDatabaseAppend")
+    .set_body_typed([](RecordDatabase database, Array<MeasureInput> inputs,
+                       Array<MeasureResult> results) { database->Append(inputs, results); });
+
+TVM_REGISTER_GLOBAL("auto_scheduler.RecordDatabaseQueryTopK")
+    .set_body_typed([](RecordDatabase database, String workload_key, String target, int k) {
+      const auto& res = database->QueryTopK(workload_key, target, k);
+      return Array<ObjectRef>{res.first, res.second};
+    });
+
+TVM_REGISTER_GLOBAL("auto_scheduler.RecordDatabaseBestRecords")
+    .set_body_typed([](RecordDatabase database) {
+      const auto& res = database->BestRecords();
+      return Array<ObjectRef>{res.first, res.second};
+    });
+
+TVM_REGISTER_GLOBAL("auto_scheduler.RecordDatabaseSize").set_body_typed([](RecordDatabase database) {
+  return database->Size();
+});
+
+TVM_REGISTER_GLOBAL("auto_scheduler.RecordToDatabase").set_body_typed([](const String& filename) {
+  return RecordToDatabase(filename);
+});
+
+TVM_REGISTER_GLOBAL("auto_scheduler.IsRecordDatabase").set_body_typed([](const String& filename) {
+  return IsRecordDatabase(filename);
+});
+
+TVM_REGISTER_GLOBAL("auto_scheduler.ConvertRecordsToDatabase")
+    .set_body_typed([](String log_file, String db_file) {
+      RecordReader reader(log_file);
+      RecordDatabase database(db_file);
+      const int batch_size = 4096;
+      while (true) {
+        auto batch = reader->ReadLines(batch_size);
+        if (batch.first.empty()) break;
+        database->Append(batch.first, batch.second);
+      }
+    });
+
+TVM_REGISTER_GLOBAL("auto_scheduler.ConvertDatabaseToRecords")
+    .set_body_typed([](String db_file, String log_file) {
+      ICHECK(IsRecordDatabase(db_file)) << db_file << " is not an auto_scheduler record database";
+      std::ofstream ofs(log_file, std::ofstream::app);
+      RecordDatabase(db_file)->ExportJSON(&ofs);
+    });
+
 TVM_REGISTER_GLOBAL("auto_scheduler.SerializeMeasureInput")
     .set_body_typed([](const MeasureInput& input) {
       std::ostringstream os;
@@ -22,6 +22,7 @@
  * \file driver_api.cc
  */
 #include <dmlc/thread_local.h>
+#include <tvm/arith/analyzer.h>
 #include <tvm/driver/driver_api.h>
 #include <tvm/ir/transform.h>
 #include <tvm/runtime/registry.h>
@@ -43,6 +44,7 @@ TVM_REGISTER_PASS_CONFIG_OPTION("tir.instrument_bound_checkers", Bool);
 TVM_REGISTER_PASS_CONFIG_OPTION("tir.disable_assert", Bool);
 TVM_REGISTER_PASS_CONFIG_OPTION("tir.disable_vectorize", Bool);
 TVM_REGISTER_PASS_CONFIG_OPTION("tir.add_lower_pass", Array<Array<ObjectRef>>);
+TVM_REGISTER_PASS_CONFIG_OPTION("tir.analyzer_cache_size", Integer);
 
 using runtime::PackedFunc;
 using runtime::TVMArgs;
@@ -261,7 +263,16 @@ Array<tvm::transform::Pass> CreatePassList(bool disable_loop_partition, bool for
 }
 
 IRModule LowerWithPassList(IRModule mod, Array<tvm::transform::Pass> pass_list) {
+  // Share the simplification results between the passes of the pipeline. Off by default
+  // until it pays off, see the AnalyzerCache lowering benchmark in tests/cpp.
+  int64_t cache_size = transform::PassContext::Current()
+                           ->GetConfig<Integer>("tir.analyzer_cache_size", Integer(0))
+                           .value();
   auto optimize = tvm::transform::Sequential(pass_list);
+  if (cache_size > 0) {
+    With<arith::AnalyzerCache> analyzer_cache(static_cast<size_t>(cache_size));
+    return optimize(std::move(mod));
+  }
   mod = optimize(std::move(mod));
   return mod;
 }
@@ -19,6 +19,7 @@
 /*!
  * \file src/node/structural_hash.cc
  */
+#include <tvm/ir/module.h>
 #include <tvm/node/functor.h>
 #include <tvm/node/node.h>
 #include <tvm/node/reflection.h>
@@ -28,7 +29,10 @@
 #include <tvm/runtime/registry.h>
 
 #include <algorithm>
+#include <memory>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "../support/str_escape.h"
 #include "../support/utils.h"
@@ -263,6 +267,261 @@ size_t StructuralHash::operator()(const ObjectRef& object) const {
   return VarCountingSHashHandler().Hash(object, false);
 }
 
+/*!
+ * \brief Hash handler computing the hash of every node from the cached hashes of
+ *  its children, see StructuralHashCache.
+ *
+ *  The hash of a node combines the values and the hashes of the children it
+ *  reduces, and the position of every variable of a child among the variables of
+ *  the node, in the order of their first occurrence. The variables of the children
+ *  defined by the node, i.e. hashed with DefHash, are local to the node, the
+ *  others are passed to its parent.
+ */
+class StructuralHashCache::Impl : public SHashReducer::Handler {
+ public:
+  /*! \brief The variables of a subtree which are not defined in it. */
+  using VarList = std::shared_ptr<const std::vector<ObjectRef>>;
+
+  /*! \brief The hash of a node and the variables it passes to its parent. */
+  struct Summary {
+    size_t hash;
+    VarList vars;
+  };
+
+  size_t Hash(const ObjectRef& object, bool map_free_vars) {
+    ICHECK(task_stack_.empty() && pending_.empty() && results_.empty());
+    this->SHashReduce(object, map_free_vars);
+    task_stack_.emplace_back(std::move(pending_.back()));
+    pending_.clear();
+    RunTasks();
+    ICHECK_EQ(results_.size(), 1U);
+    Item root = std::move(results_.back());
+    results_.clear();
+    return support::HashCombine(root.hash, root.vars ? root.vars->size() : 0);
+  }
+
+  size_t size() const { return cache_.size(); }
+
+  void Clear() { cache_.clear(); }
+
+  void SHashReduceHashedValue(size_t hashed_value) final {
+    pending_.emplace_back(Item::Value(hashed_value));
+  }
+
+  void SHashReduce(const ObjectRef& object, bool map_free_vars) final {
+    if (!object.defined()) {
+      pending_.emplace_back(Item::Value(0));
+      return;
+    }
+    Item item;
+    item.object = object;
+    item.map_free_vars = map_free_vars;
+    // Reducing with map_free_vars under a node which does not is a DefHash.
+    item.is_def = map_free_vars && !current_map_free_vars_;
+    pending_.emplace_back(std::move(item));
+  }
+
+  void SHashReduceFreeVar(const runtime::Object* var, bool map_free_vars) final {
+    Item item = Item::Value(0);
+    item.is_self_var = true;
+    pending_.emplace_back(std::move(item));
+  }
+
+  bool LookupHashedValue(const ObjectRef& key, size_t* hashed_value) final {
+    // Hashes of variables depend on the context, maps keyed by objects only hash their size.
+    return false;
+  }
+
+  void MarkGraphNode() final {}
+
+ private:
+  /*! \brief A reduced value or child, and then its result. */
+  struct Item {
+    /*! \brief The child, undefined for values. */
+    ObjectRef object;
+    /*! \brief The hash, set for values and once the child is reduced. */
+    size_t hash{0};
+    /*! \brief The variables of the reduced child. */
+    VarList vars;
+    bool map_free_vars{false};
+    /*! \brief Whether the child is hashed with DefHash. */
+    bool is_def{false};
+    /*! \brief Whether the item stands for the variable being reduced itself. */
+    bool is_self_var{false};
+    /*! \brief Whether the children of the object are pushed. */
+    bool children_expanded{false};
+    /*! \brief The location of the results of the children. */
+    size_t result_index{0};
+
+    static Item Value(size_t hash) {
+      Item item;
+      item.hash = hash;
+      return item;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const std::pair<const Object*, bool>& key) const {
+      return std::hash<const Object*>()(key.first) ^ static_cast<size_t>(key.second);
+    }
+  };
+
+  void RunTasks() {
+    while (!task_stack_.empty()) {
+      // Caution: entry becomes invalid when the stack changes
+      Item& entry = task_stack_.back();
+      if (!entry.object.defined()) {
+        results_.emplace_back(std::move(entry));
+        task_stack_.pop_back();
+      } else if (entry.children_expanded) {
+        Summary summary = Reduce(entry);
+        // Holding a reference does not protect nodes mutated in place from changes.
+        if (!entry.object->IsInstance<IRModuleNode>()) {
+          cache_[{entry.object.get(), entry.map_free_vars}] = {entry.object, summary};
+        }
+        entry.hash = summary.hash;
+        entry.vars = summary.vars;
+        entry.object = ObjectRef();
+        results_.emplace_back(std::move(entry));
+        task_stack_.pop_back();
+      } else {
+        auto it = cache_.find({entry.object.get(), entry.map_free_vars});
+        if (it != cache_.end()) {
+          entry.hash = it->second.second.hash;
+          entry.vars = it->second.second.vars;
+          entry.object = ObjectRef();
+          results_.emplace_back(std::move(entry));
+          task_stack_.pop_back();
+          continue;
+        }
+        // NOTE: important to modify entry before visit.
+        // as entry becomes invalid after we change the stack.
+        entry.children_expanded = true;
+        entry.result_index = results_.size();
+        ObjectRef object = entry.object;
+        ICHECK(pending_.empty());
+        current_map_free_vars_ = entry.map_free_vars;
+        vtable_->SHashReduce(object.get(), SHashReducer(this, entry.map_free_vars));
+        while (!pending_.empty()) {
+          task_stack_.emplace_back(std::move(pending_.back()));
+          pending_.pop_back();
+        }
+      }
+    }
+  }
+
+  /*! \brief Combine the results of the children of entry and pop them. */
+  Summary Reduce(const Item& entry) {
+    const size_t kVarMarker = 0x5f3759df;
+    const size_t kDefMarker = 0x9e3779b9;
+    size_t hash = entry.object->GetTypeKeyHash();
+    std::vector<ObjectRef> vars;
+    std::vector<bool> local;
+    // Nodes usually see few variables, only index them when there are many.
+    const size_t kMaxLinearSearch = 16;
+    std::unordered_map<const Object*, size_t> index;
+    auto position = [&](const ObjectRef& var, bool is_def) {
+      size_t pos = vars.size();
+      if (vars.size() <= kMaxLinearSearch) {
+        for (size_t i = 0; i < vars.size() && pos == vars.size(); ++i) {
+          if (vars[i].same_as(var)) pos = i;
+        }
+      } else {
+        auto it = index.find(var.get());
+        if (it != index.end()) pos = it->second;
+      }
+      if (pos == vars.size()) {
+        vars.push_back(var);
+        local.push_back(false);
+        if (vars.size() > kMaxLinearSearch) {
+          for (size_t i = index.size(); i < vars.size(); ++i) index[vars[i].get()] = i;
+        }
+      }
+      if (is_def) local[pos] = true;
+      return pos;
+    };
+    const VarList* largest = nullptr;
+    for (size_t i = entry.result_index; i < results_.size(); ++i) {
+      const Item& item = results_[i];
+      if (item.is_self_var) {
+        hash = support::HashCombine(hash, kVarMarker);
+        hash = support::HashCombine(hash, position(entry.object, false));
+        continue;
+      }
+      hash = support::HashCombine(hash, item.hash);
+      if (item.is_def) hash = support::HashCombine(hash, kDefMarker);
+      if (item.vars == nullptr) continue;
+      for (const ObjectRef& var : *item.vars) {
+        hash = support::HashCombine(hash, position(var, item.is_def));
+      }
+      if (!item.is_def && (largest == nullptr || (*largest)->size() < item.vars->size())) {
+        largest = &item.vars;
+      }
+    }
+    results_.resize(entry.result_index);
+
+    Summary summary{hash, nullptr};
+    if (std::find(local.begin(), local.end(), true) == local.end() && largest != nullptr &&
+        **largest == vars) {
+      // Share the list with the child passing the same variables.
+      summary.vars = *largest;
+    } else {
+      std::vector<ObjectRef> passed;
+      for (size_t i = 0; i < vars.size(); ++i) {
+        if (!local[i]) passed.push_back(vars[i]);
+      }
+      if (!passed.empty()) {
+        summary.vars = std::make_shared<const std::vector<ObjectRef>>(std::move(passed));
+      }
+    }
+    return summary;
+  }
+
+  /*! \brief The cached summaries, keyed by the node and map_free_vars. */
+  std::unordered_map<std::pair<const Object*, bool>, std::pair<ObjectRef, Summary>, KeyHash>
+      cache_;
+  // whether the node being expanded maps free variables.
+  bool current_map_free_vars_{false};
+  // list of pending items pushed by the node being expanded.
+  std::vector<Item> pending_;
+  // Internal task stack to executed the task
+  std::vector<Item> task_stack_;
+  // Internal stack to store the results of the children.
+  std::vector<Item> results_;
+  // reflection vtable
+  ReflectionVTable* vtable_ = ReflectionVTable::Global();
+};
+
+StructuralHashCache::StructuralHashCache() : impl_(new Impl()) {}
+
+StructuralHashCache::~StructuralHashCache() = default;
+
+size_t StructuralHashCache::operator()(const ObjectRef& key, bool map_free_vars) {
+  return impl_->Hash(key, map_free_vars);
+}
+
+size_t StructuralHashCache::size() const { return impl_->size(); }
+
+void StructuralHashCache::Clear() { impl_->Clear(); }
+
+TVM_REGISTER_GLOBAL("node.CreateStructuralHashCache").set_body_typed([]() {
+  auto self = std::make_shared<StructuralHashCache>();
+  auto f = [self](std::string name) -> PackedFunc {
+    if (name == "hash") {
+      return PackedFunc([self](TVMArgs args, TVMRetValue* ret) {
+        *ret = static_cast<int64_t>((*self)(args[0], args[1]));
+      });
+    } else if (name == "size") {
+      return PackedFunc(
+          [self](TVMArgs args, TVMRetValue* ret) { *ret = static_cast<int64_t>(self->size()); });
+    } else if (name == "clear") {
+      return PackedFunc([self](TVMArgs args, TVMRetValue* ret) { self->Clear(); });
+    }
+    return PackedFunc();
+  };
+  return runtime::TypedPackedFunc<PackedFunc(std::string)>(f);
+});
+
 // SEQualReduce traits for runtime containers.
 struct StringObjTrait {
   static constexpr const std::nullptr_t VisitAttrs = nullptr;
@@ -529,6 +788,19 @@ TVM_STATIC_IR_FUNCTOR(ReprPrinter, vtable)
       auto* op = static_cast<const runtime::profiling::CountNode*>(node.get());
       p->stream << op->GetTypeKey() << "(" << op->value << ")";
     });
+struct BytesNodeTrait {
+  static void VisitAttrs(runtime::profiling::BytesNode* n, AttrVisitor* attrs) {
+    attrs->Visit("bytes", &n->bytes);
+  }
+  static constexpr std::nullptr_t SEqualReduce = nullptr;
+  static constexpr std::nullptr_t SHashReduce = nullptr;
+};
+TVM_REGISTER_REFLECTION_VTABLE(runtime::profiling::BytesNode, BytesNodeTrait);
+TVM_STATIC_IR_FUNCTOR(ReprPrinter, vtable)
+    .set_dispatch<runtime::profiling::BytesNode>([](const ObjectRef& node, ReprPrinter* p) {
+      auto* op = static_cast<const runtime::profiling::BytesNode*>(node.get());
+      p->stream << op->GetTypeKey() << "(" << op->bytes << ")";
+    });
 struct DurationNodeTrait {
   static void VisitAttrs(runtime::profiling::DurationNode* n, AttrVisitor* attrs) {
     attrs->Visit("microseconds", &n->microseconds);
@@ -0,0 +1,311 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file relay/backend/compile_cache.cc
+ * \brief Persistent cache of lowered primitive functions shared by processes.
+ */
+#include "compile_cache.h"
+
+#include <tvm/ir/transform.h>
+#include <tvm/node/serialization.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/te/operation.h>
+#include <tvm/tir/function.h>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../../runtime/file_utils.h"
+
+namespace tvm {
+namespace relay {
+
+static constexpr const char* kCompileCacheDir = "relay.backend.compile_cache_dir";
+static constexpr const char* kCompileCacheMaxMB = "relay.backend.compile_cache_max_mb";
+
+TVM_REGISTER_PASS_CONFIG_OPTION(kCompileCacheDir, String);
+TVM_REGISTER_PASS_CONFIG_OPTION(kCompileCacheMaxMB, Integer);
+
+#ifndef _WIN32
+
+namespace {
+
+/*! \brief Placeholders with the shapes and types of tensors, all that is kept of them. */
+Array<te::Tensor> ToPlaceholders(const Array<te::Tensor>& tensors) {
+  Array<te::Tensor> ret;
+  for (const te::Tensor& tensor : tensors) {
+    ret.push_back(te::placeholder(tensor->shape, tensor->dtype, tensor->op->name));
+  }
+  return ret;
+}
+
+/*!
+ * \brief Whether a pass config value can be part of a key. Passes, as set by
+ *  `tir.add_lower_pass`, have no structural hash and change the lowering in ways a key
+ *  cannot capture.
+ */
+bool IsKeyableConfig(const ObjectRef& value) {
+  if (!value.defined() || value->IsInstance<IntImmNode>() || value->IsInstance<FloatImmNode>() ||
+      value->IsInstance<runtime::StringObj>() || value->IsInstance<BaseAttrsNode>()) {
+    return true;
+  }
+  if (const auto* arr = value.as<ArrayNode>()) {
+    return std::all_of(arr->begin(), arr->end(), IsKeyableConfig);
+  }
+  if (const auto* map = value.as<MapNode>()) {
+    return std::all_of(map->begin(), map->end(), [](const auto& kv) {
+      return IsKeyableConfig(kv.first) && IsKeyableConfig(kv.second);
+    });
+  }
+  return false;
+}
+
+/*!
+ * \brief Identify the tuning records the schedules are picked from, through the frontend.
+ * \param key The identity of the tuning context, empty when no records are used.
+ * \return Whether the tuning context can be identified.
+ */
+bool GetTuningContextKey(std::string* key) {
+  key->clear();
+  const auto* f = runtime::Registry::Get("relay.backend._tuning_context_key");
+  if (f == nullptr) return true;
+  runtime::TVMRetValue ret = (*f)();
+  if (ret.type_code() == kTVMNullptr) return false;
+  *key = ret.operator std::string();
+  return true;
+}
+
+}  // namespace
+
+PersistentCompileCache::PersistentCompileCache(std::string dir, int64_t max_bytes)
+    : dir_(std::move(dir)), max_bytes_(max_bytes) {
+  // Create the directory and its parents.
+  for (size_t pos = dir_.find('/', 1); true; pos = dir_.find('/', pos + 1)) {
+    std::string prefix = dir_.substr(0, pos);
+    if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+      LOG(FATAL) << "Cannot create the compile cache directory " << prefix << ": "
+                 << strerror(errno);
+    }
+    if (pos == std::string::npos) break;
+  }
+}
+
+std::pair<std::string, std::string> PersistentCompileCache::Locate(const CCacheKey& key) const {
+  // Everything besides the function that changes how it is lowered.
+  transform::PassContext pass_ctx = transform::PassContext::Current();
+  Map<String, ObjectRef> config;
+  for (const auto& kv : pass_ctx->config) {
+    if (kv.first != kCompileCacheDir && kv.first != kCompileCacheMaxMB) {
+      config.Set(kv.first, kv.second);
+    }
+  }
+  std::string tuning_key;
+  GetTuningContextKey(&tuning_key);
+  std::ostringstream context;
+  context << TVM_VERSION << " " << key->target->str() << " " << pass_ctx->opt_level << " "
+          << StructuralHash()(config) << " " << StructuralHash()(pass_ctx->required_pass) << " "
+          << StructuralHash()(pass_ctx->disabled_pass) << " " << tuning_key;
+  size_t hash = dmlc::HashCombine(StructuralHash()(key->source_func),
+                                  std::hash<std::string>()(context.str()));
+  std::ostringstream path;
+  path << dir_ << "/" << std::hex << std::setw(16) << std::setfill('0') << hash << ".json";
+  return {path.str(), context.str()};
+}
+
+CachedFunc PersistentCompileCache::Load(const CCacheKey& key,
+                                        const std::function<std::string(std::string)>& make_name) {
+  std::string path, context;
+  std::tie(path, context) = Locate(key);
+  std::ifstream fin(path, std::ios::in | std::ios::binary);
+  if (!fin) return CachedFunc();
+  std::stringstream json;
+  json << fin.rdbuf();
+  fin.close();
+
+  Map<String, ObjectRef> entry;
+  try {
+    entry = Downcast<Map<String, ObjectRef>>(LoadJSON(json.str()));
+    if (Downcast<String>(entry.at("context")) != context ||
+        !StructuralEqual()(entry.at("source"), key->source_func)) {
+      return CachedFunc();
+    }
+  } catch (const Error& e) {
+    LOG(WARNING) << "Ignore the unreadable compile cache entry " << path << ": " << e.what();
+    return CachedFunc();
+  }
+  // A hit makes the entry the most recently used one.
+  utime(path.c_str(), nullptr);
+
+  auto cache_node = make_object<CachedFuncNode>();
+  cache_node->target = key->target;
+  cache_node->func_name = make_name(Downcast<String>(entry["name"]));
+  cache_node->inputs = Downcast<Array<te::Tensor>>(entry["inputs"]);
+  cache_node->outputs = Downcast<Array<te::Tensor>>(entry["outputs"]);
+  // The function is renamed after the one of this process.
+  String stored_name = Downcast<String>(entry["func_name"]);
+  for (const auto& kv : Downcast<IRModule>(entry["funcs"])->functions) {
+    if (kv.first->name_hint == stored_name && kv.second->IsInstance<tir::PrimFuncNode>()) {
+      tir::PrimFunc func = WithAttr(Downcast<tir::PrimFunc>(kv.second), tvm::attr::kGlobalSymbol,
+                                    String(cache_node->func_name));
+      cache_node->funcs->Add(GlobalVar(cache_node->func_name), func);
+    } else {
+      cache_node->funcs->Add(kv.first, kv.second);
+    }
+  }
+  return CachedFunc(cache_node);
+}
+
+void PersistentCompileCache::Store(const CCacheKey& key, const CachedFunc& cfunc,
+                                   const std::string& base_name) {
+  std::string path, context;
+  std::tie(path, context) = Locate(key);
+  Map<String, ObjectRef> entry;
+  entry.Set("context", String(context));
+  entry.Set("source", key->source_func);
+  entry.Set("name", String(base_name));
+  entry.Set("func_name", String(cfunc->func_name));
+  entry.Set("funcs", cfunc->funcs);
+  entry.Set("inputs", ToPlaceholders(cfunc->inputs));
+  entry.Set("outputs", ToPlaceholders(cfunc->outputs));
+  std::string json = SaveJSON(entry);
+
+  // Readers only ever see complete entries.
+  std::ostringstream tmp_path;
+  tmp_path << path << ".tmp" << getpid();
+  runtime::SaveBinaryToFile(tmp_path.str(), json);
+  if (std::rename(tmp_path.str().c_str(), path.c_str()) != 0) {
+    LOG(WARNING) << "Cannot write the compile cache entry " << path << ": " << strerror(errno);
+    std::remove(tmp_path.str().c_str());
+    return;
+  }
+
+  bytes_since_evict_ += json.size();
+  if (!evicted_ || bytes_since_evict_ > max_bytes_ / 16) {
+    Evict();
+    evicted_ = true;
+    bytes_since_evict_ = 0;
+  }
+}
+
+void PersistentCompileCache::Evict() {
+  struct Entry {
+    time_t mtime;
+    int64_t size;
+    std::string path;
+  };
+  std::vector<Entry> entries;
+  int64_t total = 0;
+  DIR* dir = opendir(dir_.c_str());
+  if (dir == nullptr) return;
+  while (dirent* item = readdir(dir)) {
+    std::string name = item->d_name;
+    if (name.size() < 5 || name.compare(name.size() - 5, 5, ".json") != 0) continue;
+    std::string path = dir_ + "/" + name;
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) continue;
+    entries.push_back({info.st_mtime, static_cast<int64_t>(info.st_size), path});
+    total += info.st_size;
+  }
+  closedir(dir);
+  if (total <= max_bytes_) return;
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) { return a.mtime < b.mtime; });
+  for (const Entry& entry : entries) {
+    if (total <= max_bytes_) break;
+    // Another process may have removed it already.
+    std::remove(entry.path.c_str());
+    total -= entry.size;
+  }
+}
+
+PersistentCompileCache* PersistentCompileCache::Current() {
+  transform::PassContext pass_ctx = transform::PassContext::Current();
+  std::string dir = pass_ctx->GetConfig<String>(kCompileCacheDir, String("")).value();
+  if (dir.empty()) {
+    const char* env = std::getenv("TVM_COMPILE_CACHE_DIR");
+    if (env == nullptr || env[0] == '\0') return nullptr;
+    dir = env;
+  }
+  int64_t max_mb = pass_ctx->GetConfig<Integer>(kCompileCacheMaxMB, Integer(1024)).value()->value;
+  // Instruments expect the lowering passes to run.
+  if (!pass_ctx->instruments.empty()) return nullptr;
+  for (const auto& kv : pass_ctx->config) {
+    if (!IsKeyableConfig(kv.second)) return nullptr;
+  }
+  std::string tuning_key;
+  if (!GetTuningContextKey(&tuning_key)) return nullptr;
+
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::unique_ptr<PersistentCompileCache>> caches;
+  std::lock_guard<std::mutex> lock(mutex);
+  std::unique_ptr<PersistentCompileCache>& cache = caches[dir];
+  if (cache == nullptr) {
+    cache.reset(new PersistentCompileCache(dir, max_mb << 20));
+  }
+  cache->max_bytes_ = max_mb << 20;
+  return cache.get();
+}
+
+#else
+
+PersistentCompileCache::PersistentCompileCache(std::string dir, int64_t max_bytes)
+    : dir_(std::move(dir)), max_bytes_(max_bytes) {}
+
+CachedFunc PersistentCompileCache::Load(const CCacheKey& key,
+                                        const std::function<std::string(std::string)>& make_name) {
+  return CachedFunc();
+}
+
+void PersistentCompileCache::Store(const CCacheKey& key, const CachedFunc& cfunc,
+                                   const std::string& base_name) {}
+
+PersistentCompileCache* PersistentCompileCache::Current() {
+  if (!transform::PassContext::Current()
+           ->GetConfig<String>(kCompileCacheDir, String(""))
+           .value()
+           .empty()) {
+    LOG(WARNING) << "The persistent compile cache is not supported on Windows";
+  }
+  return nullptr;
+}
+
+#endif
+
+}  // namespace relay
+}  // namespace tvm
@@ -0,0 +1,105 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file relay/backend/compile_cache.h
+ * \brief Persistent cache of lowered primitive functions shared by processes.
+ */
+#ifndef TVM_RELAY_BACKEND_COMPILE_CACHE_H_
+#define TVM_RELAY_BACKEND_COMPILE_CACHE_H_
+
+#include <functional>
+#include <string>
+
+#include "compile_engine.h"
+
+namespace tvm {
+namespace relay {
+
+/*!
+ * \brief A cache of lowered primitive functions kept in a directory, so that a process reuses
+ *  what earlier processes lowered.
+ *
+ *  An entry is a json file named after the structural hash of the primitive function combined
+ *  with the target, the pass context and the TVM version. It holds the function itself, so that
+ *  a hash collision is detected with a structural equality check, the lowered IRModule and the
+ *  shapes of the inputs and outputs. The schedule is not kept.
+ *
+ *  Writers create entries under a temporary name and rename them in place, so readers of other
+ *  processes never see a partial entry. A hit refreshes the modification time of the entry, and
+ *  the least recently used entries are removed once the directory grows over its size limit.
+ *
+ *  The key includes the tuning records the schedules are picked from, as identified by the
+ *  frontend. The cache is not used while the pass context holds instruments or values without
+ *  a structural hash, such as `tir.add_lower_pass`, or while the tuning context cannot be
+ *  identified. The compile engine serializes the calls to a cache.
+ */
+class PersistentCompileCache {
+ public:
+  /*!
+   * \brief Open the cache in a directory, created if it does not exist.
+   * \param dir The directory.
+   * \param max_bytes The maximum total size of the entries.
+   */
+  PersistentCompileCache(std::string dir, int64_t max_bytes);
+
+  /*!
+   * \brief Look up the lowered function of a key.
+   * \param key The key of the primitive function.
+   * \param make_name Make the name of the function from the one it was created with.
+   * \return The lowered function, undefined on a miss.
+   */
+  CachedFunc Load(const CCacheKey& key, const std::function<std::string(std::string)>& make_name);
+
+  /*!
+   * \brief Store the lowered function of a key.
+   * \param key The key of the primitive function.
+   * \param cfunc The lowered function.
+   * \param base_name The name of the function before it was made unique in this process.
+   */
+  void Store(const CCacheKey& key, const CachedFunc& cfunc, const std::string& base_name);
+
+  /*!
+   * \brief Get the cache configured by the current pass context with
+   *  `relay.backend.compile_cache_dir`, or by the environment variable TVM_COMPILE_CACHE_DIR.
+   * \return The cache, nullptr when none is configured or the current contexts cannot be part
+   *  of a key.
+   */
+  static PersistentCompileCache* Current();
+
+ private:
+  /*! \brief The file name and the context string of the entry of a key. */
+  std::pair<std::string, std::string> Locate(const CCacheKey& key) const;
+  /*! \brief Remove the least recently used entries until the directory fits its limit. */
+  void Evict();
+
+  /*! \brief The directory of the entries. */
+  std::string dir_;
+  /*! \brief The maximum total size of the entries. */
+  int64_t max_bytes_;
+  /*! \brief The bytes written since the last eviction. */
+  int64_t bytes_since_evict_{0};
+  /*! \brief Whether the directory has been checked against its limit. */
+  bool evicted_{false};
+};
+
+}  // namespace relay
+}  // namespace tvm
+
+#endif  // TVM_RELAY_BACKEND_COMPILE_CACHE_H_
@@ -32,6 +32,7 @@
 #include <tvm/relay/op.h>
 #include <tvm/relay/op_attr_types.h>
 #include <tvm/runtime/registry.h>
+#include <tvm/support/parallel_for.h>
 #include <tvm/te/operation.h>
 #include <tvm/te/schedule.h>
 #include <tvm/te/schedule_pass.h>
@@ -40,12 +41,15 @@
 #include <functional>
 #include <limits>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "../../runtime/meta_data.h"
 #include "../transforms/pass_utils.h"
+#include "compile_cache.h"
 #include "utils.h"
 
 namespace tvm {
@@ -616,6 +620,51 @@ class CompileEngineImpl : public CompileEngineNode {
     return LowerInternal(key, mangle_fn)->cached_func;
   }
 
+  Array<CachedFunc> LowerBatch(const Array<CCacheKey>& keys,
+                               std::function<String(String)> mangle_fn) final {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<CCacheValue> values;
+    std::vector<PendingLower> pending;
+    std::unordered_set<const Object*> prepared;
+    for (const CCacheKey& key : keys) {
+      // The callers look the functions up again, which counts their uses.
+      CCacheValue value = GetCacheValue(key, true);
+      values.push_back(value);
+      if (value->cached_func.defined() || prepared.count(value.get())) continue;
+      PendingLower item;
+      if (PrepareLower(key, value, mangle_fn, &item)) {
+        prepared.insert(value.get());
+        pending.push_back(std::move(item));
+      }
+    }
+    // Only the schedules call back into the frontend, unless lower passes or instruments
+    // are set in the pass context, which then have to run on this thread.
+    using tvm::transform::PassContext;
+    PassContext pass_ctx = PassContext::Current();
+    int num_threads = pass_ctx->GetConfig<Integer>("relay.backend.lower_num_threads", Integer(0))
+                          .value()
+                          ->value;
+    if (num_threads <= 0) {
+      num_threads = std::thread::hardware_concurrency();
+    }
+    if (!pass_ctx->instruments.empty() || pass_ctx->config.count("tir.add_lower_pass")) {
+      num_threads = 1;
+    }
+    support::parallel_for_dynamic(0, pending.size(), num_threads, [&](int thread_id, int i) {
+      With<PassContext> pass_ctx_scope(pass_ctx);
+      With<Target> target_scope(pending[i].key->target);
+      LowerPending(&pending[i]);
+    });
+    for (PendingLower& item : pending) {
+      PublishPending(&item);
+    }
+    Array<CachedFunc> ret;
+    for (const CCacheValue& value : values) {
+      ret.push_back(value->cached_func);
+    }
+    return ret;
+  }
+
   // For now, build one module per function.
   PackedFunc JIT(const CCacheKey& key) final {
     auto mangle_fn = [](String name) { return name; };
@@ -716,19 +765,43 @@ class CompileEngineImpl : public CompileEngineNode {
   // implement lowered func
   CCacheValue LowerInternal(const CCacheKey& key, std::function<String(String)> mangle_fn) {
     std::lock_guard<std::mutex> lock(mutex_);
+    CCacheValue value = GetCacheValue(key);
+    if (value->cached_func.defined()) return value;
+    PendingLower pending;
+    if (PrepareLower(key, value, mangle_fn, &pending)) {
+      With<Target> target_scope(key->target);
+      LowerPending(&pending);
+      PublishPending(&pending);
+    }
+    return value;
+  }
+  /*! \brief A function whose schedule is created and which remains to be lowered to TIR. */
+  struct PendingLower {
+    CCacheKey key;
     CCacheValue value;
+    /*! \brief The result of CreateSchedule, with the name before mangling. */
+    CachedFunc cfunc;
+    /*! \brief The lowered function being built. */
+    ObjectPtr<CachedFuncNode> cache_node;
+  };
+  // Find the cache entry of key or create it, mutex_ must be held. Prefetched entries are
+  // not used yet, the first lookup of one counts as its creation.
+  CCacheValue GetCacheValue(const CCacheKey& key, bool prefetch = false) {
     auto it = cache_.find(key);
     if (it != cache_.end()) {
-      it->second->use_count += 1;
-      if (it->second->cached_func.defined()) return it->second;
-      value = it->second;
-    } else {
-      value = CCacheValue(make_object<CCacheValueNode>());
-      value->use_count = 0;
-      if (!backend::IsCompileEngineCacheDisabled()) {
-        cache_[key] = value;
-      }
+      if (!prefetch) it->second->use_count += 1;
+      return it->second;
     }
+    CCacheValue value = CCacheValue(make_object<CCacheValueNode>());
+    value->use_count = prefetch ? -1 : 0;
+    if (!backend::IsCompileEngineCacheDisabled()) {
+      cache_[key] = value;
+    }
+    return value;
+  }
+  // Create the schedule and the name of the function, return false when value is complete.
+  bool PrepareLower(const CCacheKey& key, CCacheValue value,
+                    std::function<String(String)> mangle_fn, PendingLower* pending) {
     cur_ccache_key_ = key;
 
     // No need to lower external functions for now. We will invoke the external
@@ -741,12 +814,18 @@ class CompileEngineImpl : public CompileEngineNode {
       cache_node->target = Target("ext_dev");
       cache_node->funcs->Add(GlobalVar(cache_node->func_name), key->source_func);
       value->cached_func = CachedFunc(cache_node);
-      return value;
+      return false;
     }
     // Enforce use the target.
     With<Target> target_scope(key->target);
 
     ICHECK(!value->cached_func.defined());
+    PersistentCompileCache* disk_cache = PersistentCompileCache::Current();
+    if (disk_cache != nullptr) {
+      value->cached_func = disk_cache->Load(
+          key, [&](std::string name) { return GetUniqueName(mangle_fn(name)); });
+      if (value->cached_func.defined()) return false;
+    }
     auto cfunc = CreateSchedule(key->source_func, key->target);
     auto cache_node = make_object<CachedFuncNode>(*(cfunc.operator->()));
 
@@ -755,11 +834,19 @@ class CompileEngineImpl : public CompileEngineNode {
     if (const CallNode* call_node = body.as<CallNode>()) {
       if (call_node->attrs.as<DeviceCopyAttrs>()) {
         value->cached_func = CachedFunc(cache_node);
-        return value;
+        return false;
       }
     }
     cache_node->func_name = GetUniqueName(mangle_fn(cache_node->func_name));
-
+    pending->key = key;
+    pending->value = value;
+    pending->cfunc = cfunc;
+    pending->cache_node = cache_node;
+    return true;
+  }
+  // Lower the schedule to TIR in the target scope, touches no state of the engine.
+  void LowerPending(PendingLower* pending) {
+    auto& cache_node = pending->cache_node;
     // NOTE: array will copy on write.
     Array<te::Tensor> all_args = cache_node->inputs;
     for (te::Tensor arg : cache_node->outputs) {
@@ -767,10 +854,16 @@ class CompileEngineImpl : public CompileEngineNode {
     }
     // lower the function
     std::unordered_map<te::Tensor, tir::Buffer> binds;
-    cache_node->funcs = tvm::LowerSchedule(cfunc->schedule, all_args, cache_node->func_name, binds);
-
-    value->cached_func = CachedFunc(cache_node);
-    return value;
+    cache_node->funcs =
+        tvm::LowerSchedule(pending->cfunc->schedule, all_args, cache_node->func_name, binds);
+  }
+  // Publish the lowered function in the cache entry and the persistent cache.
+  void PublishPending(PendingLower* pending) {
+    pending->value->cached_func = CachedFunc(pending->cache_node);
+    PersistentCompileCache* disk_cache = PersistentCompileCache::Current();
+    if (disk_cache != nullptr) {
+      disk_cache->Store(pending->key, pending->value->cached_func, pending->cfunc->func_name);
+    }
   }
   // implement lowered shape func
   CCacheValue LowerShapeFuncInternal(const CCacheKey& key) {
@@ -853,6 +946,7 @@ CompileEngine& CompileEngine::Global() {
 
 TVM_REGISTER_PASS_CONFIG_OPTION("relay.backend.use_auto_scheduler", Bool);
 TVM_REGISTER_PASS_CONFIG_OPTION("relay.backend.disable_compile_engine_cache", Bool);
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.backend.lower_num_threads", Integer);
 
 TVM_REGISTER_GLOBAL("relay.backend._make_LoweredOutput")
     .set_body_typed([](tvm::Array<te::Tensor> outputs, OpImplementation impl) {
@@ -203,6 +203,18 @@ class CompileEngineNode : public Object {
    * \return The result.
    */
   virtual CachedFunc Lower(const CCacheKey& key, std::function<String(String)> mangle_fn) = 0;
+  /*!
+   * \brief Lower several functions at once, the results are cached like the ones of Lower.
+   *
+   *  The schedules and names are created serially in the order of the keys, then the
+   *  schedules are lowered to TIR concurrently, so the result does not depend on the
+   *  number of threads.
+   * \param keys The keys to the cached functions.
+   * \param mangle_fn The function to mangle the names of the functions.
+   * \return The results, in the order of the keys.
+   */
+  virtual Array<CachedFunc> LowerBatch(const Array<CCacheKey>& keys,
+                                       std::function<String(String)> mangle_fn) = 0;
   /*!
    * \brief Just in time compile to get a PackedFunc.
    * \param key The key to the cached function.
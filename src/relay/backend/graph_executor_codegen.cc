@@ -25,6 +25,7 @@
 #include <dmlc/any.h>
 #include <dmlc/json.h>
 #include <tvm/ir/module.h>
+#include <tvm/relay/analysis.h>
 #include <tvm/relay/expr_functor.h>
 #include <tvm/runtime/device_api.h>
 #include <tvm/runtime/object.h>
@@ -280,6 +281,7 @@ class GraphExecutorCodegen : public backend::MemoizedExprTranslator<std::vector<
       auto node_ptr = GraphInputNode::make_node_ptr(param->name_hint(), GraphAttrs());
       var_map_[param.get()] = AddNode(node_ptr, param);
     }
+    LowerPrimitiveFunctions(func);
     heads_ = VisitExpr(func->body);
     std::ostringstream os;
     dmlc::JSONWriter writer(&os);
@@ -443,6 +445,37 @@ class GraphExecutorCodegen : public backend::MemoizedExprTranslator<std::vector<
     return lhs_storage_id == rhs_storage_id;
   }
 
+  /*!
+   * \brief Lower the primitive functions called by func at once, so that the TIR lowering of
+   *  the functions runs concurrently. The graph construction then finds them in the cache of
+   *  the compile engine.
+   * \param func The main function.
+   */
+  void LowerPrimitiveFunctions(const Function& func) {
+    if (backend::IsCompileEngineCacheDisabled()) return;
+    Array<CCacheKey> keys;
+    PostOrderVisit(func->body, [&](const Expr& expr) {
+      const auto* call = expr.as<CallNode>();
+      if (call == nullptr) return;
+      const auto* prim_func = call->op.as<FunctionNode>();
+      // Mirror the cases of VisitExpr_(const CallNode*) which lower the function.
+      if (prim_func == nullptr || !prim_func->HasNonzeroAttr(attr::kPrimitive) ||
+          prim_func->GetAttr<String>(attr::kCompiler).defined() ||
+          !storage_device_map_.count(expr)) {
+        return;
+      }
+      if (prim_func->HasNonzeroAttr(attr::kReshapeOnly) && ShareSameStorage(expr, call->args[0])) {
+        return;
+      }
+      auto call_dev_type = storage_device_map_[expr][1][0]->value;
+      keys.push_back(CCacheKey(GetRef<Function>(prim_func), GetTargetFromInteger(call_dev_type)));
+    });
+    String mod_name = mod_name_;
+    compile_engine_->LowerBatch(keys, [mod_name](String name) {
+      return runtime::get_name_mangled(mod_name, name);
+    });
+  }
+
   /*!
    * \brief Obtain the Target from the device type.
    * If homogenous compilation, this will return the only target.
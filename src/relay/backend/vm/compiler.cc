@@ -59,12 +59,7 @@ namespace transform {
 Pass LambdaLift();
 Pass InlinePrimitives();
 Pass LabelOps();
-
-Pass MemoryPlan() {
-  auto f = tvm::runtime::Registry::Get("relay.transform.MemoryPlan");
-  ICHECK(f != nullptr) << "unable to load the memory planning pass";
-  return (*f)();
-}
+Pass VMPlanMemory();
 
 Pass LiftConstants() {
   auto f = tvm::runtime::Registry::Get("relay.transform.LiftConstants");
@@ -1002,11 +997,9 @@ transform::Sequential MemoryOpt(tvm::Target host_target, TargetsMap targets) {
   // Fuse the shape functions.
   pass_seqs.push_back(transform::FuseOps());
 
-  // TODO(mbrookhart, jroesch, masahi): this pass is very slow, and is
-  // incomplete to provide memory resuse optimizations. Disable it until we can
-  // rewrite it in C++ and complete it.
-  // // Perform memory planning in order to coalesce/reduce allocations.
-  // pass_seqs.push_back(transform::MemoryPlan());
+  // Coalesce storages with disjoint lifetimes into arenas to reduce the
+  // number of allocations performed per invocation.
+  pass_seqs.push_back(transform::VMPlanMemory());
 
   // Compute away constant computation introduced by coalescing allocations.
   pass_seqs.push_back(transform::FoldConstant());
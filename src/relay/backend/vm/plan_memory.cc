@@ -0,0 +1,448 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file tvm/relay/backend/vm/plan_memory.cc
+ * \brief Ahead-of-time storage planning for VM functions.
+ *
+ * After ManifestAlloc every primitive call in a VM function allocates
+ * its outputs from a fresh memory.alloc_storage. This pass performs a
+ * liveness analysis over each let-chain and packs the storages whose
+ * lifetimes do not overlap into a single arena, rewriting every
+ * memory.alloc_tensor to use the arena plus a static offset. It plays
+ * the same role for the VM that GraphPlanMemory plays for the graph
+ * executor.
+ *
+ * Storage with a symbolic size is only planned when an upper bound can
+ * be derived for it. The bound comes from the static type of the tensor
+ * allocated from it with every dynamic dimension replaced by the
+ * "relay.VMPlanMemory.any_dim_upper_bound" hint. Such storages are never
+ * packed next to storages that are live at the same time: they only share
+ * an arena with storages of disjoint lifetimes, all placed at offset zero.
+ * The runtime only checks that a tensor fits into the whole arena, which
+ * then also proves that it did not overrun a live neighbour, so a
+ * violated hint results in an error rather than in silent corruption.
+ */
+
+#include <tvm/ir/transform.h>
+#include <tvm/relay/analysis.h>
+#include <tvm/relay/attrs/memory.h>
+#include <tvm/relay/expr.h>
+#include <tvm/relay/expr_functor.h>
+#include <tvm/relay/transform.h>
+#include <tvm/runtime/logging.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../../op/memory/memory.h"
+#include "../../transforms/pattern_utils.h"
+
+namespace tvm {
+namespace relay {
+namespace vm {
+
+/*! \brief Planning information of a single memory.alloc_storage. */
+struct StorageEntry {
+  /*! \brief The variable the storage is bound to. */
+  Var var;
+  /*! \brief Index of the binding which allocates the storage. */
+  size_t def;
+  /*! \brief Index of the last binding which may touch the storage. */
+  size_t last_use;
+  /*! \brief Size in bytes, or -1 when the size is symbolic. */
+  int64_t size;
+  /*! \brief Alignment in bytes. */
+  int64_t alignment;
+  /*! \brief The device the storage lives on. */
+  Device device;
+  /*! \brief The dtype hint of the storage. */
+  DataType dtype;
+  /*! \brief Bindings of the memory.alloc_tensor calls backed by this storage. */
+  std::vector<size_t> tensors;
+  /*! \brief Whether the size was derived from an upper-bound hint. */
+  bool bounded{false};
+  /*! \brief Whether the storage can be moved into an arena. */
+  bool plannable{true};
+  /*! \brief Offset of the storage inside its arena. */
+  int64_t offset{0};
+};
+
+/*! \brief Try to read an integer scalar out of a constant. */
+bool GetConstInt(const Expr& expr, int64_t* value) {
+  const auto* constant = expr.as<ConstantNode>();
+  if (constant == nullptr || !constant->is_scalar()) return false;
+  auto scalar = TryToScalar(constant->data);
+  if (!scalar) return false;
+  *value = static_cast<int64_t>(scalar.value());
+  return true;
+}
+
+/*!
+ * \brief Plan the storages of every let-chain in a VM function.
+ *
+ * Only storages allocated and consumed by memory.alloc_tensor within the
+ * same let-chain are considered; storages that are captured by closures
+ * or referenced directly by anything else are left untouched.
+ */
+class StoragePlanner : public ExprMutator {
+ public:
+  explicit StoragePlanner(int64_t any_dim_upper_bound)
+      : any_dim_upper_bound_(any_dim_upper_bound) {}
+
+  Expr VisitExpr_(const FunctionNode* func_node) final {
+    if (func_node->HasNonzeroAttr(attr::kPrimitive)) {
+      return GetRef<Function>(func_node);
+    }
+    return ExprMutator::VisitExpr_(func_node);
+  }
+
+  Expr VisitExpr_(const LetNode* let_node) final {
+    std::vector<std::pair<Var, Expr>> bindings;
+    Expr body = GetRef<Let>(let_node);
+    while (const auto* let = body.as<LetNode>()) {
+      bindings.emplace_back(let->var, VisitExpr(let->value));
+      body = let->body;
+    }
+    body = VisitExpr(body);
+    PlanChain(&bindings, body);
+    for (auto it = bindings.rbegin(); it != bindings.rend(); ++it) {
+      body = Let(it->first, it->second, body);
+    }
+    return body;
+  }
+
+ private:
+  using VarSet = std::vector<size_t>;
+
+  void PlanChain(std::vector<std::pair<Var, Expr>>* bindings, const Expr& body) {
+    static const Op& alloc_storage_op = Op::Get("memory.alloc_storage");
+    static const Op& alloc_tensor_op = Op::Get("memory.alloc_tensor");
+    static const Op& kill_op = Op::Get("memory.kill");
+    static const Op& invoke_tvm_op = Op::Get("vm.invoke_tvm_op");
+    static const Op& shape_of_op = Op::Get("vm.shape_of");
+    static const Op& shape_func_op = Op::Get("vm.shape_func");
+
+    const size_t num_bindings = bindings->size();
+    const size_t end_of_chain = num_bindings;
+    std::vector<StorageEntry> storages;
+    // Map each storage variable to its entry.
+    std::unordered_map<const VarNode*, size_t> storage_index;
+    // The storages a variable may hold a tensor of.
+    std::unordered_map<const VarNode*, VarSet> points_to;
+
+    auto touch = [&](const VarNode* var, size_t index) {
+      auto it = points_to.find(var);
+      if (it == points_to.end()) return;
+      for (size_t sid : it->second) {
+        storages[sid].last_use = std::max(storages[sid].last_use, index);
+      }
+    };
+
+    for (size_t i = 0; i < num_bindings; ++i) {
+      const Var& var = (*bindings)[i].first;
+      const Expr& value = (*bindings)[i].second;
+      const auto* call = value.as<CallNode>();
+
+      if (call && call->op == alloc_storage_op) {
+        const auto* attrs = call->attrs.as<AllocStorageAttrs>();
+        ICHECK(attrs != nullptr) << "must be the AllocStorage attrs";
+        StorageEntry entry;
+        entry.var = var;
+        entry.def = i;
+        entry.last_use = i;
+        entry.device.device_type = static_cast<DLDeviceType>(attrs->device_type);
+        entry.device.device_id = attrs->device_id;
+        entry.dtype = attrs->dtype;
+        if (!GetConstInt(call->args[0], &entry.size)) entry.size = -1;
+        if (!GetConstInt(call->args[1], &entry.alignment) || entry.alignment <= 0) {
+          entry.plannable = false;
+        }
+        storage_index[var.get()] = storages.size();
+        points_to[var.get()] = {storages.size()};
+        storages.push_back(entry);
+        continue;
+      }
+
+      if (call && call->op == alloc_tensor_op) {
+        const auto* storage_var = call->args[0].as<VarNode>();
+        auto it = storage_var ? storage_index.find(storage_var) : storage_index.end();
+        int64_t offset;
+        if (it != storage_index.end()) {
+          StorageEntry& entry = storages[it->second];
+          entry.tensors.push_back(i);
+          entry.last_use = std::max(entry.last_use, i);
+          if (!GetConstInt(call->args[1], &offset)) entry.plannable = false;
+          if (entry.size < 0) {
+            BoundDynamicStorage(call, &entry);
+          } else if (entry.bounded) {
+            // The bound was derived from a single tensor type.
+            entry.plannable = false;
+          }
+          points_to[var.get()] = {it->second};
+        }
+        // The offset and the shape may not reference tensors, but a storage
+        // used through anything but this call is pinned below.
+        for (size_t k = 1; k < call->args.size(); ++k) {
+          for (const Var& free_var : FreeVars(call->args[k])) {
+            PinIfStorage(free_var.get(), storage_index, &storages);
+            touch(free_var.get(), i);
+          }
+        }
+        continue;
+      }
+
+      Array<Var> free_vars = FreeVars(value);
+      bool captured = value.as<FunctionNode>() != nullptr;
+      VarSet aliases;
+      for (const Var& free_var : free_vars) {
+        PinIfStorage(free_var.get(), storage_index, &storages);
+        touch(free_var.get(), captured ? end_of_chain : i);
+        auto it = points_to.find(free_var.get());
+        if (it != points_to.end()) {
+          aliases.insert(aliases.end(), it->second.begin(), it->second.end());
+        }
+      }
+      // Calls which never return a view of their arguments.
+      bool fresh_result = call && (call->op == invoke_tvm_op || call->op == kill_op ||
+                                   call->op == shape_of_op || call->op == shape_func_op);
+      if (!fresh_result && !aliases.empty()) {
+        std::sort(aliases.begin(), aliases.end());
+        aliases.erase(std::unique(aliases.begin(), aliases.end()), aliases.end());
+        points_to[var.get()] = std::move(aliases);
+      }
+    }
+
+    // Anything reachable from the result of the chain outlives it.
+    for (const Var& free_var : FreeVars(body)) {
+      PinIfStorage(free_var.get(), storage_index, &storages);
+      touch(free_var.get(), end_of_chain);
+    }
+
+    // Group the candidates per device and dtype hint. Storages sized from
+    // the upper-bound hint are kept apart from the statically sized ones.
+    std::vector<std::vector<size_t>> groups;
+    for (size_t sid = 0; sid < storages.size(); ++sid) {
+      const StorageEntry& entry = storages[sid];
+      if (!entry.plannable || entry.size < 0) continue;
+      bool found = false;
+      for (auto& group : groups) {
+        const StorageEntry& head = storages[group[0]];
+        if (head.device.device_type == entry.device.device_type &&
+            head.device.device_id == entry.device.device_id && head.dtype == entry.dtype &&
+            head.bounded == entry.bounded) {
+          group.push_back(sid);
+          found = true;
+          break;
+        }
+      }
+      if (!found) groups.push_back({sid});
+    }
+    // A bounded storage may hold more than its bound at runtime, so it can
+    // only share an arena with storages that are dead by then.
+    std::vector<std::vector<size_t>> arenas;
+    for (const auto& group : groups) {
+      if (storages[group[0]].bounded) {
+        AssignTokens(group, storages, &arenas);
+      } else {
+        arenas.push_back(group);
+      }
+    }
+
+    // Bindings to drop, and arenas to insert before a given binding.
+    std::vector<bool> removed(num_bindings, false);
+    std::unordered_map<size_t, std::pair<Var, Expr>> arena_at;
+    for (const auto& group : arenas) {
+      if (group.size() < 2) continue;
+      int64_t arena_size = 0;
+      int64_t arena_alignment = 0;
+      AssignOffsets(group, &storages, &arena_size, &arena_alignment);
+
+      size_t first_def = num_bindings;
+      for (size_t sid : group) first_def = std::min(first_def, storages[sid].def);
+      const StorageEntry& head = storages[group[0]];
+      Var arena("memory_arena_" + std::to_string(num_arenas_++), Type(nullptr));
+      Expr alloc = AllocStorage(MakeConstantScalar(DataType::Int(64), arena_size),
+                                MakeConstantScalar(DataType::Int(64), arena_alignment),
+                                head.device, head.dtype);
+      arena_at.emplace(first_def, std::make_pair(arena, alloc));
+
+      for (size_t sid : group) {
+        const StorageEntry& entry = storages[sid];
+        removed[entry.def] = true;
+        for (size_t tid : entry.tensors) {
+          const auto* call = (*bindings)[tid].second.as<CallNode>();
+          int64_t offset = 0;
+          ICHECK(GetConstInt(call->args[1], &offset));
+          Expr new_offset = MakeConstantScalar(DataType::Int(64), entry.offset + offset);
+          (*bindings)[tid].second =
+              Call(call->op, {arena, new_offset, call->args[2]}, call->attrs, call->type_args);
+        }
+      }
+      DLOG(INFO) << "Coalesced " << group.size() << " storages into an arena of " << arena_size
+                 << " bytes";
+    }
+
+    if (arena_at.empty()) return;
+    std::vector<std::pair<Var, Expr>> planned;
+    planned.reserve(num_bindings + arena_at.size());
+    for (size_t i = 0; i < num_bindings; ++i) {
+      auto it = arena_at.find(i);
+      if (it != arena_at.end()) planned.push_back(it->second);
+      if (!removed[i]) planned.push_back(std::move((*bindings)[i]));
+    }
+    *bindings = std::move(planned);
+  }
+
+  /*! \brief A storage variable used other than by memory.alloc_tensor can't be moved. */
+  static void PinIfStorage(const VarNode* var,
+                           const std::unordered_map<const VarNode*, size_t>& storage_index,
+                           std::vector<StorageEntry>* storages) {
+    auto it = storage_index.find(var);
+    if (it != storage_index.end()) (*storages)[it->second].plannable = false;
+  }
+
+  /*!
+   * \brief Derive an upper bound for a storage of symbolic size from the
+   *  type of the tensor allocated in it.
+   */
+  void BoundDynamicStorage(const CallNode* alloc_tensor, StorageEntry* entry) const {
+    if (any_dim_upper_bound_ <= 0) {
+      entry->plannable = false;
+      return;
+    }
+    const auto* attrs = alloc_tensor->attrs.as<AllocTensorAttrs>();
+    ICHECK(attrs != nullptr) << "must be the alloc tensor attrs";
+    int64_t size = (attrs->dtype.bits() * attrs->dtype.lanes() + 7) / 8;
+    for (const auto& dim : attrs->assert_shape) {
+      if (const auto* imm = dim.as<IntImmNode>()) {
+        size *= imm->value;
+      } else if (dim.as<AnyNode>()) {
+        size *= any_dim_upper_bound_;
+      } else {
+        entry->plannable = false;
+        return;
+      }
+    }
+    entry->size = size;
+    entry->bounded = true;
+  }
+
+  /*!
+   * \brief Split a group into sets of storages with pairwise disjoint
+   *  lifetimes. AssignOffsets places every storage of such a set at
+   *  offset zero.
+   */
+  static void AssignTokens(const std::vector<size_t>& group,
+                           const std::vector<StorageEntry>& storages,
+                           std::vector<std::vector<size_t>>* tokens) {
+    std::vector<size_t> order = group;
+    std::sort(order.begin(), order.end(), [&storages](size_t lhs, size_t rhs) {
+      return storages[lhs].def < storages[rhs].def;
+    });
+    // Index into tokens and the last use of the storages assigned to it.
+    std::vector<std::pair<size_t, size_t>> last_use;
+    for (size_t sid : order) {
+      const StorageEntry& entry = storages[sid];
+      bool found = false;
+      for (auto& token : last_use) {
+        if (token.second < entry.def) {
+          (*tokens)[token.first].push_back(sid);
+          token.second = entry.last_use;
+          found = true;
+          break;
+        }
+      }
+      if (!found) {
+        last_use.emplace_back(tokens->size(), entry.last_use);
+        tokens->push_back({sid});
+      }
+    }
+  }
+
+  /*!
+   * \brief Greedy-by-size offset assignment: the largest storages are
+   *  placed first, each at the lowest aligned offset that does not overlap
+   *  a placed storage whose lifetime intersects its own.
+   */
+  static void AssignOffsets(const std::vector<size_t>& group, std::vector<StorageEntry>* storages,
+                            int64_t* arena_size, int64_t* arena_alignment) {
+    std::vector<size_t> order = group;
+    std::sort(order.begin(), order.end(), [storages](size_t lhs, size_t rhs) {
+      const StorageEntry& a = (*storages)[lhs];
+      const StorageEntry& b = (*storages)[rhs];
+      return a.size != b.size ? a.size > b.size : a.def < b.def;
+    });
+    std::vector<size_t> placed;
+    for (size_t sid : order) {
+      StorageEntry& entry = (*storages)[sid];
+      std::vector<std::pair<int64_t, int64_t>> busy;
+      for (size_t other_id : placed) {
+        const StorageEntry& other = (*storages)[other_id];
+        if (other.last_use < entry.def || entry.last_use < other.def) continue;
+        busy.emplace_back(other.offset, other.offset + other.size);
+      }
+      std::sort(busy.begin(), busy.end());
+      int64_t offset = 0;
+      for (const auto& range : busy) {
+        offset = (offset + entry.alignment - 1) / entry.alignment * entry.alignment;
+        if (offset + entry.size <= range.first) break;
+        offset = std::max(offset, range.second);
+      }
+      offset = (offset + entry.alignment - 1) / entry.alignment * entry.alignment;
+      entry.offset = offset;
+      *arena_size = std::max(*arena_size, offset + entry.size);
+      *arena_alignment = std::max(*arena_alignment, entry.alignment);
+      placed.push_back(sid);
+    }
+  }
+
+  int64_t any_dim_upper_bound_;
+  size_t num_arenas_{0};
+};
+
+}  // namespace vm
+
+namespace transform {
+
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.VMPlanMemory.any_dim_upper_bound", Integer);
+
+Pass VMPlanMemory() {
+  runtime::TypedPackedFunc<Function(Function, IRModule, PassContext)> pass_func =
+      [=](Function f, IRModule m, PassContext pc) {
+        if (f->HasNonzeroAttr(attr::kPrimitive) || f->GetAttr<String>(attr::kCompiler).defined()) {
+          return f;
+        }
+        int64_t bound =
+            pc->GetConfig("relay.VMPlanMemory.any_dim_upper_bound", Integer(0)).value()->value;
+        return Downcast<Function>(vm::StoragePlanner(bound).Mutate(f));
+      };
+  auto plan_pass = CreateFunctionPass(pass_func, 1, "VMPlanMemory", {});
+  return Sequential({plan_pass, InferType()}, "VMPlanMemory");
+}
+
+TVM_REGISTER_GLOBAL("relay._transform.VMPlanMemory").set_body_typed(VMPlanMemory);
+
+}  // namespace transform
+
+}  // namespace relay
+}  // namespace tvm
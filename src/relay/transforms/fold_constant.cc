@@ -29,6 +29,17 @@
 #include <tvm/relay/transform.h>
 #include <tvm/runtime/ndarray.h>
 #include <tvm/runtime/object.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/runtime/vm/memory_manager.h>
+#include <tvm/tir/data_layout.h>
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "pattern_utils.h"
 
@@ -37,8 +48,15 @@ namespace relay {
 
 using FInterpreter = runtime::TypedPackedFunc<ObjectRef(Expr)>;
 
+using ExprSet = std::unordered_set<Expr, ObjectPtrHash, ObjectPtrEqual>;
+
 class ConstantChecker : private ExprVisitor {
  public:
+  /*!
+   * \param folded Expressions which count as constant because they are going to be folded.
+   */
+  explicit ConstantChecker(const ExprSet* folded = nullptr) : folded_(folded) {}
+
   // Check whether an expression is constant. The results are memoized.
   bool Check(const Expr& expr) {
     // The `ConstantNode` case is common enough that we check directly for the
@@ -47,6 +65,9 @@ class ConstantChecker : private ExprVisitor {
     if (expr.as<ConstantNode>()) {
       return true;
     }
+    if (folded_ != nullptr && folded_->count(expr)) {
+      return true;
+    }
     const auto it = memo_.find(expr);
     if (it != memo_.end()) return it->second;
     VisitExpr(expr);
@@ -54,6 +75,7 @@ class ConstantChecker : private ExprVisitor {
   }
 
  private:
+  const ExprSet* folded_;
   std::unordered_map<Expr, bool, ObjectPtrHash, ObjectPtrEqual> memo_;
 
   void VisitExpr_(const TupleNode* n) final {
@@ -72,17 +94,241 @@ bool ConstantCheck(const Expr& e) { return ConstantChecker().Check(e); }
 
 TVM_REGISTER_GLOBAL("relay.analysis.check_constant").set_body_typed(ConstantCheck);
 
+/*! \brief Call f with a null pointer to the C type of dtype, return false for other types. */
+template <typename F>
+bool DispatchScalarType(DataType dtype, F f) {
+  if (dtype.lanes() != 1) return false;
+  if (dtype.is_bool()) {
+    f(static_cast<bool*>(nullptr));
+  } else if (dtype.is_int() && dtype.bits() == 8) {
+    f(static_cast<int8_t*>(nullptr));
+  } else if (dtype.is_int() && dtype.bits() == 16) {
+    f(static_cast<int16_t*>(nullptr));
+  } else if (dtype.is_int() && dtype.bits() == 32) {
+    f(static_cast<int32_t*>(nullptr));
+  } else if (dtype.is_int() && dtype.bits() == 64) {
+    f(static_cast<int64_t*>(nullptr));
+  } else if (dtype.is_uint() && dtype.bits() == 8) {
+    f(static_cast<uint8_t*>(nullptr));
+  } else if (dtype.is_uint() && dtype.bits() == 16) {
+    f(static_cast<uint16_t*>(nullptr));
+  } else if (dtype.is_uint() && dtype.bits() == 32) {
+    f(static_cast<uint32_t*>(nullptr));
+  } else if (dtype.is_uint() && dtype.bits() == 64) {
+    f(static_cast<uint64_t*>(nullptr));
+  } else if (dtype.is_float() && dtype.bits() == 32) {
+    f(static_cast<float*>(nullptr));
+  } else if (dtype.is_float() && dtype.bits() == 64) {
+    f(static_cast<double*>(nullptr));
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/*! \brief Fill dst in order, reading src at the sum of index[k] * strides[k] for every index. */
+template <typename T>
+void GatherElements(const T* src, T* dst, const std::vector<int64_t>& shape,
+                    const std::vector<int64_t>& strides) {
+  int64_t size = 1;
+  for (int64_t extent : shape) size *= extent;
+  std::vector<int64_t> index(shape.size(), 0);
+  int64_t offset = 0;
+  for (int64_t i = 0; i < size; ++i) {
+    dst[i] = src[offset];
+    for (int k = static_cast<int>(shape.size()) - 1; k >= 0; --k) {
+      offset += strides[k];
+      if (++index[k] < shape[k]) break;
+      offset -= strides[k] * shape[k];
+      index[k] = 0;
+    }
+  }
+}
+
+/*! \brief Copy src into a compact array of shape, reading it with the given element strides. */
+Optional<runtime::NDArray> GatherStrided(const runtime::NDArray& src,
+                                         const std::vector<int64_t>& shape,
+                                         const std::vector<int64_t>& strides) {
+  runtime::NDArray dst = runtime::NDArray::Empty(shape, src->dtype, src->device);
+  const void* src_data = static_cast<const char*>(src->data) + src->byte_offset;
+  switch ((src->dtype.bits * src->dtype.lanes + 7) / 8) {
+    case 1:
+      GatherElements(static_cast<const uint8_t*>(src_data), static_cast<uint8_t*>(dst->data),
+                     shape, strides);
+      break;
+    case 2:
+      GatherElements(static_cast<const uint16_t*>(src_data), static_cast<uint16_t*>(dst->data),
+                     shape, strides);
+      break;
+    case 4:
+      GatherElements(static_cast<const uint32_t*>(src_data), static_cast<uint32_t*>(dst->data),
+                     shape, strides);
+      break;
+    case 8:
+      GatherElements(static_cast<const uint64_t*>(src_data), static_cast<uint64_t*>(dst->data),
+                     shape, strides);
+      break;
+    default:
+      return NullOpt;
+  }
+  return dst;
+}
+
+/*! \brief Compact row major strides of shape, in elements. */
+std::vector<int64_t> CompactStrides(const std::vector<int64_t>& shape) {
+  std::vector<int64_t> strides(shape.size(), 1);
+  for (int k = static_cast<int>(shape.size()) - 2; k >= 0; --k) {
+    strides[k] = strides[k + 1] * shape[k + 1];
+  }
+  return strides;
+}
+
+/*!
+ * \brief Convert src between layouts like NCHW and NCHW16c. Every primal axis may be split at
+ *  most once in each layout, and the extents must match exactly, otherwise NullOpt is returned.
+ */
+Optional<runtime::NDArray> ConvertLayout(const runtime::NDArray& src, const std::string& src_name,
+                                         const std::string& dst_name,
+                                         const std::vector<int64_t>& dst_shape) {
+  tir::Layout src_layout(src_name);
+  tir::Layout dst_layout(dst_name);
+  runtime::ShapeTuple shape = src.Shape();
+  std::vector<int64_t> src_shape(shape.begin(), shape.end());
+  if (!src_layout.defined() || !dst_layout.defined() || src_layout.ndim() != src_shape.size() ||
+      dst_layout.ndim() != dst_shape.size()) {
+    return NullOpt;
+  }
+  // For every primal axis, the positions of its outer and inner parts and the inner extent.
+  struct SplitAxis {
+    int outer{-1};
+    int inner{-1};
+    int64_t factor{1};
+  };
+  auto split_axes = [](const tir::Layout& layout, const std::vector<int64_t>& shape,
+                       std::unordered_map<char, SplitAxis>* axes) {
+    for (size_t i = 0; i < layout.ndim(); ++i) {
+      const tir::LayoutAxis& axis = layout[i];
+      SplitAxis& split = (*axes)[axis.ToPrimal().name()[0]];
+      if (axis.IsPrimal()) {
+        split.outer = i;
+      } else {
+        if (split.inner != -1) return false;
+        split.inner = i;
+        split.factor = shape[i];
+      }
+    }
+    for (const auto& kv : *axes) {
+      if (kv.second.outer == -1) return false;
+    }
+    return true;
+  };
+  std::unordered_map<char, SplitAxis> src_axes, dst_axes;
+  if (!split_axes(src_layout, src_shape, &src_axes) ||
+      !split_axes(dst_layout, dst_shape, &dst_axes) || src_axes.size() != dst_axes.size()) {
+    return NullOpt;
+  }
+  std::vector<std::pair<SplitAxis, SplitAxis>> axes;
+  for (const auto& kv : dst_axes) {
+    auto it = src_axes.find(kv.first);
+    if (it == src_axes.end()) return NullOpt;
+    const SplitAxis& from = it->second;
+    const SplitAxis& to = kv.second;
+    if (src_shape[from.outer] * from.factor != dst_shape[to.outer] * to.factor) return NullOpt;
+    axes.emplace_back(from, to);
+  }
+  std::vector<int64_t> src_strides = CompactStrides(src_shape);
+  int64_t size = 1;
+  for (int64_t extent : dst_shape) size *= extent;
+  int64_t elem_bytes = (src->dtype.bits * src->dtype.lanes + 7) / 8;
+  runtime::NDArray dst = runtime::NDArray::Empty(dst_shape, src->dtype, src->device);
+  const char* src_data = static_cast<const char*>(src->data) + src->byte_offset;
+  char* dst_data = static_cast<char*>(dst->data);
+  std::vector<int64_t> index(dst_shape.size(), 0);
+  for (int64_t i = 0; i < size; ++i) {
+    int64_t offset = 0;
+    for (const auto& axis : axes) {
+      const SplitAxis& from = axis.first;
+      const SplitAxis& to = axis.second;
+      int64_t value = index[to.outer] * to.factor + (to.inner == -1 ? 0 : index[to.inner]);
+      offset += value / from.factor * src_strides[from.outer];
+      if (from.inner != -1) offset += value % from.factor * src_strides[from.inner];
+    }
+    std::memcpy(dst_data + i * elem_bytes, src_data + offset * elem_bytes, elem_bytes);
+    for (int k = static_cast<int>(dst_shape.size()) - 1; k >= 0; --k) {
+      if (++index[k] < dst_shape[k]) break;
+      index[k] = 0;
+    }
+  }
+  return dst;
+}
+
+/*! \brief Find the calls deferred by a batched ConstantFolder which are not inside another one. */
+class DeferredRootCollector : public MixedModeVisitor {
+ public:
+  explicit DeferredRootCollector(const ExprSet& deferred) : deferred_(deferred) {}
+
+  std::vector<Expr> Collect(const Expr& expr) {
+    VisitExpr(expr);
+    return std::move(roots_);
+  }
+
+ private:
+  bool CheckVisited(const Expr& expr) final {
+    if (deferred_.count(expr)) {
+      if (visit_counter_[expr.get()]++ == 0) roots_.push_back(expr);
+      return true;
+    }
+    return MixedModeVisitor::CheckVisited(expr);
+  }
+
+  const ExprSet& deferred_;
+  std::vector<Expr> roots_;
+};
+
 // TODO(tvm-team) consider combine dead-code with constant folder.
 // or make a more powerful partial evaluator.
 class ConstantFolder : public MixedModeMutator {
  public:
-  explicit ConstantFolder(IRModule module)
-      : module_(module),
+  /*!
+   * \param module The module of the expression.
+   * \param batch Whether to defer the evaluation of foldable calls, see FoldBatched.
+   */
+  explicit ConstantFolder(IRModule module, bool batch = false)
+      : checker_(&deferred_),
+        module_(module),
+        batch_(batch),
         device_copy_op_(Op::Get("device_copy")),
         shape_of_op_(Op::Get("shape_of")),
         vm_shape_of_op_(Op::Get("vm.shape_of")),
         cast_op_(Op::Get("cast")),
-        ndarray_size_op_(Op::Get("ndarray_size")) {}
+        ndarray_size_op_(Op::Get("ndarray_size")),
+        reshape_op_(Op::Get("reshape")),
+        squeeze_op_(Op::Get("squeeze")),
+        expand_dims_op_(Op::Get("expand_dims")),
+        transpose_op_(Op::Get("transpose")),
+        layout_transform_op_(Op::Get("layout_transform")) {}
+
+  /*!
+   * \brief Fold the constants of expr in rounds. Every round defers the foldable calls, then
+   *  compiles the outermost ones into one VM program which evaluates all of them at once. The
+   *  next round substitutes the values, which may enable more folding, e.g. of if conditions.
+   * \param module The module of the expression.
+   * \param expr The expression.
+   * \return The folded expression.
+   */
+  static Expr FoldBatched(const IRModule& module, Expr expr) {
+    std::vector<std::pair<Expr, Expr>> values;
+    while (true) {
+      ConstantFolder folder(module, true);
+      for (const auto& kv : values) {
+        folder.memo_[kv.first] = kv.second;
+      }
+      expr = folder.Mutate(expr);
+      std::vector<Expr> roots = DeferredRootCollector(folder.deferred_).Collect(expr);
+      if (roots.empty()) return expr;
+      values = folder.EvaluateBatch(roots);
+    }
+  }
 
   using MixedModeMutator::VisitExpr_;
 
@@ -90,7 +336,7 @@ class ConstantFolder : public MixedModeMutator {
     auto pre_visit = [this](const LetNode* op) {
       // Rely on the Memoizer to cache pre-visit values
       Expr value = this->Mutate(op->value);
-      if (value.as<ConstantNode>()) {
+      if (IsFolded(value)) {
         this->memo_[op->var] = value;
       } else {
         this->Mutate(op->var);
@@ -100,7 +346,7 @@ class ConstantFolder : public MixedModeMutator {
       Expr expr = GetRef<Expr>(op);
       // Rely on the Memoizer to cache pre-visit values
       Expr value = this->Mutate(op->value);
-      if (value.as<ConstantNode>()) {
+      if (IsFolded(value)) {
         this->memo_[expr] = this->Mutate(op->body);
       } else {
         Var var = Downcast<Var>(this->Mutate(op->var));
@@ -148,6 +394,7 @@ class ConstantFolder : public MixedModeMutator {
     static auto op_stateful = Op::GetAttrMap<TOpIsStateful>("TOpIsStateful");
 
     auto origin_args = call->args;
+    Type origin_type = call->checked_type_;
     call = post.as<CallNode>();
     // We don't constant fold function with zero arguments.
     // This is a heuristic that is useful.
@@ -182,6 +429,13 @@ class ConstantFolder : public MixedModeMutator {
       }
     }
     if (all_const_args) {
+      if (Optional<Expr> value = NativeEvaluate(GetRef<Call>(call), origin_type)) {
+        return value.value();
+      }
+      if (batch_) {
+        deferred_.insert(post);
+        return post;
+      }
       return ConstEvaluate(post);
     } else {
       return post;
@@ -193,15 +447,22 @@ class ConstantFolder : public MixedModeMutator {
     if (const auto* tuple = op->tuple.as<TupleNode>()) {
       return tuple->fields[op->index];
     } else {
+      if (deferred_.count(op->tuple)) {
+        deferred_.insert(post);
+      }
       return post;
     }
   }
 
  private:
+  // Calls whose evaluation is deferred in batch mode
+  ExprSet deferred_;
   // Internal constant checker
   ConstantChecker checker_;
   // Module
   IRModule module_;
+  // Whether to defer the evaluation of calls
+  bool batch_;
 
   // Cache the following ops for equivalence checking in this pass.
   const Op& device_copy_op_;
@@ -209,6 +470,16 @@ class ConstantFolder : public MixedModeMutator {
   const Op& vm_shape_of_op_;
   const Op& cast_op_;
   const Op& ndarray_size_op_;
+  const Op& reshape_op_;
+  const Op& squeeze_op_;
+  const Op& expand_dims_op_;
+  const Op& transpose_op_;
+  const Op& layout_transform_op_;
+
+  // Whether expr is a constant or is going to be folded into one.
+  bool IsFolded(const Expr& expr) const {
+    return expr.as<ConstantNode>() != nullptr || deferred_.count(expr);
+  }
 
   // Convert value to expression.
   Expr ObjectToExpr(const ObjectRef& value) {
@@ -260,6 +531,128 @@ class ConstantFolder : public MixedModeMutator {
     return ObjectToExpr(executor(expr));
   }
 
+  /*!
+   * \brief Evaluate calls to common layout and type conversions on CPU directly instead of
+   *  compiling them. Reshapes share the data of their input.
+   * \param call The call, with constant arguments.
+   * \param type The checked type of the call before folding its arguments, may be undefined.
+   * \return The constant, or NullOpt when the call is not handled.
+   */
+  Optional<Expr> NativeEvaluate(const Call& call, const Type& type) {
+    for (const Expr& arg : call->args) {
+      const auto* constant = arg.as<ConstantNode>();
+      if (constant == nullptr || constant->data->device.device_type != kDLCPU) return NullOpt;
+    }
+    runtime::NDArray data = call->args[0].as<ConstantNode>()->data;
+    if (!runtime::IsContiguous(*data.operator->())) return NullOpt;
+    runtime::ShapeTuple data_shape = data.Shape();
+    std::vector<int64_t> shape(data_shape.begin(), data_shape.end());
+
+    if (call->op == cast_op_) {
+      DataType dtype = call->attrs.as<CastAttrs>()->dtype;
+      if (DataType(data->dtype) == dtype) return call->args[0];
+      if (!DispatchScalarType(dtype, [](auto*) {})) return NullOpt;
+      runtime::NDArray value = runtime::NDArray::Empty(shape, dtype, data->device);
+      int64_t size = 1;
+      for (int64_t extent : shape) size *= extent;
+      const void* src = static_cast<const char*>(data->data) + data->byte_offset;
+      bool supported = DispatchScalarType(DataType(data->dtype), [&](auto* src_tag) {
+        using SrcType = std::remove_pointer_t<decltype(src_tag)>;
+        DispatchScalarType(dtype, [&](auto* dst_tag) {
+          using DstType = std::remove_pointer_t<decltype(dst_tag)>;
+          const SrcType* in = static_cast<const SrcType*>(src);
+          DstType* out = static_cast<DstType*>(value->data);
+          for (int64_t i = 0; i < size; ++i) {
+            out[i] = static_cast<DstType>(in[i]);
+          }
+        });
+      });
+      if (!supported) return NullOpt;
+      return Expr(Constant(value));
+    }
+
+    // The other ops take their output shape from the type of the call.
+    const auto* tensor_type = type.as<TensorTypeNode>();
+    if (tensor_type == nullptr || DataType(data->dtype) != tensor_type->dtype) return NullOpt;
+    std::vector<int64_t> out_shape;
+    for (const PrimExpr& dim : tensor_type->shape) {
+      const auto* extent = dim.as<IntImmNode>();
+      if (extent == nullptr) return NullOpt;
+      out_shape.push_back(extent->value);
+    }
+
+    if (call->op == reshape_op_ || call->op == squeeze_op_ || call->op == expand_dims_op_) {
+      return Expr(Constant(data.CreateView(out_shape, data->dtype)));
+    }
+    if (call->op == transpose_op_) {
+      Array<Integer> axes = call->attrs.as<TransposeAttrs>()->axes;
+      int ndim = static_cast<int>(shape.size());
+      std::vector<int64_t> in_strides = CompactStrides(shape);
+      std::vector<int64_t> strides;
+      for (int k = 0; k < ndim; ++k) {
+        int64_t axis = axes.defined() && axes.size() != 0 ? axes[k]->value : ndim - 1 - k;
+        strides.push_back(in_strides[axis < 0 ? axis + ndim : axis]);
+      }
+      if (Optional<runtime::NDArray> value = GatherStrided(data, out_shape, strides)) {
+        return Expr(Constant(value.value()));
+      }
+      return NullOpt;
+    }
+    if (call->op == layout_transform_op_) {
+      const auto* attrs = call->attrs.as<LayoutTransformAttrs>();
+      if (attrs->src_layout == attrs->dst_layout) return call->args[0];
+      if (Optional<runtime::NDArray> value =
+              ConvertLayout(data, attrs->src_layout, attrs->dst_layout, out_shape)) {
+        return Expr(Constant(value.value()));
+      }
+      return NullOpt;
+    }
+    return NullOpt;
+  }
+
+  /*!
+   * \brief Evaluate the deferred calls with one VM program, where every op is compiled into
+   *  one module.
+   * \param roots The outermost deferred calls.
+   * \return The pairs of every root and its value.
+   */
+  std::vector<std::pair<Expr, Expr>> EvaluateBatch(const std::vector<Expr>& roots) {
+    // The deferred calls only take constants and other deferred calls, so have no free variables.
+    Expr body = Tuple(Array<Expr>(roots.begin(), roots.end()));
+    Function func({}, body, Type(), {});
+    auto mod = IRModule({}, module_->type_definitions, module_->Imports());
+    mod->Add(GlobalVar("main"), func);
+
+    // Use a fresh build context, at opt level 1 to only fuse ops and skip FoldConstant.
+    using tvm::transform::PassContext;
+    PassContext pass_ctx = PassContext::Create();
+    pass_ctx->opt_level = 1;
+    With<PassContext> fresh_build_ctx(pass_ctx);
+
+    Target target = Target("llvm");
+    Map<Integer, Target> targets = {{Integer(static_cast<int>(kDLCPU)), target}};
+    const auto* create_compiler = runtime::Registry::Get("relay._vm._VMCompiler");
+    const auto* create_vm = runtime::Registry::Get("runtime._VirtualMachine");
+    ICHECK(create_compiler != nullptr && create_vm != nullptr)
+        << "The VM is required to fold constants in batch";
+    runtime::Module compiler = (*create_compiler)();
+    compiler.GetFunction("lower")(mod, targets, target);
+    compiler.GetFunction("codegen")();
+    runtime::Module exec = compiler.GetFunction("get_executable")();
+    runtime::Module vm = (*create_vm)(exec);
+    vm.GetFunction("init")(static_cast<int>(kDLCPU), 0,
+                           static_cast<int>(runtime::vm::AllocatorType::kNaive));
+    ObjectRef result = vm.GetFunction("invoke")("main");
+    runtime::ADT fields = Downcast<runtime::ADT>(result);
+    ICHECK_EQ(fields.size(), roots.size());
+
+    std::vector<std::pair<Expr, Expr>> values;
+    for (size_t i = 0; i < roots.size(); ++i) {
+      values.emplace_back(roots[i], ObjectToExpr(fields[i]));
+    }
+    return values;
+  }
+
   // Evaluate a call to the shape_of operator for tensors with constant
   // shapes.
   Expr EvaluateShapeOf(Expr expr, Array<Expr> args, Attrs attrs) {
@@ -352,6 +745,9 @@ class ConstantFolder : public MixedModeMutator {
     auto cast_attrs = make_object<CastAttrs>();
     cast_attrs->dtype = dtype;
     Expr ret = Call(cast_op_, {value}, Attrs(cast_attrs), {});
+    if (Optional<Expr> folded = NativeEvaluate(Downcast<Call>(ret), Type())) {
+      return folded.value();
+    }
     return ConstEvaluate(ret);
   }
 
@@ -370,9 +766,17 @@ class ConstantFolder : public MixedModeMutator {
 };
 
 Expr FoldConstant(const Expr& expr, const IRModule& mod) {
+  bool batch = transform::PassContext::Current()
+                   ->GetConfig<Bool>("relay.FoldConstant.batch", Bool(false))
+                   .value();
+  if (batch) {
+    return ConstantFolder::FoldBatched(mod, expr);
+  }
   return ConstantFolder(mod).Mutate(expr);
 }
 
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.FoldConstant.batch", Bool);
+
 TVM_REGISTER_GLOBAL("relay._transform.FoldConstantExpr").set_body_typed(FoldConstant);
 
 namespace transform {
@@ -24,10 +24,19 @@
 
 #include <dmlc/json.h>
 #include <dmlc/memory_io.h>
+#include <tvm/runtime/device_api.h>
 #include <tvm/runtime/logging.h>
 #include <tvm/runtime/registry.h>
 #include <tvm/runtime/serializer.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
 #include <fstream>
 #include <unordered_map>
 #include <vector>
@@ -159,15 +168,173 @@ void LoadMetaDataFromFile(const std::string& file_name,
 
 void RemoveFile(const std::string& file_name) { std::remove(file_name.c_str()); }
 
-Map<String, NDArray> LoadParams(const std::string& param_blob) {
-  dmlc::MemoryStringStream strm(const_cast<std::string*>(&param_blob));
-  return LoadParams(&strm);
+std::shared_ptr<MappedFile> MappedFile::Open(const std::string& file_name) {
+  std::shared_ptr<MappedFile> file(new MappedFile());
+#ifndef _WIN32
+  int fd = open(file_name.c_str(), O_RDONLY);
+  ICHECK_GE(fd, 0) << "Cannot open file " << file_name;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    LOG(FATAL) << "Cannot stat file " << file_name;
+  }
+  file->size_ = static_cast<size_t>(st.st_size);
+  if (file->size_ != 0) {
+    // Writable but private, the file itself is never modified.
+    void* addr = mmap(nullptr, file->size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      file->data_ = static_cast<char*>(addr);
+    }
+  }
+  close(fd);
+  if (file->data_ != nullptr || file->size_ == 0) return file;
+#endif
+  LoadBinaryFromFile(file_name, &file->buffer_);
+  file->data_ = &file->buffer_[0];
+  file->size_ = file->buffer_.size();
+  return file;
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+  if (buffer_.empty() && data_ != nullptr) {
+    munmap(data_, size_);
+  }
+#endif
+}
+
+void SaveDLTensorAligned(dmlc::SeekStream* strm, const DLTensor* tensor) {
+  uint64_t header = kTVMNDArrayAlignedMagic, reserved = 0;
+  strm->Write(header);
+  strm->Write(reserved);
+  // Saved as CPU tensor, see SaveDLTensor.
+  Device cpu_dev;
+  cpu_dev.device_type = kDLCPU;
+  cpu_dev.device_id = 0;
+  strm->Write(cpu_dev);
+  strm->Write(tensor->ndim);
+  strm->Write(tensor->dtype);
+  strm->WriteArray(tensor->shape, tensor->ndim);
+  int64_t data_byte_size = static_cast<int64_t>(GetDataSize(*tensor));
+  strm->Write(data_byte_size);
+  size_t pos = strm->Tell() + sizeof(uint64_t);
+  uint64_t padding = (kAllocAlignment - pos % kAllocAlignment) % kAllocAlignment;
+  strm->Write(padding);
+  char zeros[kAllocAlignment] = {0};
+  strm->Write(zeros, padding);
+
+  if (DMLC_IO_NO_ENDIAN_SWAP && tensor->device.device_type == kDLCPU &&
+      tensor->strides == nullptr && tensor->byte_offset == 0) {
+    strm->Write(tensor->data, data_byte_size);
+  } else {
+    std::vector<uint8_t> bytes(data_byte_size);
+    ICHECK_EQ(
+        TVMArrayCopyToBytes(const_cast<DLTensor*>(tensor), dmlc::BeginPtr(bytes), data_byte_size),
+        0)
+        << TVMGetLastError();
+    if (!DMLC_IO_NO_ENDIAN_SWAP) {
+      int type_bytes = (tensor->dtype.bits + 7) / 8;
+      dmlc::ByteSwap(dmlc::BeginPtr(bytes), type_bytes, data_byte_size / type_bytes);
+    }
+    strm->Write(dmlc::BeginPtr(bytes), data_byte_size);
+  }
+}
+
+namespace {
+/*!
+ * \brief Read the header of a tensor saved by SaveDLTensorAligned.
+ * \return The number of padding bytes in front of the data.
+ */
+uint64_t ReadAlignedHeader(dmlc::Stream* strm, std::vector<int64_t>* shape, DLDataType* dtype,
+                           int64_t* data_byte_size) {
+  uint64_t header, reserved, padding;
+  Device dev;
+  int ndim;
+  ICHECK(strm->Read(&header)) << "Invalid DLTensor file format";
+  ICHECK(strm->Read(&reserved)) << "Invalid DLTensor file format";
+  ICHECK(header == kTVMNDArrayAlignedMagic) << "Invalid DLTensor file format";
+  ICHECK(strm->Read(&dev)) << "Invalid DLTensor file format";
+  ICHECK(strm->Read(&ndim)) << "Invalid DLTensor file format";
+  ICHECK(strm->Read(dtype)) << "Invalid DLTensor file format";
+  ICHECK_EQ(dev.device_type, kDLCPU) << "Invalid DLTensor device: can only save as CPU tensor";
+  shape->resize(ndim);
+  if (ndim != 0) {
+    ICHECK(strm->ReadArray(shape->data(), ndim)) << "Invalid DLTensor file format";
+  }
+  ICHECK(strm->Read(data_byte_size)) << "Invalid DLTensor file format";
+  int64_t num_elems = 1;
+  for (int64_t dim : *shape) {
+    num_elems *= dim;
+  }
+  ICHECK_EQ(*data_byte_size, num_elems * ((dtype->bits * dtype->lanes + 7) / 8))
+      << "Invalid DLTensor file format";
+  ICHECK(strm->Read(&padding)) << "Invalid DLTensor file format";
+  ICHECK_LT(padding, kAllocAlignment) << "Invalid DLTensor file format";
+  return padding;
 }
-Map<String, NDArray> LoadParams(dmlc::Stream* strm) {
+
+/*! \brief Container of an array pointing into a mapped file, keeping the mapping alive. */
+struct MappedNDArrayContainer : public NDArray::Container {
+  MappedNDArrayContainer(void* data, ShapeTuple shape, DLDataType dtype,
+                         std::shared_ptr<MappedFile> file)
+      : NDArray::Container(data, shape, dtype, Device{kDLCPU, 0}), file(std::move(file)) {}
+  std::shared_ptr<MappedFile> file;
+
+  static void Deleter(Object* container) {
+    delete static_cast<MappedNDArrayContainer*>(container);
+  }
+};
+}  // namespace
+
+NDArray LoadDLTensorAligned(dmlc::Stream* strm) {
+  std::vector<int64_t> shape;
+  DLDataType dtype;
+  int64_t data_byte_size;
+  uint64_t padding = ReadAlignedHeader(strm, &shape, &dtype, &data_byte_size);
+  char skip[kAllocAlignment];
+  ICHECK(padding == 0 || strm->Read(skip, padding)) << "Invalid DLTensor file format";
+  NDArray ret = NDArray::Empty(ShapeTuple(shape), dtype, Device{kDLCPU, 0});
+  if (data_byte_size != 0) {
+    ICHECK(strm->Read(ret->data, data_byte_size)) << "Invalid DLTensor file format";
+  }
+  if (!DMLC_IO_NO_ENDIAN_SWAP) {
+    int type_bytes = (dtype.bits + 7) / 8;
+    dmlc::ByteSwap(ret->data, type_bytes, data_byte_size / type_bytes);
+  }
+  return ret;
+}
+
+NDArray LoadDLTensorAligned(dmlc::SeekStream* strm, const std::shared_ptr<MappedFile>& file) {
+  size_t start = strm->Tell();
+  std::vector<int64_t> shape;
+  DLDataType dtype;
+  int64_t data_byte_size;
+  uint64_t padding = ReadAlignedHeader(strm, &shape, &dtype, &data_byte_size);
+  size_t offset = strm->Tell() + padding;
+  ICHECK_LE(offset + data_byte_size, file->size()) << "Invalid DLTensor file format";
+  char* data = file->data() + offset;
+  if (!DMLC_IO_NO_ENDIAN_SWAP || reinterpret_cast<size_t>(data) % kAllocAlignment != 0) {
+    strm->Seek(start);
+    return LoadDLTensorAligned(static_cast<dmlc::Stream*>(strm));
+  }
+  strm->Seek(offset + data_byte_size);
+  auto* container = new MappedNDArrayContainer(data, ShapeTuple(shape), dtype, file);
+  container->SetDeleter(MappedNDArrayContainer::Deleter);
+  return NDArray(GetObjectPtr<Object>(container));
+}
+
+namespace {
+/*!
+ * \brief Load a parameter list.
+ * \param strm The stream to read from.
+ * \param file The file strm reads when it is a view of a mapped file, nullptr otherwise.
+ */
+Map<String, NDArray> LoadParamList(dmlc::Stream* strm, const std::shared_ptr<MappedFile>& file) {
   Map<String, NDArray> params;
   uint64_t header, reserved;
   ICHECK(strm->Read(&header)) << "Invalid parameters file format";
-  ICHECK(header == kTVMNDArrayListMagic) << "Invalid parameters file format";
+  ICHECK(header == kTVMNDArrayListMagic || header == kTVMNDArrayListAlignedMagic)
+      << "Invalid parameters file format";
   ICHECK(strm->Read(&reserved)) << "Invalid parameters file format";
 
   std::vector<std::string> names;
@@ -179,11 +346,31 @@ Map<String, NDArray> LoadParams(dmlc::Stream* strm) {
   for (size_t i = 0; i < size; ++i) {
     // The data_entry is allocated on device, NDArray.load always load the array into CPU.
     NDArray temp;
-    temp.Load(strm);
+    if (header == kTVMNDArrayListMagic) {
+      temp.Load(strm);
+    } else if (file != nullptr) {
+      temp = LoadDLTensorAligned(static_cast<dmlc::SeekStream*>(strm), file);
+    } else {
+      temp = LoadDLTensorAligned(strm);
+    }
     params.Set(names[i], temp);
   }
   return params;
 }
+}  // namespace
+
+Map<String, NDArray> LoadParams(const std::string& param_blob) {
+  dmlc::MemoryStringStream strm(const_cast<std::string*>(&param_blob));
+  return LoadParams(&strm);
+}
+
+Map<String, NDArray> LoadParams(dmlc::Stream* strm) { return LoadParamList(strm, nullptr); }
+
+Map<String, NDArray> LoadParamsFromFile(const std::string& file_name) {
+  std::shared_ptr<MappedFile> file = MappedFile::Open(file_name);
+  dmlc::MemoryFixedSizeStream strm(file->data(), file->size());
+  return LoadParamList(&strm, file);
+}
 
 void SaveParams(dmlc::Stream* strm, const Map<String, NDArray>& params) {
   std::vector<std::string> names;
@@ -206,6 +393,29 @@ void SaveParams(dmlc::Stream* strm, const Map<String, NDArray>& params) {
   }
 }
 
+std::string SaveParamsAligned(const Map<String, NDArray>& params) {
+  std::vector<std::string> names;
+  std::vector<const DLTensor*> arrays;
+  for (auto& p : params) {
+    names.push_back(p.first);
+    arrays.push_back(p.second.operator->());
+  }
+
+  std::string bytes;
+  dmlc::MemoryStringStream writer(&bytes);
+  dmlc::SeekStream* strm = &writer;
+  uint64_t header = kTVMNDArrayListAlignedMagic, reserved = 0;
+  strm->Write(header);
+  strm->Write(reserved);
+  strm->Write(names);
+  uint64_t sz = static_cast<uint64_t>(arrays.size());
+  strm->Write(sz);
+  for (size_t i = 0; i < sz; ++i) {
+    SaveDLTensorAligned(strm, arrays[i]);
+  }
+  return bytes;
+}
+
 std::string SaveParams(const Map<String, NDArray>& params) {
   std::string bytes;
   dmlc::MemoryStringStream strm(&bytes);
@@ -224,6 +434,16 @@ TVM_REGISTER_GLOBAL("runtime.SaveParams").set_body_typed([](const Map<String, ND
 TVM_REGISTER_GLOBAL("runtime.LoadParams").set_body_typed([](const String& s) {
   return ::tvm::runtime::LoadParams(s);
 });
+TVM_REGISTER_GLOBAL("runtime.SaveParamsAligned")
+    .set_body_typed([](const Map<String, NDArray>& params) {
+      std::string s = ::tvm::runtime::SaveParamsAligned(params);
+      TVMRetValue rv;
+      rv = TVMByteArray{s.data(), s.size()};
+      return rv;
+    });
+TVM_REGISTER_GLOBAL("runtime.LoadParamsFromFile").set_body_typed([](const String& file_name) {
+  return ::tvm::runtime::LoadParamsFromFile(file_name);
+});
 
 }  // namespace runtime
 }  // namespace tvm
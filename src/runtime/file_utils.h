@@ -24,9 +24,12 @@
 #ifndef TVM_RUNTIME_FILE_UTILS_H_
 #define TVM_RUNTIME_FILE_UTILS_H_
 
+#include <dmlc/io.h>
 #include <tvm/runtime/container/map.h>
 #include <tvm/runtime/container/string.h>
+#include <tvm/runtime/ndarray.h>
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -96,7 +99,64 @@ void LoadMetaDataFromFile(const std::string& file_name,
  */
 void RemoveFile(const std::string& file_name);
 
+/*!
+ * \brief A whole file mapped into memory.
+ *
+ *  The mapping is private and copy-on-write: processes mapping the same file
+ *  share its pages through the page cache until one of them writes to a page.
+ *  Platforms without mmap read the file into memory instead.
+ */
+class MappedFile {
+ public:
+  /*!
+   * \brief Map a file.
+   * \param file_name The name of the file.
+   * \return The mapping, unmapped when the last reference goes away.
+   */
+  static std::shared_ptr<MappedFile> Open(const std::string& file_name);
+  ~MappedFile();
+  /*! \return The start of the file, aligned to a page boundary when mapped. */
+  char* data() const { return data_; }
+  /*! \return The size of the file. */
+  size_t size() const { return size_; }
+
+ private:
+  MappedFile() = default;
+  char* data_{nullptr};
+  size_t size_{0};
+  /*! \brief The file content when it could not be mapped. */
+  std::string buffer_;
+};
+
+constexpr uint64_t kTVMNDArrayAlignedMagic = 0xDD5E40F096B4A140;
+/*!
+ * \brief Save a tensor with its data aligned to kAllocAlignment.
+ *
+ *  The alignment is relative to the start of the stream. The header is the
+ *  one of SaveDLTensor, followed by the number of padding bytes inserted
+ *  before the data.
+ * \param strm The stream to write to, its position gives the padding.
+ * \param tensor The tensor to save.
+ */
+void SaveDLTensorAligned(dmlc::SeekStream* strm, const DLTensor* tensor);
+/*!
+ * \brief Load a tensor saved by SaveDLTensorAligned into a new CPU array.
+ * \param strm The stream to read from.
+ * \return The loaded array.
+ */
+NDArray LoadDLTensorAligned(dmlc::Stream* strm);
+/*!
+ * \brief Load a tensor saved by SaveDLTensorAligned without copying its data.
+ * \param strm A stream reading file, position 0 being the start of the file.
+ * \param file The mapped file.
+ * \return An array pointing into the mapping and keeping it alive, or a copy
+ *  when the data cannot be used in place.
+ */
+NDArray LoadDLTensorAligned(dmlc::SeekStream* strm, const std::shared_ptr<MappedFile>& file);
+
 constexpr uint64_t kTVMNDArrayListMagic = 0xF7E58D4F05049CB7;
+/*! \brief The parameter list holding tensors saved by SaveDLTensorAligned. */
+constexpr uint64_t kTVMNDArrayListAlignedMagic = 0xF7E58D4F05049CB8;
 /*!
  * \brief Load parameters from a string.
  * \param param_blob Serialized string of parameters.
@@ -109,6 +169,15 @@ Map<String, NDArray> LoadParams(const std::string& param_blob);
  * \return Map of parameter name to parameter value.
  */
 Map<String, NDArray> LoadParams(dmlc::Stream* strm);
+/*!
+ * \brief Load parameters from a file.
+ *
+ *  The file is mapped into memory. When it was saved by SaveParamsAligned the
+ *  returned arrays point into the mapping, otherwise they are copies.
+ * \param file_name The name of the file.
+ * \return Map of parameter name to parameter value.
+ */
+Map<String, NDArray> LoadParamsFromFile(const std::string& file_name);
 /*!
  * \brief Serialize parameters to a byte array.
  * \param params Parameters to save.
@@ -121,6 +190,13 @@ std::string SaveParams(const Map<String, NDArray>& params);
  * \param params Parameters to save.
  */
 void SaveParams(dmlc::Stream* strm, const Map<String, NDArray>& params);
+/*!
+ * \brief Serialize parameters with the data of every array aligned, so that
+ *  LoadParamsFromFile can use the saved file in place.
+ * \param params Parameters to save.
+ * \return String containing binary parameter data.
+ */
+std::string SaveParamsAligned(const Map<String, NDArray>& params);
 }  // namespace runtime
 }  // namespace tvm
 #endif  // TVM_RUNTIME_FILE_UTILS_H_
@@ -0,0 +1,293 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file batching_executor.cc
+ */
+#include "batching_executor.h"
+
+#include <tvm/runtime/registry.h>
+
+#include <algorithm>
+#include <sstream>
+#include <utility>
+
+#include "graph_executor_factory.h"
+
+namespace tvm {
+namespace runtime {
+
+namespace {
+/*! \brief A view of row `row` of a tensor batched along axis 0. */
+DLTensor RowView(const NDArray& batch, int64_t row, size_t row_bytes, int64_t* shape) {
+  DLTensor view = *batch.operator->();
+  view.shape = shape;
+  view.strides = nullptr;
+  view.byte_offset += row * row_bytes;
+  return view;
+}
+}  // namespace
+
+BatchingExecutor::BatchingExecutor(const Array<Module>& factories,
+                                   const Array<String>& input_names,
+                                   const std::vector<Device>& devs,
+                                   std::chrono::microseconds max_delay)
+    : max_delay_(max_delay) {
+  ICHECK_GT(factories.size(), 0U) << "expect at least one batch size variant";
+  ICHECK_GT(input_names.size(), 0U) << "expect at least one batched input";
+
+  for (const Module& factory_mod : factories) {
+    auto* factory = dynamic_cast<GraphExecutorFactory*>(const_cast<ModuleNode*>(
+        factory_mod.operator->()));
+    ICHECK(factory != nullptr) << "expect a GraphExecutorFactory, got "
+                               << factory_mod->type_key();
+    Variant variant;
+    variant.module = factory->ExecutorCreate(devs);
+    variant.exec = dynamic_cast<GraphExecutor*>(variant.module.operator->());
+    for (const String& name : input_names) {
+      int index = variant.exec->GetInputIndex(name);
+      ICHECK_GE(index, 0) << "the model has no input named " << name;
+      variant.input_index.push_back(index);
+    }
+    NDArray first = variant.exec->GetInput(variant.input_index[0]);
+    ICHECK_GE(first->ndim, 1) << "batched input " << input_names[0] << " has no batch axis";
+    variant.batch_size = first->shape[0];
+    variants_.push_back(std::move(variant));
+  }
+  std::sort(variants_.begin(), variants_.end(),
+            [](const Variant& a, const Variant& b) { return a.batch_size < b.batch_size; });
+  max_batch_size_ = variants_.back().batch_size;
+
+  // Every variant must agree on the shape of one sample.
+  for (const Variant& variant : variants_) {
+    ICHECK_GT(variant.batch_size, 0);
+    for (size_t i = 0; i < variant.input_index.size(); ++i) {
+      NDArray input = variant.exec->GetInput(variant.input_index[i]);
+      ICHECK(input->ndim >= 1 && input->shape[0] == variant.batch_size)
+          << "input " << input_names[i] << " is not batched along axis 0";
+      size_t row_bytes = GetDataSize(*input.operator->()) / variant.batch_size;
+      if (input_row_bytes_.size() <= i) {
+        input_row_bytes_.push_back(row_bytes);
+        input_dtypes_.push_back(input->dtype);
+      }
+      ICHECK_EQ(input_row_bytes_[i], row_bytes)
+          << "variants disagree on the sample size of input " << input_names[i];
+    }
+    for (int i = 0; i < variant.exec->NumOutputs(); ++i) {
+      NDArray output = variant.exec->GetOutput(i);
+      ICHECK(output->ndim >= 1 && output->shape[0] == variant.batch_size)
+          << "output " << i << " is not batched along axis 0";
+      std::vector<int64_t> row_shape(output->shape, output->shape + output->ndim);
+      row_shape[0] = 1;
+      if (output_row_shapes_.size() <= static_cast<size_t>(i)) {
+        output_row_shapes_.push_back(row_shape);
+      }
+      ICHECK(output_row_shapes_[i] == row_shape)
+          << "variants disagree on the sample shape of output " << i;
+    }
+  }
+  thread_ = std::thread([this]() { this->BatchLoop(); });
+}
+
+BatchingExecutor::~BatchingExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  queue_cv_.notify_all();
+  thread_.join();
+}
+
+int64_t BatchingExecutor::Submit(const Array<NDArray>& inputs) {
+  ICHECK_EQ(inputs.size(), input_row_bytes_.size()) << "expect one array per batched input";
+  auto request = std::make_shared<Request>();
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    const NDArray& input = inputs[i];
+    ICHECK_EQ(GetDataSize(*input.operator->()), input_row_bytes_[i])
+        << "input " << i << " does not hold exactly one sample";
+    ICHECK(input->dtype.code == input_dtypes_[i].code &&
+           input->dtype.bits == input_dtypes_[i].bits &&
+           input->dtype.lanes == input_dtypes_[i].lanes)
+        << "input " << i << " has dtype " << DLDataType2String(input->dtype) << ", expect "
+        << DLDataType2String(input_dtypes_[i]);
+    request->inputs.push_back(input);
+  }
+  request->arrival = std::chrono::steady_clock::now();
+  int64_t id;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    id = next_id_++;
+    requests_[id] = request;
+    queue_.push_back(request);
+    ++num_requests_;
+  }
+  queue_cv_.notify_one();
+  return id;
+}
+
+Array<NDArray> BatchingExecutor::GetResult(int64_t id) {
+  std::shared_ptr<Request> request;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = requests_.find(id);
+    ICHECK(it != requests_.end()) << "unknown request " << id;
+    request = it->second;
+    done_cv_.wait(lock, [&request]() { return request->done; });
+    requests_.erase(id);
+  }
+  if (!request->error.empty()) {
+    LOG(FATAL) << request->error;
+  }
+  return Array<NDArray>(request->outputs.begin(), request->outputs.end());
+}
+
+void BatchingExecutor::BatchLoop() {
+  while (true) {
+    std::vector<std::shared_ptr<Request>> batch;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      queue_cv_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+      if (stop_ && queue_.empty()) return;
+      auto deadline = queue_.front()->arrival + max_delay_;
+      queue_cv_.wait_until(lock, deadline, [this]() {
+        return stop_ || static_cast<int64_t>(queue_.size()) >= max_batch_size_;
+      });
+      size_t num = std::min(queue_.size(), static_cast<size_t>(max_batch_size_));
+      batch.assign(queue_.begin(), queue_.begin() + num);
+      queue_.erase(queue_.begin(), queue_.begin() + num);
+    }
+    RunBatch(batch);
+  }
+}
+
+void BatchingExecutor::RunBatch(const std::vector<std::shared_ptr<Request>>& batch) {
+  const int64_t num = static_cast<int64_t>(batch.size());
+  auto variant = std::find_if(variants_.begin(), variants_.end(),
+                              [num](const Variant& v) { return v.batch_size >= num; });
+  ICHECK(variant != variants_.end());
+
+  std::string error;
+  try {
+    for (size_t i = 0; i < variant->input_index.size(); ++i) {
+      NDArray input = variant->exec->GetInput(variant->input_index[i]);
+      std::vector<int64_t> row_shape(input->shape, input->shape + input->ndim);
+      row_shape[0] = 1;
+      for (int64_t row = 0; row < num; ++row) {
+        DLTensor dst = RowView(input, row, input_row_bytes_[i], row_shape.data());
+        // Requests may come with or without the batch axis, only the bytes matter.
+        DLTensor src = *batch[row]->inputs[i].operator->();
+        src.ndim = dst.ndim;
+        src.shape = row_shape.data();
+        src.strides = nullptr;
+        NDArray::CopyFromTo(&src, &dst);
+      }
+    }
+    variant->exec->Run();
+    for (int64_t row = 0; row < num; ++row) {
+      batch[row]->outputs.clear();
+    }
+    for (int i = 0; i < variant->exec->NumOutputs(); ++i) {
+      NDArray output = variant->exec->GetOutput(i);
+      std::vector<int64_t>& row_shape = output_row_shapes_[i];
+      size_t row_bytes = GetDataSize(*output.operator->()) / variant->batch_size;
+      for (int64_t row = 0; row < num; ++row) {
+        NDArray out = NDArray::Empty(row_shape, output->dtype, output->device);
+        DLTensor src = RowView(output, row, row_bytes, row_shape.data());
+        out.CopyFrom(&src);
+        batch[row]->outputs.push_back(out);
+      }
+    }
+  } catch (const std::exception& e) {
+    error = e.what();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++variant->num_batches;
+    ++num_batches_;
+    for (const auto& request : batch) {
+      request->error = error;
+      request->inputs.clear();
+      request->done = true;
+    }
+  }
+  done_cv_.notify_all();
+}
+
+std::string BatchingExecutor::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::ostringstream os;
+  os << "{\"num_requests\": " << num_requests_ << ", \"num_batches\": " << num_batches_
+     << ", \"num_pending\": " << queue_.size() << ", \"batches_per_variant\": {";
+  for (size_t i = 0; i < variants_.size(); ++i) {
+    if (i != 0) os << ", ";
+    os << "\"" << variants_[i].batch_size << "\": " << variants_[i].num_batches;
+  }
+  os << "}}";
+  return os.str();
+}
+
+PackedFunc BatchingExecutor::GetFunction(const std::string& name,
+                                         const ObjectPtr<Object>& sptr_to_self) {
+  if (name == "submit") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      Array<NDArray> inputs;
+      for (int i = 0; i < args.num_args; ++i) {
+        inputs.push_back(args[i].operator NDArray());
+      }
+      *rv = this->Submit(inputs);
+    });
+  } else if (name == "get_result") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->GetResult(args[0]); });
+  } else if (name == "run") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      Array<NDArray> inputs;
+      for (int i = 0; i < args.num_args; ++i) {
+        inputs.push_back(args[i].operator NDArray());
+      }
+      *rv = this->GetResult(this->Submit(inputs));
+    });
+  } else if (name == "get_max_batch_size") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = max_batch_size_; });
+  } else if (name == "get_stats") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->GetStats(); });
+  } else {
+    return PackedFunc();
+  }
+}
+
+// The argument order is factories, input_names, max_delay_us, dev0_type, dev0_id, ...
+TVM_REGISTER_GLOBAL("tvm.batching_executor.create").set_body([](TVMArgs args, TVMRetValue* rv) {
+  ICHECK_GE(args.num_args, 5) << "The expected number of arguments for "
+                                 "batching_executor.create is at least 5, but it has "
+                              << args.num_args;
+  Array<Module> factories = args[0];
+  Array<String> input_names = args[1];
+  int64_t max_delay_us = args[2];
+  const auto& devices = GetAllDevice(args, 3);
+  auto exec = make_object<BatchingExecutor>(factories, input_names, devices,
+                                            std::chrono::microseconds(max_delay_us));
+  *rv = Module(exec);
+});
+
+}  // namespace runtime
+}  // namespace tvm
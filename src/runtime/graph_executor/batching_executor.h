@@ -0,0 +1,139 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \brief Executor coalescing single-sample requests into batches.
+ * \file batching_executor.h
+ */
+#ifndef TVM_RUNTIME_GRAPH_EXECUTOR_BATCHING_EXECUTOR_H_
+#define TVM_RUNTIME_GRAPH_EXECUTOR_BATCHING_EXECUTOR_H_
+
+#include <tvm/runtime/container/array.h>
+#include <tvm/runtime/container/string.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/packed_func.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "graph_executor.h"
+
+namespace tvm {
+namespace runtime {
+
+/*!
+ * \brief Serve single-sample requests with graph executors compiled for
+ *  several batch sizes.
+ *
+ *  Requests are queued. Once max_batch_size of them are pending, or the
+ *  oldest one has waited max_delay, the pending requests are copied row by
+ *  row into the inputs of the smallest variant that fits them. That variant
+ *  is run and every request receives its rows of the outputs. Rows beyond
+ *  the number of requests keep stale data, so the model must treat the
+ *  batch dimension, axis 0 of every batched input and of every output,
+ *  independently.
+ */
+class TVM_DLL BatchingExecutor : public ModuleNode {
+ public:
+  /*!
+   * \brief Create the executor.
+   * \param factories GraphExecutorFactory modules of the same model compiled
+   *  for different batch sizes.
+   * \param input_names The inputs provided with every request, all of them
+   *  batched along axis 0. Other inputs keep the values of the factory params.
+   * \param devs The devices to create the executors on.
+   * \param max_delay The longest time a request waits for others to join its batch.
+   */
+  BatchingExecutor(const Array<Module>& factories, const Array<String>& input_names,
+                   const std::vector<Device>& devs, std::chrono::microseconds max_delay);
+  ~BatchingExecutor();
+
+  const char* type_key() const final { return "BatchingExecutor"; }
+  PackedFunc GetFunction(const std::string& name, const ObjectPtr<Object>& sptr_to_self) final;
+
+  /*!
+   * \brief Queue a request.
+   * \param inputs One sample for each input, with or without the leading batch axis.
+   * \return The id to pass to GetResult.
+   */
+  int64_t Submit(const Array<NDArray>& inputs);
+  /*!
+   * \brief Wait for a request to finish.
+   * \param id The id returned by Submit.
+   * \return One sample of every output, with a leading batch axis of 1.
+   */
+  Array<NDArray> GetResult(int64_t id);
+  /*! \return Batching counters as JSON. */
+  std::string GetStats() const;
+
+ private:
+  struct Request {
+    std::vector<NDArray> inputs;
+    std::vector<NDArray> outputs;
+    std::chrono::steady_clock::time_point arrival;
+    std::string error;
+    bool done{false};
+  };
+
+  struct Variant {
+    Module module;
+    GraphExecutor* exec{nullptr};
+    int64_t batch_size{0};
+    std::vector<int> input_index;
+    /*! \brief Number of batches run with this variant. */
+    uint64_t num_batches{0};
+  };
+
+  /*! \brief The loop of the thread forming and running batches. */
+  void BatchLoop();
+  /*! \brief Run one batch and hand out the results. */
+  void RunBatch(const std::vector<std::shared_ptr<Request>>& batch);
+
+  std::vector<Variant> variants_;
+  /*! \brief Bytes and row shape (leading 1) of one sample of every input and output. */
+  std::vector<size_t> input_row_bytes_;
+  std::vector<DLDataType> input_dtypes_;
+  std::vector<std::vector<int64_t>> output_row_shapes_;
+  std::chrono::microseconds max_delay_;
+  int64_t max_batch_size_{0};
+
+  mutable std::mutex mutex_;
+  std::condition_variable queue_cv_;
+  std::condition_variable done_cv_;
+  std::deque<std::shared_ptr<Request>> queue_;
+  std::unordered_map<int64_t, std::shared_ptr<Request>> requests_;
+  int64_t next_id_{0};
+  bool stop_{false};
+  uint64_t num_requests_{0};
+  uint64_t num_batches_{0};
+  std::thread thread_;
+};
+
+}  // namespace runtime
+}  // namespace tvm
+
+#endif  // TVM_RUNTIME_GRAPH_EXECUTOR_BATCHING_EXECUTOR_H_
@@ -276,15 +276,22 @@ class GraphExecutorDebug : public GraphExecutor {
    * the module compared to GraphRuntimeDebug::RunIndividual as it runs the
    * entire graph in order.
    *
+   * \param collectors Additional metric collectors, their metrics become
+   * columns of the report.
+   *
    * \returns A table of per-op runtimes and total times.
    */
-  profiling::Report Profile() {
+  profiling::Report Profile(Array<profiling::MetricCollector> collectors) {
     // warm up. 1 iteration does not seem enough.
     for (int i = 0; i < 3; i++) {
       GraphExecutor::Run();
     }
 
-    profiling::Profiler prof;
+    std::vector<profiling::MetricCollector> cs;
+    for (profiling::MetricCollector collector : collectors) {
+      cs.push_back(collector);
+    }
+    profiling::Profiler prof(cs);
     prof.Start(devices_);
     for (size_t i = 0; i < op_execs_.size(); ++i) {
       if (op_execs_[i]) {
@@ -313,7 +320,13 @@ class GraphExecutorDebug : public GraphExecutor {
         }
         metrics["Argument Shapes"] = profiling::ShapeString(shapes);
         prof.StartCall(nodes_[i].param.func_name, dev, metrics);
-        op_execs_[i]();
+        try {
+          op_execs_[i]();
+        } catch (...) {
+          // Turn off the global tracing and memory tracking enabled by Start.
+          prof.Stop();
+          throw;
+        }
         prof.StopCall();
       }
     }
@@ -359,7 +372,13 @@ PackedFunc GraphExecutorDebug::GetFunction(const std::string& name,
       *rv = this->RunIndividual(number, repeat, min_repeat_ms);
     });
   } else if (name == "profile") {
-    return TypedPackedFunc<profiling::Report()>([sptr_to_self, this]() { return this->Profile(); });
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      Array<profiling::MetricCollector> collectors;
+      if (args.num_args > 0) {
+        collectors = args[0];
+      }
+      *rv = this->Profile(collectors);
+    });
   } else {
     return GraphExecutor::GetFunction(name, sptr_to_self);
   }
@@ -32,6 +32,8 @@
 #include <tvm/runtime/serializer.h>
 
 #include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <functional>
 #include <memory>
 #include <numeric>
@@ -56,10 +58,105 @@ inline size_t GetDataAlignment(const DLTensor& arr) {
  * \brief Run all the operations one by one.
  */
 void GraphExecutor::Run() {
+  const auto& op_execs = sampling_.SampleRun() ? SampledOpExecs() : op_execs_;
+  if (op_scheduler_) {
+    op_scheduler_->Run(op_execs);
+    return;
+  }
   // setup the array and requirements.
-  for (size_t i = 0; i < op_execs_.size(); ++i) {
-    if (op_execs_[i]) op_execs_[i]();
+  for (size_t i = 0; i < op_execs.size(); ++i) {
+    if (op_execs[i]) op_execs[i]();
+  }
+}
+
+const std::vector<std::function<void()>>& GraphExecutor::SampledOpExecs() {
+  if (sampled_op_execs_.size() == op_execs_.size()) return sampled_op_execs_;
+  sampled_op_execs_.assign(op_execs_.size(), nullptr);
+  for (uint32_t nid = 0; nid < op_execs_.size(); ++nid) {
+    if (!op_execs_[nid]) continue;
+    // The wrappers index op_execs_, so they stay valid when SetupOpExecs rebuilds it.
+    Device dev = data_entry_[entry_id(nid, 0)]->device;
+    if (dev.device_type == kDLCPU) {
+      sampled_op_execs_[nid] = [this, nid]() {
+        auto start = std::chrono::steady_clock::now();
+        op_execs_[nid]();
+        auto end = std::chrono::steady_clock::now();
+        sampling_.Record(nid, std::chrono::nanoseconds(end - start).count());
+      };
+    } else {
+      sampled_op_execs_[nid] = [this, nid, dev]() {
+        Timer timer = Timer::Start(dev);
+        op_execs_[nid]();
+        timer->Stop();
+        sampling_.Record(nid, timer->SyncAndGetElapsedNanos());
+      };
+    }
+  }
+  return sampled_op_execs_;
+}
+
+std::string GraphExecutor::GetSamplingStats() {
+  std::vector<std::string> names;
+  for (const Node& node : nodes_) {
+    names.push_back(node.name);
+  }
+  return sampling_.GetStats(names);
+}
+
+void GraphExecutor::SetConcurrency(int num_workers) {
+  op_scheduler_.reset();
+  if (num_workers <= 1) return;
+  for (const Device& dev : devices_) {
+    if (dev.device_type != kDLCPU) {
+      LOG(WARNING) << "Concurrent operator execution is only supported on CPU, running "
+                   << "the graph sequentially";
+      return;
+    }
+  }
+
+  // Operators are ordered by dependency edges through the storage they
+  // touch. Besides the data dependencies, this serializes the accesses to
+  // storage the memory plan shares among entries with disjoint lifetimes:
+  // a writer waits for the previous writer and for every reader since.
+  const uint32_t num_nodes = this->GetNumOfNodes();
+  std::vector<int64_t> last_writer(storage_pool_.size(), -1);
+  std::vector<std::vector<uint32_t>> readers(storage_pool_.size());
+  std::vector<std::vector<uint32_t>> successors(num_nodes);
+  std::vector<uint32_t> num_deps(num_nodes, 0);
+  std::vector<bool> active(num_nodes, false);
+  std::vector<uint32_t> deps;
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    const auto& inode = nodes_[nid];
+    if (inode.op_type == "null") continue;
+    active[nid] = true;
+    deps.clear();
+    for (const auto& e : inode.inputs) {
+      uint32_t sid = attrs_.storage_id[this->entry_id(e)];
+      if (last_writer[sid] >= 0) deps.push_back(static_cast<uint32_t>(last_writer[sid]));
+    }
+    for (uint32_t index = 0; index < inode.param.num_outputs; ++index) {
+      uint32_t sid = attrs_.storage_id[this->entry_id(nid, index)];
+      if (last_writer[sid] >= 0) deps.push_back(static_cast<uint32_t>(last_writer[sid]));
+      deps.insert(deps.end(), readers[sid].begin(), readers[sid].end());
+    }
+    std::sort(deps.begin(), deps.end());
+    deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+    for (uint32_t dep : deps) {
+      if (dep == nid) continue;
+      successors[dep].push_back(nid);
+      ++num_deps[nid];
+    }
+    for (const auto& e : inode.inputs) {
+      readers[attrs_.storage_id[this->entry_id(e)]].push_back(nid);
+    }
+    for (uint32_t index = 0; index < inode.param.num_outputs; ++index) {
+      uint32_t sid = attrs_.storage_id[this->entry_id(nid, index)];
+      last_writer[sid] = nid;
+      readers[sid].clear();
+    }
   }
+  op_scheduler_.reset(new GraphOpScheduler(std::move(successors), std::move(num_deps),
+                                           std::move(active), num_workers));
 }
 
 /*!
@@ -91,6 +188,9 @@ void GraphExecutor::Init(const std::string& graph_json, tvm::runtime::Module mod
     std::string& name = nodes_[nid].name;
     input_map_[name] = i;
   }
+  if (const char* val = getenv("TVM_GRAPH_EXECUTOR_CONCURRENCY")) {
+    this->SetConcurrency(atoi(val));
+  }
 }
 /*!
  * \brief Get the input index given the name of input.
@@ -139,6 +239,33 @@ void GraphExecutor::SetInputZeroCopy(int index, DLTensor* data_ref) {
     t->data = data_ref->data;
   }
 }
+/*!
+ * \brief Let the index-th output be written to data_ref without copying.
+ * \param index The output index.
+ * \param data_ref The output data that is referred.
+ */
+void GraphExecutor::SetOutputZeroCopy(int index, DLTensor* data_ref) {
+  ICHECK_LT(static_cast<size_t>(index), outputs_.size());
+  uint32_t eid = this->entry_id(outputs_[index]);
+  ICHECK(output_has_producer_[eid])
+      << "output " << index << " is not produced by an operator and cannot be redirected";
+  const DLTensor* old_t = data_entry_[eid].operator->();
+
+  // check the consistency of output
+  ICHECK_EQ(data_alignment_[eid], details::GetDataAlignment(*data_ref));
+  ICHECK_EQ(reinterpret_cast<size_t>(data_ref->data) % kAllocAlignment, 0);
+  ICHECK_EQ(old_t->ndim, static_cast<size_t>(data_ref->ndim));
+  ICHECK_EQ(old_t->device.device_type, data_ref->device.device_type);
+  ICHECK_EQ(old_t->device.device_id, data_ref->device.device_id);
+  for (auto i = 0; i < data_ref->ndim; ++i) {
+    ICHECK_EQ(old_t->shape[i], data_ref->shape[i]);
+  }
+
+  // Update the data pointer of the producer and of every consumer
+  for (DLTensor* t : output_dltensors_[eid]) {
+    t->data = data_ref->data;
+  }
+}
 /*!
  * \brief Get the number of outputs
  *
@@ -211,10 +338,34 @@ void GraphExecutor::LoadParams(dmlc::Stream* strm) {
   }
 }
 
+void GraphExecutor::LoadParamsFromFile(const std::string& file_name) {
+  Map<String, NDArray> params = ::tvm::runtime::LoadParamsFromFile(file_name);
+  for (auto& p : params) {
+    int in_idx = GetInputIndex(p.first);
+    if (in_idx < 0) continue;
+    uint32_t eid = this->entry_id(input_nodes_[in_idx], 0);
+    const NDArray& value = p.second;
+    const DLTensor* old_t = data_entry_[eid].operator->();
+    bool in_place = old_t->device.device_type == kDLCPU &&
+                    DataType(value->dtype) == DataType(old_t->dtype) &&
+                    value->ndim == old_t->ndim &&
+                    std::equal(old_t->shape, old_t->shape + old_t->ndim, value->shape) &&
+                    reinterpret_cast<size_t>(value->data) % kAllocAlignment == 0;
+    if (in_place) {
+      // The storage pool entry is left untouched, so its pages are never committed.
+      this->SetInputZeroCopy(in_idx, const_cast<DLTensor*>(value.operator->()));
+      data_entry_[eid] = value;
+    } else {
+      data_entry_[eid].CopyFrom(value);
+    }
+  }
+}
+
 void GraphExecutor::ShareParams(const GraphExecutor& other, dmlc::Stream* strm) {
   uint64_t header, reserved;
   ICHECK(strm->Read(&header)) << "Invalid parameters file format";
-  ICHECK(header == kTVMNDArrayListMagic) << "Invalid parameters file format";
+  ICHECK(header == kTVMNDArrayListMagic || header == kTVMNDArrayListAlignedMagic)
+      << "Invalid parameters file format";
   ICHECK(strm->Read(&reserved)) << "Invalid parameters file format";
   std::vector<std::string> names;
   ICHECK(strm->Read(&names)) << "Invalid parameters file format";
@@ -358,11 +509,17 @@ void GraphExecutor::SetupStorage() {
 void GraphExecutor::SetupOpExecs() {
   op_execs_.resize(this->GetNumOfNodes());
   input_dltensors_.resize(num_node_entries());
+  output_dltensors_.assign(num_node_entries(), {});
+  output_has_producer_.assign(num_node_entries(), false);
   std::unordered_set<uint32_t> input_node_eids;
   for (size_t i = 0; i < input_nodes_.size(); i++) {
     uint32_t nid = input_nodes_[i];
     input_node_eids.insert(entry_id(nid, 0));
   }
+  std::unordered_set<uint32_t> output_node_eids;
+  for (const auto& e : outputs_) {
+    output_node_eids.insert(entry_id(e));
+  }
 
   // setup the array and requirements.
   for (uint32_t nid = 0; nid < this->GetNumOfNodes(); ++nid) {
@@ -381,6 +538,9 @@ void GraphExecutor::SetupOpExecs() {
 
     std::shared_ptr<OpArgs> op_args = nullptr;
     std::tie(op_execs_[nid], op_args) = CreateTVMOp(inode.param, args, inode.inputs.size());
+    // A nop, e.g. a reshape, only aliases its input and never touches its arguments. Its
+    // output is written by the producer of the input, through a different DLTensor.
+    if (inode.param.func_name == "__nop") continue;
 
     for (size_t i = 0; i < inode.inputs.size(); i++) {
       uint32_t eid = this->entry_id(inode.inputs[i]);
@@ -388,6 +548,18 @@ void GraphExecutor::SetupOpExecs() {
       if (input_node_eids.count(eid) > 0) {
         input_dltensors_[eid].push_back(static_cast<DLTensor*>(op_args->arg_values[i].v_handle));
       }
+      // check if op input is model output
+      if (output_node_eids.count(eid) > 0) {
+        output_dltensors_[eid].push_back(static_cast<DLTensor*>(op_args->arg_values[i].v_handle));
+      }
+    }
+    for (uint32_t index = 0; index < inode.param.num_outputs; ++index) {
+      uint32_t eid = this->entry_id(nid, index);
+      if (output_node_eids.count(eid) > 0) {
+        output_dltensors_[eid].push_back(
+            static_cast<DLTensor*>(op_args->arg_values[inode.inputs.size() + index].v_handle));
+        output_has_producer_[eid] = true;
+      }
     }
   }
 }
@@ -463,6 +635,10 @@ PackedFunc GraphExecutor::GetFunction(const std::string& name,
         this->SetInputZeroCopy(args[0], args[1]);
       }
     });
+  } else if (name == "set_output_zero_copy") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      this->SetOutputZeroCopy(args[0], args[1]);
+    });
   } else if (name == "get_output") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       if (args.num_args == 2) {
@@ -491,10 +667,27 @@ PackedFunc GraphExecutor::GetFunction(const std::string& name,
         [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->NumInputs(); });
   } else if (name == "run") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { this->Run(); });
+  } else if (name == "set_concurrency") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { this->SetConcurrency(args[0]); });
+  } else if (name == "set_sampling_interval") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      this->SetSamplingInterval(args[0]);
+    });
+  } else if (name == "get_sampling_stats") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->GetSamplingStats(); });
+  } else if (name == "reset_sampling_stats") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { this->ResetSamplingStats(); });
   } else if (name == "load_params") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       this->LoadParams(args[0].operator std::string());
     });
+  } else if (name == "load_params_from_file") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      this->LoadParamsFromFile(args[0].operator std::string());
+    });
   } else if (name == "share_params") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       const auto& module = args[0].operator Module();
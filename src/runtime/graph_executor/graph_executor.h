@@ -30,6 +30,7 @@
 #include <dmlc/memory_io.h>
 #include <tvm/runtime/ndarray.h>
 #include <tvm/runtime/packed_func.h>
+#include <tvm/runtime/profiling.h>
 
 #include <memory>
 #include <string>
@@ -37,6 +38,8 @@
 #include <utility>
 #include <vector>
 
+#include "graph_op_scheduler.h"
+
 namespace tvm {
 namespace runtime {
 
@@ -85,6 +88,35 @@ class TVM_DLL GraphExecutor : public ModuleNode {
   const char* type_key() const final { return "GraphExecutor"; }
   void Run();
 
+  /*!
+   * \brief Set the number of operators that may run at the same time.
+   *
+   *  With more than one worker, Run dispatches every operator as soon as
+   *  the operators it depends on have finished. The dependencies include
+   *  the reuse of storage by the memory plan, so outputs are identical to
+   *  a sequential run. Only graphs placed entirely on the CPU are run
+   *  concurrently; other graphs keep running sequentially.
+   *
+   * \param num_workers The maximum number of concurrent operators,
+   *  0 or 1 selects sequential execution.
+   */
+  void SetConcurrency(int num_workers);
+
+  /*!
+   * \brief Time the operators of every interval-th run.
+   *
+   *  Sampled runs time every operator, synchronizing non-CPU devices after
+   *  each of them, and record the durations into per-operator histograms.
+   *  Other runs only pay for checking whether they are sampled.
+   *
+   * \param interval The sampling interval, 0 disables sampling.
+   */
+  void SetSamplingInterval(int64_t interval) { sampling_.SetInterval(interval); }
+  /*! \return The operator timing histograms of the sampled runs as JSON. */
+  std::string GetSamplingStats();
+  /*! \brief Discard the samples recorded so far. */
+  void ResetSamplingStats() { sampling_.Reset(); }
+
   /*!
    * \brief Initialize the graph executor with graph and device.
    * \param graph_json The execution graph.
@@ -119,6 +151,14 @@ class TVM_DLL GraphExecutor : public ModuleNode {
    * \param data_ref The input data that is referred.
    */
   void SetInputZeroCopy(int index, DLTensor* data_ref);
+  /*!
+   * \brief Let the index-th output be written to data_ref instead of the internal storage.
+   *  Operators consuming the output read it from data_ref as well. GetOutput keeps
+   *  returning the internal storage.
+   * \param index The output index.
+   * \param data_ref The output data that is referred.
+   */
+  void SetOutputZeroCopy(int index, DLTensor* data_ref);
   /*!
    * \brief Get the number of outputs
    *
@@ -161,6 +201,14 @@ class TVM_DLL GraphExecutor : public ModuleNode {
    * \param param_blob A binary blob of parameter.
    */
   void LoadParams(const std::string& param_blob);
+  /*!
+   * \brief Load parameters from a file saved by SaveParams or SaveParamsAligned.
+   *
+   *  The file is mapped into memory. Parameters of a CPU graph saved with
+   *  aligned data are used in place rather than copied into the storage pool.
+   * \param file_name The parameter file.
+   */
+  void LoadParamsFromFile(const std::string& file_name);
 
   /*!
    * \brief Share parameters from pre-existing GraphExecutor instance.
@@ -377,6 +425,8 @@ class TVM_DLL GraphExecutor : public ModuleNode {
   void SetupStorage();
   /*! \brief Setup the executors. */
   void SetupOpExecs();
+  /*! \return The operators wrapped to record their duration into sampling_. */
+  const std::vector<std::function<void()>>& SampledOpExecs();
   /*!
    * \brief Create an execution function given input.
    * \param attrs The node attributes.
@@ -400,6 +450,10 @@ class TVM_DLL GraphExecutor : public ModuleNode {
   std::unordered_map<std::string, uint32_t> input_map_;
   /*! \brief Used for quick node input DLTensor* lookup given an input eid. */
   std::vector<std::vector<DLTensor*>> input_dltensors_;
+  /*! \brief Used for quick node output DLTensor* lookup given an output eid. */
+  std::vector<std::vector<DLTensor*>> output_dltensors_;
+  /*! \brief Whether an output eid is written by an operator, and hence can be redirected. */
+  std::vector<bool> output_has_producer_;
   /*! \brief Used for quick entry indexing. */
   std::vector<uint32_t> node_row_ptr_;
   /*! \brief Output entries. */
@@ -418,6 +472,12 @@ class TVM_DLL GraphExecutor : public ModuleNode {
   std::vector<size_t> data_alignment_;
   /*! \brief Operator on each node. */
   std::vector<std::function<void()>> op_execs_;
+  /*! \brief Scheduler for concurrent execution, null when running sequentially. */
+  std::unique_ptr<GraphOpScheduler> op_scheduler_;
+  /*! \brief Sampling profiler of the operators, disabled by default. */
+  profiling::SamplingProfiler sampling_;
+  /*! \brief Timed wrappers of op_execs_, built on the first sampled run. */
+  std::vector<std::function<void()>> sampled_op_execs_;
   /*! \brief Linked parameter lookup function. */
   PackedFunc lookup_linked_param_;
   /*! \brief Module's _lookup_linked_param function, used by DefaultLookupLinkedParam. */
@@ -0,0 +1,160 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file graph_op_scheduler.cc
+ */
+#include "graph_op_scheduler.h"
+
+#include <tvm/runtime/logging.h>
+
+#include <utility>
+
+namespace tvm {
+namespace runtime {
+
+GraphOpScheduler::GraphOpScheduler(std::vector<std::vector<uint32_t>> successors,
+                                   std::vector<uint32_t> num_deps, std::vector<bool> active,
+                                   int num_workers)
+    : successors_(std::move(successors)),
+      num_deps_(std::move(num_deps)),
+      active_(std::move(active)),
+      num_workers_(num_workers) {
+  ICHECK_EQ(successors_.size(), num_deps_.size());
+  ICHECK_EQ(successors_.size(), active_.size());
+  ICHECK_GE(num_workers_, 1);
+  pending_.reset(new std::atomic<uint32_t>[successors_.size()]);
+  for (uint32_t nid = 0; nid < successors_.size(); ++nid) {
+    if (!active_[nid]) continue;
+    ++num_active_;
+    if (num_deps_[nid] == 0) roots_.push_back(nid);
+  }
+  // The calling thread of Run is the last worker.
+  for (int i = 1; i < num_workers_; ++i) {
+    threads_.emplace_back([this]() { this->WorkerLoop(); });
+  }
+}
+
+GraphOpScheduler::~GraphOpScheduler() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (std::thread& t : threads_) {
+    t.join();
+  }
+}
+
+void GraphOpScheduler::Run(const std::vector<std::function<void()>>& op_execs) {
+  ICHECK_EQ(op_execs.size(), successors_.size());
+  if (num_active_ == 0) return;
+  op_execs_ = &op_execs;
+  failed_.store(false, std::memory_order_relaxed);
+  error_ = nullptr;
+  for (size_t nid = 0; nid < num_deps_.size(); ++nid) {
+    pending_[nid].store(num_deps_[nid], std::memory_order_relaxed);
+  }
+  remaining_.store(num_active_, std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ready_.insert(ready_.end(), roots_.begin(), roots_.end());
+  }
+  cv_.notify_all();
+
+  while (true) {
+    uint32_t nid;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return !ready_.empty() || remaining_.load() == 0; });
+      if (ready_.empty()) break;
+      nid = ready_.front();
+      ready_.pop_front();
+    }
+    Execute(nid);
+  }
+  op_execs_ = nullptr;
+  if (error_) {
+    std::exception_ptr error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void GraphOpScheduler::WorkerLoop() {
+  while (true) {
+    uint32_t nid;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return stop_ || !ready_.empty(); });
+      if (stop_) return;
+      nid = ready_.front();
+      ready_.pop_front();
+    }
+    Execute(nid);
+  }
+}
+
+void GraphOpScheduler::Execute(uint32_t nid) {
+  std::vector<uint32_t> newly_ready;
+  while (true) {
+    const std::function<void()>& exec = (*op_execs_)[nid];
+    // After a failure the remaining operators are only retired so that Run
+    // can return; none of them is executed.
+    if (exec && !failed_.load(std::memory_order_relaxed)) {
+      try {
+        exec();
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error_) error_ = std::current_exception();
+        failed_.store(true, std::memory_order_relaxed);
+      }
+    }
+    newly_ready.clear();
+    for (uint32_t succ : successors_[nid]) {
+      if (pending_[succ].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        newly_ready.push_back(succ);
+      }
+    }
+    if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      // Take the lock so that the waiting caller cannot miss the wakeup.
+      { std::lock_guard<std::mutex> lock(mutex_); }
+      cv_.notify_all();
+      return;
+    }
+    if (newly_ready.empty()) return;
+    // Keep the first ready successor on this thread, it consumes data that
+    // is likely still in cache, and hand the others to idle workers.
+    if (newly_ready.size() > 1) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ready_.insert(ready_.end(), newly_ready.begin() + 1, newly_ready.end());
+      }
+      if (newly_ready.size() == 2) {
+        cv_.notify_one();
+      } else {
+        cv_.notify_all();
+      }
+    }
+    nid = newly_ready[0];
+  }
+}
+
+}  // namespace runtime
+}  // namespace tvm
@@ -0,0 +1,111 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \brief Dependency driven scheduler which runs independent operators
+ *        of a graph concurrently.
+ * \file graph_op_scheduler.h
+ */
+#ifndef TVM_RUNTIME_GRAPH_EXECUTOR_GRAPH_OP_SCHEDULER_H_
+#define TVM_RUNTIME_GRAPH_EXECUTOR_GRAPH_OP_SCHEDULER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tvm {
+namespace runtime {
+
+/*!
+ * \brief Run the operators of a graph over a bounded set of threads.
+ *
+ *  The scheduler is given the operator DAG once. Every Run dispatches an
+ *  operator as soon as all of its predecessors have finished. The calling
+ *  thread takes part in the execution, so at most num_workers operators
+ *  run at the same time.
+ *
+ *  Operators which use TVMBackendParallelLaunch internally launch from
+ *  several threads at once. The work stealing thread pool
+ *  (TVM_THREAD_POOL_KIND=work_stealing) shares one set of workers among
+ *  all of them. The default pool creates one per calling thread.
+ */
+class GraphOpScheduler {
+ public:
+  /*!
+   * \brief Create the scheduler.
+   * \param successors The successors of each node.
+   * \param num_deps The number of predecessors of each node.
+   * \param active Whether each node takes part in the execution at all.
+   * \param num_workers The maximum number of operators running at once.
+   */
+  GraphOpScheduler(std::vector<std::vector<uint32_t>> successors, std::vector<uint32_t> num_deps,
+                   std::vector<bool> active, int num_workers);
+  ~GraphOpScheduler();
+  /*!
+   * \brief Execute the graph once.
+   * \param op_execs The operator of each node; empty entries are skipped.
+   *
+   *  If an operator throws, no further operator is started and the first
+   *  error is rethrown once the operators already running have finished.
+   */
+  void Run(const std::vector<std::function<void()>>& op_execs);
+  /*! \return The maximum number of operators running at once. */
+  int num_workers() const { return num_workers_; }
+
+ private:
+  /*! \brief Loop executed by the helper threads. */
+  void WorkerLoop();
+  /*! \brief Execute nid and then every operator it makes ready, pushing extras to the queue. */
+  void Execute(uint32_t nid);
+
+  std::vector<std::vector<uint32_t>> successors_;
+  std::vector<uint32_t> num_deps_;
+  std::vector<bool> active_;
+  std::vector<uint32_t> roots_;
+  uint32_t num_active_{0};
+  int num_workers_;
+
+  /*! \brief Remaining predecessors of each node during the current run. */
+  std::unique_ptr<std::atomic<uint32_t>[]> pending_;
+  /*! \brief Operators that have not finished in the current run. */
+  std::atomic<uint32_t> remaining_{0};
+  /*! \brief The operators of the current run. */
+  const std::vector<std::function<void()>>* op_execs_{nullptr};
+  /*! \brief Set once an operator failed in the current run. */
+  std::atomic<bool> failed_{false};
+  std::exception_ptr error_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<uint32_t> ready_;
+  bool stop_{false};
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace runtime
+}  // namespace tvm
+
+#endif  // TVM_RUNTIME_GRAPH_EXECUTOR_GRAPH_OP_SCHEDULER_H_
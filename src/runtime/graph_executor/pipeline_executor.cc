@@ -0,0 +1,281 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file pipeline_executor.cc
+ */
+#include "pipeline_executor.h"
+
+#include <tvm/runtime/container/shape_tuple.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/runtime/threading_backend.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <sstream>
+#include <utility>
+
+namespace tvm {
+namespace runtime {
+
+namespace {
+uint64_t ElapsedNs(std::chrono::steady_clock::time_point begin,
+                   std::chrono::steady_clock::time_point end) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+}
+}  // namespace
+
+PipelineExecutor::PipelineExecutor(const Array<Module>& stages,
+                                   const Array<Array<String>>& input_names,
+                                   const std::vector<std::vector<unsigned int>>& cpus,
+                                   int queue_depth)
+    : outputs_(std::numeric_limits<size_t>::max()) {
+  ICHECK_GT(stages.size(), 0U) << "a pipeline needs at least one stage";
+  ICHECK_EQ(stages.size(), input_names.size());
+  ICHECK(cpus.empty() || cpus.size() == stages.size())
+      << "expect one CPU list per stage, got " << cpus.size() << " for " << stages.size()
+      << " stages";
+  ICHECK_GE(queue_depth, 1);
+
+  for (size_t sid = 0; sid < stages.size(); ++sid) {
+    std::unique_ptr<Stage> stage(new Stage());
+    stage->module = stages[sid];
+    stage->exec = dynamic_cast<GraphExecutor*>(stage->module.operator->());
+    ICHECK(stage->exec != nullptr) << "pipeline stage " << sid << " is a "
+                                   << stage->module->type_key() << ", expect a GraphExecutor";
+    if (sid > 0) {
+      ICHECK_EQ(static_cast<int>(input_names[sid].size()), stages_[sid - 1]->exec->NumOutputs())
+          << "stage " << sid << " must take every output of stage " << sid - 1;
+    }
+    for (const String& name : input_names[sid]) {
+      int index = stage->exec->GetInputIndex(name);
+      ICHECK_GE(index, 0) << "stage " << sid << " has no input named " << name;
+      stage->input_index.push_back(index);
+    }
+    if (!cpus.empty()) stage->cpus = cpus[sid];
+    stage->queue.reset(new BoundedQueue<std::shared_ptr<Request>>(queue_depth));
+    stage->buffers.reset(new BoundedQueue<std::vector<NDArray>>(queue_depth + 1));
+    stages_.push_back(std::move(stage));
+  }
+  for (size_t i = 0; i < input_names[0].size(); ++i) {
+    input_map_[input_names[0][i]] = static_cast<int>(i);
+  }
+  pending_inputs_.resize(input_names[0].size());
+
+  // The last stage hands freshly allocated outputs to the caller instead.
+  for (size_t sid = 0; sid + 1 < stages_.size(); ++sid) {
+    for (int i = 0; i <= queue_depth; ++i) {
+      stages_[sid]->buffers->Push(AllocOutputs(sid));
+    }
+  }
+  for (size_t sid = 0; sid < stages_.size(); ++sid) {
+    stages_[sid]->thread = std::thread([this, sid]() { this->StageLoop(static_cast<int>(sid)); });
+  }
+}
+
+PipelineExecutor::~PipelineExecutor() {
+  for (auto& stage : stages_) {
+    stage->queue->Close();
+    stage->buffers->Close();
+  }
+  outputs_.Close();
+  for (auto& stage : stages_) {
+    stage->thread.join();
+  }
+}
+
+std::vector<NDArray> PipelineExecutor::AllocOutputs(int sid) const {
+  GraphExecutor* exec = stages_[sid]->exec;
+  std::vector<NDArray> outputs;
+  for (int i = 0; i < exec->NumOutputs(); ++i) {
+    NDArray out = exec->GetOutput(i);
+    outputs.push_back(NDArray::Empty(out.Shape(), out->dtype, out->device));
+  }
+  return outputs;
+}
+
+void PipelineExecutor::StageLoop(int sid) {
+  Stage* stage = stages_[sid].get();
+  const bool last = static_cast<size_t>(sid) + 1 == stages_.size();
+  if (!stage->cpus.empty()) {
+    threading::Configure(threading::ThreadGroup::kSpecifyOneCorePerThread,
+                         static_cast<int>(stage->cpus.size()), stage->cpus);
+  }
+
+  std::shared_ptr<Request> request;
+  while (stage->queue->Pop(&request)) {
+    std::vector<NDArray> outputs;
+    if (request->error.empty()) {
+      auto begin = std::chrono::steady_clock::now();
+      if (last) {
+        outputs = AllocOutputs(sid);
+      } else if (!stage->buffers->Pop(&outputs)) {
+        break;
+      }
+      auto start = std::chrono::steady_clock::now();
+      try {
+        for (size_t i = 0; i < stage->input_index.size(); ++i) {
+          DLTensor* data = const_cast<DLTensor*>(request->tensors[i].operator->());
+          // Pipeline inputs come from the caller, who may free or reuse them after
+          // the request, so they are copied. Every later stage reads buffers of its
+          // pool, which stay alive and are never mixed with copied inputs.
+          if (sid == 0) {
+            stage->exec->SetInput(stage->input_index[i], data);
+          } else {
+            stage->exec->SetInputZeroCopy(stage->input_index[i], data);
+          }
+        }
+        for (size_t i = 0; i < outputs.size(); ++i) {
+          stage->exec->SetOutputZeroCopy(static_cast<int>(i),
+                                         const_cast<DLTensor*>(outputs[i].operator->()));
+        }
+        stage->exec->Run();
+      } catch (const std::exception& e) {
+        std::ostringstream os;
+        os << "pipeline stage " << sid << " failed: " << e.what();
+        request->error = os.str();
+      }
+      auto end = std::chrono::steady_clock::now();
+      uint64_t elapsed = ElapsedNs(start, end);
+      stage->num_runs.fetch_add(1, std::memory_order_relaxed);
+      stage->total_ns.fetch_add(elapsed, std::memory_order_relaxed);
+      stage->wait_ns.fetch_add(ElapsedNs(begin, start), std::memory_order_relaxed);
+      uint64_t max_ns = stage->max_ns.load(std::memory_order_relaxed);
+      while (elapsed > max_ns && !stage->max_ns.compare_exchange_weak(max_ns, elapsed)) {
+      }
+    }
+
+    // The inputs have been consumed, give them back to the stage producing them.
+    if (request->owner >= 0) {
+      stages_[request->owner]->buffers->Push(std::move(request->tensors));
+    }
+    request->tensors.clear();
+    request->owner = -1;
+    if (request->error.empty()) {
+      request->tensors = std::move(outputs);
+      request->owner = last ? -1 : sid;
+    } else if (!last && !outputs.empty()) {
+      stage->buffers->Push(std::move(outputs));
+    }
+    bool pushed = last ? outputs_.Push(std::move(request))
+                       : stages_[sid + 1]->queue->Push(std::move(request));
+    if (!pushed) break;
+  }
+}
+
+void PipelineExecutor::SetInput(const std::string& name, NDArray data) {
+  auto it = input_map_.find(name);
+  ICHECK(it != input_map_.end()) << "pipeline has no input named " << name;
+  pending_inputs_[it->second] = data;
+}
+
+void PipelineExecutor::Run() {
+  for (const auto& it : input_map_) {
+    ICHECK(pending_inputs_[it.second].defined()) << "input " << it.first << " is not set";
+  }
+  auto request = std::make_shared<Request>();
+  request->tensors = pending_inputs_;
+  ICHECK(stages_[0]->queue->Push(std::move(request))) << "the pipeline has been shut down";
+  ++in_flight_;
+}
+
+Array<NDArray> PipelineExecutor::GetOutput() {
+  ICHECK_GT(in_flight_, 0) << "no request has been submitted by run";
+  std::shared_ptr<Request> request;
+  ICHECK(outputs_.Pop(&request)) << "the pipeline has been shut down";
+  --in_flight_;
+  if (!request->error.empty()) {
+    LOG(FATAL) << request->error;
+  }
+  return Array<NDArray>(request->tensors.begin(), request->tensors.end());
+}
+
+std::string PipelineExecutor::GetStageStats() const {
+  std::ostringstream os;
+  os << "[";
+  for (size_t sid = 0; sid < stages_.size(); ++sid) {
+    const Stage& stage = *stages_[sid];
+    uint64_t num_runs = stage.num_runs.load(std::memory_order_relaxed);
+    double total_us = stage.total_ns.load(std::memory_order_relaxed) / 1e3;
+    if (sid != 0) os << ", ";
+    os << "{\"stage\": " << sid << ", \"num_runs\": " << num_runs
+       << ", \"total_us\": " << total_us
+       << ", \"mean_us\": " << (num_runs == 0 ? 0.0 : total_us / num_runs)
+       << ", \"max_us\": " << stage.max_ns.load(std::memory_order_relaxed) / 1e3
+       << ", \"wait_us\": " << stage.wait_ns.load(std::memory_order_relaxed) / 1e3 << "}";
+  }
+  os << "]";
+  return os.str();
+}
+
+void PipelineExecutor::ResetStageStats() {
+  for (auto& stage : stages_) {
+    stage->num_runs = 0;
+    stage->total_ns = 0;
+    stage->max_ns = 0;
+    stage->wait_ns = 0;
+  }
+}
+
+PackedFunc PipelineExecutor::GetFunction(const std::string& name,
+                                         const ObjectPtr<Object>& sptr_to_self) {
+  if (name == "set_input") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      this->SetInput(args[0].operator String(), args[1]);
+    });
+  } else if (name == "run") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { this->Run(); });
+  } else if (name == "get_output") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->GetOutput(); });
+  } else if (name == "get_num_stages") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      *rv = static_cast<int>(stages_.size());
+    });
+  } else if (name == "get_stage") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      int sid = args[0];
+      ICHECK_LT(static_cast<size_t>(sid), stages_.size());
+      *rv = stages_[sid]->module;
+    });
+  } else if (name == "get_stage_stats") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->GetStageStats(); });
+  } else if (name == "reset_stage_stats") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { this->ResetStageStats(); });
+  } else {
+    return PackedFunc();
+  }
+}
+
+TVM_REGISTER_GLOBAL("tvm.pipeline_executor.create")
+    .set_body_typed([](Array<Module> stages, Array<Array<String>> input_names,
+                       Array<ShapeTuple> cpus, int queue_depth) {
+      std::vector<std::vector<unsigned int>> stage_cpus;
+      for (const ShapeTuple& cpu_list : cpus) {
+        stage_cpus.emplace_back(cpu_list.begin(), cpu_list.end());
+      }
+      auto exec = make_object<PipelineExecutor>(stages, input_names, stage_cpus, queue_depth);
+      return Module(exec);
+    });
+
+}  // namespace runtime
+}  // namespace tvm
@@ -0,0 +1,188 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \brief Executor running a chain of graph executors as a pipeline.
+ * \file pipeline_executor.h
+ */
+#ifndef TVM_RUNTIME_GRAPH_EXECUTOR_PIPELINE_EXECUTOR_H_
+#define TVM_RUNTIME_GRAPH_EXECUTOR_PIPELINE_EXECUTOR_H_
+
+#include <tvm/runtime/container/array.h>
+#include <tvm/runtime/container/string.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/packed_func.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "graph_executor.h"
+
+namespace tvm {
+namespace runtime {
+
+/*!
+ * \brief A blocking FIFO queue with a fixed capacity.
+ */
+template <typename T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity) : capacity_(capacity) {}
+  /*!
+   * \brief Push an item, blocking while the queue is full.
+   * \return false if the queue was closed.
+   */
+  bool Push(T item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this]() { return closed_ || items_.size() < capacity_; });
+    if (closed_) return false;
+    items_.push_back(std::move(item));
+    not_empty_.notify_one();
+    return true;
+  }
+  /*!
+   * \brief Pop an item, blocking while the queue is empty.
+   * \return false if the queue was closed and drained.
+   */
+  bool Pop(T* item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this]() { return closed_ || !items_.empty(); });
+    if (items_.empty()) return false;
+    *item = std::move(items_.front());
+    items_.pop_front();
+    not_full_.notify_one();
+    return true;
+  }
+  /*! \brief Wake up all waiters, later pushes fail. */
+  void Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    not_full_.notify_all();
+    not_empty_.notify_all();
+  }
+
+ private:
+  size_t capacity_;
+  bool closed_{false};
+  std::deque<T> items_;
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+};
+
+/*!
+ * \brief Run K graph executors as a pipeline, stage i working on request n
+ *  while stage i + 1 works on request n - 1.
+ *
+ *  Output j of stage i is input j of stage i + 1. Each stage runs on its own
+ *  thread whose thread pool is pinned to the stage's CPU list. Stage outputs
+ *  are written through SetOutputZeroCopy into buffers taken from a per-stage
+ *  pool. The next stage reads them through SetInputZeroCopy and gives them
+ *  back once it has run, so tensors never get copied between stages. The
+ *  pool holds queue_depth + 1 buffer sets, which bounds the number of requests
+ *  in flight between two stages. The first stage copies the inputs of each
+ *  request, so no executor keeps pointing at caller tensors after a run.
+ */
+class TVM_DLL PipelineExecutor : public ModuleNode {
+ public:
+  /*!
+   * \brief Create the pipeline.
+   * \param stages The graph executor of every stage.
+   * \param input_names The input names of every stage, in the order of the
+   *  outputs of the previous stage. The names of the first stage are the
+   *  inputs of the pipeline.
+   * \param cpus The CPU ids each stage runs on, empty lists leave the
+   *  stage unpinned.
+   * \param queue_depth Maximum number of requests waiting in front of a stage.
+   */
+  PipelineExecutor(const Array<Module>& stages, const Array<Array<String>>& input_names,
+                   const std::vector<std::vector<unsigned int>>& cpus, int queue_depth);
+  ~PipelineExecutor();
+
+  const char* type_key() const final { return "PipelineExecutor"; }
+  PackedFunc GetFunction(const std::string& name, const ObjectPtr<Object>& sptr_to_self) final;
+
+  /*!
+   * \brief Set an input of the next request. The array is referenced, not copied,
+   *  until the request has passed the first stage.
+   */
+  void SetInput(const std::string& name, NDArray data);
+  /*!
+   * \brief Submit the inputs set so far as a request, blocks while the
+   *  first stage is saturated.
+   */
+  void Run();
+  /*! \brief Wait for the oldest request in flight and return its outputs. */
+  Array<NDArray> GetOutput();
+  /*! \return The latency counters of every stage as JSON. */
+  std::string GetStageStats() const;
+  /*! \brief Clear the latency counters. */
+  void ResetStageStats();
+
+ private:
+  struct Request {
+    /*! \brief The input tensors of the stage the request is queued in front of. */
+    std::vector<NDArray> tensors;
+    /*! \brief Stage whose buffer pool owns the tensors, -1 if not pooled. */
+    int owner{-1};
+    /*! \brief Error raised by one of the stages. */
+    std::string error;
+  };
+
+  struct Stage {
+    Module module;
+    GraphExecutor* exec{nullptr};
+    std::vector<int> input_index;
+    std::vector<unsigned int> cpus;
+    std::unique_ptr<BoundedQueue<std::shared_ptr<Request>>> queue;
+    /*! \brief Free output buffer sets. */
+    std::unique_ptr<BoundedQueue<std::vector<NDArray>>> buffers;
+    std::thread thread;
+    /*! \brief Latency counters in nanoseconds. */
+    std::atomic<uint64_t> num_runs{0};
+    std::atomic<uint64_t> total_ns{0};
+    std::atomic<uint64_t> max_ns{0};
+    std::atomic<uint64_t> wait_ns{0};
+  };
+
+  /*! \brief The loop of the thread driving stage sid. */
+  void StageLoop(int sid);
+  /*! \brief Allocate a set of buffers matching the outputs of a stage. */
+  std::vector<NDArray> AllocOutputs(int sid) const;
+
+  std::vector<std::unique_ptr<Stage>> stages_;
+  std::unordered_map<std::string, int> input_map_;
+  std::vector<NDArray> pending_inputs_;
+  BoundedQueue<std::shared_ptr<Request>> outputs_;
+  /*! \brief Number of submitted requests whose outputs were not fetched. */
+  int64_t in_flight_{0};
+};
+
+}  // namespace runtime
+}  // namespace tvm
+
+#endif  // TVM_RUNTIME_GRAPH_EXECUTOR_PIPELINE_EXECUTOR_H_
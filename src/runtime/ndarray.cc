@@ -25,6 +25,7 @@
 #include <tvm/runtime/device_api.h>
 #include <tvm/runtime/logging.h>
 #include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/profiling.h>
 #include <tvm/runtime/registry.h>
 
 #include "runtime_base.h"
@@ -105,6 +106,8 @@ struct NDArray::Internal {
     } else if (ptr->dl_tensor.data != nullptr) {
       tvm::runtime::DeviceAPI::Get(ptr->dl_tensor.device)
           ->FreeDataSpace(ptr->dl_tensor.device, ptr->dl_tensor.data);
+      profiling::MemoryTracker::Free(profiling::MemoryTracker::kTensor, ptr->dl_tensor.device,
+                                     GetDataSize(ptr->dl_tensor));
     }
     delete ptr;
   }
@@ -195,6 +198,8 @@ NDArray NDArray::Empty(ShapeTuple shape, DLDataType dtype, Device dev, Optional<
   ret.get_mutable()->dl_tensor.data =
       DeviceAPI::Get(ret->device)
           ->AllocDataSpace(ret->device, shape.size(), shape.data(), ret->dtype, mem_scope);
+  profiling::MemoryTracker::Alloc(profiling::MemoryTracker::kTensor, ret->device,
+                                  GetDataSize(*ret.operator->()));
   return ret;
 }
 
@@ -240,6 +245,15 @@ void NDArray::CopyFromTo(const DLTensor* from, DLTensor* to, TVMStreamHandle str
   // api manager.
   Device dev = from->device.device_type != kDLCPU ? from->device : to->device;
 
+  // Asynchronous copies only show the time taken to enqueue them.
+  profiling::TraceScope scope("DeviceCopy", "copy");
+  if (scope.active()) {
+    scope.AddArg("bytes", std::to_string(from_size));
+    scope.AddArg("from", DeviceName(from->device.device_type) +
+                             std::to_string(from->device.device_id));
+    scope.AddArg("to",
+                 DeviceName(to->device.device_type) + std::to_string(to->device.device_id));
+  }
   DeviceAPI::Get(dev)->CopyDataFromTo(const_cast<DLTensor*>(from), to, stream);
 }
 
@@ -0,0 +1,272 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file src/runtime/perf_event.cc
+ * \brief Metric collector reading CPU performance counters with perf_event_open.
+ */
+#include <tvm/runtime/profiling.h>
+#include <tvm/runtime/registry.h>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#endif
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tvm {
+namespace runtime {
+namespace profiling {
+
+#if defined(__linux__)
+
+namespace {
+
+struct PerfEvent {
+  const char* name;
+  uint32_t type;
+  uint64_t config;
+};
+
+constexpr uint64_t CacheEvent(uint64_t cache, uint64_t op, uint64_t result) {
+  return cache | (op << 8) | (result << 16);
+}
+
+/*! \brief The events known by name, using the names of the perf tool. */
+const PerfEvent kPerfEvents[] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"cache-references", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+    {"cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"branch-instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+    {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"stalled-cycles-frontend", PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_FRONTEND},
+    {"stalled-cycles-backend", PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND},
+    {"L1-dcache-loads", PERF_TYPE_HW_CACHE,
+     CacheEvent(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                PERF_COUNT_HW_CACHE_RESULT_ACCESS)},
+    {"L1-dcache-load-misses", PERF_TYPE_HW_CACHE,
+     CacheEvent(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"LLC-loads", PERF_TYPE_HW_CACHE,
+     CacheEvent(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ,
+                PERF_COUNT_HW_CACHE_RESULT_ACCESS)},
+    {"LLC-load-misses", PERF_TYPE_HW_CACHE,
+     CacheEvent(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ,
+                PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"dTLB-load-misses", PERF_TYPE_HW_CACHE,
+     CacheEvent(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"task-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+    {"page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+    {"context-switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+    {"cpu-migrations", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS},
+};
+
+PerfEvent ParsePerfEvent(const std::string& name) {
+  for (const PerfEvent& event : kPerfEvents) {
+    if (name == event.name) return event;
+  }
+  if (name.size() > 1 && name[0] == 'r') {
+    char* end = nullptr;
+    uint64_t config = std::strtoull(name.c_str() + 1, &end, 16);
+    if (*end == '\0') return PerfEvent{nullptr, PERF_TYPE_RAW, config};
+  }
+  LOG(FATAL) << "Unknown perf event " << name
+             << ", expect a perf event name or a raw event of the form rNNNN";
+  return PerfEvent{};
+}
+
+std::vector<int> ThreadIds() {
+  std::vector<int> tids;
+  DIR* dir = opendir("/proc/self/task");
+  if (dir == nullptr) return {static_cast<int>(syscall(SYS_gettid))};
+  while (dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') tids.push_back(std::atoi(entry->d_name));
+  }
+  closedir(dir);
+  return tids;
+}
+
+}  // namespace
+
+/*! \brief Counter values at the start of a call. */
+class PerfEventSnapshotNode : public Object {
+ public:
+  /*! \brief For every thread the time enabled, the time running and the counts. */
+  std::vector<uint64_t> values;
+
+  static constexpr const char* _type_key = "runtime.profiling.PerfEventSnapshot";
+  TVM_DECLARE_FINAL_OBJECT_INFO(PerfEventSnapshotNode, Object);
+};
+
+/*!
+ * \brief Count CPU events of every thread of the process.
+ *
+ *  One counter group is opened per thread existing at `Init`, so threads of
+ *  the thread pool must have been started by then, which the warm up runs of
+ *  the executors take care of. Only user space is counted so that the
+ *  collector works with the default perf_event_paranoid setting. Counts are
+ *  scaled by the fraction of time the group was scheduled on the PMU.
+ */
+class PerfEventMetricCollectorNode final : public MetricCollectorNode {
+ public:
+  explicit PerfEventMetricCollectorNode(const std::vector<std::string>& names) : names_(names) {
+    for (const std::string& name : names_) {
+      events_.push_back(ParsePerfEvent(name));
+    }
+  }
+
+  ~PerfEventMetricCollectorNode() { Close(); }
+
+  void Init(const std::vector<Device>& devs) final {
+    Close();
+    int self = static_cast<int>(syscall(SYS_gettid));
+    for (int tid : ThreadIds()) {
+      std::vector<int> fds;
+      for (size_t i = 0; i < events_.size(); ++i) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events_[i].type;
+        attr.config = events_[i].config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+        int leader = fds.empty() ? -1 : fds[0];
+        int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, tid, -1, leader, 0));
+        if (fd < 0) {
+          // Threads may exit between listing and opening, only the caller must be countable.
+          ICHECK_NE(tid, self) << "Cannot open perf event " << names_[i] << ": "
+                               << std::strerror(errno)
+                               << ". Check that the CPU exposes it and that "
+                                  "/proc/sys/kernel/perf_event_paranoid is at most 2.";
+          break;
+        }
+        fds.push_back(fd);
+      }
+      if (fds.size() == events_.size()) {
+        groups_.push_back(std::move(fds));
+      } else {
+        for (int fd : fds) close(fd);
+      }
+    }
+  }
+
+  ObjectRef Start(Device dev) final {
+    if (dev.device_type != kDLCPU) return ObjectRef();
+    auto snapshot = make_object<PerfEventSnapshotNode>();
+    Read(&snapshot->values);
+    return ObjectRef(snapshot);
+  }
+
+  Map<String, ObjectRef> Stop(ObjectRef obj) final {
+    const auto* start = obj.as<PerfEventSnapshotNode>();
+    ICHECK(start != nullptr);
+    std::vector<uint64_t> end;
+    Read(&end);
+    std::vector<double> counts(events_.size(), 0.0);
+    size_t stride = events_.size() + 2;
+    for (size_t g = 0; g < groups_.size(); ++g) {
+      const uint64_t* a = &start->values[g * stride];
+      const uint64_t* b = &end[g * stride];
+      uint64_t enabled = b[0] - a[0];
+      uint64_t running = b[1] - a[1];
+      if (running == 0) continue;
+      double scale = static_cast<double>(enabled) / running;
+      for (size_t i = 0; i < events_.size(); ++i) {
+        counts[i] += (b[i + 2] - a[i + 2]) * scale;
+      }
+    }
+    Map<String, ObjectRef> metrics;
+    for (size_t i = 0; i < events_.size(); ++i) {
+      metrics.Set(names_[i], ObjectRef(make_object<CountNode>(static_cast<int64_t>(counts[i]))));
+    }
+    return metrics;
+  }
+
+  static constexpr const char* _type_key = "runtime.profiling.PerfEventMetricCollector";
+  TVM_DECLARE_FINAL_OBJECT_INFO(PerfEventMetricCollectorNode, MetricCollectorNode);
+
+ private:
+  void Read(std::vector<uint64_t>* values) {
+    size_t stride = events_.size() + 2;
+    values->assign(groups_.size() * stride, 0);
+    // Group read layout: nr, time_enabled, time_running, then one value per event.
+    std::vector<uint64_t> buf(stride + 1);
+    for (size_t g = 0; g < groups_.size(); ++g) {
+      ssize_t n = read(groups_[g][0], buf.data(), buf.size() * sizeof(uint64_t));
+      if (n != static_cast<ssize_t>(buf.size() * sizeof(uint64_t))) continue;
+      std::copy(buf.begin() + 1, buf.end(), values->begin() + g * stride);
+    }
+  }
+
+  void Close() {
+    for (auto& fds : groups_) {
+      for (int fd : fds) close(fd);
+    }
+    groups_.clear();
+  }
+
+  std::vector<std::string> names_;
+  std::vector<PerfEvent> events_;
+  /*! \brief The counters of every thread, the group leader first. */
+  std::vector<std::vector<int>> groups_;
+};
+
+TVM_REGISTER_OBJECT_TYPE(PerfEventSnapshotNode);
+TVM_REGISTER_OBJECT_TYPE(PerfEventMetricCollectorNode);
+
+MetricCollector PerfEventMetricCollector(Array<String> events) {
+  std::vector<std::string> names;
+  for (const String& event : events) {
+    names.push_back(event);
+  }
+  if (names.empty()) {
+    names = {"cycles", "instructions", "cache-misses", "branch-misses"};
+  }
+  return MetricCollector(make_object<PerfEventMetricCollectorNode>(names));
+}
+
+#else
+
+MetricCollector PerfEventMetricCollector(Array<String> events) {
+  LOG(FATAL) << "PerfEventMetricCollector relies on perf_event_open and is only available on Linux";
+  return MetricCollector();
+}
+
+#endif
+
+TVM_REGISTER_GLOBAL("runtime.profiling.PerfEventMetricCollector")
+    .set_body_typed(PerfEventMetricCollector);
+
+}  // namespace profiling
+}  // namespace runtime
+}  // namespace tvm
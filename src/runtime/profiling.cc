@@ -26,11 +26,25 @@
 #include <tvm/runtime/packed_func.h>
 #include <tvm/runtime/profiling.h>
 
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
 #include <map>
 #include <numeric>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
 
 namespace tvm {
 namespace runtime {
@@ -100,8 +114,30 @@ TVM_REGISTER_GLOBAL("profiling.start_timer").set_body_typed(Timer::Start);
 
 namespace profiling {
 
+std::string DeviceString(Device dev) {
+  return DeviceName(dev.device_type) + std::to_string(dev.device_id);
+}
+
 void Profiler::Start(const std::vector<Device>& devs) {
   CHECK(global_timers_.empty()) << "You can only call Start once per Profiler.";
+  running_ = true;
+  TraceRecorder::Global()->Start();
+  begin_ns_ = TraceRecorder::Now();
+  MemoryTracker::StartTracking();
+  for (auto dev : devs) {
+    MemoryTracker::ResetPeak(dev);
+  }
+  for (auto& collector : collectors_) {
+    collector->Init(devs);
+  }
+  for (auto dev : devs) {
+    for (auto& collector : collectors_) {
+      ObjectRef obj = collector->Start(dev);
+      if (obj.defined()) {
+        global_collectors_.push_back({dev, {collector, obj}});
+      }
+    }
+  }
   for (auto dev : devs) {
     global_timers_.emplace_back(dev, Timer::Start(dev));
   }
@@ -109,24 +145,72 @@ void Profiler::Start(const std::vector<Device>& devs) {
 
 void Profiler::StartCall(String name, Device dev,
                          std::unordered_map<std::string, ObjectRef> extra_metrics) {
-  in_flight_.push(CallFrame{dev, name, Timer::Start(dev), extra_metrics});
+  std::vector<std::pair<MetricCollector, ObjectRef>> objs;
+  for (auto& collector : collectors_) {
+    ObjectRef obj = collector->Start(dev);
+    if (obj.defined()) {
+      objs.emplace_back(collector, obj);
+    }
+  }
+  MemoryTracker::ResetWindow(dev);
+  int64_t workspace_bytes = MemoryTracker::Get(dev).workspace_bytes;
+  in_flight_.push(CallFrame{dev, name, Timer::Start(dev), extra_metrics, objs,
+                            TraceRecorder::Now(), workspace_bytes});
 }
 
 void Profiler::StopCall(std::unordered_map<std::string, ObjectRef> extra_metrics) {
   CallFrame cf = in_flight_.top();
   cf.timer->Stop();
+  MemoryTracker::Usage usage = MemoryTracker::Get(cf.dev);
+  cf.extra_metrics["Workspace (B)"] = ObjectRef(make_object<BytesNode>(
+      std::max<int64_t>(usage.window_peak_workspace_bytes - cf.begin_workspace_bytes, 0)));
+  cf.extra_metrics["Live Tensors (B)"] = ObjectRef(make_object<BytesNode>(usage.tensor_bytes));
+  cf.extra_metrics["Peak Memory (B)"] = ObjectRef(make_object<BytesNode>(usage.window_peak_bytes));
   for (auto& p : extra_metrics) {
     cf.extra_metrics[p.first] = p.second;
   }
+  for (auto& p : cf.extra_collectors) {
+    for (auto metric : p.first->Stop(p.second)) {
+      cf.extra_metrics[metric.first] = metric.second;
+    }
+  }
+  cf.extra_collectors.clear();
   in_flight_.pop();
+
+  TraceEvent event{cf.name, "op", cf.begin_ns, TraceRecorder::Now(), 0, {}};
+  event.args.emplace_back("Device", DeviceString(cf.dev));
+  for (const auto& p : cf.extra_metrics) {
+    if (const auto* str = p.second.as<StringObj>()) {
+      event.args.emplace_back(p.first, str->data);
+    }
+  }
+  TraceRecorder::Global()->Record(std::move(event));
   calls_.push_back(cf);
 }
 
 void Profiler::Stop() {
+  ICHECK(running_) << "Profiler::Stop called on a profiler which is not running.";
+  running_ = false;
   // Stop all global timers. We wait to synchronize until we are making the report.
   for (auto p : global_timers_) {
     p.second->Stop();
   }
+  for (auto& p : global_collectors_) {
+    Map<String, ObjectRef>& metrics = global_metrics_[DeviceString(p.first)];
+    for (auto metric : p.second.first->Stop(p.second.second)) {
+      metrics.Set(metric.first, metric.second);
+    }
+  }
+  global_collectors_.clear();
+  for (auto p : global_timers_) {
+    MemoryTracker::Usage usage = MemoryTracker::Get(p.first);
+    Map<String, ObjectRef>& metrics = global_metrics_[DeviceString(p.first)];
+    metrics.Set("Peak Memory (B)", ObjectRef(make_object<BytesNode>(usage.peak_bytes)));
+    metrics.Set("Live Tensors (B)", ObjectRef(make_object<BytesNode>(usage.tensor_bytes)));
+  }
+  MemoryTracker::StopTracking();
+  trace_events_ = TraceRecorder::Global()->Collect(begin_ns_, TraceRecorder::Now());
+  TraceRecorder::Global()->Stop();
 }
 
 String ShapeString(const std::vector<NDArray>& shapes) {
@@ -185,6 +269,8 @@ String ReportNode::AsCSV() const {
           s << (*it).second.as<DurationNode>()->microseconds;
         } else if ((*it).second.as<PercentNode>()) {
           s << (*it).second.as<PercentNode>()->percent;
+        } else if ((*it).second.as<BytesNode>()) {
+          s << (*it).second.as<BytesNode>()->bytes;
         } else if ((*it).second.as<StringObj>()) {
           s << "\"" << Downcast<String>((*it).second) << "\"";
         }
@@ -239,11 +325,15 @@ String ReportNode::AsTable(bool sort, bool aggregate) const {
               aggregated[metric.first] =
                   ObjectRef(make_object<PercentNode>(it->second.as<PercentNode>()->percent +
                                                      metric.second.as<PercentNode>()->percent));
+            } else if (metric.second.as<BytesNode>()) {
+              // Memory is reused between calls, so the largest one matters.
+              aggregated[metric.first] = ObjectRef(make_object<BytesNode>(std::max(
+                  it->second.as<BytesNode>()->bytes, metric.second.as<BytesNode>()->bytes)));
             } else if (metric.second.as<StringObj>()) {
               // Don't do anything. Assume the two strings are the same.
             } else {
               LOG(FATAL) << "Can only aggregate metrics with types DurationNode, CountNode, "
-                            "PercentNode, and StringObj, but got "
+                            "PercentNode, BytesNode, and StringObj, but got "
                          << metric.second->GetTypeKey();
             }
           }
@@ -291,6 +381,13 @@ String ReportNode::AsTable(bool sort, bool aggregate) const {
           val += it->second.as<PercentNode>()->percent;
         }
         col_sums[p.first] = ObjectRef(make_object<PercentNode>(val));
+      } else if (p.second.as<BytesNode>()) {
+        int64_t val = p.second.as<BytesNode>()->bytes;
+        auto it = col_sums.find(p.first);
+        if (it != col_sums.end()) {
+          val = std::max(val, it->second.as<BytesNode>()->bytes);
+        }
+        col_sums[p.first] = ObjectRef(make_object<BytesNode>(val));
       }
     }
   }
@@ -349,6 +446,11 @@ String ReportNode::AsTable(bool sort, bool aggregate) const {
           std::stringstream s;
           s << std::fixed << std::setprecision(2) << (*it).second.as<PercentNode>()->percent;
           val = s.str();
+        } else if ((*it).second.as<BytesNode>()) {
+          std::stringstream s;
+          s.imbue(std::locale(""));  // for 1000s seperators
+          s << std::fixed << (*it).second.as<BytesNode>()->bytes;
+          val = s.str();
         } else if ((*it).second.as<StringObj>()) {
           val = Downcast<String>((*it).second);
         }
@@ -391,10 +493,6 @@ String ReportNode::AsTable(bool sort, bool aggregate) const {
   return s.str();
 }
 
-std::string DeviceString(Device dev) {
-  return DeviceName(dev.device_type) + std::to_string(dev.device_id);
-}
-
 Report Profiler::Report(bool aggregate, bool sort) {
   std::vector<std::pair<Device, double>> global_times;
   for (auto p : global_timers_) {
@@ -413,6 +511,12 @@ Report Profiler::Report(bool aggregate, bool sort) {
     row["Duration (us)"] = ObjectRef(make_object<DurationNode>(p.second));
     row["Percent"] = ObjectRef(make_object<PercentNode>(p.second / overall_time * 100));
     row["Device"] = String(DeviceString(p.first));
+    auto it = global_metrics_.find(DeviceString(p.first));
+    if (it != global_metrics_.end()) {
+      for (auto metric : it->second) {
+        row[metric.first] = metric.second;
+      }
+    }
     device_metrics[DeviceString(p.first)] = row;
   }
 
@@ -431,23 +535,439 @@ Report Profiler::Report(bool aggregate, bool sort) {
     rows.push_back(row);
   }
 
-  return profiling::Report(rows, device_metrics);
+  return profiling::Report(rows, device_metrics, trace_events_);
 }
 
 Report::Report(Array<Map<String, ObjectRef>> calls,
-               Map<String, Map<String, ObjectRef>> device_metrics) {
+               Map<String, Map<String, ObjectRef>> device_metrics,
+               std::vector<TraceEvent> trace_events) {
   auto node = make_object<ReportNode>();
   node->calls = std::move(calls);
   node->device_metrics = std::move(device_metrics);
+  node->trace_events = std::move(trace_events);
   data_ = std::move(node);
 }
 
+String ReportNode::AsChromeTrace() const {
+  return TraceRecorder::Global()->AsChromeTrace(trace_events);
+}
+
+namespace {
+constexpr int kSubBucketBits = 3;
+constexpr int kSubBuckets = 1 << kSubBucketBits;
+
+/*! \brief The log-linear histogram bucket of a duration. */
+int BucketOf(int64_t nanos) {
+  uint64_t n = nanos > 0 ? static_cast<uint64_t>(nanos) : 0;
+  if (n < kSubBuckets) return static_cast<int>(n);
+  int exp = kSubBucketBits;
+  while ((n >> (exp + 1)) != 0) ++exp;
+  return kSubBuckets * (exp - kSubBucketBits + 1) +
+         static_cast<int>((n >> (exp - kSubBucketBits)) & (kSubBuckets - 1));
+}
+
+/*! \brief The smallest duration falling into a bucket. */
+uint64_t BucketLowerBound(int bucket) {
+  if (bucket < kSubBuckets) return bucket;
+  int exp = bucket / kSubBuckets + kSubBucketBits - 1;
+  return static_cast<uint64_t>(kSubBuckets + bucket % kSubBuckets) << (exp - kSubBucketBits);
+}
+
+/*! \brief The middle of a bucket in microseconds. */
+double BucketMiddleUs(int bucket) {
+  return (BucketLowerBound(bucket) + BucketLowerBound(bucket + 1)) / 2e3;
+}
+
+void WriteJSONString(std::ostream& os, const std::string& str) {
+  os << '"';
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      os << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c)
+         << std::dec << std::setfill(' ');
+    } else {
+      os << c;
+    }
+  }
+  os << '"';
+}
+}  // namespace
+
+SamplingProfiler::SamplingProfiler(size_t capacity) {
+  size_t size = 1;
+  while (size < capacity) size <<= 1;
+  ring_.reset(new Slot[size]);
+  mask_ = size - 1;
+  for (size_t i = 0; i < size; ++i) {
+    ring_[i].seq.store(i, std::memory_order_relaxed);
+  }
+}
+
+void SamplingProfiler::SetInterval(int64_t interval) {
+  ICHECK_GE(interval, 0) << "the sampling interval must not be negative";
+  interval_.store(interval, std::memory_order_relaxed);
+}
+
+void SamplingProfiler::Record(uint32_t op, int64_t nanos) {
+  // Bounded multi-producer queue: a slot is free for position pos when its
+  // sequence number equals pos and holds a sample once it equals pos + 1.
+  uint64_t pos = write_pos_.load(std::memory_order_relaxed);
+  Slot* slot;
+  bool drained = false;
+  while (true) {
+    slot = &ring_[pos & mask_];
+    uint64_t seq = slot->seq.load(std::memory_order_acquire);
+    int64_t diff = static_cast<int64_t>(seq - pos);
+    if (diff == 0) {
+      if (write_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    } else if (diff < 0) {
+      // The ring is full. Fold it into the histograms once, unless another
+      // thread is reading them, in which case the sample is dropped.
+      std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+      if (drained || !lock.owns_lock()) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      Drain();
+      drained = true;
+      pos = write_pos_.load(std::memory_order_relaxed);
+    } else {
+      pos = write_pos_.load(std::memory_order_relaxed);
+    }
+  }
+  slot->op = op;
+  slot->nanos = nanos;
+  slot->seq.store(pos + 1, std::memory_order_release);
+}
+
+void SamplingProfiler::Drain() {
+  while (true) {
+    Slot* slot = &ring_[read_pos_ & mask_];
+    if (slot->seq.load(std::memory_order_acquire) != read_pos_ + 1) return;
+    Histogram& hist = histograms_[slot->op];
+    int64_t nanos = slot->nanos;
+    if (hist.count == 0 || nanos < hist.min) hist.min = nanos;
+    if (hist.count == 0 || nanos > hist.max) hist.max = nanos;
+    hist.count += 1;
+    hist.total += nanos;
+    hist.buckets[BucketOf(nanos)] += 1;
+    slot->seq.store(read_pos_ + mask_ + 1, std::memory_order_release);
+    read_pos_ += 1;
+  }
+}
+
+std::string SamplingProfiler::GetStats(const std::vector<std::string>& op_names) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Drain();
+  std::ostringstream os;
+  os << std::setprecision(6);
+  os << "{\"interval\": " << interval() << ", \"sampled_runs\": "
+     << sampled_runs_.load(std::memory_order_relaxed)
+     << ", \"dropped\": " << dropped_.load(std::memory_order_relaxed) << ", \"ops\": [";
+  bool first = true;
+  for (const auto& it : histograms_) {
+    const Histogram& hist = it.second;
+    auto percentile = [&hist](double q) {
+      uint64_t rank = static_cast<uint64_t>(std::ceil(q * hist.count));
+      uint64_t seen = 0;
+      for (const auto& bucket : hist.buckets) {
+        seen += bucket.second;
+        if (seen >= rank) return BucketMiddleUs(bucket.first);
+      }
+      return hist.max / 1e3;
+    };
+    if (!first) os << ", ";
+    first = false;
+    os << "{\"name\": ";
+    WriteJSONString(os, it.first < op_names.size() ? op_names[it.first]
+                                                   : std::to_string(it.first));
+    os << ", \"index\": " << it.first << ", \"count\": " << hist.count
+       << ", \"mean_us\": " << hist.total / 1e3 / hist.count << ", \"min_us\": " << hist.min / 1e3
+       << ", \"max_us\": " << hist.max / 1e3 << ", \"p50_us\": " << percentile(0.5)
+       << ", \"p90_us\": " << percentile(0.9) << ", \"p99_us\": " << percentile(0.99)
+       << ", \"buckets\": [";
+    // Every bucket as its lower bound in microseconds and its sample count.
+    bool first_bucket = true;
+    for (const auto& bucket : hist.buckets) {
+      if (!first_bucket) os << ", ";
+      first_bucket = false;
+      os << "[" << BucketLowerBound(bucket.first) / 1e3 << ", " << bucket.second << "]";
+    }
+    os << "]}";
+  }
+  os << "]}";
+  return os.str();
+}
+
+void SamplingProfiler::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Drain();
+  histograms_.clear();
+  sampled_runs_.store(0, std::memory_order_relaxed);
+  dropped_.store(0, std::memory_order_relaxed);
+}
+
+struct TraceRecorder::ThreadBuffer {
+  std::mutex mutex;
+  uint64_t tid;
+  std::string name;
+  std::vector<TraceEvent> events;
+};
+
+std::atomic<int> TraceRecorder::active_{0};
+
+namespace {
+uint64_t CurrentThreadId() {
+#if defined(__linux__)
+  return static_cast<uint64_t>(syscall(SYS_gettid));
+#else
+  return std::hash<std::thread::id>()(std::this_thread::get_id());
+#endif
+}
+
+int64_t CurrentProcessId() {
+#if defined(_WIN32)
+  return _getpid();
+#else
+  return getpid();
+#endif
+}
+}  // namespace
+
+TraceRecorder* TraceRecorder::Global() {
+  // Leaked so that threads may record events during static destruction.
+  static TraceRecorder* inst = new TraceRecorder();
+  return inst;
+}
+
+int64_t TraceRecorder::Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::LocalBuffer() {
+  static thread_local ThreadBuffer* local = nullptr;
+  if (local == nullptr) {
+    auto buffer = std::make_shared<ThreadBuffer>();
+    buffer->tid = CurrentThreadId();
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffers_.push_back(buffer);
+    local = buffer.get();
+  }
+  return local;
+}
+
+void TraceRecorder::Start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  active_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TraceRecorder::Stop() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ICHECK_GT(active_.load(std::memory_order_relaxed), 0) << "Stop without a matching Start";
+  if (active_.fetch_sub(1, std::memory_order_relaxed) != 1) return;
+  for (auto& buffer : buffers_) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    buffer->events.clear();
+    buffer->events.shrink_to_fit();
+  }
+}
+
+void TraceRecorder::Record(TraceEvent event) {
+  ThreadBuffer* buffer = LocalBuffer();
+  std::lock_guard<std::mutex> lock(buffer->mutex);
+  event.tid = buffer->tid;
+  buffer->events.push_back(std::move(event));
+}
+
+void TraceRecorder::SetThreadName(const std::string& name) {
+  ThreadBuffer* buffer = LocalBuffer();
+  std::lock_guard<std::mutex> lock(buffer->mutex);
+  buffer->name = name;
+}
+
+std::vector<TraceEvent> TraceRecorder::Collect(int64_t begin_ns, int64_t end_ns) {
+  std::vector<TraceEvent> events;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& buffer : buffers_) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    for (const TraceEvent& event : buffer->events) {
+      if (event.end_ns >= begin_ns && event.begin_ns <= end_ns) events.push_back(event);
+    }
+  }
+  std::stable_sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) {
+    return a.tid != b.tid ? a.tid < b.tid : a.begin_ns < b.begin_ns;
+  });
+  return events;
+}
+
+std::string TraceRecorder::AsChromeTrace(const std::vector<TraceEvent>& events) {
+  int64_t pid = CurrentProcessId();
+  std::ostringstream os;
+  os << std::fixed << std::setprecision(3);
+  os << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+  bool first = true;
+  std::unordered_set<uint64_t> tids;
+  for (const TraceEvent& event : events) {
+    tids.insert(event.tid);
+    if (!first) os << ",";
+    first = false;
+    // Complete events, timestamps and durations are in microseconds.
+    os << "\n{\"ph\": \"X\", \"name\": ";
+    WriteJSONString(os, event.name);
+    os << ", \"cat\": ";
+    WriteJSONString(os, event.category);
+    os << ", \"pid\": " << pid << ", \"tid\": " << event.tid << ", \"ts\": " << event.begin_ns / 1e3
+       << ", \"dur\": " << (event.end_ns - event.begin_ns) / 1e3;
+    if (!event.args.empty()) {
+      os << ", \"args\": {";
+      for (size_t i = 0; i < event.args.size(); ++i) {
+        if (i != 0) os << ", ";
+        WriteJSONString(os, event.args[i].first);
+        os << ": ";
+        WriteJSONString(os, event.args[i].second);
+      }
+      os << "}";
+    }
+    os << "}";
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& buffer : buffers_) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    if (buffer->name.empty() || !tids.count(buffer->tid)) continue;
+    if (!first) os << ",";
+    first = false;
+    os << "\n{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": " << pid
+       << ", \"tid\": " << buffer->tid << ", \"args\": {\"name\": ";
+    WriteJSONString(os, buffer->name);
+    os << "}}";
+  }
+  os << "\n]}";
+  return os.str();
+}
+
+namespace {
+constexpr int kMaxTrackedDeviceTypes = 32;
+constexpr int kMaxTrackedDeviceIds = 16;
+
+struct MemoryCounters {
+  std::atomic<int64_t> tensor_bytes{0};
+  std::atomic<int64_t> workspace_bytes{0};
+  std::atomic<int64_t> peak_bytes{0};
+  std::atomic<int64_t> window_peak_bytes{0};
+  std::atomic<int64_t> window_peak_workspace_bytes{0};
+};
+
+MemoryCounters memory_counters[kMaxTrackedDeviceTypes][kMaxTrackedDeviceIds];
+std::atomic<int> memory_tracking{0};
+
+MemoryCounters* CountersOf(Device dev) {
+  int type = static_cast<int>(dev.device_type);
+  if (type < 0 || type >= kMaxTrackedDeviceTypes || dev.device_id < 0 ||
+      dev.device_id >= kMaxTrackedDeviceIds) {
+    return nullptr;
+  }
+  return &memory_counters[type][dev.device_id];
+}
+
+void UpdateMax(std::atomic<int64_t>* target, int64_t value) {
+  int64_t current = target->load(std::memory_order_relaxed);
+  while (value > current &&
+         !target->compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+}  // namespace
+
+void MemoryTracker::Alloc(Kind kind, Device dev, size_t bytes) {
+  MemoryCounters* counters = CountersOf(dev);
+  if (counters == nullptr) return;
+  int64_t size = static_cast<int64_t>(bytes);
+  int64_t tensor, workspace;
+  if (kind == kWorkspace) {
+    workspace = counters->workspace_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    tensor = counters->tensor_bytes.load(std::memory_order_relaxed);
+  } else {
+    tensor = counters->tensor_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    workspace = counters->workspace_bytes.load(std::memory_order_relaxed);
+  }
+  if (memory_tracking.load(std::memory_order_relaxed) == 0) return;
+  UpdateMax(&counters->peak_bytes, tensor + workspace);
+  UpdateMax(&counters->window_peak_bytes, tensor + workspace);
+  UpdateMax(&counters->window_peak_workspace_bytes, workspace);
+}
+
+void MemoryTracker::Free(Kind kind, Device dev, size_t bytes) {
+  MemoryCounters* counters = CountersOf(dev);
+  if (counters == nullptr) return;
+  auto& counter = kind == kWorkspace ? counters->workspace_bytes : counters->tensor_bytes;
+  counter.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+}
+
+MemoryTracker::Usage MemoryTracker::Get(Device dev) {
+  Usage usage;
+  MemoryCounters* counters = CountersOf(dev);
+  if (counters == nullptr) return usage;
+  usage.tensor_bytes = counters->tensor_bytes.load(std::memory_order_relaxed);
+  usage.workspace_bytes = counters->workspace_bytes.load(std::memory_order_relaxed);
+  usage.peak_bytes = counters->peak_bytes.load(std::memory_order_relaxed);
+  usage.window_peak_bytes = counters->window_peak_bytes.load(std::memory_order_relaxed);
+  usage.window_peak_workspace_bytes =
+      counters->window_peak_workspace_bytes.load(std::memory_order_relaxed);
+  return usage;
+}
+
+void MemoryTracker::StartTracking() { memory_tracking.fetch_add(1, std::memory_order_relaxed); }
+
+void MemoryTracker::StopTracking() {
+  ICHECK_GT(memory_tracking.fetch_sub(1, std::memory_order_relaxed), 0)
+      << "StopTracking without a matching StartTracking";
+}
+
+void MemoryTracker::ResetPeak(Device dev) {
+  MemoryCounters* counters = CountersOf(dev);
+  if (counters == nullptr) return;
+  int64_t workspace = counters->workspace_bytes.load(std::memory_order_relaxed);
+  int64_t total = counters->tensor_bytes.load(std::memory_order_relaxed) + workspace;
+  counters->peak_bytes.store(total, std::memory_order_relaxed);
+  counters->window_peak_bytes.store(total, std::memory_order_relaxed);
+  counters->window_peak_workspace_bytes.store(workspace, std::memory_order_relaxed);
+}
+
+void MemoryTracker::ResetWindow(Device dev) {
+  MemoryCounters* counters = CountersOf(dev);
+  if (counters == nullptr) return;
+  int64_t workspace = counters->workspace_bytes.load(std::memory_order_relaxed);
+  int64_t total = counters->tensor_bytes.load(std::memory_order_relaxed) + workspace;
+  counters->window_peak_bytes.store(total, std::memory_order_relaxed);
+  counters->window_peak_workspace_bytes.store(workspace, std::memory_order_relaxed);
+}
+
 TVM_REGISTER_OBJECT_TYPE(DurationNode);
 TVM_REGISTER_OBJECT_TYPE(PercentNode);
 TVM_REGISTER_OBJECT_TYPE(CountNode);
+TVM_REGISTER_OBJECT_TYPE(BytesNode);
 TVM_REGISTER_OBJECT_TYPE(ReportNode);
+TVM_REGISTER_OBJECT_TYPE(MetricCollectorNode);
 
 TVM_REGISTER_GLOBAL("runtime.profiling.AsCSV").set_body_typed([](Report n) { return n->AsCSV(); });
+
+TVM_REGISTER_GLOBAL("runtime.profiling.AsChromeTrace").set_body_typed([](Report n) {
+  return n->AsChromeTrace();
+});
+
+TVM_REGISTER_GLOBAL("runtime.profiling.StartTrace").set_body_typed([]() {
+  TraceRecorder::Global()->Start();
+  return TraceRecorder::Now();
+});
+
+TVM_REGISTER_GLOBAL("runtime.profiling.StopTrace").set_body_typed([](int64_t begin_ns) {
+  TraceRecorder* recorder = TraceRecorder::Global();
+  std::string trace = recorder->AsChromeTrace(recorder->Collect(begin_ns, TraceRecorder::Now()));
+  recorder->Stop();
+  return trace;
+});
 }  // namespace profiling
 }  // namespace runtime
 }  // namespace tvm
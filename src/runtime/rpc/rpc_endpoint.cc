@@ -101,6 +101,13 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
   /*! \brief Finish the copy ack stage. */
   void FinishCopyAck() { this->SwitchToState(kRecvPacketNumBytes); }
 
+  /*! \brief Skip the data of a copy ack and finish the stage. */
+  void DiscardCopyAck() {
+    std::vector<char> data(pending_request_bytes_);
+    this->ReadArray(data.data(), data.size());
+    this->FinishCopyAck();
+  }
+
   /*!
    * \brief Enter the io loop until the next event.
    * \param client_mode Whether we are in the client.
@@ -112,6 +119,8 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
                           RPCSession::FEncodeReturn setreturn) {
     std::swap(client_mode_, client_mode);
     std::swap(async_server_mode_, async_server_mode);
+    bool handling_event = true;
+    std::swap(handling_event_, handling_event);
 
     RPCCode status = RPCCode::kNone;
 
@@ -153,6 +162,7 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
       }
     }
 
+    std::swap(handling_event_, handling_event);
     std::swap(async_server_mode_, async_server_mode);
     std::swap(client_mode_, client_mode);
     return status;
@@ -246,6 +256,8 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
   bool client_mode_{false};
   // Whether current handler is in the async server mode.
   bool async_server_mode_{false};
+  // Whether HandleNextEvent is running.
+  bool handling_event_{false};
   // Internal arena
   support::Arena arena_;
 
@@ -257,7 +269,8 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
     }
     // need to actively flush the writer
     // so the data get pushed out.
-    if (state_ == kWaitForAsyncCallback) {
+    bool async_callback_done = state_ == kWaitForAsyncCallback;
+    if (async_callback_done) {
       flush_writer_();
     }
     state_ = state;
@@ -266,6 +279,12 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
       this->RequestBytes(sizeof(uint64_t));
       // recycle arena for the next session.
       arena_.RecycleAll();
+      // A client pipelining requests may have sent the next ones already,
+      // they would wait for an IO event that never comes.
+      if (async_callback_done && !handling_event_ && this->Ready()) {
+        this->HandleNextEvent(false, true, [](TVMArgs) {});
+        flush_writer_();
+      }
     }
   }
 
@@ -646,16 +665,30 @@ RPCCode RPCEndpoint::HandleUntilReturnEvent(bool client_mode, RPCSession::FEncod
   return code;
 }
 
+void RPCEndpoint::FlushWriter() {
+  while (writer_.bytes_available() != 0) {
+    size_t n = writer_.ReadWithCallback(
+        [this](const void* data, size_t size) { return channel_->Send(data, size); },
+        writer_.bytes_available());
+    if (n == 0) break;
+  }
+}
+
+void RPCEndpoint::DrainReplies(int num_replies) {
+  FinishStartedCalls();
+  for (int i = 0; i < num_replies; ++i) {
+    try {
+      if (HandleUntilReturnEvent(true, [](TVMArgs) {}) == RPCCode::kCopyAck) {
+        handler_->DiscardCopyAck();
+      }
+    } catch (const std::exception& e) {
+    }
+  }
+}
+
 void RPCEndpoint::Init() {
   // callback to flush the writer.
-  auto flush_writer = [this]() {
-    while (writer_.bytes_available() != 0) {
-      size_t n = writer_.ReadWithCallback(
-          [this](const void* data, size_t size) { return channel_->Send(data, size); },
-          writer_.bytes_available());
-      if (n == 0) break;
-    }
-  };
+  auto flush_writer = [this]() { this->FlushWriter(); };
 
   // Event handler
   handler_ = std::make_shared<EventHandler>(&reader_, &writer_, name_, &remote_key_, flush_writer);
@@ -674,6 +707,7 @@ void RPCEndpoint::Init() {
     handler_->Write(code);
     handler_->SendPackedSeq(args.values, args.type_codes, args.num_args, true);
 
+    FinishStartedCalls();
     code = HandleUntilReturnEvent(true, [rv](TVMArgs args) {
       ICHECK_EQ(args.size(), 1);
       *rv = args[0];
@@ -712,12 +746,7 @@ void RPCEndpoint::Shutdown() {
 
     // flush all writing buffer to output channel.
     try {
-      while (writer_.bytes_available() != 0) {
-        size_t n = writer_.ReadWithCallback(
-            [this](const void* data, size_t size) { return channel_->Send(data, size); },
-            writer_.bytes_available());
-        if (n == 0) break;
-      }
+      this->FlushWriter();
     } catch (const Error& e) {
     }
     channel_.reset(nullptr);
@@ -740,8 +769,9 @@ int RPCEndpoint::ServerAsyncIOEventHandler(const std::string& in_bytes, int even
   RPCCode code = RPCCode::kNone;
   if (in_bytes.length() != 0) {
     reader_.Write(in_bytes.c_str(), in_bytes.length());
-    code = handler_->HandleNextEvent(false, true, [](TVMArgs) {});
   }
+  // Also pick up a shutdown handled after the completion of an async callback.
+  code = handler_->HandleNextEvent(false, true, [](TVMArgs) {});
   if ((event_flag & 2) != 0 && writer_.bytes_available() != 0) {
     writer_.ReadWithCallback(
         [this](const void* data, size_t size) { return channel_->Send(data, size); },
@@ -793,11 +823,70 @@ void RPCEndpoint::CallFunc(RPCSession::PackedFuncHandle h, const TVMValue* arg_v
   handler_->Write(handle);
   handler_->SendPackedSeq(arg_values, arg_type_codes, num_args, true);
 
+  FinishStartedCalls();
   code = HandleUntilReturnEvent(true, encode_return);
   ICHECK(code == RPCCode::kReturn) << "code=" << RPCCodeToString(code);
 }
 
-void RPCEndpoint::CopyToRemote(void* from_bytes, DLTensor* to, uint64_t nbytes) {
+uint64_t RPCEndpoint::StartCallFunc(RPCSession::PackedFuncHandle h, const TVMValue* arg_values,
+                                    const int* arg_type_codes, int num_args,
+                                    RPCSession::FAsyncCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  handler_->ValidateArguments(arg_values, arg_type_codes, num_args);
+  RPCCode code = RPCCode::kCallFunc;
+  uint64_t handle = reinterpret_cast<uint64_t>(h);
+
+  uint64_t packet_nbytes =
+      sizeof(code) + sizeof(handle) +
+      handler_->PackedSeqGetNumBytes(arg_values, arg_type_codes, num_args, true);
+
+  handler_->Write(packet_nbytes);
+  handler_->Write(code);
+  handler_->Write(handle);
+  handler_->SendPackedSeq(arg_values, arg_type_codes, num_args, true);
+  this->FlushWriter();
+
+  started_calls_.push_back(std::move(callback));
+  return num_finished_calls_ + started_calls_.size() - 1;
+}
+
+void RPCEndpoint::WaitForCall(uint64_t call_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  while (num_finished_calls_ <= call_id && !started_calls_.empty()) {
+    FinishStartedCall();
+  }
+}
+
+void RPCEndpoint::FinishStartedCall() {
+  RPCSession::FAsyncCallback callback = std::move(started_calls_.front());
+  started_calls_.pop_front();
+  ++num_finished_calls_;
+  bool returned = false;
+  try {
+    RPCCode code = HandleUntilReturnEvent(true, [&callback, &returned](TVMArgs args) {
+      returned = true;
+      callback(RPCCode::kReturn, args);
+    });
+    ICHECK(code == RPCCode::kReturn) << "code=" << RPCCodeToString(code);
+  } catch (const std::exception& e) {
+    if (!returned) {
+      TVMValue value;
+      value.v_str = e.what();
+      int32_t tcode = kTVMStr;
+      callback(RPCCode::kException, TVMArgs(&value, &tcode, 1));
+    }
+  }
+}
+
+void RPCEndpoint::FinishStartedCalls() {
+  while (!started_calls_.empty()) {
+    FinishStartedCall();
+  }
+}
+
+void RPCEndpoint::CopyToRemote(void* from_bytes, DLTensor* to, uint64_t nbytes,
+                               uint64_t chunk_bytes, int window) {
   std::lock_guard<std::mutex> lock(mutex_);
   RPCCode code = RPCCode::kCopyToRemote;
 
@@ -805,19 +894,42 @@ void RPCEndpoint::CopyToRemote(void* from_bytes, DLTensor* to, uint64_t nbytes)
   ICHECK_LE(to->byte_offset + nbytes, tensor_total_size_bytes)
       << "CopyToRemote: overflow in tensor size: (byte_offset=" << to->byte_offset
       << ", nbytes=" << nbytes << ", tensor_total_size=" << tensor_total_size_bytes << ")";
-
-  uint64_t overhead = RemoteCopyCalculatePacketOverheadSize(to, code, nbytes);
-  uint64_t packet_nbytes = overhead + nbytes;
-
-  handler_->Write(packet_nbytes);
-  handler_->Write(code);
-  RPCReference::SendDLTensor(handler_, to);
-  handler_->Write(nbytes);
-  handler_->WriteArray(reinterpret_cast<char*>(from_bytes), nbytes);
-  ICHECK(HandleUntilReturnEvent(true, [](TVMArgs) {}) == RPCCode::kReturn);
+  ICHECK_GT(chunk_bytes, 0U);
+  ICHECK_GT(window, 0);
+
+  DLTensor chunk = *to;
+  uint64_t sent = 0;
+  int in_flight = 0;
+  try {
+    while (sent < nbytes || in_flight != 0) {
+      if (sent < nbytes && in_flight < window) {
+        uint64_t chunk_nbytes = std::min(chunk_bytes, nbytes - sent);
+        chunk.byte_offset = to->byte_offset + sent;
+        uint64_t overhead = RemoteCopyCalculatePacketOverheadSize(&chunk, code, chunk_nbytes);
+        uint64_t packet_nbytes = overhead + chunk_nbytes;
+
+        handler_->Write(packet_nbytes);
+        handler_->Write(code);
+        RPCReference::SendDLTensor(handler_, &chunk);
+        handler_->Write(chunk_nbytes);
+        handler_->WriteArray(reinterpret_cast<char*>(from_bytes) + sent, chunk_nbytes);
+        this->FlushWriter();
+        sent += chunk_nbytes;
+        ++in_flight;
+      } else {
+        --in_flight;
+        FinishStartedCalls();
+        ICHECK(HandleUntilReturnEvent(true, [](TVMArgs) {}) == RPCCode::kReturn);
+      }
+    }
+  } catch (const std::exception& e) {
+    DrainReplies(in_flight);
+    throw;
+  }
 }
 
-void RPCEndpoint::CopyFromRemote(DLTensor* from, void* to_bytes, uint64_t nbytes) {
+void RPCEndpoint::CopyFromRemote(DLTensor* from, void* to_bytes, uint64_t nbytes,
+                                 uint64_t chunk_bytes, int window) {
   std::lock_guard<std::mutex> lock(mutex_);
   RPCCode code = RPCCode::kCopyFromRemote;
 
@@ -825,18 +937,41 @@ void RPCEndpoint::CopyFromRemote(DLTensor* from, void* to_bytes, uint64_t nbytes
   ICHECK_LE(from->byte_offset + nbytes, tensor_total_size_bytes)
       << "CopyFromRemote: overflow in tensor size: (byte_offset=" << from->byte_offset
       << ", nbytes=" << nbytes << ", tensor_total_size=" << tensor_total_size_bytes << ")";
-
-  uint64_t overhead = RemoteCopyCalculatePacketOverheadSize(from, code, nbytes);
-  uint64_t packet_nbytes = overhead;
-
-  handler_->Write(packet_nbytes);
-  handler_->Write(code);
-  RPCReference::SendDLTensor(handler_, from);
-  handler_->Write(nbytes);
-  ICHECK(HandleUntilReturnEvent(true, [](TVMArgs) {}) == RPCCode::kCopyAck);
-
-  handler_->ReadArray(reinterpret_cast<char*>(to_bytes), nbytes);
-  handler_->FinishCopyAck();
+  ICHECK_GT(chunk_bytes, 0U);
+  ICHECK_GT(window, 0);
+
+  DLTensor chunk = *from;
+  uint64_t requested = 0;
+  uint64_t received = 0;
+  int in_flight = 0;
+  try {
+    while (received < nbytes) {
+      if (requested < nbytes && in_flight < window) {
+        uint64_t chunk_nbytes = std::min(chunk_bytes, nbytes - requested);
+        chunk.byte_offset = from->byte_offset + requested;
+        uint64_t packet_nbytes = RemoteCopyCalculatePacketOverheadSize(&chunk, code, chunk_nbytes);
+
+        handler_->Write(packet_nbytes);
+        handler_->Write(code);
+        RPCReference::SendDLTensor(handler_, &chunk);
+        handler_->Write(chunk_nbytes);
+        this->FlushWriter();
+        requested += chunk_nbytes;
+        ++in_flight;
+      } else {
+        uint64_t chunk_nbytes = std::min(chunk_bytes, nbytes - received);
+        --in_flight;
+        FinishStartedCalls();
+        ICHECK(HandleUntilReturnEvent(true, [](TVMArgs) {}) == RPCCode::kCopyAck);
+        handler_->ReadArray(reinterpret_cast<char*>(to_bytes) + received, chunk_nbytes);
+        handler_->FinishCopyAck();
+        received += chunk_nbytes;
+      }
+    }
+  } catch (const std::exception& e) {
+    DrainReplies(in_flight);
+    throw;
+  }
 }
 
 // SysCallEventHandler functions
@@ -1005,30 +1140,20 @@ class RPCClientSession : public RPCSession, public DeviceAPI {
     endpoint_->CallFunc(func, arg_values, arg_type_codes, num_args, fencode_return);
   }
 
+  uint64_t StartCallFunc(PackedFuncHandle func, const TVMValue* arg_values,
+                         const int* arg_type_codes, int num_args, FAsyncCallback callback) final {
+    return endpoint_->StartCallFunc(func, arg_values, arg_type_codes, num_args, callback);
+  }
+
+  void WaitForCall(uint64_t call_id) final { endpoint_->WaitForCall(call_id); }
+
   void CopyToRemote(void* local_from_bytes, DLTensor* remote_to, uint64_t nbytes) final {
     RPCCode code = RPCCode::kCopyToRemote;
     uint64_t overhead = RemoteCopyCalculatePacketOverheadSize(remote_to, code, nbytes);
     uint64_t rpc_max_size = GetRPCMaxTransferSize();
     ICHECK_GT(rpc_max_size, overhead) << "CopyToRemote: Invalid block size!";
-    const uint64_t block_size = rpc_max_size - overhead;
-    uint64_t block_count = 0;
-    const uint64_t num_blocks = nbytes / block_size;
-    void* from_bytes;
-
-    for (block_count = 0; block_count < num_blocks; block_count++) {
-      remote_to->byte_offset = block_count * block_size;
-      from_bytes = reinterpret_cast<void*>(
-          (reinterpret_cast<uint8_t*>(local_from_bytes) + block_count * block_size));
-      endpoint_->CopyToRemote(from_bytes, remote_to, block_size);
-    }
-
-    const uint64_t remainder_bytes = nbytes % block_size;
-    if (remainder_bytes != 0) {
-      remote_to->byte_offset = block_count * block_size;
-      from_bytes = reinterpret_cast<void*>(
-          (reinterpret_cast<uint8_t*>(local_from_bytes) + block_count * block_size));
-      endpoint_->CopyToRemote(from_bytes, remote_to, remainder_bytes);
-    }
+    uint64_t block_size = std::min(rpc_max_size - overhead, copy_chunk_bytes_);
+    endpoint_->CopyToRemote(local_from_bytes, remote_to, nbytes, block_size, copy_window_);
   }
 
   void CopyFromRemote(DLTensor* remote_from, void* local_to_bytes, uint64_t nbytes) final {
@@ -1036,25 +1161,21 @@ class RPCClientSession : public RPCSession, public DeviceAPI {
     uint64_t overhead = RemoteCopyCalculatePacketOverheadSize(remote_from, code, nbytes);
     uint64_t rpc_max_size = GetRPCMaxTransferSize();
     ICHECK_GT(rpc_max_size, overhead) << "CopyFromRemote: Invalid block size!";
-    const uint64_t block_size = rpc_max_size - overhead;
-    uint64_t block_count = 0;
-    const uint64_t num_blocks = nbytes / block_size;
-    void* to_bytes;
-
-    for (block_count = 0; block_count < num_blocks; block_count++) {
-      remote_from->byte_offset = block_count * block_size;
-      to_bytes = reinterpret_cast<void*>(
-          (reinterpret_cast<uint8_t*>(local_to_bytes) + block_count * block_size));
-      endpoint_->CopyFromRemote(remote_from, to_bytes, block_size);
-    }
+    uint64_t block_size = std::min(rpc_max_size - overhead, copy_chunk_bytes_);
+    endpoint_->CopyFromRemote(remote_from, local_to_bytes, nbytes, block_size, copy_window_);
+  }
 
-    const uint64_t remainder_bytes = nbytes % block_size;
-    if (remainder_bytes != 0) {
-      remote_from->byte_offset = block_count * block_size;
-      to_bytes = reinterpret_cast<void*>(
-          (reinterpret_cast<uint8_t*>(local_to_bytes) + block_count * block_size));
-      endpoint_->CopyFromRemote(remote_from, to_bytes, remainder_bytes);
-    }
+  /*!
+   * \brief Set how tensor copies are split.
+   * \param chunk_bytes The largest number of bytes in one packet.
+   * \param window The number of packets in flight, microTVM servers always use 1.
+   */
+  void SetCopyChunking(uint64_t chunk_bytes, int window) {
+    ICHECK_GT(chunk_bytes, 0U) << "The chunk size must be positive";
+    ICHECK_GT(window, 0) << "The window must be positive";
+    copy_chunk_bytes_ = chunk_bytes;
+    GetRPCMaxTransferSize();
+    copy_window_ = packet_size_limited_ ? 1 : window;
   }
 
   void FreeHandle(void* handle, int type_code) final {
@@ -1124,34 +1245,48 @@ class RPCClientSession : public RPCSession, public DeviceAPI {
 
  private:
   uint64_t GetRPCMaxTransferSize() {
-    if (rpc_chunk_max_size_bytes_ > 0) {
-      return (uint64_t)rpc_chunk_max_size_bytes_;
+    if (rpc_chunk_max_size_bytes_ != 0) {
+      return rpc_chunk_max_size_bytes_;
     }
 
     PackedFuncHandle rpc_func = GetFunction("tvm.rpc.server.GetCRTMaxPacketSize");
     if (rpc_func == nullptr) {
-      rpc_chunk_max_size_bytes_ = (int64_t)kRPCMaxTransferSizeBytesDefault;
+      rpc_chunk_max_size_bytes_ = kRPCMaxTransferSizeBytesDefault;
     } else {
       CallFunc(rpc_func, nullptr, nullptr, 0, [this](TVMArgs args) {
         // Use args[1] as return value, args[0] is tcode
         // Look at RPCWrappedFunc in src/runtime/rpc/rpc_module.cc
-        rpc_chunk_max_size_bytes_ = (int64_t)args[1];
-        ICHECK_GT(rpc_chunk_max_size_bytes_, 0)
-            << "RPC max transfer size is <= 0! (remote value = " << rpc_chunk_max_size_bytes_
-            << ")";
+        int64_t max_size = args[1];
+        ICHECK_GT(max_size, 0) << "RPC max transfer size is <= 0! (remote value = " << max_size
+                               << ")";
+        rpc_chunk_max_size_bytes_ = static_cast<uint64_t>(max_size);
       });
+      // The microTVM transport buffers a single packet.
+      packet_size_limited_ = true;
+      copy_window_ = 1;
     }
-    return (uint64_t)rpc_chunk_max_size_bytes_;
+    return rpc_chunk_max_size_bytes_;
   }
 
   std::shared_ptr<RPCEndpoint> endpoint_;
-  int64_t rpc_chunk_max_size_bytes_ = -1;
+  // Zero until queried from the remote.
+  uint64_t rpc_chunk_max_size_bytes_ = 0;
+  bool packet_size_limited_ = false;
+  uint64_t copy_chunk_bytes_ = kRPCCopyChunkBytesDefault;
+  int copy_window_ = kRPCCopyWindowDefault;
 };
 
 std::shared_ptr<RPCSession> CreateClientSession(std::shared_ptr<RPCEndpoint> endpoint) {
   return std::make_shared<RPCClientSession>(endpoint);
 }
 
+TVM_REGISTER_GLOBAL("rpc.SetCopyChunking")
+    .set_body_typed([](Module sess, int64_t chunk_bytes, int window) {
+      auto* client = dynamic_cast<RPCClientSession*>(RPCModuleGetSession(sess).get());
+      ICHECK(client != nullptr) << "Copy chunking only applies to remote sessions";
+      client->SetCopyChunking(chunk_bytes, window);
+    });
+
 uint64_t RemoteCopyCalculatePacketOverheadSize(DLTensor* tensor, RPCCode code, uint64_t nbytes) {
   uint64_t shape_bytes = tensor->ndim * sizeof(int64_t);
   uint64_t to_data = reinterpret_cast<uint64_t>(static_cast<uint8_t*>(tensor->data));
@@ -26,6 +26,7 @@
 
 #include <tvm/runtime/packed_func.h>
 
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -61,6 +62,11 @@ enum class TrackerCode : int {
   kGetPendingMatchKeys = 7
 };
 
+/*! \brief The default number of bytes of one packet of a tensor copy. */
+const uint64_t kRPCCopyChunkBytesDefault = 256 << 10;
+/*! \brief The default number of packets of a tensor copy in flight. */
+const int kRPCCopyWindowDefault = 4;
+
 /*!
  * \brief Communication endpoints to connect local and remote RPC sessions.
  *        An endpoint can either be a client or a server.
@@ -125,28 +131,57 @@ class RPCEndpoint {
    */
   void CallFunc(RPCSession::PackedFuncHandle handle, const TVMValue* arg_values,
                 const int* arg_type_codes, int num_args, RPCSession::FEncodeReturn encode_return);
+  /*!
+   * \brief Send a call to the remote function without waiting for its return.
+   *
+   *  The remote handles requests one after the other, so the returns of
+   *  started calls come before the reply to any later request. They are
+   *  handed to the callbacks by WaitForCall and by every later request.
+   *
+   * \param handle The function handle
+   * \param arg_values The argument values.
+   * \param arg_type_codes the type codes of the argument.
+   * \param num_args Number of arguments.
+   * \param callback The function to receive the return value or the exception.
+   * \return The id of the call, counting the calls started on this endpoint.
+   */
+  uint64_t StartCallFunc(RPCSession::PackedFuncHandle handle, const TVMValue* arg_values,
+                         const int* arg_type_codes, int num_args,
+                         RPCSession::FAsyncCallback callback);
+  /*!
+   * \brief Wait until the callback of a started call has run.
+   * \param call_id The id returned by StartCallFunc.
+   */
+  void WaitForCall(uint64_t call_id);
   /*!
    * \brief Copy bytes into remote array content.
-   * \param from The source host data.
-   * \param from_offset The byte offeset in the from.
-   * \param to The target array.
-   * \param to_offset The byte offset in the to.
+   *
+   *  The bytes are sent in packets of at most chunk_bytes, and up to window
+   *  packets are sent before waiting for the acknowledgement of the first one.
+   *  The remote thus stores a chunk while the next ones are on the wire.
+   *
+   * \param from_bytes The source host data.
+   * \param to The target array, the copy starts at its byte_offset.
    * \param nbytes The size of the memory in bytes.
-   * \param dev_to The target device.
-   * \param type_hint Hint of content data type.
+   * \param chunk_bytes The largest number of bytes in one packet.
+   * \param window The number of packets in flight.
    */
-  void CopyToRemote(void* from_bytes, DLTensor* to, uint64_t nbytes);
+  void CopyToRemote(void* from_bytes, DLTensor* to, uint64_t nbytes,
+                    uint64_t chunk_bytes = UINT64_MAX, int window = 1);
   /*!
    * \brief Copy bytes from remote array content.
-   * \param from The source host data.
-   * \param from_offset The byte offeset in the from.
-   * \param to The target array.
-   * \param to_offset The byte offset in the to.
+   *
+   *  Up to window requests of at most chunk_bytes each are outstanding, so
+   *  that the remote prepares the next chunks while one is received.
+   *
+   * \param from The source array, the copy starts at its byte_offset.
+   * \param to_bytes The target host data.
    * \param nbytes The size of the memory in bytes.
-   * \param dev_from The source device.
-   * \param type_hint Hint of content data type.
+   * \param chunk_bytes The largest number of bytes in one packet.
+   * \param window The number of requests in flight.
    */
-  void CopyFromRemote(DLTensor* from, void* to_bytes, uint64_t nbytes);
+  void CopyFromRemote(DLTensor* from, void* to_bytes, uint64_t nbytes,
+                      uint64_t chunk_bytes = UINT64_MAX, int window = 1);
 
   /*!
    * \brief Call a remote defined system function with arguments.
@@ -172,6 +207,14 @@ class RPCEndpoint {
   // Handle events until receives a return
   // Also flushes channels so that the function advances.
   RPCCode HandleUntilReturnEvent(bool client_mode, RPCSession::FEncodeReturn setreturn);
+  // Send everything in the writer to the channel.
+  void FlushWriter();
+  // Wait for the replies of requests still in flight after an error, dropping them.
+  void DrainReplies(int num_replies);
+  // Hand the return of the oldest started call to its callback.
+  void FinishStartedCall();
+  // Finish all started calls, before waiting for the reply of a later request.
+  void FinishStartedCalls();
   // Initalization
   void Init();
   // Shutdown
@@ -190,6 +233,10 @@ class RPCEndpoint {
   std::string name_;
   // The remote key
   std::string remote_key_;
+  // The callbacks of the started calls, oldest first.
+  std::deque<RPCSession::FAsyncCallback> started_calls_;
+  // The number of started calls that have finished.
+  uint64_t num_finished_calls_{0};
 };
 
 /*!
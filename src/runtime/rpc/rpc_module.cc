@@ -26,6 +26,7 @@
 #include <tvm/runtime/profiling.h>
 #include <tvm/runtime/registry.h>
 
+#include <atomic>
 #include <cstring>
 #include <memory>
 #if defined(_M_X64) || defined(__x86_64__)
@@ -84,47 +85,55 @@ class RPCWrappedFunc : public Object {
   RPCWrappedFunc(void* handle, std::shared_ptr<RPCSession> sess) : handle_(handle), sess_(sess) {}
 
   void operator()(TVMArgs args, TVMRetValue* rv) const {
-    std::vector<TVMValue> values(args.values, args.values + args.size());
-    std::vector<int> type_codes(args.type_codes, args.type_codes + args.size());
+    std::vector<TVMValue> values;
+    std::vector<int> type_codes;
     std::vector<std::unique_ptr<DLTensor>> temp_dltensors;
+    this->TranslateArgs(args, &values, &type_codes, &temp_dltensors);
+    auto set_return = [this, rv](TVMArgs args) { this->WrapRemoteReturnToValue(args, rv); };
+    sess_->CallFunc(handle_, values.data(), type_codes.data(), args.size(), set_return);
+  }
 
-    // scan and check whether we need rewrite these arguments
-    // to their remote variant.
-    for (int i = 0; i < args.size(); ++i) {
-      if (args[i].IsObjectRef<String>()) {
-        String str = args[i];
-        type_codes[i] = kTVMStr;
-        values[i].v_str = str.c_str();
-        continue;
-      }
-      int tcode = type_codes[i];
-      switch (tcode) {
-        case kTVMDLTensorHandle:
-        case kTVMNDArrayHandle: {
-          // Pass NDArray as DLTensor, NDArray and DLTensor
-          // are compatible to each other, just need to change the index.
-          type_codes[i] = kTVMDLTensorHandle;
-          // translate to a remote view of DLTensor
-          auto dptr = std::make_unique<DLTensor>(*static_cast<DLTensor*>(values[i].v_handle));
-          dptr->device = RemoveSessMask(dptr->device);
-          dptr->data = static_cast<RemoteSpace*>(dptr->data)->data;
-          values[i].v_handle = dptr.get();
-          temp_dltensors.emplace_back(std::move(dptr));
-          break;
-        }
-        case kDLDevice: {
-          values[i].v_device = RemoveSessMask(values[i].v_device);
-          break;
-        }
-        case kTVMPackedFuncHandle:
-        case kTVMModuleHandle: {
-          values[i].v_handle = UnwrapRemoteValueToHandle(TVMArgValue(values[i], tcode));
-          break;
+  /*!
+   * \brief Start a call without waiting for it to return.
+   * \param wf The remote function.
+   * \param args The arguments.
+   * \return A function waiting for the call and returning its result.
+   */
+  static PackedFunc StartCall(std::shared_ptr<RPCWrappedFunc> wf, TVMArgs args) {
+    struct CallState {
+      std::atomic<bool> done{false};
+      TVMRetValue value;
+      std::string error;
+    };
+    std::vector<TVMValue> values;
+    std::vector<int> type_codes;
+    std::vector<std::unique_ptr<DLTensor>> temp_dltensors;
+    wf->TranslateArgs(args, &values, &type_codes, &temp_dltensors);
+
+    auto state = std::make_shared<CallState>();
+    auto callback = [wf, state](RPCCode status, TVMArgs args) {
+      if (status == RPCCode::kException) {
+        state->error = args[0].operator std::string();
+      } else {
+        try {
+          wf->WrapRemoteReturnToValue(args, &state->value);
+        } catch (const std::exception& e) {
+          state->error = e.what();
         }
       }
-    }
-    auto set_return = [this, rv](TVMArgs args) { this->WrapRemoteReturnToValue(args, rv); };
-    sess_->CallFunc(handle_, values.data(), type_codes.data(), args.size(), set_return);
+      state->done = true;
+    };
+    std::shared_ptr<RPCSession> sess = wf->sess_;
+    uint64_t call_id = sess->StartCallFunc(wf->handle_, values.data(), type_codes.data(),
+                                           args.size(), callback);
+    return PackedFunc([sess, call_id, state](TVMArgs args, TVMRetValue* rv) {
+      if (!state->done) sess->WaitForCall(call_id);
+      ICHECK(state->done) << "The remote call did not return";
+      if (!state->error.empty()) {
+        LOG(FATAL) << state->error;
+      }
+      *rv = state->value;
+    });
   }
 
   ~RPCWrappedFunc() {
@@ -141,6 +150,9 @@ class RPCWrappedFunc : public Object {
   // pointer to the session.
   std::shared_ptr<RPCSession> sess_;
 
+  // rewrite the arguments to their remote variant.
+  void TranslateArgs(TVMArgs args, std::vector<TVMValue>* values, std::vector<int>* type_codes,
+                     std::vector<std::unique_ptr<DLTensor>>* temp_dltensors) const;
   // unwrap a remote value to the underlying handle.
   void* UnwrapRemoteValueToHandle(const TVMArgValue& arg) const;
   // wrap a remote return via Set
@@ -155,6 +167,12 @@ class RPCWrappedFunc : public Object {
   }
 };
 
+/*! \brief The body of the PackedFunc of a remote function. */
+struct RPCWrappedFuncBody {
+  std::shared_ptr<RPCWrappedFunc> wf;
+  void operator()(TVMArgs args, TVMRetValue* rv) const { wf->operator()(args, rv); }
+};
+
 // RPC that represents a remote module session.
 class RPCModuleNode final : public ModuleNode {
  public:
@@ -232,8 +250,7 @@ class RPCModuleNode final : public ModuleNode {
 
   PackedFunc WrapRemoteFunc(RPCSession::PackedFuncHandle handle) {
     if (handle == nullptr) return PackedFunc();
-    auto wf = std::make_shared<RPCWrappedFunc>(handle, sess_);
-    return PackedFunc([wf](TVMArgs args, TVMRetValue* rv) { return wf->operator()(args, rv); });
+    return PackedFunc(RPCWrappedFuncBody{std::make_shared<RPCWrappedFunc>(handle, sess_)});
   }
 
   // The module handle
@@ -251,6 +268,49 @@ class RPCModuleNode final : public ModuleNode {
   TypedPackedFunc<void(Module, Module)> remote_import_module_;
 };
 
+void RPCWrappedFunc::TranslateArgs(TVMArgs args, std::vector<TVMValue>* values,
+                                   std::vector<int>* type_codes,
+                                   std::vector<std::unique_ptr<DLTensor>>* temp_dltensors) const {
+  values->assign(args.values, args.values + args.size());
+  type_codes->assign(args.type_codes, args.type_codes + args.size());
+
+  // scan and check whether we need rewrite these arguments
+  // to their remote variant.
+  for (int i = 0; i < args.size(); ++i) {
+    if (args[i].IsObjectRef<String>()) {
+      String str = args[i];
+      (*type_codes)[i] = kTVMStr;
+      (*values)[i].v_str = str.c_str();
+      continue;
+    }
+    int tcode = (*type_codes)[i];
+    switch (tcode) {
+      case kTVMDLTensorHandle:
+      case kTVMNDArrayHandle: {
+        // Pass NDArray as DLTensor, NDArray and DLTensor
+        // are compatible to each other, just need to change the index.
+        (*type_codes)[i] = kTVMDLTensorHandle;
+        // translate to a remote view of DLTensor
+        auto dptr = std::make_unique<DLTensor>(*static_cast<DLTensor*>((*values)[i].v_handle));
+        dptr->device = RemoveSessMask(dptr->device);
+        dptr->data = static_cast<RemoteSpace*>(dptr->data)->data;
+        (*values)[i].v_handle = dptr.get();
+        temp_dltensors->emplace_back(std::move(dptr));
+        break;
+      }
+      case kDLDevice: {
+        (*values)[i].v_device = RemoveSessMask((*values)[i].v_device);
+        break;
+      }
+      case kTVMPackedFuncHandle:
+      case kTVMModuleHandle: {
+        (*values)[i].v_handle = UnwrapRemoteValueToHandle(TVMArgValue((*values)[i], tcode));
+        break;
+      }
+    }
+  }
+}
+
 void* RPCWrappedFunc::UnwrapRemoteValueToHandle(const TVMArgValue& arg) const {
   if (arg.type_code() == kTVMModuleHandle) {
     Module mod = arg;
@@ -274,8 +334,7 @@ void RPCWrappedFunc::WrapRemoteReturnToValue(TVMArgs args, TVMRetValue* rv) cons
   if (tcode == kTVMPackedFuncHandle) {
     ICHECK_EQ(args.size(), 2);
     void* handle = args[1];
-    auto wf = std::make_shared<RPCWrappedFunc>(handle, sess_);
-    *rv = PackedFunc([wf](TVMArgs args, TVMRetValue* rv) { return wf->operator()(args, rv); });
+    *rv = PackedFunc(RPCWrappedFuncBody{std::make_shared<RPCWrappedFunc>(handle, sess_)});
   } else if (tcode == kTVMModuleHandle) {
     ICHECK_EQ(args.size(), 2);
     void* handle = args[1];
@@ -461,6 +520,15 @@ TVM_REGISTER_GLOBAL("rpc.ImportRemoteModule").set_body_typed([](Module parent, M
   static_cast<RPCModuleNode*>(parent.operator->())->ImportModule(child);
 });
 
+TVM_REGISTER_GLOBAL("rpc.StartCall").set_body([](TVMArgs args, TVMRetValue* rv) {
+  PackedFunc func = args[0];
+  PackedFunc::FType body = func.body();
+  auto* remote = body.target<RPCWrappedFuncBody>();
+  ICHECK(remote != nullptr) << "ValueError: rpc.StartCall expects a remote function";
+  *rv = RPCWrappedFunc::StartCall(remote->wf,
+                                  TVMArgs(args.values + 1, args.type_codes + 1, args.size() - 1));
+});
+
 TVM_REGISTER_GLOBAL("rpc.SessTableIndex").set_body([](TVMArgs args, TVMRetValue* rv) {
   Module m = args[0];
   std::string tkey = m->type_key();
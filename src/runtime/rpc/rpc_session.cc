@@ -51,6 +51,15 @@ void RPCSession::AsyncCallFunc(PackedFuncHandle func, const TVMValue* arg_values
   }
 }
 
+uint64_t RPCSession::StartCallFunc(PackedFuncHandle func, const TVMValue* arg_values,
+                                   const int* arg_type_codes, int num_args,
+                                   FAsyncCallback callback) {
+  this->AsyncCallFunc(func, arg_values, arg_type_codes, num_args, callback);
+  return 0;
+}
+
+void RPCSession::WaitForCall(uint64_t call_id) {}
+
 void RPCSession::AsyncCopyToRemote(void* local_from_bytes, DLTensor* remote_to, uint64_t nbytes,
                                    RPCSession::FAsyncCallback callback) {
   TVMValue value;
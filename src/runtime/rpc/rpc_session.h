@@ -176,6 +176,30 @@ class RPCSession {
    */
   virtual bool IsLocalSession() const = 0;
 
+  /*!
+   * \brief Start calling func without waiting for it to return.
+   *
+   *  Calls return in the order they are started on a session, so several of
+   *  them can be in flight on one connection. The callback runs in the thread
+   *  that waits for this call or for a later request of the session. The
+   *  default implementation finishes the call before returning.
+   *
+   * \param func The function handle.
+   * \param arg_values The argument values.
+   * \param arg_type_codes the type codes of the argument.
+   * \param num_args Number of arguments.
+   * \param callback The callback to pass the return value or exception.
+   * \return The id of the call in the session, to pass to WaitForCall.
+   */
+  virtual uint64_t StartCallFunc(PackedFuncHandle func, const TVMValue* arg_values,
+                                 const int* arg_type_codes, int num_args,
+                                 FAsyncCallback callback);
+  /*!
+   * \brief Wait until the callback of a call started with StartCallFunc has run.
+   * \param call_id The id of the call.
+   */
+  virtual void WaitForCall(uint64_t call_id);
+
   // Asynchrous variant of API
   // These APIs are used by the RPC server to allow sessions that
   // have special implementations for the async functions.
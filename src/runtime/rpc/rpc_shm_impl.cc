@@ -0,0 +1,504 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file rpc_shm_impl.cc
+ * \brief Shared memory RPC channel for servers running on the same host.
+ */
+// Relies on POSIX shared memory and futexes, Android lacks shm_open.
+#if defined(__linux__) && !defined(__ANDROID__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <tvm/runtime/registry.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "rpc_endpoint.h"
+#include "rpc_local_session.h"
+
+namespace tvm {
+namespace runtime {
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+              "shared memory rings need lock free atomics");
+
+/*! \brief The default capacity of each direction of a channel. */
+constexpr uint64_t kShmRingCapacityDefault = 8 << 20;
+
+namespace {
+
+/*! \brief A named POSIX shared memory segment mapped into the process. */
+class SharedMemory {
+ public:
+  /*!
+   * \brief Create a segment with a fresh name.
+   * \param size The size of the segment.
+   * \return The segment, unlinked when the last reference goes away.
+   */
+  static std::shared_ptr<SharedMemory> Create(size_t size) {
+    static std::atomic<uint64_t> counter{0};
+    std::random_device rd;
+    std::shared_ptr<SharedMemory> shm(new SharedMemory());
+    int fd = -1;
+    for (int attempt = 0; attempt < 16 && fd < 0; ++attempt) {
+      shm->name_ = "/tvm-" + std::to_string(getpid()) + "-" + std::to_string(counter++) + "-" +
+                   std::to_string(rd());
+      fd = shm_open(shm->name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    }
+    ICHECK_GE(fd, 0) << "Cannot create shared memory " << shm->name_ << ": "
+                     << std::strerror(errno);
+    shm->owner_ = true;
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+      int err = errno;
+      close(fd);
+      shm_unlink(shm->name_.c_str());
+      LOG(FATAL) << "Cannot allocate " << size << " bytes of shared memory: " << std::strerror(err);
+    }
+    shm->Map(fd, size);
+    return shm;
+  }
+
+  /*!
+   * \brief Map an existing segment.
+   * \param name The name of the segment.
+   * \return The mapping.
+   */
+  static std::shared_ptr<SharedMemory> Open(const std::string& name) {
+    std::shared_ptr<SharedMemory> shm(new SharedMemory());
+    shm->name_ = name;
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    ICHECK_GE(fd, 0) << "Cannot open shared memory " << name << ": " << std::strerror(errno);
+    struct stat st;
+    ICHECK_EQ(fstat(fd, &st), 0) << "Cannot stat shared memory " << name;
+    shm->Map(fd, static_cast<size_t>(st.st_size));
+    return shm;
+  }
+
+  ~SharedMemory() {
+    if (data_ != nullptr) munmap(data_, size_);
+    Unlink();
+  }
+
+  /*! \brief Remove the name of a segment this process created, mappings stay valid. */
+  void Unlink() {
+    if (owner_) shm_unlink(name_.c_str());
+    owner_ = false;
+  }
+
+  char* data() const { return data_; }
+  size_t size() const { return size_; }
+  const std::string& name() const { return name_; }
+
+ private:
+  SharedMemory() = default;
+
+  void Map(int fd, size_t size) {
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int err = errno;
+    close(fd);
+    if (addr == MAP_FAILED) {
+      Unlink();
+      LOG(FATAL) << "Cannot map shared memory " << name_ << ": " << std::strerror(err);
+    }
+    data_ = static_cast<char*>(addr);
+    size_ = size;
+  }
+
+  std::string name_;
+  char* data_{nullptr};
+  size_t size_{0};
+  bool owner_{false};
+};
+
+/*! \brief The state of a single producer single consumer ring, bytes follow the channel header. */
+struct ShmRing {
+  /*! \brief Number of bytes written so far. */
+  std::atomic<uint64_t> head;
+  /*! \brief Number of bytes read so far. */
+  std::atomic<uint64_t> tail;
+  /*! \brief Bumped after writes, the futex readers sleep on. */
+  std::atomic<uint32_t> head_seq;
+  /*! \brief Bumped after reads, the futex writers sleep on. */
+  std::atomic<uint32_t> tail_seq;
+  std::atomic<uint32_t> reader_waiting;
+  std::atomic<uint32_t> writer_waiting;
+};
+
+constexpr uint64_t kShmChannelMagic = 0x54564D53484D5250;
+
+/*! \brief The header of a channel segment, ring 0 goes to the server and ring 1 to the client. */
+struct ShmChannelHeader {
+  uint64_t magic;
+  uint64_t capacity;
+  std::atomic<int32_t> pid[2];
+  std::atomic<uint32_t> closed[2];
+  ShmRing ring[2];
+};
+
+constexpr size_t kShmChannelDataOffset =
+    (sizeof(ShmChannelHeader) + kAllocAlignment - 1) / kAllocAlignment * kAllocAlignment;
+
+void FutexWait(std::atomic<uint32_t>* addr, uint32_t value, int64_t timeout_ns) {
+  struct timespec ts;
+  ts.tv_sec = timeout_ns / 1000000000;
+  ts.tv_nsec = timeout_ns % 1000000000;
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT, value, &ts, nullptr, 0);
+}
+
+void FutexWake(std::atomic<uint32_t>* addr) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+}  // namespace
+
+/*!
+ * \brief RPC channel over a pair of rings in shared memory.
+ *
+ *  Data is copied into and out of the rings in user space, a side only enters
+ *  the kernel to sleep when its ring is empty or full, after a short spin, and
+ *  the other side only wakes it when it is asleep. Sleeps time out periodically
+ *  to notice a peer that died without closing the channel.
+ */
+class ShmChannel final : public RPCChannel {
+ public:
+  /*!
+   * \brief Constructor.
+   * \param shm The channel segment.
+   * \param side 0 for the client, 1 for the server.
+   * \param child_pid The server process when the client started it, 0 otherwise.
+   */
+  ShmChannel(std::shared_ptr<SharedMemory> shm, int side, pid_t child_pid = 0)
+      : shm_(std::move(shm)), side_(side), child_pid_(child_pid) {
+    header_ = reinterpret_cast<ShmChannelHeader*>(shm_->data());
+    ICHECK_GE(shm_->size(), kShmChannelDataOffset);
+    ICHECK_EQ(header_->magic, kShmChannelMagic) << "Invalid shared memory channel " << shm_->name();
+    capacity_ = header_->capacity;
+    ICHECK_EQ(shm_->size(), kShmChannelDataOffset + 2 * capacity_);
+    header_->pid[side_] = static_cast<int32_t>(getpid());
+  }
+
+  ~ShmChannel() {
+    header_->closed[side_] = 1;
+    for (ShmRing& ring : header_->ring) {
+      ring.head_seq.fetch_add(1);
+      ring.tail_seq.fetch_add(1);
+      FutexWake(&ring.head_seq);
+      FutexWake(&ring.tail_seq);
+    }
+    if (child_pid_ != 0) {
+      kill(child_pid_, SIGKILL);
+      waitpid(child_pid_, nullptr, 0);
+    }
+  }
+
+  /*! \brief Initialize the header of a new channel segment. */
+  static void InitSegment(SharedMemory* shm, uint64_t capacity) {
+    auto* header = new (shm->data()) ShmChannelHeader();
+    header->capacity = capacity;
+    for (int side = 0; side < 2; ++side) {
+      header->pid[side] = 0;
+      header->closed[side] = 0;
+      ShmRing& ring = header->ring[side];
+      ring.head = 0;
+      ring.tail = 0;
+      ring.head_seq = 0;
+      ring.tail_seq = 0;
+      ring.reader_waiting = 0;
+      ring.writer_waiting = 0;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = kShmChannelMagic;
+  }
+
+  static size_t SegmentSize(uint64_t capacity) { return kShmChannelDataOffset + 2 * capacity; }
+
+  size_t Send(const void* data, size_t size) final {
+    ShmRing& ring = header_->ring[side_];
+    char* buf = RingData(side_);
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    uint64_t space = 0;
+    bool ready = Wait(&ring.tail_seq, &ring.writer_waiting, [&]() {
+      space = capacity_ - (head - ring.tail.load(std::memory_order_acquire));
+      return space != 0;
+    });
+    ICHECK(ready) << "Shared memory RPC peer closed the channel";
+    size_t nbytes = std::min<uint64_t>(size, space);
+    CopyWrapped(static_cast<const char*>(data), buf, head % capacity_, nbytes);
+    ring.head.store(head + nbytes, std::memory_order_release);
+    Notify(&ring.head_seq, &ring.reader_waiting);
+    return nbytes;
+  }
+
+  size_t Recv(void* data, size_t size) final {
+    ShmRing& ring = header_->ring[1 - side_];
+    const char* buf = RingData(1 - side_);
+    uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+    uint64_t avail = 0;
+    bool ready = Wait(&ring.head_seq, &ring.reader_waiting, [&]() {
+      avail = ring.head.load(std::memory_order_acquire) - tail;
+      return avail != 0;
+    });
+    // A closed peer with nothing left to read is the end of the stream.
+    if (!ready) return 0;
+    size_t nbytes = std::min<uint64_t>(size, avail);
+    size_t offset = tail % capacity_;
+    size_t first = std::min<size_t>(nbytes, capacity_ - offset);
+    std::memcpy(data, buf + offset, first);
+    std::memcpy(static_cast<char*>(data) + first, buf, nbytes - first);
+    ring.tail.store(tail + nbytes, std::memory_order_release);
+    Notify(&ring.tail_seq, &ring.writer_waiting);
+    return nbytes;
+  }
+
+  /*! \brief Remove the name of the segment once the server has attached. */
+  void Unlink() { shm_->Unlink(); }
+
+ private:
+  char* RingData(int index) const {
+    return shm_->data() + kShmChannelDataOffset + index * capacity_;
+  }
+
+  void CopyWrapped(const char* src, char* buf, size_t offset, size_t nbytes) {
+    size_t first = std::min<size_t>(nbytes, capacity_ - offset);
+    std::memcpy(buf + offset, src, first);
+    std::memcpy(buf, src + first, nbytes - first);
+  }
+
+  bool PeerAlive() const {
+    if (header_->closed[1 - side_]) return false;
+    if (child_pid_ != 0) {
+      if (waitpid(child_pid_, nullptr, WNOHANG) == 0) return true;
+      child_pid_ = 0;
+      return false;
+    }
+    int32_t pid = header_->pid[1 - side_];
+    return pid == 0 || kill(pid, 0) == 0 || errno != ESRCH;
+  }
+
+  /*!
+   * \brief Wait until cond holds.
+   * \return Whether cond holds, false when the peer went away first.
+   */
+  template <typename FCond>
+  bool Wait(std::atomic<uint32_t>* seq, std::atomic<uint32_t>* waiting, FCond cond) {
+    // Spinning only helps when the peer runs on another core.
+    static const int spin_count = std::thread::hardware_concurrency() > 1 ? kSpinCount : 0;
+    for (int i = 0; i < spin_count; ++i) {
+      if (cond()) return true;
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#endif
+    }
+    while (true) {
+      uint32_t value = seq->load();
+      waiting->store(1);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (cond()) break;
+      FutexWait(seq, value, kWaitTimeoutNs);
+      if (cond()) break;
+      if (!PeerAlive()) {
+        waiting->store(0);
+        return cond();
+      }
+    }
+    waiting->store(0);
+    return true;
+  }
+
+  void Notify(std::atomic<uint32_t>* seq, std::atomic<uint32_t>* waiting) {
+    seq->fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting->load()) FutexWake(seq);
+  }
+
+  static constexpr int kSpinCount = 1024;
+  static constexpr int64_t kWaitTimeoutNs = 100000000;
+
+  std::shared_ptr<SharedMemory> shm_;
+  ShmChannelHeader* header_;
+  uint64_t capacity_;
+  int side_;
+  // Cleared once the child has been reaped.
+  mutable pid_t child_pid_;
+};
+
+Module CreateShmClient(uint64_t capacity, std::vector<std::string> cmd) {
+  ICHECK(!cmd.empty()) << "Expect the command starting the server";
+  std::shared_ptr<SharedMemory> shm = SharedMemory::Create(ShmChannel::SegmentSize(capacity));
+  ShmChannel::InitSegment(shm.get(), capacity);
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    // child process
+    cmd.push_back(shm->name());
+    std::vector<char*> argv;
+    for (auto& str : cmd) {
+      argv.push_back(dmlc::BeginPtr(str));
+    }
+    argv.push_back(nullptr);
+    execvp(argv[0], &argv[0]);
+    _exit(127);
+  }
+  ICHECK_GT(pid, 0) << "Cannot fork the shared memory RPC server";
+  // parent process
+  std::unique_ptr<ShmChannel> channel(new ShmChannel(shm, 0, pid));
+  ShmChannel* chan = channel.get();
+  auto endpt = RPCEndpoint::Create(std::move(channel), "shm", "shm");
+  endpt->InitRemoteSession(TVMArgs(nullptr, nullptr, 0));
+  // The server has attached, nobody else needs the name.
+  chan->Unlink();
+  return CreateRPCSessionModule(CreateClientSession(endpt));
+}
+
+void ShmServerLoop(const std::string& name) {
+  std::unique_ptr<ShmChannel> channel(new ShmChannel(SharedMemory::Open(name), 1));
+  RPCEndpoint::Create(std::move(channel), "ShmServerLoop", "")->ServerLoop();
+}
+
+// The argument order is capacity, cmd0, cmd1, ...; the segment name is appended to cmd.
+TVM_REGISTER_GLOBAL("rpc.CreateShmClient").set_body([](TVMArgs args, TVMRetValue* rv) {
+  ICHECK_GE(args.size(), 2) << "Expect the ring capacity and the command starting the server";
+  int64_t capacity = args[0];
+  std::vector<std::string> cmd;
+  for (int i = 1; i < args.size(); ++i) {
+    cmd.push_back(args[i].operator std::string());
+  }
+  *rv = CreateShmClient(capacity > 0 ? capacity : kShmRingCapacityDefault, cmd);
+});
+
+TVM_REGISTER_GLOBAL("rpc.ShmServerLoop").set_body_typed(ShmServerLoop);
+
+namespace {
+
+constexpr uint64_t kShmNDArrayMagic = 0x54564D53484D4E44;
+constexpr int kShmNDArrayMaxDim = 32;
+
+/*! \brief The header of an array segment, the data follows at kShmNDArrayDataOffset. */
+struct ShmNDArrayHeader {
+  uint64_t magic;
+  DLDataType dtype;
+  int32_t ndim;
+  int64_t shape[kShmNDArrayMaxDim];
+};
+
+constexpr size_t kShmNDArrayDataOffset =
+    (sizeof(ShmNDArrayHeader) + kAllocAlignment - 1) / kAllocAlignment * kAllocAlignment;
+
+/*! \brief Container of an array in shared memory, keeping the mapping alive. */
+struct ShmNDArrayContainer : public NDArray::Container {
+  ShmNDArrayContainer(ShapeTuple shape, DLDataType dtype, std::shared_ptr<SharedMemory> shm)
+      : NDArray::Container(shm->data() + kShmNDArrayDataOffset, shape, dtype, Device{kDLCPU, 0}),
+        shm(std::move(shm)) {
+    std::lock_guard<std::mutex> lock(mutex);
+    names[dl_tensor.data] = this->shm->name();
+  }
+  std::shared_ptr<SharedMemory> shm;
+
+  static void Deleter(Object* container) {
+    auto* ptr = static_cast<ShmNDArrayContainer*>(container);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      names.erase(ptr->dl_tensor.data);
+    }
+    delete ptr;
+  }
+
+  /*! \brief The segment names of the live arrays, by data pointer. */
+  static std::unordered_map<const void*, std::string> names;
+  static std::mutex mutex;
+};
+
+std::unordered_map<const void*, std::string> ShmNDArrayContainer::names;
+std::mutex ShmNDArrayContainer::mutex;
+
+}  // namespace
+
+/*!
+ * \brief Allocate a CPU array in a new shared memory segment.
+ *
+ *  Other processes on the host map the same pages with ShmNDArrayOpen, so
+ *  large inputs and outputs change hands without being copied. The segment
+ *  name goes away with the array.
+ */
+NDArray ShmNDArrayEmpty(ShapeTuple shape, DLDataType dtype) {
+  ICHECK_LE(shape.size(), kShmNDArrayMaxDim) << "Too many dimensions for a shared memory array";
+  size_t nbytes = (dtype.bits * dtype.lanes + 7) / 8;
+  for (int64_t dim : shape) {
+    nbytes *= dim;
+  }
+  std::shared_ptr<SharedMemory> shm = SharedMemory::Create(kShmNDArrayDataOffset + nbytes);
+  auto* header = reinterpret_cast<ShmNDArrayHeader*>(shm->data());
+  header->magic = kShmNDArrayMagic;
+  header->dtype = dtype;
+  header->ndim = static_cast<int32_t>(shape.size());
+  std::copy(shape.begin(), shape.end(), header->shape);
+  auto* container = new ShmNDArrayContainer(shape, dtype, shm);
+  container->SetDeleter(ShmNDArrayContainer::Deleter);
+  return NDArray(GetObjectPtr<Object>(container));
+}
+
+/*! \brief Map an array created by ShmNDArrayEmpty in another process. */
+NDArray ShmNDArrayOpen(const std::string& name) {
+  std::shared_ptr<SharedMemory> shm = SharedMemory::Open(name);
+  ICHECK_GE(shm->size(), kShmNDArrayDataOffset) << "Invalid shared memory array " << name;
+  const auto* header = reinterpret_cast<const ShmNDArrayHeader*>(shm->data());
+  ICHECK_EQ(header->magic, kShmNDArrayMagic) << "Invalid shared memory array " << name;
+  ShapeTuple shape(header->shape, header->shape + header->ndim);
+  auto* container = new ShmNDArrayContainer(shape, header->dtype, shm);
+  container->SetDeleter(ShmNDArrayContainer::Deleter);
+  NDArray arr(GetObjectPtr<Object>(container));
+  ICHECK_LE(kShmNDArrayDataOffset + GetDataSize(*arr.operator->()), shm->size())
+      << "Invalid shared memory array " << name;
+  return arr;
+}
+
+/*! \return The segment name of an array created by ShmNDArrayEmpty. */
+std::string ShmNDArrayName(NDArray arr) {
+  std::lock_guard<std::mutex> lock(ShmNDArrayContainer::mutex);
+  auto it = ShmNDArrayContainer::names.find(arr->data);
+  ICHECK(it != ShmNDArrayContainer::names.end()) << "The array is not in shared memory";
+  return it->second;
+}
+
+TVM_REGISTER_GLOBAL("rpc.ShmNDArrayEmpty").set_body_typed(ShmNDArrayEmpty);
+TVM_REGISTER_GLOBAL("rpc.ShmNDArrayOpen").set_body_typed(ShmNDArrayOpen);
+TVM_REGISTER_GLOBAL("rpc.ShmNDArrayName").set_body_typed(ShmNDArrayName);
+
+}  // namespace runtime
+}  // namespace tvm
+#endif
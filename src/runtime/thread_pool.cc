@@ -24,8 +24,11 @@
 #include <dmlc/thread_local.h>
 #include <tvm/runtime/c_backend_api.h>
 #include <tvm/runtime/c_runtime_api.h>
+#include <tvm/runtime/container/array.h>
+#include <tvm/runtime/container/shape_tuple.h>
 #include <tvm/runtime/logging.h>
 #include <tvm/runtime/packed_func.h>
+#include <tvm/runtime/profiling.h>
 #include <tvm/runtime/registry.h>
 #include <tvm/runtime/threading_backend.h>
 #if TVM_THREADPOOL_USE_OPENMP
@@ -35,6 +38,7 @@
 #include <atomic>
 #include <condition_variable>
 #include <cstring>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <sstream>
@@ -58,6 +62,34 @@ uint32_t GetSpinCount() {
   return atoi(val);
 }
 
+/*! \brief The kind of thread pool backing TVMBackendParallelLaunch. */
+enum class ThreadPoolKind : int {
+  /*! \brief Per-caller pool, one task per worker through a SpscTaskQueue. */
+  kDefault = 0,
+  /*! \brief Process-wide pool with per-worker deques and work stealing. */
+  kWorkStealing = 1,
+};
+
+ThreadPoolKind ParseThreadPoolKind(const std::string& name) {
+  if (name == "default") return ThreadPoolKind::kDefault;
+  if (name == "work_stealing") return ThreadPoolKind::kWorkStealing;
+  LOG(FATAL) << "Unknown thread pool kind \"" << name
+             << "\", expected one of \"default\", \"work_stealing\"";
+  return ThreadPoolKind::kDefault;
+}
+
+std::atomic<int>& ThreadPoolKindStore() {
+  static std::atomic<int> kind([] {
+    const char* val = getenv("TVM_THREAD_POOL_KIND");
+    return static_cast<int>(val ? ParseThreadPoolKind(val) : ThreadPoolKind::kDefault);
+  }());
+  return kind;
+}
+
+ThreadPoolKind GetThreadPoolKind() {
+  return static_cast<ThreadPoolKind>(ThreadPoolKindStore().load(std::memory_order_relaxed));
+}
+
 }  // namespace
 
 // stride in the page, fit to cache line.
@@ -301,6 +333,8 @@ class ThreadPool {
     // use the main thread to run task 0
     if (exclude_worker0_) {
       TVMParallelGroupEnv* penv = &(tsk.launcher->env);
+      profiling::TraceScope scope("parallel task", "parallel");
+      if (scope.active()) scope.AddArg("task_id", "0");
       if ((*tsk.launcher->flambda)(0, penv, cdata) == 0) {
         tsk.launcher->SignalJobFinish();
       } else {
@@ -313,10 +347,11 @@ class ThreadPool {
 
   static ThreadPool* ThreadLocal() { return dmlc::ThreadLocalStore<ThreadPool>::Get(); }
 
-  void UpdateWorkerConfiguration(threading::ThreadGroup::AffinityMode mode, int nthreads) {
+  void UpdateWorkerConfiguration(threading::ThreadGroup::AffinityMode mode, int nthreads,
+                                 std::vector<unsigned int> cpus) {
     // this will also reset the affinity of the ThreadGroup
     // may use less than the MaxConcurrency number of workers
-    num_workers_used_ = threads_->Configure(mode, nthreads, exclude_worker0_);
+    num_workers_used_ = threads_->Configure(mode, nthreads, exclude_worker0_, cpus);
     // if MaxConcurrency restricted the number of workers (e.g., due to
     // hyperthreading), respect the restriction
     num_workers_used_ = std::min(num_workers_, num_workers_used_);
@@ -332,10 +367,13 @@ class ThreadPool {
     // the global first use of the ThreadPool.
     // TODO(tulloch): should we make this configurable via standard APIs?
     static size_t spin_count = GetSpinCount();
+    profiling::TraceRecorder::Global()->SetThreadName("tvm worker " + std::to_string(worker_id));
     while (queue->Pop(&task, spin_count)) {
       ICHECK(task.launcher != nullptr);
       TVMParallelGroupEnv* penv = &(task.launcher->env);
       void* cdata = task.launcher->cdata;
+      profiling::TraceScope scope("parallel task", "parallel");
+      if (scope.active()) scope.AddArg("task_id", std::to_string(task.task_id));
       if ((*task.launcher->flambda)(task.task_id, penv, cdata) == 0) {
         task.launcher->SignalJobFinish();
       } else {
@@ -352,27 +390,303 @@ class ThreadPool {
   std::unique_ptr<tvm::runtime::threading::ThreadGroup> threads_;
 };
 
+/*!
+ * \brief Process-wide work-stealing thread pool.
+ *
+ *  Unlike ThreadPool, a single instance is shared by every thread calling into the
+ *  runtime. A launch is published as one task range [begin, end); whoever picks a range
+ *  up splits it in halves, keeps the lower half and pushes the upper half onto its own
+ *  deque where idle workers can steal it. Owners pop from the back of their deque (LIFO)
+ *  while thieves take from the front (FIFO), so stolen ranges are the largest ones.
+ *
+ *  The launching thread never blocks: it executes tasks until its job finishes. The same
+ *  holds for a launch issued from inside a worker, so nested launches reuse the existing
+ *  workers instead of oversubscribing the machine.
+ *
+ *  Tasks of one launch are not guaranteed to run concurrently, hence
+ *  TVMBackendParallelBarrier is not supported by this pool: a task reaching a barrier
+ *  makes its launch fail with an error instead of waiting forever.
+ *
+ *  The pool is shared by the whole process and always uses the big cores, so the
+ *  per-thread affinity and CPU lists set through threading::Configure only apply to
+ *  the default pool.
+ */
+class WorkStealingThreadPool {
+ public:
+  WorkStealingThreadPool() : num_workers_(tvm::runtime::threading::MaxConcurrency()) {
+    const char* tasks_per_worker = getenv("TVM_THREAD_POOL_TASKS_PER_WORKER");
+    if (tasks_per_worker) {
+      tasks_per_worker_ = std::max(atoi(tasks_per_worker), 1);
+    }
+    // queues_[0] is shared by all threads outside of the pool.
+    for (int i = 0; i < num_workers_; ++i) {
+      queues_.emplace_back(new TaskDeque());
+    }
+    threads_ = std::unique_ptr<tvm::runtime::threading::ThreadGroup>(
+        new tvm::runtime::threading::ThreadGroup(
+            num_workers_, [this](int worker_id) { this->RunWorker(worker_id); },
+            true /* exclude_worker0 */));
+    threads_->Configure(threading::ThreadGroup::kBig, 0, true);
+  }
+  ~WorkStealingThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      exit_now_.store(true);
+      cv_.notify_all();
+    }
+    threads_.reset();
+  }
+
+  int Launch(FTVMParallelLambda flambda, void* cdata, int num_task) {
+    if (num_task == 0) {
+      num_task = num_workers_ * tasks_per_worker_;
+    }
+    Job job;
+    job.flambda = flambda;
+    job.cdata = cdata;
+    job.env.num_task = num_task;
+    job.env.sync_handle = nullptr;
+    job.num_pending.store(num_task, std::memory_order_relaxed);
+    job.errors.resize(num_task);
+    int self = WorkerId();
+    RunRange(self, Task{&job, 0, num_task});
+    // Help out until every task of the job has been finished, possibly by thieves.
+    while (job.num_pending.load(std::memory_order_acquire) != 0) {
+      Task task;
+      if (PopOrSteal(self, &task)) {
+        RunRange(self, task);
+      } else {
+        tvm::runtime::threading::Yield();
+      }
+    }
+    if (!job.has_error.load(std::memory_order_relaxed)) return 0;
+    std::ostringstream os;
+    for (int i = 0; i < num_task; ++i) {
+      if (job.errors[i].length() != 0) {
+        os << "Task " << i << " error: " << job.errors[i] << '\n';
+      }
+    }
+    TVMAPISetLastError(os.str().c_str());
+    return -1;
+  }
+
+  static WorkStealingThreadPool* Global() {
+    static WorkStealingThreadPool* inst = new WorkStealingThreadPool();
+    return inst;
+  }
+
+  /*! \return Whether the calling thread is a worker of the global pool. */
+  static bool IsWorker() { return WorkerId() != 0; }
+
+  /*!
+   * \brief Fail the task the calling thread is running because it reached a barrier.
+   * \return Whether the calling thread is running a task of this pool.
+   */
+  static bool ReportBarrier() {
+    const Task* task = CurrentTask();
+    if (task == nullptr) return false;
+    task->job->errors[task->begin] =
+        "TVMBackendParallelBarrier is not supported by the work-stealing thread pool, "
+        "set TVM_THREAD_POOL_KIND=default to run kernels with parallel barriers";
+    task->job->has_error.store(true, std::memory_order_relaxed);
+    return true;
+  }
+
+ private:
+  /*! \brief A single parallel launch, lives on the stack of the launching thread. */
+  struct Job {
+    FTVMParallelLambda flambda;
+    void* cdata;
+    TVMParallelGroupEnv env;
+    std::atomic<int32_t> num_pending;
+    std::atomic<bool> has_error{false};
+    std::vector<std::string> errors;
+  };
+  /*! \brief A range of task ids [begin, end) of one job. */
+  struct Task {
+    Job* job;
+    int32_t begin;
+    int32_t end;
+  };
+  /*! \brief Deque of one worker, padded to avoid false sharing between workers. */
+  struct TaskDeque {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+    char pad[kL1CacheBytes];
+  };
+
+  // Per-thread worker id, 0 for threads outside of the pool.
+  static int& WorkerId() {
+    static thread_local int worker_id = 0;
+    return worker_id;
+  }
+
+  // The task the calling thread is executing, nullptr outside of RunRange.
+  static const Task*& CurrentTask() {
+    static thread_local const Task* task = nullptr;
+    return task;
+  }
+
+  void Push(int self, const Task& task) {
+    {
+      TaskDeque* q = queues_[self].get();
+      std::lock_guard<std::mutex> lock(q->mutex);
+      q->tasks.push_back(task);
+    }
+    num_queued_.fetch_add(1);
+    if (num_sleeping_.load() != 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cv_.notify_one();
+    }
+  }
+
+  bool TryPop(int index, bool back, Task* task) {
+    TaskDeque* q = queues_[index].get();
+    std::lock_guard<std::mutex> lock(q->mutex);
+    if (q->tasks.empty()) return false;
+    if (back) {
+      *task = q->tasks.back();
+      q->tasks.pop_back();
+    } else {
+      *task = q->tasks.front();
+      q->tasks.pop_front();
+    }
+    num_queued_.fetch_sub(1);
+    return true;
+  }
+
+  bool PopOrSteal(int self, Task* task) {
+    if (num_queued_.load(std::memory_order_relaxed) == 0) return false;
+    // The shared queue of external threads is served in FIFO order.
+    if (TryPop(self, self != 0, task)) return true;
+    for (int i = 1; i < num_workers_; ++i) {
+      int victim = (self + i) % num_workers_;
+      if (TryPop(victim, false, task)) return true;
+    }
+    return false;
+  }
+
+  // Split off the upper halves of the range for thieves, then run the rest.
+  void RunRange(int self, Task task) {
+    while (task.end - task.begin > 1) {
+      int32_t mid = task.begin + (task.end - task.begin) / 2;
+      Push(self, Task{task.job, mid, task.end});
+      task.end = mid;
+    }
+    Job* job = task.job;
+    {
+      profiling::TraceScope scope("parallel task", "parallel");
+      if (scope.active()) scope.AddArg("task_id", std::to_string(task.begin));
+      // Nested launches run tasks of other jobs on this thread, restore the outer one.
+      const Task* outer = CurrentTask();
+      CurrentTask() = &task;
+      if ((*job->flambda)(task.begin, &(job->env), job->cdata) != 0) {
+        job->errors[task.begin] = TVMGetLastError();
+        job->has_error.store(true, std::memory_order_relaxed);
+      }
+      CurrentTask() = outer;
+    }
+    // The job may be released by its launcher once num_pending reaches zero.
+    job->num_pending.fetch_sub(1, std::memory_order_acq_rel);
+  }
+
+  void RunWorker(int worker_id) {
+    WorkerId() = worker_id;
+    static size_t spin_count = GetSpinCount();
+    profiling::TraceRecorder::Global()->SetThreadName("tvm work-stealing worker " +
+                                                      std::to_string(worker_id));
+    Task task;
+    while (!exit_now_.load(std::memory_order_relaxed)) {
+      if (PopOrSteal(worker_id, &task)) {
+        RunRange(worker_id, task);
+        continue;
+      }
+      for (size_t i = 0; i < spin_count && num_queued_.load() == 0; ++i) {
+        tvm::runtime::threading::Yield();
+      }
+      if (num_queued_.load() != 0) continue;
+      std::unique_lock<std::mutex> lock(mutex_);
+      num_sleeping_.fetch_add(1);
+      cv_.wait(lock, [this] { return num_queued_.load() != 0 || exit_now_.load(); });
+      num_sleeping_.fetch_sub(1);
+    }
+  }
+
+  int num_workers_;
+  // number of tasks to split a launch into per worker when num_task is 0
+  int tasks_per_worker_{1};
+  std::vector<std::unique_ptr<TaskDeque> > queues_;
+  // total number of ranges sitting in the deques
+  std::atomic<int32_t> num_queued_{0};
+  // number of workers waiting on cv_
+  std::atomic<int32_t> num_sleeping_{0};
+  std::atomic<bool> exit_now_{false};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::unique_ptr<tvm::runtime::threading::ThreadGroup> threads_;
+};
+
+TVM_REGISTER_GLOBAL("runtime.config_threadpool_kind").set_body_typed([](std::string kind) {
+  ThreadPoolKindStore().store(static_cast<int>(ParseThreadPoolKind(kind)));
+});
+
 TVM_REGISTER_GLOBAL("runtime.config_threadpool").set_body([](TVMArgs args, TVMRetValue* rv) {
   threading::ThreadGroup::AffinityMode mode =
       static_cast<threading::ThreadGroup::AffinityMode>(static_cast<int>(args[0]));
   int nthreads = args[1];
-  ThreadPool::ThreadLocal()->UpdateWorkerConfiguration(mode, nthreads);
+  std::vector<unsigned int> cpus;
+  if (args.num_args >= 3) {
+    ShapeTuple cpu_list = args[2];
+    cpus.assign(cpu_list.begin(), cpu_list.end());
+  }
+  threading::Configure(mode, nthreads, cpus);
+});
+
+namespace {
+Array<ShapeTuple> ToCpuArray(const std::vector<std::vector<unsigned int>>& cpu_lists) {
+  Array<ShapeTuple> result;
+  for (const auto& cpus : cpu_lists) {
+    result.push_back(ShapeTuple(cpus.begin(), cpus.end()));
+  }
+  return result;
+}
+}  // namespace
+
+TVM_REGISTER_GLOBAL("runtime.threading.NumaNodeCpus").set_body_typed([]() {
+  return ToCpuArray(threading::NumaNodeCpus());
 });
 
+TVM_REGISTER_GLOBAL("runtime.threading.PartitionCpus")
+    .set_body_typed([](int num_sessions, int cores_per_session) {
+      return ToCpuArray(threading::PartitionCpus(num_sessions, cores_per_session));
+    });
+
+namespace threading {
+void Configure(ThreadGroup::AffinityMode mode, int nthreads, std::vector<unsigned int> cpus) {
+  ThreadPool::ThreadLocal()->UpdateWorkerConfiguration(mode, nthreads, cpus);
+}
+}  // namespace threading
+
 }  // namespace runtime
 }  // namespace tvm
 
 int TVMBackendParallelLaunch(FTVMParallelLambda flambda, void* cdata, int num_task) {
+  tvm::runtime::profiling::TraceScope scope("TVMBackendParallelLaunch", "parallel");
+  if (scope.active()) scope.AddArg("num_task", std::to_string(num_task));
   int num_workers = tvm::runtime::threading::MaxConcurrency();
   if (num_workers == 1) {
     std::atomic<int32_t> sync_counter{0};
     TVMParallelGroupEnv env;
     env.num_task = 1;
     env.sync_handle = &sync_counter;
-    (*flambda)(0, &env, cdata);
-    return 0;
+    return (*flambda)(0, &env, cdata) == 0 ? 0 : -1;
   } else {
 #if !TVM_THREADPOOL_USE_OPENMP
+    // Launches from inside the work-stealing pool always stay in it.
+    if (tvm::runtime::GetThreadPoolKind() == tvm::runtime::ThreadPoolKind::kWorkStealing ||
+        tvm::runtime::WorkStealingThreadPool::IsWorker()) {
+      return tvm::runtime::WorkStealingThreadPool::Global()->Launch(flambda, cdata, num_task);
+    }
     int res = tvm::runtime::ThreadPool::ThreadLocal()->Launch(flambda, cdata, num_task, 1);
     return res;
 #else
@@ -395,6 +709,14 @@ int TVMBackendParallelBarrier(int task_id, TVMParallelGroupEnv* penv) {
 #else
   using tvm::runtime::kSyncStride;
   int num_task = penv->num_task;
+  if (penv->sync_handle == nullptr) {
+    // Only launches of the work-stealing pool come without sync counters. Throwing here
+    // would terminate the worker thread, so fail the launch through its error instead.
+    if (!tvm::runtime::WorkStealingThreadPool::ReportBarrier()) {
+      TVMAPISetLastError("TVMBackendParallelBarrier called without a parallel environment");
+    }
+    return -1;
+  }
   std::atomic<int>* sync_counter = reinterpret_cast<std::atomic<int>*>(penv->sync_handle);
   int old_counter = sync_counter[task_id * kSyncStride].fetch_add(1, std::memory_order_release);
   for (int i = 0; i < num_task; ++i) {
@@ -25,6 +25,7 @@
 #include <tvm/runtime/threading_backend.h>
 
 #include <algorithm>
+#include <string>
 #include <thread>
 #if defined(__linux__) || defined(__ANDROID__)
 #include <fstream>
@@ -60,7 +61,11 @@ class ThreadGroup::Impl {
     }
   }
 
-  int Configure(AffinityMode mode, int nthreads, bool exclude_worker0) {
+  int Configure(AffinityMode mode, int nthreads, bool exclude_worker0,
+                std::vector<unsigned int> cpus) {
+    if (mode == kSpecifyOneCorePerThread || mode == kSpecifyThreadShareAllCore) {
+      return ConfigureCpus(mode, nthreads, exclude_worker0, cpus);
+    }
     int num_workers_used = 0;
     if (mode == kLittle) {
       num_workers_used = little_count_;
@@ -94,6 +99,54 @@ class ThreadGroup::Impl {
   }
 
  private:
+  int ConfigureCpus(AffinityMode mode, int nthreads, bool exclude_worker0,
+                    const std::vector<unsigned int>& cpus) {
+    CHECK(!cpus.empty()) << "The CPU list must not be empty in affinity mode " << mode;
+    int num_workers_used = nthreads ? nthreads : static_cast<int>(cpus.size());
+    if (mode == kSpecifyOneCorePerThread) {
+      num_workers_used = std::min(num_workers_used, static_cast<int>(cpus.size()));
+    }
+    num_workers_used = std::min(num_workers_, num_workers_used);
+    const char* val = getenv("TVM_BIND_THREADS");
+    if (val == nullptr || atoi(val) == 1) {
+      SetCpusAffinity(exclude_worker0, mode == kSpecifyOneCorePerThread, cpus);
+    }
+    return num_workers_used;
+  }
+
+  // bind worker threads to the given cpus, either one core each (cycling over
+  // the list when there are more threads than cpus) or sharing all of them.
+  // The main thread may migrate over the whole list.
+  void SetCpusAffinity(bool exclude_worker0, bool one_core_per_thread,
+                       const std::vector<unsigned int>& cpus) {
+#if defined(__linux__) || defined(__ANDROID__)
+    cpu_set_t all_cpus;
+    CPU_ZERO(&all_cpus);
+    for (unsigned int cpu : cpus) {
+      CPU_SET(cpu, &all_cpus);
+    }
+    for (unsigned i = 0; i < threads_.size(); ++i) {
+      cpu_set_t cpuset = all_cpus;
+      if (one_core_per_thread) {
+        CPU_ZERO(&cpuset);
+        CPU_SET(cpus[(i + exclude_worker0) % cpus.size()], &cpuset);
+      }
+#if defined(__ANDROID__)
+      sched_setaffinity(threads_[i].native_handle(), sizeof(cpu_set_t), &cpuset);
+#else
+      pthread_setaffinity_np(threads_[i].native_handle(), sizeof(cpu_set_t), &cpuset);
+#endif
+    }
+    if (exclude_worker0) {
+#if defined(__ANDROID__)
+      sched_setaffinity(pthread_self(), sizeof(cpu_set_t), &all_cpus);
+#else
+      pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &all_cpus);
+#endif
+    }
+#endif
+  }
+
   // bind worker threads to disjoint cores
   // if worker 0 is offloaded to main, i.e. exclude_worker0 is true,
   // the main thread is bound to core 0.
@@ -231,8 +284,9 @@ ThreadGroup::ThreadGroup(int num_workers, std::function<void(int)> worker_callba
 ThreadGroup::~ThreadGroup() { delete impl_; }
 void ThreadGroup::Join() { impl_->Join(); }
 
-int ThreadGroup::Configure(AffinityMode mode, int nthreads, bool exclude_worker0) {
-  return impl_->Configure(mode, nthreads, exclude_worker0);
+int ThreadGroup::Configure(AffinityMode mode, int nthreads, bool exclude_worker0,
+                           std::vector<unsigned int> cpus) {
+  return impl_->Configure(mode, nthreads, exclude_worker0, cpus);
 }
 
 void Yield() { std::this_thread::yield(); }
@@ -265,6 +319,97 @@ int MaxConcurrency() {
   return std::max(max_concurrency, 1);
 }
 
+#if defined(__linux__)
+namespace {
+// Parse a kernel cpu list such as "0-3,8,10-11".
+std::vector<unsigned int> ParseCpuList(const std::string& list) {
+  std::vector<unsigned int> cpus;
+  std::istringstream is(list);
+  std::string range;
+  while (std::getline(is, range, ',')) {
+    if (range.empty() || range == "\n") continue;
+    size_t dash = range.find('-');
+    unsigned int begin = std::stoul(range.substr(0, dash));
+    unsigned int end = dash == std::string::npos ? begin : std::stoul(range.substr(dash + 1));
+    for (unsigned int cpu = begin; cpu <= end; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+}  // namespace
+#endif
+
+std::vector<std::vector<unsigned int>> NumaNodeCpus() {
+  std::vector<std::vector<unsigned int>> nodes;
+#if defined(__linux__)
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  bool has_mask = sched_getaffinity(0, sizeof(cpu_set_t), &allowed) == 0;
+  for (int node = 0;; ++node) {
+    std::ostringstream filepath;
+    filepath << "/sys/devices/system/node/node" << node << "/cpulist";
+    std::ifstream ifs(filepath.str());
+    if (ifs.fail()) break;
+    std::string list;
+    std::getline(ifs, list);
+    std::vector<unsigned int> cpus;
+    for (unsigned int cpu : ParseCpuList(list)) {
+      if (!has_mask || CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+    }
+    if (!cpus.empty()) nodes.push_back(cpus);
+  }
+  if (nodes.empty() && has_mask) {
+    std::vector<unsigned int> cpus;
+    for (unsigned int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+    }
+    nodes.push_back(cpus);
+  }
+#endif
+  if (nodes.empty()) {
+    std::vector<unsigned int> cpus;
+    for (unsigned int cpu = 0; cpu < std::thread::hardware_concurrency(); ++cpu) {
+      cpus.push_back(cpu);
+    }
+    nodes.push_back(cpus);
+  }
+  return nodes;
+}
+
+std::vector<std::vector<unsigned int>> PartitionCpus(int num_sessions, int cores_per_session) {
+  CHECK_GT(num_sessions, 0) << "The number of sessions must be positive";
+  CHECK_GT(cores_per_session, 0) << "The number of cores per session must be positive";
+  std::vector<std::vector<unsigned int>> nodes = NumaNodeCpus();
+  size_t num_cpus = 0;
+  for (const auto& node : nodes) {
+    num_cpus += node.size();
+  }
+  CHECK_LE(static_cast<size_t>(num_sessions) * cores_per_session, num_cpus)
+      << "Cannot give " << num_sessions << " sessions " << cores_per_session
+      << " cores each, only " << num_cpus << " cores are available";
+  // the number of cores already handed out on each node
+  std::vector<size_t> used(nodes.size(), 0);
+  std::vector<std::vector<unsigned int>> sessions;
+  for (int i = 0; i < num_sessions; ++i) {
+    std::vector<unsigned int> cpus;
+    for (size_t n = 0; n < nodes.size() && cpus.empty(); ++n) {
+      if (nodes[n].size() - used[n] >= static_cast<size_t>(cores_per_session)) {
+        cpus.assign(nodes[n].begin() + used[n], nodes[n].begin() + used[n] + cores_per_session);
+        used[n] += cores_per_session;
+      }
+    }
+    for (size_t n = 0; n < nodes.size() && cpus.size() < static_cast<size_t>(cores_per_session);
+         ++n) {
+      while (used[n] < nodes[n].size() && cpus.size() < static_cast<size_t>(cores_per_session)) {
+        cpus.push_back(nodes[n][used[n]++]);
+      }
+    }
+    sessions.push_back(cpus);
+  }
+  return sessions;
+}
+
 }  // namespace threading
 }  // namespace runtime
 }  // namespace tvm
@@ -0,0 +1,445 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file runtime/best_fit_allocator.h
+ * \brief Allocator that carves size-classed blocks out of device chunks.
+ *
+ *  Unlike PooledAllocator, which only reuses a buffer for a request of exactly the same
+ *  page-rounded size, this allocator keeps the free blocks ordered by size and serves a
+ *  request from the smallest block that fits, splitting off the remainder. Freed blocks
+ *  are merged with free neighbours of the same chunk, so memory released by one shape can
+ *  be reused by any other shape. Workloads with dynamic shapes therefore plateau at their
+ *  peak working set instead of growing with the number of distinct shapes.
+ */
+#ifndef TVM_RUNTIME_VM_BEST_FIT_ALLOCATOR_H_
+#define TVM_RUNTIME_VM_BEST_FIT_ALLOCATOR_H_
+
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/vm/memory_manager.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tvm {
+namespace runtime {
+namespace vm {
+
+class BestFitAllocator final : public Allocator {
+ public:
+  /*! \brief Granularity of all blocks, every block is aligned to it. */
+  static constexpr size_t kBlockAlignment = 256;
+  /*! \brief Largest block size served from the thread-local caches. */
+  static constexpr size_t kMaxThreadCacheBlock = 256 << 10;
+  /*! \brief Maximum number of blocks of one size class kept in a thread-local cache. */
+  static constexpr size_t kMaxThreadCacheBlocksPerClass = 8;
+  static constexpr size_t kDefaultThreadCacheBytes = 4 << 20;
+
+  /*! \brief Snapshot of the allocator state. */
+  struct Stats {
+    /*! \brief Bytes currently held from the device. */
+    size_t reserved_bytes{0};
+    /*! \brief The peak of reserved_bytes. */
+    size_t peak_reserved_bytes{0};
+    /*! \brief Bytes of blocks handed out, including those parked in thread-local caches. */
+    size_t allocated_bytes{0};
+    /*! \brief Bytes of blocks parked in thread-local caches. */
+    size_t thread_cached_bytes{0};
+    /*! \brief Bytes of free blocks in the shared pool. */
+    size_t free_bytes{0};
+    /*! \brief Size of the largest free block in the shared pool. */
+    size_t largest_free_block{0};
+    /*! \brief Number of free blocks in the shared pool. */
+    size_t num_free_blocks{0};
+    /*! \brief Number of chunks allocated from the device. */
+    size_t num_chunks{0};
+    /*!
+     * \brief External fragmentation of the shared pool, 1 - largest_free_block / free_bytes.
+     *  0 means all free memory is one contiguous block.
+     */
+    double fragmentation{0};
+  };
+
+  /*!
+   * \brief Create the allocator.
+   * \param dev The device to allocate on.
+   * \param max_free_bytes The high-water mark of free memory kept in the pool. Free chunks
+   *        beyond it are returned to the device. Defaults to TVM_VM_ALLOCATOR_MAX_FREE_BYTES,
+   *        or no limit when the variable is unset.
+   * \param thread_cache_bytes The capacity of each thread-local cache, 0 disables them.
+   *        Defaults to TVM_VM_ALLOCATOR_THREAD_CACHE_BYTES, or kDefaultThreadCacheBytes.
+   */
+  explicit BestFitAllocator(Device dev, size_t max_free_bytes = GetEnvBytes(
+                                            "TVM_VM_ALLOCATOR_MAX_FREE_BYTES",
+                                            std::numeric_limits<size_t>::max()),
+                            size_t thread_cache_bytes = GetEnvBytes(
+                                "TVM_VM_ALLOCATOR_THREAD_CACHE_BYTES", kDefaultThreadCacheBytes))
+      : Allocator(kBestFit),
+        device_(dev),
+        splittable_(IsSplittable(dev)),
+        max_free_bytes_(max_free_bytes),
+        thread_cache_bytes_(thread_cache_bytes),
+        id_(NextId()) {
+    std::lock_guard<std::mutex> lock(LiveAllocatorsMutex());
+    LiveAllocators()[id_] = this;
+  }
+
+  ~BestFitAllocator() {
+    {
+      std::lock_guard<std::mutex> lock(LiveAllocatorsMutex());
+      LiveAllocators().erase(id_);
+    }
+    // Blocks parked in caches of other threads are released together with their chunks.
+    ThreadCacheStore::Get()->caches.erase(id_);
+    for (auto& kv : chunks_) {
+      DeviceAPI::Get(device_)->FreeDataSpace(device_, kv.second->buffer.data);
+    }
+  }
+
+  Buffer Alloc(size_t nbytes, size_t alignment, DLDataType type_hint) override {
+    size_t size = SizeClass(nbytes);
+    if (alignment <= kBlockAlignment && size <= kMaxThreadCacheBlock &&
+        thread_cache_bytes_ != 0) {
+      ThreadCache* cache = LocalCache();
+      auto it = cache->bins.find(size);
+      if (it != cache->bins.end() && !it->second.empty()) {
+        Buffer buf = it->second.back();
+        it->second.pop_back();
+        cache->bytes -= size;
+        thread_cached_bytes_.fetch_sub(size, std::memory_order_relaxed);
+        return buf;
+      }
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    return AllocFromPool(size, alignment, type_hint);
+  }
+
+  void Free(const Buffer& buffer) override {
+    if (buffer.size <= kMaxThreadCacheBlock && thread_cache_bytes_ != 0) {
+      ThreadCache* cache = LocalCache();
+      std::vector<Buffer>& bin = cache->bins[buffer.size];
+      if (cache->bytes + buffer.size <= thread_cache_bytes_ &&
+          bin.size() < kMaxThreadCacheBlocksPerClass) {
+        bin.push_back(buffer);
+        cache->bytes += buffer.size;
+        thread_cached_bytes_.fetch_add(buffer.size, std::memory_order_relaxed);
+        return;
+      }
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    FreeToPool(buffer);
+  }
+
+  size_t UsedMemory() const override { return reserved_bytes_.load(std::memory_order_relaxed); }
+
+  /*! \brief Return the free chunks of the shared pool to the device until at most
+   *  max_free_bytes remain free. */
+  void Trim(size_t max_free_bytes) {
+    std::lock_guard<std::mutex> lock(mu_);
+    TrimLocked(max_free_bytes);
+  }
+
+  Stats GetStats() {
+    std::lock_guard<std::mutex> lock(mu_);
+    Stats stats;
+    stats.reserved_bytes = reserved_bytes_.load(std::memory_order_relaxed);
+    stats.peak_reserved_bytes = peak_reserved_bytes_;
+    stats.allocated_bytes = allocated_bytes_;
+    stats.thread_cached_bytes = thread_cached_bytes_.load(std::memory_order_relaxed);
+    stats.free_bytes = free_bytes_;
+    stats.largest_free_block = free_blocks_.empty() ? 0 : free_blocks_.rbegin()->first;
+    stats.num_free_blocks = free_blocks_.size();
+    stats.num_chunks = chunks_.size();
+    if (free_bytes_ != 0) {
+      stats.fragmentation = 1.0 - static_cast<double>(stats.largest_free_block) / free_bytes_;
+    }
+    return stats;
+  }
+
+  /*! \brief Round a request up to its size class: 8 classes per power of two, and at
+   *  least kBlockAlignment. The rounding wastes at most 12.5% of a larger request. */
+  static size_t SizeClass(size_t nbytes) {
+    size_t step = kBlockAlignment;
+    size_t size = nbytes > step ? nbytes : step;
+    while ((step << 4) < size) step <<= 1;
+    return (size + step - 1) / step * step;
+  }
+
+ private:
+  struct Chunk;
+  /*! \brief A contiguous range of a chunk, either free or handed out. */
+  struct Block {
+    Chunk* chunk;
+    size_t offset;
+    size_t size;
+    bool free{false};
+    // address-ordered neighbours within the chunk
+    Block* prev{nullptr};
+    Block* next{nullptr};
+    std::multimap<size_t, Block*>::iterator free_it;
+  };
+  /*! \brief A single allocation from the device, split into blocks. */
+  struct Chunk {
+    Buffer buffer;
+    std::unique_ptr<Block> head;
+    ~Chunk() {
+      if (head == nullptr) return;
+      for (Block* block = head->next; block != nullptr;) {
+        Block* next = block->next;
+        delete block;
+        block = next;
+      }
+    }
+  };
+  /*! \brief Per-thread cache of one allocator, accessed without any locking. */
+  struct ThreadCache {
+    std::unordered_map<size_t, std::vector<Buffer>> bins;
+    size_t bytes{0};
+  };
+  /*! \brief The thread-local caches of all allocators, flushed when the thread exits. */
+  struct ThreadCacheStore {
+    std::unordered_map<uint64_t, ThreadCache> caches;
+    static ThreadCacheStore* Get() {
+      static thread_local ThreadCacheStore inst;
+      return &inst;
+    }
+    ~ThreadCacheStore() {
+      std::lock_guard<std::mutex> lock(LiveAllocatorsMutex());
+      for (auto& kv : caches) {
+        auto it = LiveAllocators().find(kv.first);
+        if (it == LiveAllocators().end()) continue;
+        it->second->FlushCache(&kv.second);
+      }
+    }
+  };
+
+  static size_t GetEnvBytes(const char* name, size_t default_value) {
+    const char* val = getenv(name);
+    return val ? static_cast<size_t>(std::strtoull(val, nullptr, 10)) : default_value;
+  }
+
+  // Sub-ranges of an allocation can only be addressed by pointer arithmetic on devices
+  // whose data pointers are plain addresses, e.g. not on OpenCL where they are handles.
+  static bool IsSplittable(Device dev) {
+    switch (static_cast<int>(dev.device_type)) {
+      case kDLCPU:
+      case kDLCUDA:
+      case kDLCUDAHost:
+      case kDLROCM:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  static uint64_t NextId() {
+    static std::atomic<uint64_t> counter{0};
+    return counter.fetch_add(1);
+  }
+  static std::mutex& LiveAllocatorsMutex() {
+    static std::mutex* mu = new std::mutex();
+    return *mu;
+  }
+  static std::unordered_map<uint64_t, BestFitAllocator*>& LiveAllocators() {
+    static auto* inst = new std::unordered_map<uint64_t, BestFitAllocator*>();
+    return *inst;
+  }
+
+  ThreadCache* LocalCache() { return &(ThreadCacheStore::Get()->caches[id_]); }
+
+  void FlushCache(ThreadCache* cache) {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (auto& kv : cache->bins) {
+      for (const Buffer& buf : kv.second) {
+        thread_cached_bytes_.fetch_sub(buf.size, std::memory_order_relaxed);
+        FreeToPool(buf);
+      }
+    }
+    cache->bins.clear();
+    cache->bytes = 0;
+  }
+
+  void* BlockData(const Block* block) const {
+    return static_cast<char*>(block->chunk->buffer.data) + block->offset;
+  }
+
+  Buffer MakeBuffer(Block* block) {
+    Buffer buf;
+    buf.device = device_;
+    buf.size = block->size;
+    buf.data = splittable_ ? BlockData(block) : block->chunk->buffer.data;
+    used_blocks_[buf.data] = block;
+    allocated_bytes_ += block->size;
+    return buf;
+  }
+
+  Buffer AllocFromPool(size_t size, size_t alignment, DLDataType type_hint) {
+    // Blocks inside a chunk are only aligned to kBlockAlignment.
+    if (alignment <= kBlockAlignment) {
+      auto it = free_blocks_.lower_bound(size);
+      // Without splitting, do not waste more than half of a block.
+      if (it != free_blocks_.end() && (splittable_ || it->first <= size * 2)) {
+        Block* block = it->second;
+        free_blocks_.erase(it);
+        free_bytes_ -= block->size;
+        block->free = false;
+        if (splittable_ && block->size - size >= kBlockAlignment) {
+          std::unique_ptr<Block> rest(new Block());
+          rest->chunk = block->chunk;
+          rest->offset = block->offset + size;
+          rest->size = block->size - size;
+          rest->prev = block;
+          rest->next = block->next;
+          if (block->next != nullptr) block->next->prev = rest.get();
+          block->next = rest.get();
+          block->size = size;
+          InsertFree(rest.release());
+        }
+        return MakeBuffer(block);
+      }
+    }
+    Chunk* chunk = AllocChunk(size, alignment > kBlockAlignment ? alignment : kBlockAlignment,
+                              type_hint);
+    return MakeBuffer(chunk->head.get());
+  }
+
+  Chunk* AllocChunk(size_t size, size_t alignment, DLDataType type_hint) {
+    std::unique_ptr<Chunk> chunk(new Chunk());
+    chunk->buffer.device = device_;
+    chunk->buffer.size = size;
+    chunk->head.reset(new Block());
+    chunk->head->chunk = chunk.get();
+    chunk->head->offset = 0;
+    chunk->head->size = size;
+    try {
+      chunk->buffer.data =
+          DeviceAPI::Get(device_)->AllocDataSpace(device_, size, alignment, type_hint);
+    } catch (InternalError& err) {
+      LOG(WARNING) << "BestFitAllocator got InternalError during allocation: " << err.message();
+      LOG(WARNING) << "Trying to release all free chunks and reallocate...";
+      TrimLocked(0);
+      chunk->buffer.data =
+          DeviceAPI::Get(device_)->AllocDataSpace(device_, size, alignment, type_hint);
+    } catch (std::bad_alloc&) {
+      // Host device APIs report out of memory with std::bad_alloc.
+      LOG(WARNING) << "BestFitAllocator ran out of memory allocating " << size << " B";
+      LOG(WARNING) << "Trying to release all free chunks and reallocate...";
+      TrimLocked(0);
+      chunk->buffer.data =
+          DeviceAPI::Get(device_)->AllocDataSpace(device_, size, alignment, type_hint);
+    }
+    size_t reserved = reserved_bytes_.fetch_add(size, std::memory_order_relaxed) + size;
+    peak_reserved_bytes_ = std::max(peak_reserved_bytes_, reserved);
+    DLOG(INFO) << "allocate chunk of " << size << " B, reserved memory " << reserved << " B";
+    Chunk* ret = chunk.get();
+    chunks_[ret->buffer.data] = std::move(chunk);
+    return ret;
+  }
+
+  void FreeToPool(const Buffer& buffer) {
+    auto it = used_blocks_.find(buffer.data);
+    ICHECK(it != used_blocks_.end()) << "Freeing a buffer not allocated by this allocator";
+    Block* block = it->second;
+    used_blocks_.erase(it);
+    allocated_bytes_ -= block->size;
+    // Merge with the free neighbours, the head block of a chunk is never deleted.
+    if (block->next != nullptr && block->next->free) {
+      Block* next = block->next;
+      EraseFree(next);
+      block->size += next->size;
+      block->next = next->next;
+      if (next->next != nullptr) next->next->prev = block;
+      delete next;
+    }
+    if (block->prev != nullptr && block->prev->free) {
+      Block* prev = block->prev;
+      EraseFree(prev);
+      prev->size += block->size;
+      prev->next = block->next;
+      if (block->next != nullptr) block->next->prev = prev;
+      delete block;
+      block = prev;
+    }
+    InsertFree(block);
+    if (free_bytes_ > max_free_bytes_) {
+      TrimLocked(max_free_bytes_);
+    }
+  }
+
+  void InsertFree(Block* block) {
+    block->free = true;
+    block->free_it = free_blocks_.emplace(block->size, block);
+    free_bytes_ += block->size;
+  }
+
+  void EraseFree(Block* block) {
+    free_blocks_.erase(block->free_it);
+    free_bytes_ -= block->size;
+    block->free = false;
+  }
+
+  // Release whole free chunks, largest first, until at most max_free_bytes stay free.
+  void TrimLocked(size_t max_free_bytes) {
+    auto it = free_blocks_.end();
+    while (free_bytes_ > max_free_bytes && it != free_blocks_.begin()) {
+      --it;
+      Block* block = it->second;
+      if (block->prev != nullptr || block->next != nullptr) continue;
+      Chunk* chunk = block->chunk;
+      it = free_blocks_.erase(it);
+      free_bytes_ -= block->size;
+      reserved_bytes_.fetch_sub(chunk->buffer.size, std::memory_order_relaxed);
+      DLOG(INFO) << "release chunk of " << chunk->buffer.size << " B";
+      void* data = chunk->buffer.data;
+      DeviceAPI::Get(device_)->FreeDataSpace(device_, data);
+      chunks_.erase(data);
+    }
+  }
+
+  Device device_;
+  bool splittable_;
+  size_t max_free_bytes_;
+  size_t thread_cache_bytes_;
+  uint64_t id_;
+  std::mutex mu_;
+  std::atomic<size_t> reserved_bytes_{0};
+  std::atomic<size_t> thread_cached_bytes_{0};
+  size_t peak_reserved_bytes_{0};
+  size_t allocated_bytes_{0};
+  size_t free_bytes_{0};
+  std::unordered_map<void*, std::unique_ptr<Chunk>> chunks_;
+  std::unordered_map<void*, Block*> used_blocks_;
+  std::multimap<size_t, Block*> free_blocks_;
+};
+
+}  // namespace vm
+}  // namespace runtime
+}  // namespace tvm
+
+#endif  // TVM_RUNTIME_VM_BEST_FIT_ALLOCATOR_H_
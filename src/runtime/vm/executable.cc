@@ -82,6 +82,24 @@ PackedFunc Executable::GetFunction(const std::string& name, const ObjectPtr<Obje
       vm->LoadExecutable(this);
       *rv = Module(vm);
     });
+  } else if (name == "vm_load_shared") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      ICHECK_EQ(args.size() % 3, 0);
+      std::vector<Device> devices;
+      std::vector<AllocatorType> alloc_types;
+      for (int i = 0; i < args.size() / 3; ++i) {
+        Device dev;
+        int device_type = args[i * 3];
+        dev.device_type = DLDeviceType(device_type);
+        dev.device_id = args[i * 3 + 1];
+        int type = args[i * 3 + 2];
+        devices.push_back(dev);
+        alloc_types.push_back(AllocatorType(type));
+      }
+      auto loaded = make_object<LoadedExecutable>(this, Module(sptr_to_self));
+      loaded->Init(devices, alloc_types);
+      *rv = Module(loaded);
+    });
   } else {
     LOG(FATAL) << "Unknown packed function: " << name;
     return PackedFunc(nullptr);
@@ -248,7 +266,7 @@ void Executable::SaveGlobalSection(dmlc::Stream* strm) {
   strm->Write(glbs);
 }
 
-void Executable::SaveConstantSection(dmlc::Stream* strm) {
+void Executable::SaveConstantSection(dmlc::SeekStream* strm) {
   std::vector<DLTensor*> arrays;
   for (const auto& obj : this->constants) {
     const auto cell = Downcast<runtime::NDArray>(obj);
@@ -256,7 +274,7 @@ void Executable::SaveConstantSection(dmlc::Stream* strm) {
   }
   strm->Write(static_cast<uint64_t>(this->constants.size()));
   for (const auto& it : arrays) {
-    runtime::SaveDLTensor(strm, it);
+    runtime::SaveDLTensorAligned(strm, it);
   }
 
   // Save the const to device mapping.
@@ -535,6 +553,23 @@ runtime::Module Executable::Load(const std::string& code, const runtime::Module
   return runtime::Module(exec);
 }
 
+runtime::Module Executable::LoadFromFile(const std::string& file_name, const runtime::Module lib) {
+  auto exec = make_object<Executable>();
+  if (lib.defined()) {
+    exec->SetLib(lib);
+  }
+
+  std::shared_ptr<MappedFile> file = MappedFile::Open(file_name);
+  dmlc::MemoryFixedSizeStream strm(file->data(), file->size());
+  LoadHeader(&strm);
+  exec->LoadGlobalSection(&strm);
+  exec->LoadConstantSection(&strm, file);
+  exec->LoadPrimitiveOpNames(&strm);
+  exec->LoadCodeSection(&strm);
+
+  return runtime::Module(exec);
+}
+
 void Executable::LoadGlobalSection(dmlc::Stream* strm) {
   std::vector<std::string> globals;
   STREAM_CHECK(strm->Read(&globals), "global");
@@ -543,7 +578,8 @@ void Executable::LoadGlobalSection(dmlc::Stream* strm) {
   }
 }
 
-void Executable::LoadConstantSection(dmlc::Stream* strm) {
+void Executable::LoadConstantSection(dmlc::SeekStream* strm,
+                                     const std::shared_ptr<MappedFile>& file) {
   uint64_t sz;
   // Load the number of constants.
   STREAM_CHECK(strm->Read(&sz, sizeof(sz)), "constant");
@@ -551,9 +587,20 @@ void Executable::LoadConstantSection(dmlc::Stream* strm) {
   size_t size = static_cast<size_t>(sz);
   // Load each of the constants.
   for (size_t i = 0; i < size; i++) {
-    runtime::NDArray constant;
-    STREAM_CHECK(constant.Load(strm), "constant");
-    this->constants.push_back(constant);
+    // Executables saved before the constants were aligned hold plain NDArrays.
+    size_t start = strm->Tell();
+    uint64_t header;
+    STREAM_CHECK(strm->Read(&header), "constant");
+    strm->Seek(start);
+    if (header == kTVMNDArrayMagic) {
+      NDArray constant;
+      constant.Load(strm);
+      this->constants.push_back(constant);
+    } else if (file != nullptr) {
+      this->constants.push_back(runtime::LoadDLTensorAligned(strm, file));
+    } else {
+      this->constants.push_back(runtime::LoadDLTensorAligned(strm));
+    }
   }
 
   // Load the const to device mapping.
@@ -889,6 +936,11 @@ TVM_REGISTER_GLOBAL("runtime.Load_Executable")
       return Executable::Load(code, lib);
     });
 
+TVM_REGISTER_GLOBAL("runtime.Load_Executable_From_File")
+    .set_body_typed([](std::string file_name, runtime::Module lib) {
+      return Executable::LoadFromFile(file_name, lib);
+    });
+
 }  // namespace vm
 }  // namespace runtime
 }  // namespace tvm
@@ -21,11 +21,14 @@
  * \file tvm/runtime/vm/memory_manager.cc
  * \brief Allocate and manage memory for the runtime.
  */
+#include <tvm/runtime/registry.h>
 #include <tvm/runtime/vm/memory_manager.h>
 
 #include <memory>
+#include <sstream>
 #include <utility>
 
+#include "best_fit_allocator.h"
 #include "naive_allocator.h"
 #include "pooled_allocator.h"
 
@@ -38,6 +41,7 @@ static void BufferDeleter(Object* obj) {
   ICHECK(ptr->manager_ctx != nullptr);
   Buffer* buffer = reinterpret_cast<Buffer*>(ptr->manager_ctx);
   MemoryManager::GetAllocator(buffer->device)->Free(*(buffer));
+  profiling::MemoryTracker::Free(profiling::MemoryTracker::kTensor, buffer->device, buffer->size);
   delete buffer;
   delete ptr;
 }
@@ -76,12 +80,12 @@ inline size_t GetDataAlignment(const DLTensor& arr) {
   return align;
 }
 
-NDArray StorageObj::AllocNDArray(size_t offset, std::vector<int64_t> shape, DLDataType dtype) {
+NDArray StorageObj::AllocNDArray(size_t offset, ShapeTuple shape, DLDataType dtype) {
   VerifyDataType(dtype);
 
   // crtical zone: allocate header, cannot throw
   NDArray::Container* container =
-      new NDArray::Container(this->buffer.data, shape, dtype, this->buffer.device);
+      new NDArray::Container(this->buffer.data, std::move(shape), dtype, this->buffer.device);
   container->dl_tensor.byte_offset = offset;
 
   container->SetDeleter(StorageObj::Deleter);
@@ -130,6 +134,12 @@ Allocator* MemoryManager::GetOrCreateAllocator(Device dev, AllocatorType type) {
         alloc.reset(new PooledAllocator(dev));
         break;
       }
+      case kBestFit: {
+        DLOG(INFO) << "New best-fit allocator for " << DeviceName(dev.device_type) << "("
+                   << dev.device_id << ")";
+        alloc.reset(new BestFitAllocator(dev));
+        break;
+      }
       default:
         LOG(FATAL) << "Unknown allocator type: " << type;
     }
@@ -165,11 +175,41 @@ NDArray Allocator::Empty(std::vector<int64_t> shape, DLDataType dtype, DLDevice
   size_t alignment = GetDataAlignment(container->dl_tensor);
   Buffer* buffer = new Buffer;
   *buffer = this->Alloc(size, alignment, dtype);
+  profiling::MemoryTracker::Alloc(profiling::MemoryTracker::kTensor, buffer->device, buffer->size);
   container->manager_ctx = reinterpret_cast<void*>(buffer);
   container->dl_tensor.data = buffer->data;
   return NDArray(GetObjectPtr<Object>(container));
 }
 
+TVM_REGISTER_GLOBAL("vm.GetAllocatorStats").set_body_typed([](int device_type, int device_id) {
+  Device dev{static_cast<DLDeviceType>(device_type), device_id};
+  Allocator* alloc = MemoryManager::GetAllocator(dev);
+  std::ostringstream os;
+  os << "{\"type\": " << alloc->type() << ", \"used_memory\": " << alloc->UsedMemory();
+  if (alloc->type() == kBestFit) {
+    BestFitAllocator::Stats stats = static_cast<BestFitAllocator*>(alloc)->GetStats();
+    os << ", \"reserved_bytes\": " << stats.reserved_bytes
+       << ", \"peak_reserved_bytes\": " << stats.peak_reserved_bytes
+       << ", \"allocated_bytes\": " << stats.allocated_bytes
+       << ", \"thread_cached_bytes\": " << stats.thread_cached_bytes
+       << ", \"free_bytes\": " << stats.free_bytes
+       << ", \"largest_free_block\": " << stats.largest_free_block
+       << ", \"num_free_blocks\": " << stats.num_free_blocks
+       << ", \"num_chunks\": " << stats.num_chunks
+       << ", \"fragmentation\": " << stats.fragmentation;
+  }
+  os << "}";
+  return String(os.str());
+});
+
+TVM_REGISTER_GLOBAL("vm.TrimAllocator")
+    .set_body_typed([](int device_type, int device_id, int64_t max_free_bytes) {
+      Device dev{static_cast<DLDeviceType>(device_type), device_id};
+      Allocator* alloc = MemoryManager::GetAllocator(dev);
+      ICHECK_EQ(alloc->type(), kBestFit) << "Only the best-fit allocator can be trimmed";
+      static_cast<BestFitAllocator*>(alloc)->Trim(static_cast<size_t>(max_free_bytes));
+    });
+
 }  // namespace vm
 }  // namespace runtime
 }  // namespace tvm
@@ -43,7 +43,15 @@ namespace vm {
 PackedFunc VirtualMachineDebug::GetFunction(const std::string& name,
                                             const ObjectPtr<Object>& sptr_to_self) {
   if (name == "profile") {
-    return TypedPackedFunc<profiling::Report(String)>([sptr_to_self, this](String arg_name) {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      std::string arg_name = args[0];
+      std::vector<profiling::MetricCollector> collectors;
+      if (args.num_args > 1) {
+        Array<profiling::MetricCollector> arr = args[1];
+        for (profiling::MetricCollector collector : arr) {
+          collectors.push_back(collector);
+        }
+      }
       std::vector<Device> devices;
       for (auto dev : devices_) {
         if (dev.device_type > 0) {
@@ -57,11 +65,16 @@ PackedFunc VirtualMachineDebug::GetFunction(const std::string& name,
         invoke(arg_name);
       }
 
-      prof_ = profiling::Profiler();  // reset profiler
+      prof_ = profiling::Profiler(collectors);  // reset profiler
       prof_.Start(devices);
-      invoke(arg_name);
+      try {
+        invoke(arg_name);
+      } catch (...) {
+        prof_.Stop();
+        throw;
+      }
       prof_.Stop();
-      return prof_.Report();
+      *rv = prof_.Report();
     });
   } else {
     return VirtualMachine::GetFunction(name, sptr_to_self);
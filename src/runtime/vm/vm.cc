@@ -122,7 +122,7 @@ PackedFunc VirtualMachine::GetFunction(const std::string& name,
       auto git = exec_->global_map.find(func_name);
       ICHECK(git != exec_->global_map.end())
           << "Cannot find function " << func_name << " in the executable";
-      auto func = exec_->functions[git->second];
+      const auto& func = exec_->functions[git->second];
       if (func.params.empty()) {
         *rv = Invoke(func, {});
       } else {
@@ -159,6 +159,16 @@ PackedFunc VirtualMachine::GetFunction(const std::string& name,
         return 1;
       }
     });
+  } else if (name == "set_sampling_interval") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      this->SetSamplingInterval(args[0]);
+    });
+  } else if (name == "get_sampling_stats") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->GetSamplingStats(); });
+  } else if (name == "reset_sampling_stats") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { this->ResetSamplingStats(); });
   } else if (name == "init") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       ICHECK_EQ(args.size() % 3, 0);
@@ -227,22 +237,32 @@ inline Device VirtualMachine::GetDevice(Index device_type) const {
 }
 
 void VirtualMachine::PushFrame(Index arg_count, Index ret_pc, const VMFunction& vm_func) {
-  auto frame = VMFrame(ret_pc, func_index_, arg_count, code_, vm_func.register_file_size);
-  frames_.push_back(frame);
+  frames_.emplace_back(ret_pc, func_index_, arg_count, code_, 0);
+  // Reuse the register file of a popped frame to avoid allocating on every call.
+  auto& register_file = frames_.back().register_file;
+  if (!register_pool_.empty()) {
+    register_file.swap(register_pool_.back());
+    register_pool_.pop_back();
+  }
+  register_file.resize(vm_func.register_file_size);
 }
 
 Index VirtualMachine::PopFrame() {
   ICHECK_GT(frames_.size(), 0);
-  const VMFrame& fr = frames_.back();
+  VMFrame& fr = frames_.back();
   func_index_ = fr.func_index;
   code_ = fr.code;
+  decoded_ = code_ ? loaded_->decoded_functions[func_index_].data() : nullptr;
   pc_ = fr.pc;
   auto call_stack_size = frames_.size();
+  fr.register_file.clear();
+  register_pool_.push_back(std::move(fr.register_file));
   frames_.pop_back();
   return call_stack_size;
 }
 
-void VirtualMachine::InvokeGlobal(const VMFunction& func, const std::vector<ObjectRef>& args) {
+void VirtualMachine::InvokeGlobal(Index func_index, const std::vector<ObjectRef>& args) {
+  const VMFunction& func = exec_->functions[func_index];
   DLOG(INFO) << "Invoking global " << func.name << " " << args.size();
 
   PushFrame(func.params.size(), this->pc_ + 1, func);
@@ -251,14 +271,25 @@ void VirtualMachine::InvokeGlobal(const VMFunction& func, const std::vector<Obje
   }
   DLOG(INFO) << "func.params= " << func.params.size();
 
+  func_index_ = func_index;
   code_ = func.instructions.data();
+  decoded_ = loaded_->decoded_functions[func_index].data();
   pc_ = 0;
 }
 
 ObjectRef VirtualMachine::Invoke(const VMFunction& func, const std::vector<ObjectRef>& args) {
   DLOG(INFO) << "Executing Function: " << std::endl << func;
-
-  InvokeGlobal(func, args);
+  auto it = exec_->global_map.find(func.name);
+  ICHECK(it != exec_->global_map.end())
+      << "Cannot find function " << func.name << " in the executable";
+
+  InvokeGlobal(it->second, args);
+  // Stop sampling even when the run throws.
+  struct SampledRunGuard {
+    bool* sampled;
+    ~SampledRunGuard() { *sampled = false; }
+  } guard{&sampled_};
+  sampled_ = sampling_.SampleRun();
   RunLoop();
   return return_register_;
 }
@@ -272,6 +303,38 @@ ObjectRef VirtualMachine::Invoke(const std::string& name, const std::vector<Obje
   return Invoke(exec_->functions[func_index_], args);
 }
 
+void VirtualMachine::InvokePackedSampled(Index packed_index, const PackedFunc& func,
+                                         Index arg_count, Index output_size,
+                                         const std::vector<ObjectRef>& args) {
+  // The device of the first array argument is timed.
+  Device dev{kDLCPU, 0};
+  if (arg_count > 0) {
+    ObjectRef arg = args[0];
+    while (const auto* adt = arg.as<ADTObj>()) {
+      if (adt->size == 0) break;
+      arg = (*adt)[0];
+    }
+    if (const auto* array = arg.as<NDArray::ContainerType>()) {
+      dev = array->dl_tensor.device;
+    }
+  }
+  Timer timer = Timer::Start(dev);
+  InvokePacked(packed_index, func, arg_count, output_size, args);
+  timer->Stop();
+  sampling_.Record(static_cast<uint32_t>(packed_index), timer->SyncAndGetElapsedNanos());
+}
+
+std::string VirtualMachine::GetSamplingStats() {
+  std::vector<std::string> names;
+  if (exec_) {
+    names.resize(exec_->primitive_map.size());
+    for (const auto& kv : exec_->primitive_map) {
+      if (kv.second < static_cast<Index>(names.size())) names[kv.second] = kv.first;
+    }
+  }
+  return sampling_.GetStats(names);
+}
+
 void VirtualMachine::InvokePacked(Index packed_index, const PackedFunc& func, Index arg_count,
                                   Index output_size, const std::vector<ObjectRef>& args) {
   size_t arity = 0;
@@ -283,67 +346,151 @@ void VirtualMachine::InvokePacked(Index packed_index, const PackedFunc& func, In
     }
   }
 
-  std::vector<TVMValue> values(arity);
-  std::vector<int> codes(arity);
-  runtime::TVMArgsSetter setter(values.data(), codes.data());
+  // The scratch buffers only grow, so steady-state calls do not allocate.
+  if (packed_values_.size() < arity) {
+    packed_values_.resize(arity);
+    packed_codes_.resize(arity);
+  }
+  TVMValue* values = packed_values_.data();
+  int* codes = packed_codes_.data();
+  runtime::TVMArgsSetter setter(values, codes);
   int idx = 0;
   bool is_empty_output = false;
   for (Index i = 0; i < arg_count; i++) {
     if (const auto* dt_cell = args[i].as<ADTObj>()) {
       for (size_t fi = 0; fi < dt_cell->size; ++fi) {
-        auto obj = (*dt_cell)[fi];
-        auto nd_array = Downcast<NDArray>(obj);
-        setter(idx++, nd_array);
+        setter(idx++, (*dt_cell)[fi]);
       }
     } else {
-      auto nd_array = Downcast<NDArray>(args[i]);
+      // Pass the registers without copying the references, this runs for every kernel.
+      const ObjectRef& arg = args[i];
+      ICHECK(arg->IsInstance<NDArray::ContainerType>())
+          << "Expect a tensor argument, but received: " << arg->GetTypeKey();
       // We can safely skip CallPacked if there is only one
       // output and it is empty.
       if (i == arg_count - 1 && output_size == 1) {
-        for (const auto& dim : nd_array.Shape()) {
-          if (!dim) {
+        const DLTensor& tensor = static_cast<const NDArray::Container*>(arg.get())->dl_tensor;
+        for (int d = 0; d < tensor.ndim; ++d) {
+          if (!tensor.shape[d]) {
             is_empty_output = true;
             break;
           }
         }
       }
-      setter(idx++, nd_array);
+      setter(idx++, arg);
     }
   }
 
   if (!is_empty_output) {
     TVMRetValue rv;
-    func.CallPacked(TVMArgs(values.data(), codes.data(), arity), &rv);
+    func.CallPacked(TVMArgs(values, codes, arity), &rv);
   }
 }
 
-void VirtualMachine::LoadExecutable(const Executable* exec) {
+LoadedExecutable::LoadedExecutable(const Executable* exec, Module exec_module)
+    : exec(exec), exec_module(exec_module) {
   ICHECK(exec) << "The executable is not created yet.";
-  exec_ = exec;
-
-  runtime::Module lib = exec_->GetLib();
+  runtime::Module lib = exec->GetLib();
 
   ICHECK(exec->primitive_map.empty() || lib.operator->())
       << "If the executable has declared primitive functions, the"
       << "generated kernel library must non-be null.";
 
-  for (const auto& it : exec_->primitive_map) {
+  for (const auto& it : exec->primitive_map) {
     const auto& packed_name = it.first;
     auto packed_index = static_cast<size_t>(it.second);
-    if (packed_funcs_.size() <= packed_index) {
-      packed_funcs_.resize(packed_index + 1);
+    if (packed_funcs.size() <= packed_index) {
+      packed_funcs.resize(packed_index + 1);
     }
     tvm::runtime::PackedFunc pf = lib.GetFunction(packed_name, true);
     ICHECK(pf != nullptr) << "Cannot find function in module: " << packed_name;
-    packed_funcs_[packed_index] = pf;
+    packed_funcs[packed_index] = pf;
+  }
+  for (size_t i = 0; i < packed_funcs.size(); ++i) {
+    ICHECK(packed_funcs[i] != nullptr) << "Packed function " << i << " is not initialized";
   }
-  for (size_t i = 0; i < packed_funcs_.size(); ++i) {
-    ICHECK(packed_funcs_[i] != nullptr) << "Packed function " << i << " is not initialized";
+
+  decoded_functions.resize(exec->functions.size());
+  for (size_t fi = 0; fi < exec->functions.size(); ++fi) {
+    const auto& instructions = exec->functions[fi].instructions;
+    auto& decoded = decoded_functions[fi];
+    decoded.resize(instructions.size());
+    for (size_t pc = 0; pc < instructions.size(); ++pc) {
+      const Instruction& instr = instructions[pc];
+      // The dispatch table of RunLoop relies on the opcode being in range.
+      ICHECK_LE(static_cast<uint32_t>(instr.op), static_cast<uint32_t>(Opcode::DeviceCopy))
+          << "Unknown instruction opcode: " << static_cast<int>(instr.op);
+      if (instr.op == Opcode::AllocTensor) {
+        decoded[pc].shape =
+            ShapeTuple(instr.alloc_tensor.shape, instr.alloc_tensor.shape + instr.alloc_tensor.ndim);
+      } else if (instr.op == Opcode::LoadConsti) {
+        auto tensor = NDArray::Empty({1}, {kDLInt, 64, 1}, {kDLCPU, 0});
+        reinterpret_cast<int64_t*>(tensor->data)[0] = instr.load_consti.val;
+        decoded[pc].constant = tensor;
+      }
+    }
   }
+  constants.resize(exec->constants.size());
+}
+
+void LoadedExecutable::Init(const std::vector<Device>& devs,
+                            const std::vector<AllocatorType>& alloc_types) {
+  ICHECK(!initialized) << "The loaded executable has been initialized already.";
+  ICHECK_EQ(devs.size(), alloc_types.size());
+  for (size_t i = 0; i < devs.size(); i++) {
+    auto dev_type = static_cast<size_t>(devs[i].device_type);
+    if (devices.size() <= dev_type) {
+      devices.resize(dev_type + 1);
+      allocators.resize(dev_type + 1);
+    }
+    devices[dev_type] = devs[i];
+    allocators[dev_type] = MemoryManager::GetOrCreateAllocator(devs[i], alloc_types[i]);
+  }
+  for (size_t i = 0; i < exec->constants.size(); ++i) {
+    auto dev_type = static_cast<size_t>(exec->const_device_type[i]);
+    ICHECK(dev_type < devices.size() &&
+           static_cast<size_t>(devices[dev_type].device_type) == dev_type)
+        << "device type " << dev_type << " of constant " << i
+        << " has not been initialized in the device list.";
+    constants[i] = CopyTo(exec->constants[i], devices[dev_type]);
+  }
+  initialized = true;
+}
+
+PackedFunc LoadedExecutable::GetFunction(const std::string& name,
+                                         const ObjectPtr<Object>& sptr_to_self) {
+  if (name == "create_vm") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      auto vm = make_object<VirtualMachine>();
+      vm->LoadShared(GetObjectPtr<LoadedExecutable>(this));
+      *rv = Module(vm);
+    });
+  } else if (name == "get_executable") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->exec_module; });
+  } else {
+    return PackedFunc(nullptr);
+  }
+}
+
+void VirtualMachine::LoadExecutable(const Executable* exec) {
+  ICHECK(exec) << "The executable is not created yet.";
+  exec_ = exec;
+  loaded_ = make_object<LoadedExecutable>(exec, Module());
+}
+
+void VirtualMachine::LoadShared(ObjectPtr<LoadedExecutable> loaded) {
+  ICHECK(loaded->initialized) << "The loaded executable has not been initialized with devices.";
+  exec_ = loaded->exec;
+  devices_ = loaded->devices;
+  allocators_ = loaded->allocators;
+  loaded_ = std::move(loaded);
 }
 
 void VirtualMachine::Init(const std::vector<Device>& devs,
                           const std::vector<AllocatorType>& alloc_types) {
+  ICHECK(loaded_ == nullptr || !loaded_->initialized)
+      << "The devices of a VM sharing a loaded executable cannot be changed.";
   ICHECK_EQ(devs.size(), alloc_types.size());
   // Cache the device
   for (size_t i = 0; i < devs.size(); i++) {
@@ -362,14 +509,23 @@ inline void VirtualMachine::WriteRegister(Index r, const ObjectRef& val) {
   frames_.back().register_file[r] = val;
 }
 
-inline ObjectRef VirtualMachine::ReadRegister(Index r) const {
+inline const ObjectRef& VirtualMachine::ReadRegister(Index r) const {
   return frames_.back().register_file[r];
 }
 
 inline int64_t VirtualMachine::LoadScalarInt(Index r) const {
   int64_t result = 0;
   const auto& obj = ReadRegister(r);
-  NDArray array = Downcast<NDArray>(CopyTo(obj, {kDLCPU, 0}));
+  // Scalars are almost always on the CPU already, read them in place.
+  NDArray copy;
+  const DLTensor* array;
+  if (obj->IsInstance<NDArray::ContainerType>() &&
+      static_cast<const NDArray::Container*>(obj.get())->dl_tensor.device.device_type == kDLCPU) {
+    array = &static_cast<const NDArray::Container*>(obj.get())->dl_tensor;
+  } else {
+    copy = Downcast<NDArray>(CopyTo(obj, {kDLCPU, 0}));
+    array = copy.operator->();
+  }
 
   switch (array->dtype.bits) {
     case 1: {
@@ -398,265 +554,302 @@ inline int64_t VirtualMachine::LoadScalarInt(Index r) const {
   return result;
 }
 
+// Where the compiler supports labels as values, every handler ends with its
+// own indirect jump through a dispatch table instead of going back to a
+// shared switch, so that the branch predictor can learn opcode sequences.
+#ifndef TVM_VM_COMPUTED_GOTO
+#if defined(__GNUC__) || defined(__clang__)
+#define TVM_VM_COMPUTED_GOTO 1
+#else
+#define TVM_VM_COMPUTED_GOTO 0
+#endif
+#endif
+
+#if TVM_VM_COMPUTED_GOTO
+#define VM_SWITCH(op)
+#define VM_CASE(name) op_##name
+#define VM_DEFAULT op_Unknown
+#define VM_DISPATCH()                                          \
+  do {                                                         \
+    instr = &code_[pc_];                                       \
+    DLOG(INFO) << "Executing(" << pc_ << "): " << *instr;      \
+    goto* dispatch_table[static_cast<size_t>(instr->op)];      \
+  } while (0)
+#else
+#define VM_SWITCH(op) switch (op)
+#define VM_CASE(name) case Opcode::name
+#define VM_DEFAULT default
+#define VM_DISPATCH() goto main_loop
+#endif
+
 void VirtualMachine::RunLoop() {
   ICHECK(this->exec_);
   ICHECK(this->code_);
   pc_ = 0;
   Index frame_start = frames_.size();
-  while (true) {
-  main_loop:
-    auto const& instr = code_[this->pc_];
-    DLOG(INFO) << "Executing(" << pc_ << "): " << instr;
-
-    switch (instr.op) {
-      case Opcode::Move: {
-        ObjectRef from_obj;
-        from_obj = ReadRegister(instr.from);
-        WriteRegister(instr.dst, from_obj);
-        pc_++;
-        goto main_loop;
-      }
-      case Opcode::Fatal: {
-        throw std::runtime_error("VM encountered fatal error");
-      }
-      case Opcode::LoadConst: {
-        auto constant_obj = exec_->constants[instr.const_index];
-        // We cache the allocated object in the constant pool. To measure, the
-        // first iteration will set the pool up. The other iterations will
-        // directly reuse the allocated objects.
-        if (const_pool_.size() <= static_cast<size_t>(instr.const_index)) {
-          const_pool_.resize(instr.const_index + 1);
-        }
-
-        if (!const_pool_[instr.const_index].defined()) {
-          Device dev = GetDevice(exec_->const_device_type[instr.const_index]);
-          const_pool_[instr.const_index] = CopyTo(constant_obj, dev);
-        }
-        WriteRegister(instr.dst, const_pool_[instr.const_index]);
-        pc_++;
-        goto main_loop;
+  const Instruction* instr = nullptr;
+#if TVM_VM_COMPUTED_GOTO
+  // Indexed by Opcode, LoadedExecutable checks every opcode is in range.
+  static const void* dispatch_table[] = {
+      &&op_Move,         &&op_Ret,          &&op_Invoke,        &&op_InvokeClosure,
+      &&op_InvokePacked, &&op_AllocTensor,  &&op_AllocTensorReg, &&op_AllocADT,
+      &&op_AllocClosure, &&op_GetField,     &&op_If,            &&op_LoadConst,
+      &&op_Goto,         &&op_GetTag,       &&op_LoadConsti,    &&op_Fatal,
+      &&op_AllocStorage, &&op_ShapeOf,      &&op_ReshapeTensor, &&op_DeviceCopy,
+      &&op_Unknown};
+  static_assert(sizeof(dispatch_table) / sizeof(dispatch_table[0]) ==
+                    static_cast<size_t>(Opcode::DeviceCopy) + 2,
+                "the dispatch table must cover every opcode");
+#endif
+
+#if TVM_VM_COMPUTED_GOTO
+  VM_DISPATCH();
+#else
+main_loop:
+  instr = &code_[this->pc_];
+  DLOG(INFO) << "Executing(" << pc_ << "): " << *instr;
+#endif
+
+  VM_SWITCH(instr->op) {
+    VM_CASE(Move) : {
+      WriteRegister(instr->dst, ReadRegister(instr->from));
+      pc_++;
+      VM_DISPATCH();
+    }
+    VM_CASE(Fatal) : { throw std::runtime_error("VM encountered fatal error"); }
+    VM_CASE(LoadConst) : {
+      // We cache the allocated object in the constant pool. To measure, the
+      // first iteration will set the pool up. The other iterations will
+      // directly reuse the allocated objects. A shared loaded executable has
+      // all of its constants set up already, so it is never written here.
+      auto& constants = loaded_->constants;
+      if (!constants[instr->const_index].defined()) {
+        Device dev = GetDevice(exec_->const_device_type[instr->const_index]);
+        constants[instr->const_index] = CopyTo(exec_->constants[instr->const_index], dev);
       }
-      case Opcode::LoadConsti: {
-        auto tensor = NDArray::Empty({1}, {kDLInt, 64, 1}, {kDLCPU, 0});
-        reinterpret_cast<int64_t*>(tensor->data)[0] = instr.load_consti.val;
-        WriteRegister(instr.dst, tensor);
-        pc_++;
-        goto main_loop;
+      WriteRegister(instr->dst, constants[instr->const_index]);
+      pc_++;
+      VM_DISPATCH();
+    }
+    VM_CASE(LoadConsti) : {
+      WriteRegister(instr->dst, decoded_[pc_].constant);
+      pc_++;
+      VM_DISPATCH();
+    }
+    VM_CASE(Invoke) : {
+      call_args_.clear();
+      for (Index i = 0; i < instr->num_args; ++i) {
+        call_args_.push_back(ReadRegister(instr->invoke_args_registers[i]));
       }
-      case Opcode::Invoke: {
-        std::vector<ObjectRef> args;
-        for (Index i = 0; i < instr.num_args; ++i) {
-          args.push_back(ReadRegister(instr.invoke_args_registers[i]));
-        }
-        InvokeGlobal(exec_->functions[instr.func_index], args);
-        frames_.back().caller_return_register = instr.dst;
-        goto main_loop;
+      RegName dst = instr->dst;
+      InvokeGlobal(instr->func_index, call_args_);
+      call_args_.clear();
+      frames_.back().caller_return_register = dst;
+      VM_DISPATCH();
+    }
+    VM_CASE(InvokePacked) : {
+      DLOG(INFO) << "InvokedPacked " << instr->packed_index << " arity=" << instr->arity;
+      ICHECK_LE(instr->packed_index, loaded_->packed_funcs.size());
+      const auto& func = loaded_->packed_funcs[instr->packed_index];
+      const auto& arity = instr->arity;
+      call_args_.clear();
+      for (Index i = 0; i < arity; ++i) {
+        DLOG(INFO) << "arg" << i << " $" << instr->packed_args[i];
+        call_args_.push_back(ReadRegister(instr->packed_args[i]));
       }
-      case Opcode::InvokePacked: {
-        DLOG(INFO) << "InvokedPacked " << instr.packed_index << " arity=" << instr.arity;
-        ICHECK_LE(instr.packed_index, packed_funcs_.size());
-        const auto& func = packed_funcs_[instr.packed_index];
-        const auto& arity = instr.arity;
-        std::vector<ObjectRef> args;
-        for (Index i = 0; i < arity; ++i) {
-          DLOG(INFO) << "arg" << i << " $" << instr.packed_args[i];
-          auto arg = ReadRegister(instr.packed_args[i]);
-          args.push_back(arg);
-        }
 
-        // We no longer need to write the registers back, we write directly
-        // through the registers mutably.
-        InvokePacked(instr.packed_index, func, arity, instr.output_size, args);
-        pc_++;
-        goto main_loop;
-      }
-      case Opcode::InvokeClosure: {
-        auto object = ReadRegister(instr.closure);
-        const auto* closure = object.as<VMClosureObj>();
-        ICHECK(closure);
-        std::vector<ObjectRef> args;
-        for (auto free_var : closure->free_vars) {
-          args.push_back(free_var);
-        }
-        for (Index i = 0; i < instr.num_closure_args; ++i) {
-          args.push_back(ReadRegister(instr.closure_args[i]));
-        }
-        InvokeGlobal(exec_->functions[closure->func_index], args);
-        frames_.back().caller_return_register = instr.dst;
-        goto main_loop;
-      }
-      case Opcode::GetField: {
-        auto object = ReadRegister(instr.object);
-        const auto& tuple = Downcast<ADT>(object);
-        auto field = tuple[instr.field_index];
-        WriteRegister(instr.dst, field);
-        pc_++;
-        goto main_loop;
+      // We no longer need to write the registers back, we write directly
+      // through the registers mutably.
+      if (sampled_) {
+        InvokePackedSampled(instr->packed_index, func, arity, instr->output_size, call_args_);
+      } else {
+        InvokePacked(instr->packed_index, func, arity, instr->output_size, call_args_);
       }
-      case Opcode::GetTag: {
-        auto object = ReadRegister(instr.get_tag.object);
-        const auto& adt = Downcast<ADT>(object);
-        auto tag = adt.tag();
-        auto tag_tensor = NDArray::Empty({1}, {kDLInt, 32, 1}, {kDLCPU, 0});
-        reinterpret_cast<int32_t*>(tag_tensor->data)[0] = tag;
-        WriteRegister(instr.dst, tag_tensor);
-        pc_++;
-        goto main_loop;
+      call_args_.clear();
+      pc_++;
+      VM_DISPATCH();
+    }
+    VM_CASE(InvokeClosure) : {
+      const auto* closure = ReadRegister(instr->closure).as<VMClosureObj>();
+      ICHECK(closure);
+      call_args_.clear();
+      for (const auto& free_var : closure->free_vars) {
+        call_args_.push_back(free_var);
       }
-      case Opcode::Goto: {
-        pc_ += instr.pc_offset;
-        goto main_loop;
+      for (Index i = 0; i < instr->num_closure_args; ++i) {
+        call_args_.push_back(ReadRegister(instr->closure_args[i]));
       }
-      case Opcode::If: {
-        int32_t test_val = LoadScalarInt(instr.if_op.test);
-        int32_t target_val = LoadScalarInt(instr.if_op.target);
-
-        if (test_val == target_val) {
-          ICHECK_NE(instr.if_op.true_offset, 0);
-          pc_ += instr.if_op.true_offset;
-        } else {
-          ICHECK_NE(instr.if_op.false_offset, 0);
-          pc_ += instr.if_op.false_offset;
-        }
+      RegName dst = instr->dst;
+      InvokeGlobal(closure->func_index, call_args_);
+      call_args_.clear();
+      frames_.back().caller_return_register = dst;
+      VM_DISPATCH();
+    }
+    VM_CASE(GetField) : {
+      const auto& tuple = Downcast<ADT>(ReadRegister(instr->object));
+      WriteRegister(instr->dst, tuple[instr->field_index]);
+      pc_++;
+      VM_DISPATCH();
+    }
+    VM_CASE(GetTag) : {
+      const auto& adt = Downcast<ADT>(ReadRegister(instr->get_tag.object));
+      auto tag = adt.tag();
+      auto tag_tensor = NDArray::Empty({1}, {kDLInt, 32, 1}, {kDLCPU, 0});
+      reinterpret_cast<int32_t*>(tag_tensor->data)[0] = tag;
+      WriteRegister(instr->dst, tag_tensor);
+      pc_++;
+      VM_DISPATCH();
+    }
+    VM_CASE(Goto) : {
+      pc_ += instr->pc_offset;
+      VM_DISPATCH();
+    }
+    VM_CASE(If) : {
+      int32_t test_val = LoadScalarInt(instr->if_op.test);
+      int32_t target_val = LoadScalarInt(instr->if_op.target);
 
-        goto main_loop;
+      if (test_val == target_val) {
+        ICHECK_NE(instr->if_op.true_offset, 0);
+        pc_ += instr->if_op.true_offset;
+      } else {
+        ICHECK_NE(instr->if_op.false_offset, 0);
+        pc_ += instr->if_op.false_offset;
       }
-      case Opcode::AllocTensor: {
-        auto shape = std::vector<int64_t>(instr.alloc_tensor.ndim);
 
-        for (uint32_t i = 0; i < instr.alloc_tensor.ndim; ++i) {
-          shape[i] = instr.alloc_tensor.shape[i];
-        }
-
-        auto storage_obj = ReadRegister(instr.alloc_tensor.storage);
-        auto offset = LoadScalarInt(instr.alloc_tensor.offset);
-        auto storage = Downcast<Storage>(storage_obj);
-        auto obj = storage->AllocNDArray(offset, shape, instr.alloc_tensor.dtype);
-
-        WriteRegister(instr.dst, obj);
-        pc_++;
-        goto main_loop;
-      }
-      case Opcode::AllocTensorReg: {
-        Device cpu_dev = GetDevice(static_cast<Index>(kDLCPU));
-        auto shape_obj = ReadRegister(instr.alloc_tensor_reg.shape_register);
-        NDArray shape_tensor = Downcast<NDArray>(CopyTo(shape_obj, cpu_dev));
-        auto shape = ToShape(shape_tensor);
-        auto storage_obj = ReadRegister(instr.alloc_tensor_reg.storage);
-        auto storage = Downcast<Storage>(storage_obj);
-        auto offset = LoadScalarInt(instr.alloc_tensor.offset);
-        auto obj = storage->AllocNDArray(offset, shape, instr.alloc_tensor_reg.dtype);
-
-        WriteRegister(instr.dst, obj);
-        pc_++;
-        goto main_loop;
-      }
-      case Opcode::AllocADT: {
-        std::vector<ObjectRef> fields;
-        for (Index i = 0; i < instr.num_fields; ++i) {
-          fields.push_back(ReadRegister(instr.datatype_fields[i]));
-        }
-        ObjectRef obj = ADT(instr.constructor_tag, fields);
-        WriteRegister(instr.dst, obj);
-        pc_++;
-        goto main_loop;
-      }
-      case Opcode::AllocClosure: {
-        std::vector<ObjectRef> free_vars;
-        for (Index i = 0; i < instr.num_freevar; i++) {
-          free_vars.push_back(ReadRegister(instr.free_vars[i]));
-        }
-        WriteRegister(instr.dst, VMClosure(instr.func_index, free_vars));
-        pc_++;
-        goto main_loop;
-      }
-      case Opcode::AllocStorage: {
-        auto size = LoadScalarInt(instr.alloc_storage.allocation_size);
-        auto alignment = instr.alloc_storage.alignment;
-
-        DLOG(INFO) << "AllocStorage: allocation_size=" << size << ", alignment=" << alignment
-                   << ", dtype_hint=" << DLDataType2String(instr.alloc_storage.dtype_hint)
-                   << ", device_type=" << instr.alloc_storage.device_type;
-
-        auto storage_obj = SimpleObjAllocator().make_object<StorageObj>();
-        auto dev_type = instr.alloc_storage.device_type;
-        ICHECK_LT(static_cast<size_t>(dev_type), allocators_.size())
-            << "Memory allocator for device " << dev_type << " has not been initialized";
-        auto* alloc = allocators_[dev_type];
-        ICHECK(alloc) << "Did you forget to init the VirtualMachine with devices?";
-        storage_obj->buffer = alloc->Alloc(size, alignment, instr.alloc_storage.dtype_hint);
-        Storage storage(storage_obj);
-        WriteRegister(instr.dst, storage);
-        pc_++;
-        goto main_loop;
-      }
-      case Opcode::ShapeOf: {
-        auto input = ReadRegister(instr.shape_of.tensor);
-        NDArray input_array = Downcast<NDArray>(input);
-        int ndim = input_array->ndim;
-        auto out_tensor = NDArray::Empty({ndim}, {kDLInt, 64, 1}, {kDLCPU, 0});
-        for (int i = 0; i < ndim; ++i) {
-          reinterpret_cast<int64_t*>(out_tensor->data)[i] = input_array->shape[i];
-        }
-        WriteRegister(instr.dst, out_tensor);
-        pc_++;
-        goto main_loop;
+      VM_DISPATCH();
+    }
+    VM_CASE(AllocTensor) : {
+      auto offset = LoadScalarInt(instr->alloc_tensor.offset);
+      auto storage = Downcast<Storage>(ReadRegister(instr->alloc_tensor.storage));
+      auto obj = storage->AllocNDArray(offset, decoded_[pc_].shape, instr->alloc_tensor.dtype);
+
+      WriteRegister(instr->dst, obj);
+      pc_++;
+      VM_DISPATCH();
+    }
+    VM_CASE(AllocTensorReg) : {
+      Device cpu_dev = GetDevice(static_cast<Index>(kDLCPU));
+      auto shape_obj = ReadRegister(instr->alloc_tensor_reg.shape_register);
+      NDArray shape_tensor = Downcast<NDArray>(CopyTo(shape_obj, cpu_dev));
+      auto shape = ToShape(shape_tensor);
+      auto storage = Downcast<Storage>(ReadRegister(instr->alloc_tensor_reg.storage));
+      auto offset = LoadScalarInt(instr->alloc_tensor.offset);
+      auto obj = storage->AllocNDArray(offset, shape, instr->alloc_tensor_reg.dtype);
+
+      WriteRegister(instr->dst, obj);
+      pc_++;
+      VM_DISPATCH();
+    }
+    VM_CASE(AllocADT) : {
+      call_args_.clear();
+      for (Index i = 0; i < instr->num_fields; ++i) {
+        call_args_.push_back(ReadRegister(instr->datatype_fields[i]));
       }
-      case Opcode::Ret: {
-        // If we have hit the point from which we started
-        // running, we should return to the caller breaking
-        // the dispatch loop.
-        return_register_ = ReadRegister(instr.result);
-        auto caller_return_register = frames_.back().caller_return_register;
-
-        if (PopFrame() == frame_start) {
-          return;
-          // Otherwise we are just returning from a local call.
-        } else {
-          WriteRegister(caller_return_register, return_register_);
-          goto main_loop;
-        }
+      ObjectRef obj = ADT(instr->constructor_tag, call_args_.begin(), call_args_.end());
+      call_args_.clear();
+      WriteRegister(instr->dst, obj);
+      pc_++;
+      VM_DISPATCH();
+    }
+    VM_CASE(AllocClosure) : {
+      std::vector<ObjectRef> free_vars;
+      for (Index i = 0; i < instr->num_freevar; i++) {
+        free_vars.push_back(ReadRegister(instr->free_vars[i]));
       }
-      case Opcode::ReshapeTensor: {
-        Device cpu_dev = GetDevice(static_cast<Index>(kDLCPU));
-        auto tensor_obj = ReadRegister(instr.reshape_tensor.tensor);
-        NDArray tensor_arr = Downcast<NDArray>(tensor_obj);
-        // Read the shape from shape tensor
-        auto shape_obj = ReadRegister(instr.reshape_tensor.newshape);
-        NDArray shape_tensor = Downcast<NDArray>(CopyTo(shape_obj, cpu_dev));
-        const DLTensor* dl_tensor = shape_tensor.operator->();
-        ICHECK_EQ(dl_tensor->dtype.code, 0u);
-        ICHECK_EQ(dl_tensor->dtype.bits, 64);
-        int64_t* dims = reinterpret_cast<int64_t*>(dl_tensor->data);
-        int64_t ndim = shape_tensor->shape[0];
-        std::vector<int64_t> shape(dims, dims + ndim);
-        // Reshape the input tensor
-        auto out_tensor = tensor_arr.CreateView(shape, tensor_arr->dtype);
-        WriteRegister(instr.dst, out_tensor);
-        pc_++;
-        goto main_loop;
+      WriteRegister(instr->dst, VMClosure(instr->func_index, free_vars));
+      pc_++;
+      VM_DISPATCH();
+    }
+    VM_CASE(AllocStorage) : {
+      auto size = LoadScalarInt(instr->alloc_storage.allocation_size);
+      auto alignment = instr->alloc_storage.alignment;
+
+      DLOG(INFO) << "AllocStorage: allocation_size=" << size << ", alignment=" << alignment
+                 << ", dtype_hint=" << DLDataType2String(instr->alloc_storage.dtype_hint)
+                 << ", device_type=" << instr->alloc_storage.device_type;
+
+      auto storage_obj = SimpleObjAllocator().make_object<StorageObj>();
+      auto dev_type = instr->alloc_storage.device_type;
+      ICHECK_LT(static_cast<size_t>(dev_type), allocators_.size())
+          << "Memory allocator for device " << dev_type << " has not been initialized";
+      auto* alloc = allocators_[dev_type];
+      ICHECK(alloc) << "Did you forget to init the VirtualMachine with devices?";
+      storage_obj->buffer = alloc->Alloc(size, alignment, instr->alloc_storage.dtype_hint);
+      profiling::MemoryTracker::Alloc(profiling::MemoryTracker::kTensor,
+                                      storage_obj->buffer.device, storage_obj->buffer.size);
+      Storage storage(storage_obj);
+      WriteRegister(instr->dst, storage);
+      pc_++;
+      VM_DISPATCH();
+    }
+    VM_CASE(ShapeOf) : {
+      const auto& input_array = Downcast<NDArray>(ReadRegister(instr->shape_of.tensor));
+      int ndim = input_array->ndim;
+      auto out_tensor = NDArray::Empty({ndim}, {kDLInt, 64, 1}, {kDLCPU, 0});
+      for (int i = 0; i < ndim; ++i) {
+        reinterpret_cast<int64_t*>(out_tensor->data)[i] = input_array->shape[i];
       }
-      case Opcode::DeviceCopy: {
-        auto tensor_src = ReadRegister(instr.src);
-        NDArray src_data = Downcast<NDArray>(tensor_src);
-        Device src_dev = src_data->device;
-        ICHECK_EQ(static_cast<Index>(src_dev.device_type), instr.src_device_type);
-
-        Device dst_dev;
-        dst_dev.device_type = static_cast<DLDeviceType>(instr.dst_device_type);
-        dst_dev.device_id = 0;
-
-        NDArray dst_data = src_data.CopyTo(dst_dev);
-        WriteRegister(instr.dst, dst_data);
-        pc_++;
-        goto main_loop;
+      WriteRegister(instr->dst, out_tensor);
+      pc_++;
+      VM_DISPATCH();
+    }
+    VM_CASE(Ret) : {
+      // If we have hit the point from which we started
+      // running, we should return to the caller breaking
+      // the dispatch loop.
+      return_register_ = ReadRegister(instr->result);
+      auto caller_return_register = frames_.back().caller_return_register;
+
+      if (PopFrame() == frame_start) {
+        return;
+        // Otherwise we are just returning from a local call.
+      } else {
+        WriteRegister(caller_return_register, return_register_);
+        VM_DISPATCH();
       }
-      default:
-        LOG(FATAL) << "Unknown instruction opcode: " << int(instr.op);
     }
+    VM_CASE(ReshapeTensor) : {
+      Device cpu_dev = GetDevice(static_cast<Index>(kDLCPU));
+      NDArray tensor_arr = Downcast<NDArray>(ReadRegister(instr->reshape_tensor.tensor));
+      // Read the shape from shape tensor
+      auto shape_obj = ReadRegister(instr->reshape_tensor.newshape);
+      NDArray shape_tensor = Downcast<NDArray>(CopyTo(shape_obj, cpu_dev));
+      const DLTensor* dl_tensor = shape_tensor.operator->();
+      ICHECK_EQ(dl_tensor->dtype.code, 0u);
+      ICHECK_EQ(dl_tensor->dtype.bits, 64);
+      int64_t* dims = reinterpret_cast<int64_t*>(dl_tensor->data);
+      int64_t ndim = shape_tensor->shape[0];
+      std::vector<int64_t> shape(dims, dims + ndim);
+      // Reshape the input tensor
+      auto out_tensor = tensor_arr.CreateView(shape, tensor_arr->dtype);
+      WriteRegister(instr->dst, out_tensor);
+      pc_++;
+      VM_DISPATCH();
+    }
+    VM_CASE(DeviceCopy) : {
+      NDArray src_data = Downcast<NDArray>(ReadRegister(instr->src));
+      Device src_dev = src_data->device;
+      ICHECK_EQ(static_cast<Index>(src_dev.device_type), instr->src_device_type);
+
+      Device dst_dev;
+      dst_dev.device_type = static_cast<DLDeviceType>(instr->dst_device_type);
+      dst_dev.device_id = 0;
+
+      NDArray dst_data = src_data.CopyTo(dst_dev);
+      WriteRegister(instr->dst, dst_data);
+      pc_++;
+      VM_DISPATCH();
+    }
+    VM_DEFAULT:
+      LOG(FATAL) << "Unknown instruction opcode: " << int(instr->op);
   }
 }
 
+#undef VM_SWITCH
+#undef VM_CASE
+#undef VM_DEFAULT
+#undef VM_DISPATCH
+
 runtime::Module CreateVirtualMachine(const Executable* exec) {
   auto vm = make_object<VirtualMachine>();
   vm->LoadExecutable(exec);
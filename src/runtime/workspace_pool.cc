@@ -23,6 +23,8 @@
  */
 #include "workspace_pool.h"
 
+#include <tvm/runtime/profiling.h>
+
 #include <memory>
 
 namespace tvm {
@@ -82,10 +84,11 @@ class WorkspacePool::Pool {
       }
     }
     allocated_.push_back(e);
+    profiling::MemoryTracker::Alloc(profiling::MemoryTracker::kWorkspace, dev, e.size);
     return e.data;
   }
-  // free resource back to pool
-  void Free(void* data) {
+  // free resource back to pool, returns the size of the entry
+  size_t Free(void* data) {
     Entry e;
     if (allocated_.back().data == data) {
       // quick path, last allocated.
@@ -112,6 +115,7 @@ class WorkspacePool::Pool {
       }
       free_list_[i + 1] = e;
     }
+    return e.size;
   }
   // Release all resources
   void Release(Device dev, DeviceAPI* device) {
@@ -160,7 +164,8 @@ void* WorkspacePool::AllocWorkspace(Device dev, size_t size) {
 
 void WorkspacePool::FreeWorkspace(Device dev, void* ptr) {
   ICHECK(static_cast<size_t>(dev.device_id) < array_.size() && array_[dev.device_id] != nullptr);
-  array_[dev.device_id]->Free(ptr);
+  size_t size = array_[dev.device_id]->Free(ptr);
+  profiling::MemoryTracker::Free(profiling::MemoryTracker::kWorkspace, dev, size);
 }
 
 }  // namespace runtime
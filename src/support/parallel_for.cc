@@ -24,7 +24,11 @@
 #include <tvm/runtime/logging.h>
 #include <tvm/support/parallel_for.h>
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <future>
+#include <mutex>
 #include <thread>
 #include <utility>
 #include <vector>
@@ -32,6 +36,11 @@
 namespace tvm {
 namespace support {
 
+namespace {
+/*! \brief Whether the current thread is a worker of parallel_for or parallel_for_dynamic. */
+thread_local bool in_parallel_worker = false;
+}  // namespace
+
 std::vector<std::vector<int>> rr_partitioner(int begin, int end, int step, int num_threads) {
   int total_task_count = (end - begin) / step;
   ICHECK_GE(total_task_count, 0) << "Infinite loop condition with begin: " << begin
@@ -68,6 +77,7 @@ void parallel_for(int begin, int end, const std::function<void(int)>& f, int ste
   for (const auto& run_partition : run_partitions) {
     std::packaged_task<void(const std::vector<int>&, const std::function<void(int)>&)> task(
         [](const std::vector<int>& run_pattition, const std::function<void(int)>& f) {
+          in_parallel_worker = true;
           for (const auto& i : run_pattition) {
             f(i);
           }
@@ -93,5 +103,45 @@ void parallel_for(int begin, int end, const std::function<void(int)>& f, int ste
   }
 }
 
+void parallel_for_dynamic(int begin, int end, int num_threads,
+                          const std::function<void(int thread_id, int index)>& f) {
+  num_threads = std::min(num_threads, end - begin);
+  if (num_threads <= 1 || in_parallel_worker) {
+    for (int i = begin; i < end; ++i) {
+      f(0, i);
+    }
+    return;
+  }
+  std::atomic<int> next{begin};
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto worker = [&](int thread_id) {
+    bool was_worker = in_parallel_worker;
+    in_parallel_worker = true;
+    for (int i = next++; i < end; i = next++) {
+      try {
+        f(thread_id, i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error) error = std::current_exception();
+        next = end;
+      }
+    }
+    in_parallel_worker = was_worker;
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (int thread_id = 1; thread_id < num_threads; ++thread_id) {
+    threads.emplace_back(worker, thread_id);
+  }
+  worker(0);
+  for (auto&& thread : threads) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
 }  // namespace support
 }  // namespace tvm
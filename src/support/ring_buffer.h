@@ -38,6 +38,13 @@ class RingBuffer {
  public:
   /*! \brief Initial capacity of ring buffer. */
   static const int kInitCapacity = 4 << 10;
+  /*!
+   * \brief Capacity up to which the buffer never shrinks.
+   *
+   *  It fits the packets of chunked tensor copies, which would otherwise
+   *  reallocate the buffer for every chunk.
+   */
+  static const int kRetainCapacity = 2 << 20;
   /*! \brief constructor */
   RingBuffer() : ring_(kInitCapacity) {}
   /*! \return number of bytes available in buffer. */
@@ -63,7 +70,7 @@ class RingBuffer {
         size_t ncopy = head_ptr_ + bytes_available_ - old_size;
         memcpy(&ring_[0] + old_size, &ring_[0], ncopy);
       }
-    } else if (ring_.size() > n * 8 && ring_.size() > kInitCapacity) {
+    } else if (ring_.size() > n * 8 && ring_.size() > kRetainCapacity) {
       // shrink too large temporary buffer to
       // avoid out of memory on some embedded devices
       if (bytes_available_ != 0) {
@@ -121,6 +128,8 @@ class RingBuffer {
       bytes_available_ -= nsend2;
       nsend += nsend2;
     }
+    // Channels may send less than asked, the rest stays at the head.
+    head_ptr_ = (head_ptr_ + nsend) % ring_.size();
     return nsend;
   }
   /*!
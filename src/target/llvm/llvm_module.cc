@@ -24,11 +24,15 @@
 #ifdef TVM_LLVM_VERSION
 
 #include <tvm/ir/module.h>
+#include <tvm/ir/transform.h>
 #include <tvm/runtime/packed_func.h>
 #include <tvm/runtime/registry.h>
+#include <tvm/support/parallel_for.h>
 #include <tvm/target/codegen.h>
 
+#include <algorithm>
 #include <mutex>
+#include <thread>
 
 #include "../../runtime/file_utils.h"
 #include "../../runtime/library_module.h"
@@ -45,6 +49,11 @@ using runtime::PackedFunc;
 using runtime::TVMArgs;
 using runtime::TVMRetValue;
 
+/*! \brief The maximum number of modules the codegen of a module is split into. */
+constexpr int kMaxCodegenPartitions = 8;
+/*! \brief The minimum number of functions in every split of the codegen. */
+constexpr size_t kMinFuncsPerPartition = 8;
+
 class LLVMModuleNode final : public runtime::ModuleNode {
  public:
   ~LLVMModuleNode() {
@@ -235,30 +244,34 @@ class LLVMModuleNode final : public runtime::ModuleNode {
       funcs.push_back(f);
     }
     ICHECK(funcs.size() > 0 || (could_have_linked_params && found_linked_params));
-    // TODO(tqchen): remove the entry function behavior as it does not
-    // makes sense when we start to use multiple modules.
-    cg->Init("TVMMod", tm_.get(), ctx_.get(), system_lib, system_lib, target_c_runtime);
+    // The startup function of the system library, the entry function and the linked
+    // parameters are emitted once per module, so these modules are not split.
+    int num_partitions =
+        std::min(kMaxCodegenPartitions, static_cast<int>(funcs.size() / kMinFuncsPerPartition));
+    if (num_partitions > 1 && !system_lib && !target_c_runtime && entry_func.length() == 0 &&
+        !found_linked_params) {
+      module_ = BuildPartitioned(funcs, target, num_partitions);
+    } else {
+      // TODO(tqchen): remove the entry function behavior as it does not
+      // makes sense when we start to use multiple modules.
+      cg->Init("TVMMod", tm_.get(), ctx_.get(), system_lib, system_lib, target_c_runtime);
 
-    for (const auto& f : funcs) {
-      cg->AddFunction(f);
-    }
+      for (const auto& f : funcs) {
+        cg->AddFunction(f);
+      }
 
-    if (entry_func.length() != 0) {
-      cg->AddMainFunction(entry_func);
-    }
+      if (entry_func.length() != 0) {
+        cg->AddMainFunction(entry_func);
+      }
 
-    if (found_linked_params) {
-      cg->LinkParameters(linked_params);
+      if (found_linked_params) {
+        cg->LinkParameters(linked_params);
+      }
+      module_ = cg->Finish();
     }
-    module_ = cg->Finish();
     module_->addModuleFlag(llvm::Module::Warning, "tvm_target",
                            llvm::MDString::get(*ctx_, LLVMTargetToString(target)));
-    module_->addModuleFlag(llvm::Module::Override, "Debug Info Version",
-                           llvm::DEBUG_METADATA_VERSION);
-
-    if (tm_->getTargetTriple().isOSDarwin()) {
-      module_->addModuleFlag(llvm::Module::Override, "Dwarf Version", 2);
-    }
+    AddDebugInfoFlags(module_.get(), tm_.get());
 
     std::string verify_errors_storage;
     llvm::raw_string_ostream verify_errors(verify_errors_storage);
@@ -309,6 +322,79 @@ class LLVMModuleNode final : public runtime::ModuleNode {
   }
 
  private:
+  /*! \brief Add the module flags describing the debug info, unless they are set already. */
+  static void AddDebugInfoFlags(llvm::Module* module, llvm::TargetMachine* tm) {
+    if (module->getModuleFlag("Debug Info Version") == nullptr) {
+      module->addModuleFlag(llvm::Module::Override, "Debug Info Version",
+                            llvm::DEBUG_METADATA_VERSION);
+    }
+    if (tm->getTargetTriple().isOSDarwin() && module->getModuleFlag("Dwarf Version") == nullptr) {
+      module->addModuleFlag(llvm::Module::Override, "Dwarf Version", 2);
+    }
+  }
+
+  /*!
+   * \brief Generate and optimize contiguous slices of funcs concurrently, each in its own
+   *  context, then link them in order into one module of ctx_.
+   *
+   *  The slices only depend on the number of functions, so the module is the same for any
+   *  number of threads. The globals shared by the slices, such as the module context, have
+   *  linkonce linkage and are merged by the linker.
+   */
+  std::unique_ptr<llvm::Module> BuildPartitioned(const std::vector<PrimFunc>& funcs,
+                                                 const Target& target, int num_partitions) {
+    std::unique_ptr<llvm::Module> module;
+    std::vector<std::string> bitcodes(num_partitions);
+    int num_threads = transform::PassContext::Current()
+                          ->GetConfig<Integer>("relay.backend.lower_num_threads", Integer(0))
+                          .value()
+                          ->value;
+    if (num_threads <= 0) {
+      num_threads = std::thread::hardware_concurrency();
+    }
+    support::parallel_for_dynamic(0, num_partitions, num_threads, [&](int thread_id, int part) {
+      std::shared_ptr<llvm::LLVMContext> ctx =
+          part == 0 ? ctx_ : std::make_shared<llvm::LLVMContext>();
+      std::unique_ptr<llvm::TargetMachine> tm = part == 0 ? nullptr : GetLLVMTargetMachine(target);
+      llvm::TargetMachine* part_tm = part == 0 ? tm_.get() : tm.get();
+      std::unique_ptr<CodeGenLLVM> cg = CodeGenLLVM::Create(part_tm);
+      cg->Init("TVMMod", part_tm, ctx.get(), false, false, false);
+      size_t begin = funcs.size() * part / num_partitions;
+      size_t end = funcs.size() * (part + 1) / num_partitions;
+      for (size_t i = begin; i < end; ++i) {
+        cg->AddFunction(funcs[i]);
+      }
+      std::unique_ptr<llvm::Module> part_module = cg->Finish();
+      // Without the flags, parsing the bitcode strips the debug info of the slice.
+      AddDebugInfoFlags(part_module.get(), part_tm);
+      if (part == 0) {
+        module = std::move(part_module);
+        return;
+      }
+      // Modules of different contexts cannot be linked, the slice moves to ctx_ as bitcode.
+      llvm::raw_string_ostream os(bitcodes[part]);
+#if TVM_LLVM_VERSION <= 60
+      llvm::WriteBitcodeToFile(part_module.get(), os);
+#else
+      llvm::WriteBitcodeToFile(*part_module, os);
+#endif
+      os.flush();
+    });
+    for (int part = 1; part < num_partitions; ++part) {
+      std::unique_ptr<llvm::MemoryBuffer> buf =
+          llvm::MemoryBuffer::getMemBuffer(bitcodes[part], "TVMMod", false);
+      llvm::Expected<std::unique_ptr<llvm::Module>> part_module =
+          llvm::parseBitcodeFile(buf->getMemBufferRef(), *ctx_);
+      if (!part_module) {
+        LOG(FATAL) << "Fail to read the bitcode of a codegen partition: "
+                   << llvm::toString(part_module.takeError());
+      }
+      ICHECK(!llvm::Linker::linkModules(*module, std::move(part_module.get())))
+          << "Failed to link modules";
+    }
+    return module;
+  }
+
   void LazyInitJIT() {
     std::lock_guard<std::mutex> lock(mutex_);
     if (ee_) {
@@ -0,0 +1,96 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/arith/analyzer.h>
+#include <tvm/driver/driver_api.h>
+#include <tvm/ir/transform.h>
+#include <tvm/node/structural_equal.h>
+#include <tvm/runtime/profiling.h>
+#include <tvm/te/operation.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tvm {
+
+/*! \brief A matmul tiled on three levels, whose lowering simplifies many split indices. */
+static IRModule LowerTiledMatmul(int n, int tile) {
+  auto A = te::placeholder({n, n}, DataType::Float(32), "A");
+  auto B = te::placeholder({n, n}, DataType::Float(32), "B");
+  auto k = te::reduce_axis(Range(0, n), "k");
+  auto C = te::compute(
+      {n, n}, [&](tir::Var i, tir::Var j) { return te::sum(A(i, k) * B(k, j), {k}); }, "C");
+  te::Schedule s = te::create_schedule({C->op});
+  te::IterVar i = C->op.as<te::ComputeOpNode>()->axis[0];
+  te::IterVar j = C->op.as<te::ComputeOpNode>()->axis[1];
+  te::IterVar io, ii, jo, ji, iio, iii, jio, jii, ko, ki;
+  s[C].split(i, tile, &io, &ii);
+  s[C].split(j, tile, &jo, &ji);
+  s[C].split(ii, 4, &iio, &iii);
+  s[C].split(ji, 4, &jio, &jii);
+  s[C].split(k, tile, &ko, &ki);
+  s[C].reorder({io, jo, ko, iio, jio, ki, iii, jii});
+  std::unordered_map<te::Tensor, tir::Buffer> binds;
+  return LowerSchedule(s, {A, B, C}, "matmul", binds);
+}
+
+/*!
+ * \brief Lower a set of schedules with a given analyzer cache capacity.
+ * \return The elapsed nanoseconds.
+ */
+static int64_t LowerAll(int64_t cache_size, std::vector<IRModule>* lowered) {
+  transform::PassContext ctx = transform::PassContext::Create();
+  ctx->config.Set("tir.analyzer_cache_size", Integer(static_cast<int>(cache_size)));
+  With<transform::PassContext> scope(ctx);
+  lowered->clear();
+  runtime::Timer timer = runtime::Timer::Start({kDLCPU, 0});
+  for (int n : {67, 128, 250, 512, 1000}) {
+    for (int tile : {8, 16, 32}) {
+      lowered->push_back(LowerTiledMatmul(n, tile));
+    }
+  }
+  timer->Stop();
+  return timer->SyncAndGetElapsedNanos();
+}
+
+// Disabled by default, run with --gtest_also_run_disabled_tests to compare the
+// lowering times with and without the analyzer cache.
+TEST(AnalyzerCache, DISABLED_LoweringBenchmark) {
+  const int repeats = 5;
+  std::vector<IRModule> uncached, cached;
+  LowerAll(0, &uncached);
+  for (int64_t cache_size : {int64_t(0), int64_t(arith::AnalyzerCache::kDefaultCapacity)}) {
+    std::vector<IRModule>* lowered = cache_size == 0 ? &uncached : &cached;
+    int64_t best = -1;
+    for (int r = 0; r < repeats; ++r) {
+      int64_t ns = LowerAll(cache_size, lowered);
+      if (best < 0 || ns < best) best = ns;
+    }
+    LOG(INFO) << "Lowering " << lowered->size() << " schedules with an analyzer cache of "
+              << cache_size << " results: " << best / 1e6 << " ms";
+  }
+  ASSERT_EQ(cached.size(), uncached.size());
+  for (size_t i = 0; i < cached.size(); ++i) {
+    EXPECT_TRUE(StructuralEqual()(cached[i], uncached[i])) << "schedule " << i;
+  }
+}
+
+}  // namespace tvm
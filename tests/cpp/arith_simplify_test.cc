@@ -53,6 +53,57 @@ TEST(Simplify, Mod) {
   auto es = ana.canonical_simplify(mod - x);
   ICHECK(tvm::tir::is_zero(es));
 }
+
+TEST(AnalyzerCache, SharedAcrossAnalyzers) {
+  tvm::With<tvm::arith::AnalyzerCache> scope;
+  auto* cache = tvm::arith::AnalyzerCache::Current();
+  auto x = tvm::te::var("x");
+  auto e = tvm::floordiv(x * 4 + 8, 4) - x;
+  {
+    tvm::arith::Analyzer ana;
+    ICHECK(tvm::tir::is_const_int(ana.canonical_simplify(e), 2));
+  }
+  size_t misses = cache->misses();
+  {
+    // A structurally equal expression built again hits the results of the first analyzer.
+    tvm::arith::Analyzer ana;
+    ICHECK(tvm::tir::is_const_int(ana.canonical_simplify(tvm::floordiv(x * 4 + 8, 4) - x), 2));
+  }
+  ICHECK_EQ(cache->misses(), misses);
+  ICHECK_GT(cache->hits(), 0U);
+}
+
+TEST(AnalyzerCache, ContextAware) {
+  tvm::With<tvm::arith::AnalyzerCache> scope;
+  auto x = tvm::te::var("x");
+  tvm::PrimExpr e = x < 8;
+  tvm::arith::Analyzer ana;
+  ICHECK(!tvm::tir::is_const_int(ana.Simplify(e)));
+  {
+    tvm::With<tvm::arith::ConstraintContext> constraint(&ana, x < 4);
+    ICHECK(tvm::tir::is_one(ana.Simplify(e)));
+  }
+  ICHECK(!tvm::tir::is_const_int(ana.Simplify(e)));
+  ana.Bind(x, tvm::Range(0, 4));
+  ICHECK(tvm::tir::is_one(ana.Simplify(e)));
+  ICHECK_EQ(ana.const_int_bound(x + 1)->max_value, 4);
+
+  // A new analyzer does not know the binding.
+  tvm::arith::Analyzer other;
+  ICHECK(!tvm::tir::is_const_int(other.Simplify(e)));
+}
+
+TEST(AnalyzerCache, Bounded) {
+  tvm::With<tvm::arith::AnalyzerCache> scope(4);
+  auto* cache = tvm::arith::AnalyzerCache::Current();
+  auto x = tvm::te::var("x");
+  tvm::arith::Analyzer ana;
+  for (int i = 0; i < 16; ++i) {
+    ana.rewrite_simplify(x + i + 1);
+  }
+  ICHECK_EQ(cache->size(), 4U);
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   testing::FLAGS_gtest_death_test_style = "threadsafe";
@@ -0,0 +1,180 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/vm/vm.h>
+
+#include <string>
+#include <vector>
+
+#include "../../src/runtime/file_utils.h"
+#include "../../src/runtime/vm/serialize_utils.h"
+
+namespace tvm {
+namespace runtime {
+
+static const Device kCPU{kDLCPU, 0};
+
+static Map<String, NDArray> MakeParams() {
+  Map<String, NDArray> params;
+  // Odd sizes so that the data of the next array would be misaligned without padding.
+  NDArray w = NDArray::Empty({3, 7}, {kDLFloat, 32, 1}, kCPU);
+  NDArray b = NDArray::Empty({5}, {kDLInt, 8, 1}, kCPU);
+  NDArray s = NDArray::Empty({}, {kDLFloat, 64, 1}, kCPU);
+  for (int i = 0; i < 21; ++i) static_cast<float*>(w->data)[i] = i * 0.5f;
+  for (int i = 0; i < 5; ++i) static_cast<int8_t*>(b->data)[i] = -i;
+  static_cast<double*>(s->data)[0] = 42.0;
+  params.Set("w", w);
+  params.Set("b", b);
+  params.Set("s", s);
+  return params;
+}
+
+static void ExpectEqual(const Map<String, NDArray>& expected, const Map<String, NDArray>& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (const auto& it : expected) {
+    ASSERT_TRUE(actual.count(it.first));
+    NDArray value = actual[it.first];
+    ASSERT_EQ(value->ndim, it.second->ndim);
+    size_t size = GetDataSize(*it.second.operator->());
+    ASSERT_EQ(GetDataSize(*value.operator->()), size);
+    EXPECT_EQ(memcmp(value->data, it.second->data, size), 0) << it.first;
+  }
+}
+
+static std::string WriteFile(const std::string& name, const std::string& data) {
+  std::string file_name = testing::TempDir() + name;
+  SaveBinaryToFile(file_name, data);
+  return file_name;
+}
+
+TEST(MappedParams, AlignedBlob) {
+  Map<String, NDArray> params = MakeParams();
+  std::string blob = SaveParamsAligned(params);
+  ExpectEqual(params, LoadParams(blob));
+}
+
+TEST(MappedParams, LoadFromFileInPlace) {
+  Map<String, NDArray> params = MakeParams();
+  std::string file_name = WriteFile("mapped_params_aligned.params", SaveParamsAligned(params));
+  Map<String, NDArray> loaded = LoadParamsFromFile(file_name);
+  ExpectEqual(params, loaded);
+  for (const auto& it : loaded) {
+    EXPECT_EQ(reinterpret_cast<size_t>(it.second->data) % kAllocAlignment, 0);
+  }
+
+  // Writes are private to the process and never reach the file.
+  NDArray w = loaded["w"];
+  static_cast<float*>(w->data)[0] = -1.0f;
+  Map<String, NDArray> reloaded = LoadParamsFromFile(file_name);
+  EXPECT_EQ(static_cast<float*>(reloaded["w"]->data)[0], 0.0f);
+
+  // The arrays keep the mapping alive once the map is gone.
+  loaded = Map<String, NDArray>();
+  EXPECT_EQ(static_cast<float*>(w->data)[20], 10.0f);
+  RemoveFile(file_name);
+}
+
+TEST(MappedParams, LoadFromFileLegacy) {
+  Map<String, NDArray> params = MakeParams();
+  std::string file_name = WriteFile("mapped_params_legacy.params", SaveParams(params));
+  ExpectEqual(params, LoadParamsFromFile(file_name));
+  RemoveFile(file_name);
+}
+
+static const char* kConstantNames[] = {"w", "b", "s"};
+
+/*! \brief An executable whose main function returns its second constant. */
+static ObjectPtr<vm::Executable> MakeExecutable(const Map<String, NDArray>& params) {
+  auto exec = make_object<vm::Executable>();
+  for (const char* name : kConstantNames) {
+    exec->constants.push_back(params[name]);
+    exec->const_device_type.push_back(kDLCPU);
+  }
+  exec->functions.push_back(vm::VMFunction("main", {}, {vm::Instruction::LoadConst(1, 0),
+                                                        vm::Instruction::Ret(0)},
+                                           1, {}));
+  exec->global_map["main"] = 0;
+  return exec;
+}
+
+/*! \brief Load an executable from code and from a file holding it, check its constants. */
+static void ExpectConstants(const Map<String, NDArray>& params, const std::string& code,
+                            bool aligned) {
+  std::string file_name = WriteFile("mapped_exec.ro", code);
+  for (bool mapped : {false, true}) {
+    Module mod = mapped ? vm::Executable::LoadFromFile(file_name, Module())
+                        : vm::Executable::Load(code, Module());
+    auto* loaded = static_cast<vm::Executable*>(mod.operator->());
+    ASSERT_EQ(loaded->constants.size(), 3U);
+    EXPECT_EQ(loaded->functions[0].instructions.size(), 2U);
+    Map<String, NDArray> constants;
+    for (size_t i = 0; i < 3; ++i) {
+      constants.Set(kConstantNames[i], Downcast<NDArray>(loaded->constants[i]));
+    }
+    ExpectEqual(params, constants);
+    if (!aligned) continue;
+    for (const auto& it : constants) {
+      EXPECT_EQ(reinterpret_cast<size_t>(it.second->data) % kAllocAlignment, 0);
+    }
+  }
+  RemoveFile(file_name);
+}
+
+TEST(MappedParams, VMExecutableConstants) {
+  Map<String, NDArray> params = MakeParams();
+  TVMByteArray code = MakeExecutable(params)->Save();
+  ExpectConstants(params, std::string(code.data, code.size), true);
+}
+
+TEST(MappedParams, VMExecutableLegacyConstants) {
+  Map<String, NDArray> params = MakeParams();
+  ObjectPtr<vm::Executable> exec = MakeExecutable(params);
+  TVMByteArray code = exec->Save();
+  std::string aligned(code.data, code.size);
+
+  // The header and global section, which precede the constants.
+  std::string prefix;
+  dmlc::MemoryStringStream prefix_strm(&prefix);
+  prefix_strm.Write(vm::kTVMVMBytecodeMagic);
+  prefix_strm.Write(std::string(TVM_VERSION));
+  prefix_strm.Write(std::vector<std::string>{"main"});
+
+  // Rewrite the constant section the way executables saved it before alignment.
+  std::string aligned_prefix = prefix, legacy = prefix;
+  dmlc::MemoryStringStream aligned_strm(&aligned_prefix), legacy_strm(&legacy);
+  aligned_strm.Seek(prefix.size());
+  legacy_strm.Seek(prefix.size());
+  aligned_strm.Write(static_cast<uint64_t>(3));
+  legacy_strm.Write(static_cast<uint64_t>(3));
+  for (const char* name : kConstantNames) {
+    SaveDLTensorAligned(&aligned_strm, params[name].operator->());
+    params[name].Save(&legacy_strm);
+  }
+  aligned_strm.Write(exec->const_device_type);
+  legacy_strm.Write(exec->const_device_type);
+  ASSERT_EQ(aligned.compare(0, aligned_prefix.size(), aligned_prefix), 0);
+  legacy += aligned.substr(aligned_prefix.size());
+
+  ExpectConstants(params, legacy, false);
+}
+
+}  // namespace runtime
+}  // namespace tvm
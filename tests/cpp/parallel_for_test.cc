@@ -119,6 +119,57 @@ TEST(ParallelFor, Exception) {
   ICHECK(exception);
 }
 
+TEST(ParallelForDynamic, Basic) {
+  using tvm::support::parallel_for_dynamic;
+
+  std::vector<int> a(1000, 0);
+  std::vector<int> thread_ids(1000, -1);
+  parallel_for_dynamic(0, 1000, 4, [&](int thread_id, int i) {
+    a[i] = i * 2;
+    thread_ids[i] = thread_id;
+  });
+  for (int i = 0; i < 1000; i++) {
+    ICHECK_EQ(a[i], i * 2);
+    ICHECK(thread_ids[i] >= 0 && thread_ids[i] < 4);
+  }
+}
+
+TEST(ParallelForDynamic, Nested) {
+  using tvm::support::parallel_for;
+  using tvm::support::parallel_for_dynamic;
+
+  std::vector<std::vector<int>> a(20, std::vector<int>(20, 0));
+  parallel_for(0, 20, [&](int i) {
+    // Runs serially on the worker of the outer loop.
+    parallel_for_dynamic(0, 20, 4, [&](int thread_id, int j) {
+      ICHECK_EQ(thread_id, 0);
+      a[i][j] = i + j;
+    });
+  });
+  parallel_for_dynamic(0, 20, 4, [&](int thread_id, int i) {
+    parallel_for_dynamic(0, 20, 4, [&](int inner_thread_id, int j) { a[i][j] -= i + j; });
+  });
+  for (int i = 0; i < 20; i++) {
+    for (int j = 0; j < 20; j++) {
+      ICHECK_EQ(a[i][j], 0);
+    }
+  }
+}
+
+TEST(ParallelForDynamic, Exception) {
+  using tvm::support::parallel_for_dynamic;
+
+  bool exception = false;
+  try {
+    parallel_for_dynamic(0, 100, 4, [](int thread_id, int i) {
+      if (i == 42) LOG(FATAL) << "error";
+    });
+  } catch (const std::exception& e) {
+    exception = true;
+  }
+  ICHECK(exception);
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   testing::FLAGS_gtest_death_test_style = "threadsafe";
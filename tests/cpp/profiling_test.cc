@@ -18,10 +18,16 @@
  */
 
 #include <gtest/gtest.h>
+#include <tvm/runtime/c_backend_api.h>
+#include <tvm/runtime/ndarray.h>
 #include <tvm/runtime/profiling.h>
+#include <tvm/runtime/threading_backend.h>
 
+#include <algorithm>
 #include <chrono>
+#include <string>
 #include <thread>
+#include <vector>
 
 namespace tvm {
 namespace runtime {
@@ -37,6 +43,231 @@ TEST(DefaultTimer, Basic) {
   int64_t elapsed = t->SyncAndGetElapsedNanos();
   CHECK_GT(elapsed, 9 * 1e6);
 }
+
+namespace profiling {
+
+/*! \brief Counts the calls made on CPU. */
+class CallCountCollectorNode : public MetricCollectorNode {
+ public:
+  void Init(const std::vector<Device>& devs) final { num_devices = devs.size(); }
+  ObjectRef Start(Device dev) final {
+    if (dev.device_type != kDLCPU) return ObjectRef();
+    return ObjectRef(make_object<CountNode>(num_started++));
+  }
+  Map<String, ObjectRef> Stop(ObjectRef obj) final {
+    int64_t calls = num_started - obj.as<CountNode>()->value;
+    return {{"Nested Calls", ObjectRef(make_object<CountNode>(calls))}};
+  }
+
+  size_t num_devices{0};
+  int64_t num_started{0};
+};
+
+TEST(Profiler, MetricCollector) {
+  Device cpu{kDLCPU, 0};
+  auto collector = make_object<CallCountCollectorNode>();
+  Profiler prof({MetricCollector(collector)});
+  prof.Start({cpu});
+  EXPECT_EQ(collector->num_devices, 1U);
+  prof.StartCall("outer", cpu);
+  prof.StartCall("inner", cpu);
+  prof.StopCall();
+  prof.StopCall();
+  prof.Stop();
+
+  profiling::Report report = prof.Report();
+  ASSERT_EQ(report->calls.size(), 2U);
+  for (const auto& call : report->calls) {
+    int64_t expected = Downcast<String>(call["Name"]) == "outer" ? 2 : 1;
+    EXPECT_EQ(call["Nested Calls"].as<CountNode>()->value, expected);
+  }
+  // The whole run spans the global collection started first.
+  EXPECT_EQ(report->device_metrics["cpu0"]["Nested Calls"].as<CountNode>()->value, 3);
+  EXPECT_NE(std::string(report->AsTable()).find("Nested Calls"), std::string::npos);
+}
+
+TEST(Profiler, PerfEventMetricCollector) {
+  Device cpu{kDLCPU, 0};
+  Profiler prof({PerfEventMetricCollector({"task-clock", "page-faults"})});
+  try {
+    prof.Start({cpu});
+  } catch (const std::exception& e) {
+    GTEST_SKIP() << "perf events are not available: " << e.what();
+  }
+  prof.StartCall("touch", cpu);
+  // Above the largest mmap threshold of glibc, so that the pages are always fresh.
+  std::vector<char> buffer(64 << 20);
+  for (size_t i = 0; i < buffer.size(); i += 4096) buffer[i] = 1;
+  prof.StopCall();
+  prof.Stop();
+
+  profiling::Report report = prof.Report();
+  ASSERT_EQ(report->calls.size(), 1U);
+  EXPECT_GT(report->calls[0]["task-clock"].as<CountNode>()->value, 0);
+  EXPECT_GE(report->calls[0]["page-faults"].as<CountNode>()->value, 1000);
+}
+
+TEST(Profiler, ChromeTrace) {
+  Device cpu{kDLCPU, 0};
+  Profiler prof;
+  prof.Start({cpu});
+  prof.StartCall("my_op", cpu, {{"Argument Shapes", String("float32[4]")}});
+  auto task = [](int task_id, TVMParallelGroupEnv* penv, void* cdata) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return 0;
+  };
+  ASSERT_EQ(TVMBackendParallelLaunch(task, nullptr, 2), 0);
+  NDArray a = NDArray::Empty({4}, {kDLFloat, 32, 1}, cpu);
+  NDArray b = NDArray::Empty({4}, {kDLFloat, 32, 1}, cpu);
+  a.CopyTo(b);
+  prof.StopCall();
+  prof.Stop();
+
+  profiling::Report report = prof.Report();
+  std::vector<std::string> names;
+  for (const TraceEvent& event : report->trace_events) names.push_back(event.name);
+  auto count = [&names](const std::string& name) {
+    return std::count(names.begin(), names.end(), name);
+  };
+  EXPECT_EQ(count("my_op"), 1);
+  EXPECT_EQ(count("TVMBackendParallelLaunch"), 1);
+  EXPECT_EQ(count("DeviceCopy"), 1);
+  EXPECT_EQ(count("parallel task"), threading::MaxConcurrency() > 1 ? 2 : 0);
+
+  std::string trace = report->AsChromeTrace();
+  EXPECT_NE(trace.find("\"name\": \"my_op\", \"cat\": \"op\""), std::string::npos) << trace;
+  EXPECT_NE(trace.find("\"Argument Shapes\": \"float32[4]\""), std::string::npos) << trace;
+  EXPECT_NE(trace.find("\"bytes\": \"16\""), std::string::npos) << trace;
+
+  // Nothing is recorded once the profiler has stopped.
+  EXPECT_FALSE(TraceRecorder::Enabled());
+  ASSERT_EQ(TVMBackendParallelLaunch(task, nullptr, 2), 0);
+  int64_t now = TraceRecorder::Now();
+  EXPECT_TRUE(TraceRecorder::Global()->Collect(0, now).empty());
+}
+
+TEST(Profiler, IsRunning) {
+  Device cpu{kDLCPU, 0};
+  Profiler prof;
+  EXPECT_FALSE(prof.IsRunning());
+  prof.Start({cpu});
+  EXPECT_TRUE(prof.IsRunning());
+  EXPECT_TRUE(TraceRecorder::Enabled());
+  prof.Stop();
+  // The report stays available, but calls are no longer recorded.
+  EXPECT_FALSE(prof.IsRunning());
+  EXPECT_FALSE(TraceRecorder::Enabled());
+  EXPECT_ANY_THROW(prof.Stop());
+}
+
+TEST(Profiler, MemoryUsage) {
+  Device cpu{kDLCPU, 0};
+  auto bytes = [](const Map<String, ObjectRef>& metrics, const String& name) {
+    const auto* node = metrics[name].as<BytesNode>();
+    return node == nullptr ? int64_t(-1) : node->bytes;
+  };
+  int64_t live_before = MemoryTracker::Get(cpu).tensor_bytes;
+  Profiler prof;
+  prof.Start({cpu});
+  NDArray kept;
+  prof.StartCall("alloc", cpu);
+  {
+    void* workspace = TVMBackendAllocWorkspace(kDLCPU, 0, 1 << 20, kDLFloat, 32);
+    ASSERT_NE(workspace, nullptr);
+    NDArray temp = NDArray::Empty({1024}, {kDLFloat, 32, 1}, cpu);
+    kept = NDArray::Empty({256}, {kDLFloat, 32, 1}, cpu);
+    ASSERT_EQ(TVMBackendFreeWorkspace(kDLCPU, 0, workspace), 0);
+  }
+  prof.StopCall();
+  prof.StartCall("noop", cpu);
+  prof.StopCall();
+  prof.Stop();
+  kept = NDArray();
+
+  profiling::Report report = prof.Report(false);
+  ASSERT_EQ(report->calls.size(), 2U);
+  Map<String, ObjectRef> alloc = report->calls[0];
+  Map<String, ObjectRef> noop = report->calls[1];
+  // The pool rounds workspaces up to whole pages.
+  EXPECT_GE(bytes(alloc, "Workspace (B)"), 1 << 20);
+  EXPECT_EQ(bytes(alloc, "Live Tensors (B)"), live_before + 1024);
+  EXPECT_GE(bytes(alloc, "Peak Memory (B)"), live_before + 4096 + 1024 + (1 << 20));
+  EXPECT_EQ(bytes(noop, "Workspace (B)"), 0);
+  EXPECT_EQ(bytes(noop, "Peak Memory (B)"), live_before + 1024);
+
+  Map<String, ObjectRef> device = report->device_metrics["cpu0"];
+  EXPECT_EQ(bytes(device, "Peak Memory (B)"), bytes(alloc, "Peak Memory (B)"));
+  EXPECT_EQ(MemoryTracker::Get(cpu).tensor_bytes, live_before);
+  EXPECT_NE(std::string(report->AsTable()).find("Peak Memory (B)"), std::string::npos);
+}
+
+TEST(SamplingProfiler, Interval) {
+  SamplingProfiler sampling;
+  for (int i = 0; i < 10; ++i) EXPECT_FALSE(sampling.SampleRun());
+  sampling.SetInterval(4);
+  int sampled = 0;
+  for (int i = 0; i < 12; ++i) sampled += sampling.SampleRun();
+  EXPECT_EQ(sampled, 3);
+  EXPECT_NE(sampling.GetStats({}).find("\"sampled_runs\": 3,"), std::string::npos);
+  sampling.SetInterval(0);
+  EXPECT_FALSE(sampling.SampleRun());
+}
+
+TEST(SamplingProfiler, Histogram) {
+  SamplingProfiler sampling;
+  for (int i = 1; i <= 100; ++i) sampling.Record(1, i * 1000);
+  sampling.Record(0, 5);
+  std::string stats = sampling.GetStats({"a", "b"});
+  EXPECT_NE(stats.find("{\"name\": \"a\", \"index\": 0, \"count\": 1,"), std::string::npos)
+      << stats;
+  EXPECT_NE(stats.find("{\"name\": \"b\", \"index\": 1, \"count\": 100, \"mean_us\": 50.5, "
+                       "\"min_us\": 1, \"max_us\": 100,"),
+            std::string::npos)
+      << stats;
+  // 50us falls into the bucket [49.152, 53.248)us, 99us into [98.304, 106.496)us.
+  EXPECT_NE(stats.find("\"p50_us\": 51.2,"), std::string::npos) << stats;
+  EXPECT_NE(stats.find("\"p99_us\": 102.4,"), std::string::npos) << stats;
+  EXPECT_NE(stats.find("[0.005, 1]"), std::string::npos) << stats;
+
+  sampling.Reset();
+  EXPECT_NE(sampling.GetStats({}).find("\"ops\": []"), std::string::npos);
+}
+
+// The integer following key in the JSON statistics.
+int64_t StatsValue(const std::string& stats, const std::string& key) {
+  size_t pos = stats.find(key);
+  EXPECT_NE(pos, std::string::npos) << key << " missing in " << stats;
+  return pos == std::string::npos ? 0 : std::stoll(stats.substr(pos + key.size()));
+}
+
+TEST(SamplingProfiler, DrainsWhenFull) {
+  SamplingProfiler sampling(64);
+  for (int i = 0; i < 1000; ++i) sampling.Record(7, 1000);
+  std::string stats = sampling.GetStats({});
+  EXPECT_EQ(StatsValue(stats, "\"dropped\": "), 0);
+  EXPECT_EQ(StatsValue(stats, "\"index\": 7, \"count\": "), 1000);
+}
+
+TEST(SamplingProfiler, ConcurrentRecordWhenFull) {
+  SamplingProfiler sampling(64);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&sampling, t]() {
+      for (int i = 0; i < 100; ++i) sampling.Record(t, 1000);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  // Samples are only dropped while another thread drains the ring.
+  std::string stats = sampling.GetStats({});
+  int64_t total = StatsValue(stats, "\"dropped\": ");
+  for (int t = 0; t < 4; ++t) {
+    std::string key = "\"index\": " + std::to_string(t) + ", \"count\": ";
+    if (stats.find(key) != std::string::npos) total += StatsValue(stats, key);
+  }
+  EXPECT_EQ(total, 400) << stats;
+}
+
+}  // namespace profiling
 }  // namespace runtime
 }  // namespace tvm
 
@@ -0,0 +1,178 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/registry.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../src/runtime/rpc/rpc_endpoint.h"
+#include "../../src/runtime/rpc/rpc_session.h"
+
+namespace tvm {
+namespace runtime {
+
+class FdChannel final : public RPCChannel {
+ public:
+  explicit FdChannel(int fd) : fd_(fd) {}
+  ~FdChannel() { close(fd_); }
+  size_t Send(const void* data, size_t size) final {
+    ssize_t n = send(fd_, data, size, 0);
+    ICHECK_GE(n, 0);
+    return n;
+  }
+  size_t Recv(void* data, size_t size) final {
+    ssize_t n = recv(fd_, data, size, 0);
+    ICHECK_GE(n, 0);
+    return n;
+  }
+
+ private:
+  int fd_;
+};
+
+/*! \brief A client session connected to a server loop in another thread. */
+class LoopbackSession {
+ public:
+  LoopbackSession() {
+    int fds[2];
+    ICHECK_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    server_ = std::thread([fd = fds[1]]() { (*Registry::Get("rpc.ServerLoop"))(fd); });
+    auto endpoint =
+        RPCEndpoint::Create(std::unique_ptr<RPCChannel>(new FdChannel(fds[0])), "client", "");
+    endpoint->InitRemoteSession(TVMArgs(nullptr, nullptr, 0));
+    sess_ = CreateClientSession(endpoint);
+    mod_ = CreateRPCSessionModule(sess_);
+  }
+  ~LoopbackSession() {
+    mod_ = Module();
+    sess_.reset();
+    server_.join();
+  }
+  RPCSession* operator->() const { return sess_.get(); }
+  const Module& module() const { return mod_; }
+
+ private:
+  std::thread server_;
+  std::shared_ptr<RPCSession> sess_;
+  Module mod_;
+};
+
+TEST(RPC, ChunkedCopy) {
+  LoopbackSession sess;
+  const Device cpu{kDLCPU, 0};
+  const DLDataType u8{kDLUInt, 8, 1};
+  DeviceAPI* api = sess->GetDeviceAPI(cpu);
+  int64_t nbytes = 100003;
+  std::vector<uint8_t> src(nbytes), dst(nbytes);
+  for (int64_t i = 0; i < nbytes; ++i) src[i] = static_cast<uint8_t>(i * 7 + 3);
+
+  void* remote = api->AllocDataSpace(cpu, nbytes, 64, u8);
+  DLTensor tensor{remote, cpu, 1, u8, &nbytes, nullptr, 0};
+  const PackedFunc* set_chunking = Registry::Get("rpc.SetCopyChunking");
+  // Chunks that do not divide the size, with and without requests in flight.
+  for (int64_t chunk_bytes : {int64_t(1) << 20, int64_t(4096), int64_t(999)}) {
+    for (int window : {1, 3, 16}) {
+      (*set_chunking)(sess.module(), chunk_bytes, window);
+      std::fill(dst.begin(), dst.end(), 0);
+      sess->CopyToRemote(src.data(), &tensor, nbytes);
+      sess->CopyFromRemote(&tensor, dst.data(), nbytes);
+      EXPECT_EQ(src, dst) << "chunk_bytes=" << chunk_bytes << " window=" << window;
+      EXPECT_EQ(tensor.byte_offset, 0U);
+    }
+  }
+
+  // Copies start at the byte offset of the remote tensor.
+  DLTensor tail = tensor;
+  tail.byte_offset = nbytes - 1000;
+  std::vector<uint8_t> zeros(1000, 0);
+  sess->CopyToRemote(zeros.data(), &tail, zeros.size());
+  sess->CopyFromRemote(&tensor, dst.data(), nbytes);
+  EXPECT_TRUE(std::equal(src.begin(), src.end() - 1000, dst.begin()));
+  EXPECT_TRUE(std::all_of(dst.end() - 1000, dst.end(), [](uint8_t x) { return x == 0; }));
+  api->FreeDataSpace(cpu, remote);
+}
+
+TVM_REGISTER_GLOBAL("testing.rpc_checked_add_one").set_body_typed([](int64_t x) {
+  ICHECK_GE(x, 0) << "negative input " << x;
+  return x + 1;
+});
+
+TEST(RPC, StartCall) {
+  LoopbackSession sess;
+  Module mod = sess.module();
+  PackedFunc add_one = mod.GetFunction("testing.rpc_checked_add_one");
+  const PackedFunc* start_call = Registry::Get("rpc.StartCall");
+  std::vector<PackedFunc> futures;
+  for (int64_t i = 0; i < 8; ++i) {
+    futures.push_back((*start_call)(add_one, i == 3 ? -i : i));
+  }
+  // Synchronous calls and copies wait for the calls started before them.
+  EXPECT_EQ(add_one(100).operator int64_t(), 101);
+  // Waiting out of order, a failed call does not affect the others.
+  for (int64_t i = 7; i >= 0; --i) {
+    if (i == 3) {
+      EXPECT_THROW(futures[i](), Error);
+    } else {
+      EXPECT_EQ(futures[i]().operator int64_t(), i + 1);
+      EXPECT_EQ(futures[i]().operator int64_t(), i + 1);
+    }
+  }
+  PackedFunc future = (*start_call)(add_one, 41);
+  EXPECT_EQ(future().operator int64_t(), 42);
+
+  // Only remote functions can be started.
+  PackedFunc local([](TVMArgs args, TVMRetValue* rv) {});
+  EXPECT_THROW((*start_call)(local), Error);
+}
+
+TEST(RPC, ShmNDArray) {
+  const DLDataType f32{kDLFloat, 32, 1};
+  NDArray arr = (*Registry::Get("rpc.ShmNDArrayEmpty"))(ShapeTuple({3, 5}), f32);
+  EXPECT_EQ(reinterpret_cast<size_t>(arr->data) % kAllocAlignment, 0U);
+  std::string name = (*Registry::Get("rpc.ShmNDArrayName"))(arr);
+
+  // A second mapping of the same segment, as the server process would get.
+  NDArray view = (*Registry::Get("rpc.ShmNDArrayOpen"))(name);
+  ASSERT_EQ(view->ndim, 2);
+  EXPECT_EQ(view->shape[0], 3);
+  EXPECT_EQ(view->shape[1], 5);
+  EXPECT_EQ(view->dtype.bits, 32);
+  EXPECT_NE(view->data, arr->data);
+  static_cast<float*>(arr->data)[14] = 2.5f;
+  EXPECT_EQ(static_cast<float*>(view->data)[14], 2.5f);
+  static_cast<float*>(view->data)[0] = -1.0f;
+  EXPECT_EQ(static_cast<float*>(arr->data)[0], -1.0f);
+
+  NDArray plain = NDArray::Empty({3, 5}, f32, {kDLCPU, 0});
+  EXPECT_THROW((*Registry::Get("rpc.ShmNDArrayName"))(plain), Error);
+  // The name goes away with the array, existing mappings stay valid.
+  arr = NDArray();
+  EXPECT_THROW((*Registry::Get("rpc.ShmNDArrayOpen"))(name), Error);
+  EXPECT_EQ(static_cast<float*>(view->data)[14], 2.5f);
+}
+
+}  // namespace runtime
+}  // namespace tvm
@@ -19,9 +19,12 @@
 
 #include <gtest/gtest.h>
 #include <tvm/runtime/c_backend_api.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/runtime/threading_backend.h>
 
 #include <atomic>
 #include <memory>
+#include <set>
 #include <thread>
 
 constexpr size_t N = 128;
@@ -64,6 +67,121 @@ TEST(ThreadingBackend, TVMBackendParallelLaunchMultipleThreads) {
   }
 }
 
+TEST(ThreadingBackend, PartitionCpus) {
+  using tvm::runtime::threading::NumaNodeCpus;
+  using tvm::runtime::threading::PartitionCpus;
+  size_t num_cpus = 0;
+  for (const auto& node : NumaNodeCpus()) {
+    num_cpus += node.size();
+  }
+  ASSERT_GE(num_cpus, 1);
+  int num_sessions = num_cpus >= 2 ? 2 : 1;
+  int cores_per_session = static_cast<int>(num_cpus) / num_sessions;
+  auto sessions = PartitionCpus(num_sessions, cores_per_session);
+  ASSERT_EQ(sessions.size(), static_cast<size_t>(num_sessions));
+  std::set<unsigned int> seen;
+  for (const auto& cpus : sessions) {
+    EXPECT_EQ(cpus.size(), static_cast<size_t>(cores_per_session));
+    for (unsigned int cpu : cpus) {
+      EXPECT_TRUE(seen.insert(cpu).second) << "cpu " << cpu << " given to two sessions";
+    }
+  }
+  EXPECT_ANY_THROW(PartitionCpus(static_cast<int>(num_cpus) + 1, 1));
+}
+
+TEST(ThreadingBackend, TVMBackendParallelLaunchPerSessionCpus) {
+  using tvm::runtime::threading::ThreadGroup;
+  auto sessions = tvm::runtime::threading::PartitionCpus(1, 1);
+  std::thread t([&]() {
+    tvm::runtime::threading::Configure(ThreadGroup::kSpecifyOneCorePerThread, 0, sessions[0]);
+    std::atomic<size_t> acc(0);
+    TVMBackendParallelLaunch(atomic_add_task_id, &acc, 0);
+    EXPECT_EQ(acc.load(std::memory_order_relaxed), N * (N - 1) / 2);
+  });
+  t.join();
+}
+
+// Restores the thread pool kind when it goes out of scope.
+class ScopedThreadPoolKind {
+ public:
+  explicit ScopedThreadPoolKind(const std::string& kind) {
+    (*tvm::runtime::Registry::Get("runtime.config_threadpool_kind"))(kind);
+  }
+  ~ScopedThreadPoolKind() {
+    (*tvm::runtime::Registry::Get("runtime.config_threadpool_kind"))("default");
+  }
+};
+
+TEST(ThreadingBackend, WorkStealingParallelLaunch) {
+  ScopedThreadPoolKind scope("work_stealing");
+  for (int num_task : {0, 1, 3, 64}) {
+    std::atomic<size_t> acc(0);
+    EXPECT_EQ(TVMBackendParallelLaunch(atomic_add_task_id, &acc, num_task), 0);
+    EXPECT_EQ(acc.load(std::memory_order_relaxed), N * (N - 1) / 2);
+  }
+}
+
+TEST(ThreadingBackend, WorkStealingNestedLaunch) {
+  ScopedThreadPoolKind scope("work_stealing");
+  static FTVMParallelLambda nested_task = [](int task_id, TVMParallelGroupEnv* penv,
+                                             void* cdata) -> int {
+    auto* data = reinterpret_cast<std::atomic<size_t>*>(cdata);
+    std::atomic<size_t> acc(0);
+    int ret = TVMBackendParallelLaunch(atomic_add_task_id, &acc, 0);
+    EXPECT_EQ(acc.load(std::memory_order_relaxed), N * (N - 1) / 2);
+    data->fetch_add(1, std::memory_order_relaxed);
+    return ret;
+  };
+  std::atomic<size_t> num_finished(0);
+  EXPECT_EQ(TVMBackendParallelLaunch(nested_task, &num_finished, 8), 0);
+  // A single-core runtime runs every launch as one task.
+  size_t expected = tvm::runtime::threading::MaxConcurrency() == 1 ? 1 : 8;
+  EXPECT_EQ(num_finished.load(std::memory_order_relaxed), expected);
+}
+
+TEST(ThreadingBackend, WorkStealingError) {
+  ScopedThreadPoolKind scope("work_stealing");
+  static FTVMParallelLambda failing_task = [](int task_id, TVMParallelGroupEnv* penv,
+                                              void* cdata) -> int {
+    if (task_id != penv->num_task - 1) return 0;
+    TVMAPISetLastError("task failed");
+    return -1;
+  };
+  EXPECT_EQ(TVMBackendParallelLaunch(failing_task, nullptr, 8), -1);
+  EXPECT_NE(std::string(TVMGetLastError()).find("task failed"), std::string::npos);
+}
+
+TEST(ThreadingBackend, WorkStealingBarrier) {
+  if (tvm::runtime::threading::MaxConcurrency() == 1) {
+    GTEST_SKIP() << "single-core launches do not go through the thread pool";
+  }
+  ScopedThreadPoolKind scope("work_stealing");
+  static FTVMParallelLambda barrier_task = [](int task_id, TVMParallelGroupEnv* penv,
+                                              void* cdata) -> int {
+    TVMBackendParallelBarrier(task_id, penv);
+    return 0;
+  };
+  EXPECT_EQ(TVMBackendParallelLaunch(barrier_task, nullptr, 8), -1);
+  EXPECT_NE(std::string(TVMGetLastError()).find("TVMBackendParallelBarrier"), std::string::npos);
+}
+
+TEST(ThreadingBackend, WorkStealingMultipleThreads) {
+  ScopedThreadPoolKind scope("work_stealing");
+  std::vector<std::unique_ptr<std::thread>> ts;
+  for (size_t i = 0; i < 4; ++i) {
+    ts.emplace_back(new std::thread([&]() {
+      for (size_t j = 0; j < 16; ++j) {
+        std::atomic<size_t> acc(0);
+        TVMBackendParallelLaunch(atomic_add_task_id, &acc, 0);
+        EXPECT_EQ(acc.load(std::memory_order_relaxed), N * (N - 1) / 2);
+      }
+    }));
+  }
+  for (auto& t : ts) {
+    t->join();
+  }
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   testing::FLAGS_gtest_death_test_style = "threadsafe";
@@ -0,0 +1,137 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "../../src/runtime/vm/best_fit_allocator.h"
+
+namespace tvm {
+namespace runtime {
+namespace vm {
+
+static const DLDataType kFloat32{kDLFloat, 32, 1};
+static const Device kCPU{kDLCPU, 0};
+
+TEST(BestFitAllocator, SizeClass) {
+  EXPECT_EQ(BestFitAllocator::SizeClass(1), 256);
+  EXPECT_EQ(BestFitAllocator::SizeClass(256), 256);
+  EXPECT_EQ(BestFitAllocator::SizeClass(257), 512);
+  EXPECT_EQ(BestFitAllocator::SizeClass(600000), 655360);
+  for (size_t n = 1; n < (1 << 22); n = n * 3 + 1) {
+    size_t size = BestFitAllocator::SizeClass(n);
+    EXPECT_GE(size, n);
+    EXPECT_EQ(size % BestFitAllocator::kBlockAlignment, 0);
+    if (n > 2048) EXPECT_LE(size, n + n / 8);
+  }
+}
+
+TEST(BestFitAllocator, SplitAndCoalesce) {
+  BestFitAllocator alloc(kCPU, std::numeric_limits<size_t>::max(), 0);
+  Buffer big = alloc.Alloc(1 << 20, kAllocAlignment, kFloat32);
+  alloc.Free(big);
+  // A slightly smaller request reuses the freed block instead of a new chunk.
+  Buffer a = alloc.Alloc(600000, kAllocAlignment, kFloat32);
+  Buffer b = alloc.Alloc(30000, kAllocAlignment, kFloat32);
+  EXPECT_EQ(a.data, big.data);
+  EXPECT_EQ(alloc.GetStats().num_chunks, 1);
+  EXPECT_EQ(static_cast<char*>(b.data), static_cast<char*>(a.data) + a.size);
+  alloc.Free(a);
+  alloc.Free(b);
+  BestFitAllocator::Stats stats = alloc.GetStats();
+  EXPECT_EQ(stats.num_free_blocks, 1);
+  EXPECT_EQ(stats.largest_free_block, 1 << 20);
+  EXPECT_EQ(stats.fragmentation, 0);
+  EXPECT_EQ(stats.allocated_bytes, 0);
+}
+
+TEST(BestFitAllocator, Trim) {
+  BestFitAllocator alloc(kCPU, 1 << 20, 0);
+  std::vector<Buffer> bufs;
+  for (int i = 0; i < 4; ++i) {
+    bufs.push_back(alloc.Alloc(1 << 20, kAllocAlignment, kFloat32));
+  }
+  EXPECT_EQ(alloc.UsedMemory(), 4 << 20);
+  for (const Buffer& buf : bufs) {
+    alloc.Free(buf);
+  }
+  // Only the high-water mark of free memory is kept.
+  EXPECT_EQ(alloc.UsedMemory(), 1 << 20);
+  alloc.Trim(0);
+  EXPECT_EQ(alloc.UsedMemory(), 0);
+  EXPECT_EQ(alloc.GetStats().num_chunks, 0);
+}
+
+TEST(BestFitAllocator, OutOfMemory) {
+  BestFitAllocator alloc(kCPU, std::numeric_limits<size_t>::max(), 0);
+  Buffer a = alloc.Alloc(1 << 20, kAllocAlignment, kFloat32);
+  alloc.Free(a);
+  EXPECT_ANY_THROW(alloc.Alloc(size_t(1) << 60, kAllocAlignment, kFloat32));
+  // The failed allocation released the free chunk before retrying.
+  EXPECT_EQ(alloc.GetStats().num_chunks, 0);
+  Buffer b = alloc.Alloc(1 << 20, kAllocAlignment, kFloat32);
+  EXPECT_EQ(alloc.UsedMemory(), 1 << 20);
+  alloc.Free(b);
+}
+
+TEST(BestFitAllocator, ThreadCache) {
+  BestFitAllocator alloc(kCPU);
+  Buffer a = alloc.Alloc(1000, kAllocAlignment, kFloat32);
+  alloc.Free(a);
+  EXPECT_EQ(alloc.GetStats().thread_cached_bytes, 1024);
+  Buffer b = alloc.Alloc(900, kAllocAlignment, kFloat32);
+  EXPECT_EQ(a.data, b.data);
+  EXPECT_EQ(alloc.GetStats().thread_cached_bytes, 0);
+  // Blocks cached by an exiting thread go back to the shared pool.
+  std::thread t([&]() { alloc.Free(b); });
+  t.join();
+  BestFitAllocator::Stats stats = alloc.GetStats();
+  EXPECT_EQ(stats.thread_cached_bytes, 0);
+  EXPECT_EQ(stats.free_bytes, 1024);
+}
+
+TEST(BestFitAllocator, MultipleThreads) {
+  BestFitAllocator alloc(kCPU);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&alloc, t]() {
+      std::vector<Buffer> bufs;
+      for (int i = 0; i < 200; ++i) {
+        bufs.push_back(alloc.Alloc((i * 7919 + t * 104729) % (1 << 19) + 1, 64, kFloat32));
+        if (i % 3 == 0) {
+          alloc.Free(bufs.front());
+          bufs.erase(bufs.begin());
+        }
+      }
+      for (const Buffer& buf : bufs) {
+        alloc.Free(buf);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(alloc.GetStats().allocated_bytes, 0);
+}
+
+}  // namespace vm
+}  // namespace runtime
+}  // namespace tvm
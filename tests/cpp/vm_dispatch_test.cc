@@ -0,0 +1,177 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/profiling.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/runtime/vm/vm.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tvm {
+namespace runtime {
+namespace vm {
+
+static const DLDataType kInt64{kDLInt, 64, 1};
+static const Device kCPU{kDLCPU, 0};
+
+/*! \brief A kernel library with a single kernel writing its input minus one to its output. */
+class DecrementModule : public ModuleNode {
+ public:
+  const char* type_key() const final { return "test.Decrement"; }
+  PackedFunc GetFunction(const std::string& name, const ObjectPtr<Object>& sptr_to_self) final {
+    return PackedFunc([](TVMArgs args, TVMRetValue* rv) {
+      DLTensor* in = args[0];
+      DLTensor* out = args[1];
+      static_cast<int64_t*>(out->data)[0] = static_cast<int64_t*>(in->data)[0] - 1;
+    });
+  }
+};
+
+/*! \brief The VM only references its executable, keep both alive. */
+struct TestVM {
+  Module exec;
+  Module vm;
+};
+
+TestVM MakeVM(const std::vector<Instruction>& code, Index register_file_size) {
+  auto exec = make_object<Executable>();
+  exec->functions.push_back(VMFunction("main", {"i"}, code, register_file_size, {kDLCPU}));
+  exec->global_map["main"] = 0;
+  exec->primitive_map["decrement"] = 0;
+  exec->Import(Module(make_object<DecrementModule>()));
+  TestVM test_vm;
+  test_vm.exec = Module(exec);
+  test_vm.vm = (*Registry::Get("runtime._VirtualMachine"))(test_vm.exec);
+  test_vm.vm.GetFunction("init")(static_cast<int>(kDLCPU), 0, static_cast<int>(kPooled));
+  return test_vm;
+}
+
+int64_t RunCountDown(const TestVM& test_vm, int64_t n) {
+  Module vm = test_vm.vm;
+  NDArray i = NDArray::Empty({1}, kInt64, kCPU);
+  static_cast<int64_t*>(i->data)[0] = n;
+  vm.GetFunction("set_input")("main", i);
+  vm.GetFunction("invoke")("main");
+  NDArray out = vm.GetFunction("get_output")(0);
+  return static_cast<int64_t*>(out->data)[0];
+}
+
+/*! \brief main(i): while i != 0: i = i - 1 in place. Four instructions per iteration. */
+std::vector<Instruction> CountDownLoop() {
+  return {Instruction::LoadConsti(0, 1),
+          Instruction::If(0, 1, 1, 2),
+          Instruction::Ret(0),
+          Instruction::InvokePacked(0, 2, 1, {0, 0}),
+          Instruction::Move(0, 2),
+          Instruction::Goto(-4)};
+}
+
+TEST(VMDispatch, Loop) {
+  TestVM vm = MakeVM(CountDownLoop(), 3);
+  for (int64_t n : {0, 1, 7, 1000}) {
+    EXPECT_EQ(RunCountDown(vm, n), 0);
+  }
+}
+
+TEST(VMDispatch, Recursion) {
+  // main(i): if i == 0 return i else return main(i - 1), with a fresh output tensor per call.
+  std::vector<Instruction> code = {Instruction::LoadConsti(0, 1),
+                                   Instruction::If(0, 1, 1, 2),
+                                   Instruction::Ret(0),
+                                   Instruction::LoadConsti(8, 2),
+                                   Instruction::AllocStorage(2, 64, kInt64, kDLCPU, 3),
+                                   Instruction::AllocTensor(3, 1, {1}, kInt64, 4),
+                                   Instruction::InvokePacked(0, 2, 1, {0, 4}),
+                                   Instruction::Invoke(0, {4}, 5),
+                                   Instruction::Ret(5)};
+  TestVM vm = MakeVM(code, 6);
+  // Run twice so that the second run reuses the register files of the first one.
+  for (int rep = 0; rep < 2; ++rep) {
+    for (int64_t n : {0, 1, 100}) {
+      EXPECT_EQ(RunCountDown(vm, n), 0);
+    }
+  }
+}
+
+TEST(VMLoadedExecutable, ConcurrentVMs) {
+  // main(i): count down recursively as in the Recursion test, then return constant 0.
+  std::vector<Instruction> code = {Instruction::LoadConsti(0, 1),
+                                   Instruction::If(0, 1, 1, 3),
+                                   Instruction::LoadConst(0, 6),
+                                   Instruction::Ret(6),
+                                   Instruction::LoadConsti(8, 2),
+                                   Instruction::AllocStorage(2, 64, kInt64, kDLCPU, 3),
+                                   Instruction::AllocTensor(3, 1, {1}, kInt64, 4),
+                                   Instruction::InvokePacked(0, 2, 1, {0, 4}),
+                                   Instruction::Invoke(0, {4}, 5),
+                                   Instruction::Ret(5)};
+  TestVM test_vm = MakeVM(code, 7);
+  auto* exec = static_cast<Executable*>(const_cast<ModuleNode*>(test_vm.exec.operator->()));
+  NDArray constant = NDArray::Empty({1}, kInt64, kCPU);
+  static_cast<int64_t*>(constant->data)[0] = 42;
+  exec->constants.push_back(constant);
+  exec->const_device_type.push_back(kDLCPU);
+
+  Module loaded = test_vm.exec.GetFunction("vm_load_shared")(static_cast<int>(kDLCPU), 0,
+                                                             static_cast<int>(kPooled));
+  const int num_threads = 8;
+  std::vector<NDArray> outputs(num_threads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      Module vm = loaded.GetFunction("create_vm")();
+      NDArray i = NDArray::Empty({1}, kInt64, kCPU);
+      for (int rep = 0; rep < 20; ++rep) {
+        static_cast<int64_t*>(i->data)[0] = 50 + t;
+        vm.GetFunction("set_input")("main", i);
+        vm.GetFunction("invoke")("main");
+      }
+      outputs[t] = vm.GetFunction("get_output")(0);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (const NDArray& output : outputs) {
+    EXPECT_EQ(static_cast<int64_t*>(output->data)[0], 42);
+    // Every VM returns the single copy of the constant held by the loaded executable.
+    EXPECT_EQ(output->data, outputs[0]->data);
+  }
+  // The devices of a shared VM are fixed.
+  Module vm = loaded.GetFunction("create_vm")();
+  EXPECT_ANY_THROW(vm.GetFunction("init")(static_cast<int>(kDLCPU), 0, static_cast<int>(kNaive)));
+}
+
+// Disabled by default, run with --gtest_also_run_disabled_tests to measure the dispatch loop.
+TEST(VMDispatch, DISABLED_Benchmark) {
+  // Reports the average cost of an instruction including one trivial kernel call per iteration.
+  TestVM vm = MakeVM(CountDownLoop(), 3);
+  const int64_t iterations = 200000;
+  RunCountDown(vm, iterations);
+  Timer timer = Timer::Start(kCPU);
+  EXPECT_EQ(RunCountDown(vm, iterations), 0);
+  timer->Stop();
+  double ns = static_cast<double>(timer->SyncAndGetElapsedNanos());
+  LOG(INFO) << "VM dispatch: " << ns / (iterations * 4) << " ns per instruction";
+}
+
+}  // namespace vm
+}  // namespace runtime
+}  // namespace tvm
@@ -14,6 +14,8 @@
 # KIND, either express or implied.  See the License for the
 # specific language governing permissions and limitations
 # under the License.
+import os
+
 import numpy as np
 import tvm
 from tvm import te
@@ -21,6 +23,7 @@ import tvm.testing
 from tvm import relay
 from tvm import autotvm
 from tvm import topi
+from tvm.contrib import graph_executor
 from tvm.relay.testing import run_infer_type
 from tvm.relay.testing.temp_op_attr import TempOpAttr
 import tvm.testing
@@ -194,6 +197,60 @@ def test_compile_engine():
     engine.dump()
 
 
+def test_compile_engine_persistent_cache():
+    engine = relay.backend.compile_engine.get()
+    x = relay.var("x", shape=(10,))
+    mod = tvm.IRModule.from_expr(relay.Function([x], relay.add(relay.multiply(x, x), x)))
+    mod = relay.transform.InferType()(mod)
+    tmpdir = tvm.contrib.utils.tempdir()
+    config = {"relay.backend.compile_cache_dir": tmpdir.relpath("cache")}
+
+    # The first lowering stores the function, the next ones load it without a schedule.
+    with tvm.transform.PassContext(config=config):
+        engine.clear()
+        z1 = engine.lower(mod["main"], "llvm")
+        engine.clear()
+        z2 = engine.lower(mod["main"], "llvm")
+    assert z1.schedule is not None and z2.schedule is None
+    assert len(os.listdir(tmpdir.relpath("cache"))) == 1
+
+    data = np.arange(10).astype("float32")
+    for _ in range(2):
+        engine.clear()
+        with tvm.transform.PassContext(opt_level=3, config=config):
+            lib = relay.build(mod, target="llvm")
+        m = graph_executor.GraphModule(lib["default"](tvm.cpu()))
+        m.set_input("x", data)
+        m.run()
+        tvm.testing.assert_allclose(m.get_output(0).numpy(), data * data + data)
+    # Only the first build lowered the fused function.
+    assert len(os.listdir(tmpdir.relpath("cache"))) == 2
+
+
+def test_compile_engine_persistent_cache_bypass():
+    engine = relay.backend.compile_engine.get()
+    x = relay.var("x", shape=(10,))
+    mod = tvm.IRModule.from_expr(relay.Function([x], relay.add(relay.multiply(x, x), x)))
+    mod = relay.transform.InferType()(mod)
+    tmpdir = tvm.contrib.utils.tempdir()
+    config = {"relay.backend.compile_cache_dir": tmpdir.relpath("cache")}
+
+    # Lower passes cannot be part of a key.
+    lower_passes = [(1, tvm.tir.transform.Simplify())]
+    with tvm.transform.PassContext(config={**config, "tir.add_lower_pass": lower_passes}):
+        engine.clear()
+        z = engine.lower(mod["main"], "llvm")
+    assert z.schedule is not None
+
+    # Neither can schedules picked from arbitrary tuning records.
+    with autotvm.apply_history_best([]):
+        with tvm.transform.PassContext(config=config):
+            engine.clear()
+            z = engine.lower(mod["main"], "llvm")
+    assert z.schedule is not None
+    assert not os.path.exists(tmpdir.relpath("cache"))
+
+
 def test_compile_placeholder_bypass():
     engine = relay.backend.compile_engine.get()
     x = relay.var("x", shape=(2, 3))
@@ -263,6 +320,8 @@ if __name__ == "__main__":
     test_get_valid_implementations()
     test_select_implementation()
     test_compile_engine()
+    test_compile_engine_persistent_cache()
+    test_compile_engine_persistent_cache_bypass()
     test_compile_placeholder_bypass()
     test_compile_injective_with_tuple()
     test_compile_tuple_dup()
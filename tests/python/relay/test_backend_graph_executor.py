@@ -18,6 +18,7 @@ import numpy as np
 
 import tvm
 import json
+import re
 from tvm import relay
 from tvm.contrib import graph_executor
 from tvm.relay.op import add
@@ -287,6 +288,38 @@ def test_graph_executor_nested_tuples():
     tvm.testing.assert_allclose(out[1][1][1].numpy(), data[3])
 
 
+def test_parallel_lower_deterministic():
+    x = relay.var("x", shape=(4, 8), dtype="float32")
+    y = x
+    data = np.random.rand(4, 8).astype("float32")
+    expected = data
+    # The shape grows at every step, so that no two kernels are the same and
+    # lowering cannot deduplicate them.
+    for i in range(16):
+        y = relay.add(relay.nn.pad(y, ((0, 0), (0, 1))), relay.const(float(i)))
+        expected = np.pad(expected, ((0, 0), (0, 1))) + i
+    func = relay.Function([x], y)
+
+    def build(num_threads):
+        # Without fusion every operator is a primitive function, enough to split the codegen.
+        config = {"relay.backend.lower_num_threads": num_threads}
+        with tvm.transform.PassContext(opt_level=0, config=config):
+            return relay.build(tvm.IRModule.from_expr(func), "llvm")
+
+    serial = build(1)
+    parallel = build(4)
+    assert serial.get_graph_json() == parallel.get_graph_json()
+    source = parallel.get_lib().get_source("ll")
+    assert serial.get_lib().get_source("ll") == source
+    kernels = set(re.findall(r"^define .*@(tvmgen_default_fused_\w+)\(", source, re.M))
+    # The codegen splits modules with at least 16 functions.
+    assert len([k for k in kernels if "_compute_" not in k]) >= 16
+
+    mod = graph_executor.GraphModule(parallel["default"](tvm.cpu()))
+    mod.set_input("x", data)
+    mod.run()
+    tvm.testing.assert_allclose(mod.get_output(0).numpy(), expected, rtol=1e-5)
+
 if __name__ == "__main__":
     test_reshape_nop()
     test_plan_memory()
@@ -296,3 +329,4 @@ if __name__ == "__main__":
     test_add_op_broadcast()
     test_gru_like()
     test_compile_nested_tuples()
+    test_parallel_lower_deterministic()
@@ -14,6 +14,7 @@
 # KIND, either express or implied.  See the License for the
 # specific language governing permissions and limitations
 # under the License
+import pytest
 import tvm
 from tvm import te
 import numpy as np
@@ -37,7 +38,7 @@ def check_memory_plan(func, check_fn):
     no_plan_result = ex.evaluate(mod["main"])(*args)
 
     # Compute with memory planning.
-    with tvm.transform.PassContext(opt_level=1, disabled_pass=["MemoryPlan"]):
+    with tvm.transform.PassContext(opt_level=1, disabled_pass=["VMPlanMemory"]):
         plan_result = ex.evaluate(mod["main"])(*args)
 
     # Compute Python result.
@@ -114,7 +115,67 @@ def test_no_fuse():
     check_memory_plan(func, check_no_fuse)
 
 
+def count_alloc_storage(func, disabled_pass=None, config=None):
+    mod = tvm.IRModule.from_expr(func)
+    with tvm.transform.PassContext(opt_level=3, disabled_pass=disabled_pass, config=config):
+        exe = relay.vm.compile(mod, "llvm")
+    return exe.bytecode.count("alloc_storage"), exe
+
+
+def test_vm_plan_memory_reuse():
+    x = relay.var("x", shape=(16, 16))
+    y = x
+    # A chain of non-fusable ops, each output is dead after the next op.
+    for _ in range(6):
+        y = relay.nn.softmax(y)
+        y = relay.nn.dense(y, x)
+    func = relay.Function([x], y)
+
+    num_unplanned, _ = count_alloc_storage(func, disabled_pass=["VMPlanMemory"])
+    num_planned, exe = count_alloc_storage(func)
+    assert num_planned < num_unplanned
+
+    data = np.random.rand(16, 16).astype("float32")
+    vm = tvm.runtime.vm.VirtualMachine(exe, tvm.cpu())
+    ref = data
+    for _ in range(6):
+        ref = np.exp(ref - ref.max(axis=1, keepdims=True))
+        ref = ref / ref.sum(axis=1, keepdims=True)
+        ref = np.matmul(ref, data.T)
+    np.testing.assert_allclose(vm.run(data).numpy(), ref, rtol=1e-5, atol=1e-5)
+
+
+def test_vm_plan_memory_dynamic_upper_bound():
+    x = relay.var("x", shape=(relay.Any(), 8))
+    y = relay.exp(x)
+    # Every output is dead two ops later, so alternate storages can share.
+    for _ in range(4):
+        y = relay.nn.softmax(y)
+    func = relay.Function([x], y)
+
+    num_unbounded, _ = count_alloc_storage(func)
+    config = {"relay.VMPlanMemory.any_dim_upper_bound": 32}
+    num_bounded, exe = count_alloc_storage(func, config=config)
+    assert num_bounded < num_unbounded
+
+    vm = tvm.runtime.vm.VirtualMachine(exe, tvm.cpu())
+    for rows in [1, 7, 32]:
+        data = np.random.rand(rows, 8).astype("float32")
+        ref = np.exp(data)
+        for _ in range(4):
+            ref = np.exp(ref - ref.max(axis=1, keepdims=True))
+            ref = ref / ref.sum(axis=1, keepdims=True)
+        np.testing.assert_allclose(vm.run(data).numpy(), ref, rtol=1e-5, atol=1e-5)
+
+    # An input above the hint must not overrun the storages next to it.
+    data = np.random.rand(33, 8).astype("float32")
+    with pytest.raises(tvm.TVMError, match="storage allocation failure"):
+        vm.run(data)
+
+
 if __name__ == "__main__":
     test_tyck_alloc_tensor()
     test_add()
     test_add_sub()
+    test_vm_plan_memory_reuse()
+    test_vm_plan_memory_dynamic_upper_bound()
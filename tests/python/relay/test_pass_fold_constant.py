@@ -298,6 +298,49 @@ def test_fold_dropout():
     assert tvm.ir.structural_equal(run_infer_type(before_mod["main"]), after_mod["main"])
 
 
+def test_fold_layout_ops_natively():
+    x_np = np.arange(2 * 8 * 3 * 3).astype("float32").reshape(2, 8, 3, 3)
+    x = relay.const(x_np)
+    exprs = [
+        (relay.transpose(x, axes=[0, 2, 3, 1]), np.transpose(x_np, (0, 2, 3, 1))),
+        (relay.transpose(x), np.transpose(x_np)),
+        (
+            relay.layout_transform(x, "NCHW", "NCHW4c"),
+            x_np.reshape(2, 2, 4, 3, 3).transpose(0, 1, 3, 4, 2),
+        ),
+        (relay.cast(x, "int32"), x_np.astype("int32")),
+        (relay.reshape(x, newshape=(4, -1)), x_np.reshape(4, -1)),
+        (relay.expand_dims(relay.squeeze(relay.reshape(x, (1, -1))), 0), x_np.reshape(1, -1)),
+    ]
+    for expr, expected in exprs:
+        folded = run_opt_pass(expr, transform.FoldConstant())
+        assert isinstance(folded, relay.Constant)
+        np.testing.assert_equal(folded.data.numpy(), expected)
+
+
+def test_fold_batched():
+    def before():
+        c_data = np.array([1, 2, 3]).astype("float32")
+        t = relay.TensorType([1, 2, 3], "float32")
+        c = relay.const(c_data)
+        x = relay.var("x", t)
+        y = relay.add(c, c)
+        y = relay.multiply(y, relay.const(2, "float32"))
+        y = relay.add(x, y)
+        z = relay.exp(relay.add(c, relay.const(1, "float32")))
+        cond = relay.greater(relay.sum(c), relay.const(1, "float32"))
+        w = relay.If(cond, relay.add(y, z), relay.subtract(y, z))
+        return relay.Function([x], w)
+
+    mod = tvm.IRModule.from_expr(before())
+    mod = relay.transform.InferType()(mod)
+    expected = relay.transform.FoldConstant()(mod)
+    with tvm.transform.PassContext(config={"relay.FoldConstant.batch": True}):
+        batched = relay.transform.FoldConstant()(mod)
+    assert not isinstance(batched["main"].body, relay.If)
+    assert tvm.ir.structural_equal(batched["main"], expected["main"])
+
+
 if __name__ == "__main__":
     test_fold_const()
     test_fold_let()
@@ -307,3 +350,5 @@ if __name__ == "__main__":
     test_fold_batch_norm()
     test_fold_ndarray_size()
     test_fold_dropout()
+    test_fold_layout_ops_natively()
+    test_fold_batched()
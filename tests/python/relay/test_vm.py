@@ -915,5 +915,55 @@ def test_get_output_multiple():
     np.testing.assert_allclose(outputs[1].numpy(), inp)
 
 
+def test_loaded_executable_concurrent_vms():
+    import threading
+
+    target = tvm.target.Target("llvm")
+    x = relay.var("x", shape=(4, 8))
+    w = relay.const(np.random.uniform(size=(16, 8)).astype("float32"))
+    mod = IRModule.from_expr(relay.Function([x], relay.nn.relu(relay.nn.dense(x, w))))
+    vm_exec = vm.compile(mod, target=target)
+
+    loaded = runtime.vm.LoadedExecutable(vm_exec, tvm.cpu())
+    inputs = [np.random.uniform(size=(4, 8)).astype("float32") for _ in range(8)]
+    expected = [np.maximum(inp.dot(w.data.numpy().T), 0) for inp in inputs]
+    results = [None] * len(inputs)
+
+    def worker(i):
+        vm_inst = loaded.create_vm()
+        for _ in range(10):
+            results[i] = vm_inst.run(inputs[i]).numpy()
+
+    threads = [threading.Thread(target=worker, args=(i,)) for i in range(len(inputs))]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    for result, ref in zip(results, expected):
+        tvm.testing.assert_allclose(result, ref, rtol=1e-5)
+
+
+def test_vm_sampling_profiler():
+    target = tvm.target.Target("llvm")
+    x = relay.var("x", shape=(4, 8))
+    w = relay.const(np.random.uniform(size=(16, 8)).astype("float32"))
+    mod = IRModule.from_expr(relay.Function([x], relay.nn.relu(relay.nn.dense(x, w))))
+    vm_exec = vm.compile(mod, target=target)
+    vm_inst = runtime.vm.VirtualMachine(vm_exec, tvm.cpu())
+    x_data = np.random.uniform(size=(4, 8)).astype("float32")
+
+    vm_inst.set_sampling_interval(3)
+    for _ in range(9):
+        vm_inst.run(x_data)
+    stats = vm_inst.get_sampling_stats()
+    assert stats["sampled_runs"] == 3
+    assert len(stats["ops"]) == 1
+    assert "dense" in stats["ops"][0]["name"]
+    assert stats["ops"][0]["count"] == 3
+
+    vm_inst.reset_sampling_stats()
+    assert vm_inst.get_sampling_stats()["ops"] == []
+
+
 if __name__ == "__main__":
     pytest.main([__file__])
@@ -146,6 +146,27 @@ def test_save_load():
     tvm.testing.assert_allclose(res.numpy(), x_data + x_data)
 
 
+def test_load_exec_from_file():
+    x = relay.var("x", shape=(10, 10))
+    c = relay.const(np.random.rand(10, 10).astype("float32"))
+    f = relay.Function([x], x + c)
+    x_data = np.random.rand(10, 10).astype("float32")
+
+    exe = create_exec(f)
+    code, lib = exe.save()
+    tmp = utils.tempdir()
+    path_lib = tmp.relpath("lib.so")
+    path_code = tmp.relpath("code.ro")
+    lib.export_library(path_lib)
+    with open(path_code, "wb") as fo:
+        fo.write(code)
+
+    des_exec = _vm.Executable.load_exec_from_file(path_code, tvm.runtime.load_module(path_lib))
+    des_vm = _vm.VirtualMachine(des_exec, tvm.cpu())
+    res = des_vm.run(x_data)
+    tvm.testing.assert_allclose(res.numpy(), x_data + c.data.numpy())
+
+
 def test_const():
     c = relay.const(1.0, "float32")
     x = relay.var("x", shape=(10, 10), dtype="float32")
@@ -79,6 +79,31 @@ def test_xgb_model():
     model.load(tmpfile)
 
 
+def test_gbdt_model():
+    task, inputs, results = get_sample_records(50)
+
+    model = auto_scheduler.GBDTModel(num_warmup_sample=-1)
+    model.update(inputs[:40], results[:40])
+    # An incremental update only adds trees to the ensemble.
+    model.update(inputs[40:], results[40:])
+    preds = model.predict(task, [x.state for x in inputs])
+    assert len(preds) == len(inputs)
+
+    costs = [np.mean([x.value for x in res.costs]) for res in results]
+    throughputs = np.min(costs) / costs
+
+    # test regression quality
+    rmse = np.sqrt(np.mean([np.square(pred - label) for pred, label in zip(preds, throughputs)]))
+    assert rmse <= 0.3
+
+    # test loading a record file
+    tmpdir = tvm.contrib.utils.tempdir()
+    tmpfile = tmpdir.relpath("test1")
+    auto_scheduler.save_records(tmpfile, inputs, results)
+    model.update_from_file(tmpfile)
+
+
 if __name__ == "__main__":
     test_random_model()
     test_xgb_model()
+    test_gbdt_model()
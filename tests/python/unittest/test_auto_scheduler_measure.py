@@ -19,6 +19,7 @@
 import json
 
 import multiprocessing
+import os
 import numpy as np
 import tvm
 from tvm import topi
@@ -203,6 +204,56 @@ def test_recover_measure_input():
         assert str(correct_inp.state) == str(inp.state)
 
 
+def test_record_database():
+    tasks = [
+        auto_scheduler.SearchTask(func=matmul_auto_scheduler_test, args=(n, n, n), target="llvm")
+        for n in (64, 128)
+    ]
+    inputs, results = [], []
+    for i, cost in enumerate([0.3, 0.1, 0.2, 0.4]):
+        task = tasks[i % 2]
+        inputs.append(auto_scheduler.measure.MeasureInput(task, task.compute_dag.init_state))
+        results.append(auto_scheduler.measure.MeasureResult([cost], 0, "", 0.2, i))
+    # A failed measurement is never returned even though its cost is the lowest.
+    inputs.append(inputs[0])
+    results.append(auto_scheduler.measure.MeasureResult([0.01], 2, "error", 0.2, 4))
+
+    with tempfile.TemporaryDirectory() as tmpdir:
+        db_file = os.path.join(tmpdir, "records.db")
+        db = auto_scheduler.RecordDatabase(db_file)
+        db.append(inputs[:2], results[:2])
+        # A second writer appends to the same file, the first one sees its records.
+        auto_scheduler.RecordDatabase(db_file).append(inputs[2:], results[2:])
+        assert len(db) == 5
+        assert auto_scheduler.measure_record.is_record_database(db_file)
+
+        key, target = tasks[0].workload_key, tasks[0].target
+        best_inputs, best_results = db.query_top_k(key, target, k=3)
+        assert [r.timestamp for r in best_results] == [2, 0]
+        assert all(inp.task.workload_key == key for inp in best_inputs)
+        assert len(db.query_top_k("unknown", target, k=3)[0]) == 0
+
+        best = db.best_records()
+        assert sorted(res.timestamp for _, res in best) == [1, 2]
+        context = auto_scheduler.ApplyHistoryBest(db_file)
+        assert sum(len(entry) for entry in context.best_by_targetkey["cpu"].values()) == 2
+
+        # A deleted index is rebuilt from the data file.
+        os.remove(db_file + ".idx")
+        assert len(auto_scheduler.RecordDatabase(db_file)) == 5
+
+        # Round trip through the json log.
+        log_file = os.path.join(tmpdir, "records.json")
+        auto_scheduler.measure_record.convert_database_to_records(db_file, log_file)
+        assert not auto_scheduler.measure_record.is_record_database(log_file)
+        assert len(list(auto_scheduler.load_records(log_file))) == 5
+        db_file2 = os.path.join(tmpdir, "records2.db")
+        auto_scheduler.measure_record.convert_records_to_database(log_file, db_file2)
+        db2 = auto_scheduler.RecordDatabase(db_file2)
+        assert len(db2) == 5
+        assert [r.timestamp for r in db2.query_top_k(key, target, k=3)[1]] == [2, 0]
+
+
 def test_workload_dis_factor():
     calc = auto_scheduler.utils.calc_workload_dis_factor
     decode = auto_scheduler.utils.decode_workload_key
@@ -257,6 +308,45 @@ def test_measure_local_builder_runner():
         assert mress[0].error_no == 0
 
 
+@tvm.testing.requires_llvm
+def test_measure_native_local_builder():
+    task = auto_scheduler.SearchTask(
+        func=matmul_auto_scheduler_test, args=(128, 128, 128), target="llvm"
+    )
+    s = task.compute_dag.init_state
+    C = s.stage_ops[2]
+    s.split(C, s[C].iters[0], [4])
+    inputs = [
+        auto_scheduler.MeasureInput(task, task.compute_dag.init_state),
+        auto_scheduler.MeasureInput(task, s),
+        auto_scheduler.MeasureInput(task, task.compute_dag.init_state),
+    ]
+    builder = auto_scheduler.LocalBuilder(n_parallel=2, build_func="native")
+    bress = builder.build(inputs)
+    for bres in bress:
+        assert bres.error_no == 0
+        assert set(bres.stage_costs.keys()) == {"instantiate", "lower", "codegen", "export"}
+    # Each program gets its own binary, whether it was compiled or reused.
+    assert len({bres.filename for bres in bress}) == 3
+
+    mress = auto_scheduler.LocalRunner(timeout=60).run(inputs, bress)
+    for mres in mress:
+        assert mres.error_no == 0
+
+
+@tvm.testing.requires_cuda
+def test_measure_native_local_builder_device_fallback():
+    task = auto_scheduler.SearchTask(
+        func=matmul_auto_scheduler_test, args=(128, 128, 128), target="cuda"
+    )
+    inputs = [auto_scheduler.MeasureInput(task, task.compute_dag.init_state)]
+    builder = auto_scheduler.LocalBuilder(n_parallel=2, build_func="native")
+    # Device programs are built by the default builder, which reports no stage costs.
+    bress = builder.build(inputs)
+    assert len(bress) == 1
+    assert len(bress[0].stage_costs) == 0
+
+
 def test_dag_measure_local_builder_runner():
     if not tvm.testing.device_enabled("llvm"):
         return
@@ -420,6 +510,7 @@ if __name__ == "__main__":
     test_record_follow_split_follow_fused_split()
     test_record_pragma_storage_align_rfactor()
     test_recover_measure_input()
+    test_record_database()
     test_workload_dis_factor()
     test_measure_local_builder_runner()
     test_dag_measure_local_builder_runner()
@@ -0,0 +1,59 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+import numpy as np
+
+import tvm
+import tvm.testing
+from tvm import relay
+from tvm.contrib import batching_executor
+
+
+def build_variant(batch_size, weight):
+    x = relay.var("x", shape=(batch_size, 8))
+    w = relay.var("w", shape=(4, 8))
+    func = relay.Function([x, w], relay.nn.relu(relay.nn.dense(x, w)))
+    mod = tvm.IRModule.from_expr(func)
+    return relay.build(mod, target="llvm", params={"w": weight})
+
+
+@tvm.testing.requires_llvm
+def test_batching():
+    weight = np.random.uniform(-1, 1, size=(4, 8)).astype("float32")
+    factories = [build_variant(bs, weight) for bs in [1, 4, 8]]
+    exe = batching_executor.create(factories, tvm.cpu(0), ["x"], max_delay_ms=50)
+    assert exe.max_batch_size == 8
+
+    samples = [np.random.uniform(size=(1, 8)).astype("float32") for _ in range(11)]
+    ids = [exe.submit(x=s) for s in samples]
+    for request_id, sample in zip(ids, samples):
+        out = exe.get_result(request_id)[0].numpy()
+        assert out.shape == (1, 4)
+        tvm.testing.assert_allclose(out, np.maximum(sample.dot(weight.T), 0), rtol=1e-5)
+
+    # A lone request is run once the deadline has passed.
+    sample = np.random.uniform(size=(8,)).astype("float32")
+    out = exe.run(x=sample)[0].numpy()
+    tvm.testing.assert_allclose(out[0], np.maximum(weight.dot(sample), 0), rtol=1e-5)
+
+    stats = exe.get_stats()
+    assert stats["num_requests"] == 12
+    assert stats["num_batches"] < 12
+    assert sum(stats["batches_per_variant"].values()) == stats["num_batches"]
+
+
+if __name__ == "__main__":
+    test_batching()
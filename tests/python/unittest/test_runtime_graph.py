@@ -139,6 +139,91 @@ def test_load_unexpected_params():
     rt_mod.load_params(runtime.save_param_dict(new_params))
 
 
+@tvm.testing.requires_llvm
+def test_load_params_from_file():
+    x = relay.var("x", shape=(3, 5))
+    y = relay.var("y", shape=(3, 5))
+    mod = tvm.IRModule.from_expr(relay.Function([x, y], x * y))
+    lib = relay.build(mod, target="llvm")
+
+    x_data = np.random.uniform(size=(3, 5)).astype("float32")
+    y_data = np.random.uniform(size=(3, 5)).astype("float32")
+    temp = utils.tempdir()
+    for aligned in [False, True]:
+        path = temp.relpath("params_%d.bin" % aligned)
+        with open(path, "wb") as fo:
+            fo.write(runtime.save_param_dict({"y": y_data}, aligned=aligned))
+        loaded = runtime.load_param_dict_from_file(path)
+        np.testing.assert_equal(loaded["y"].numpy(), y_data)
+
+        gmod = graph_executor.GraphModule(lib["default"](tvm.cpu(0)))
+        gmod.load_params_from_file(path)
+        gmod.run(x=x_data)
+        np.testing.assert_allclose(gmod.get_output(0).numpy(), x_data * y_data)
+        np.testing.assert_equal(gmod.get_input("y").numpy(), y_data)
+
+
+@tvm.testing.requires_llvm
+def test_graph_concurrent_branches():
+    # Several independent towers joined at the end, like an inception block.
+    x = relay.var("x", shape=(1, 32))
+    branches = []
+    for i in range(4):
+        w = relay.const(np.random.uniform(size=(32, 32)).astype("float32"))
+        y = x
+        for _ in range(i + 1):
+            y = relay.nn.softmax(relay.nn.dense(y, w))
+        branches.append(y)
+    func = relay.Function([x], relay.concatenate(branches, axis=1))
+    lib = relay.build(tvm.IRModule.from_expr(func), target="llvm")
+
+    data = np.random.uniform(size=(1, 32)).astype("float32")
+    sequential = graph_executor.GraphModule(lib["default"](tvm.cpu(0)))
+    sequential.run(x=data)
+    expected = sequential.get_output(0).numpy()
+
+    concurrent = graph_executor.GraphModule(lib["default"](tvm.cpu(0)))
+    concurrent.set_concurrency(4)
+    for _ in range(10):
+        concurrent.run(x=data)
+        np.testing.assert_equal(concurrent.get_output(0).numpy(), expected)
+
+
+@tvm.testing.requires_llvm
+def test_graph_sampling_profiler():
+    x = relay.var("x", shape=(4, 8))
+    y = relay.nn.relu(relay.exp(x) + relay.const(1.0))
+    mod = tvm.IRModule.from_expr(relay.Function([x], y))
+    with tvm.transform.PassContext(opt_level=0):
+        lib = relay.build(mod, target="llvm")
+    gmod = graph_executor.GraphModule(lib["default"](tvm.cpu(0)))
+    x_data = np.random.uniform(size=(4, 8)).astype("float32")
+
+    gmod.run(x=x_data)
+    assert gmod.get_sampling_stats()["ops"] == []
+
+    gmod.set_sampling_interval(2)
+    for _ in range(10):
+        gmod.run(x=x_data)
+    stats = gmod.get_sampling_stats()
+    assert stats["interval"] == 2
+    assert stats["sampled_runs"] == 5
+    assert len(stats["ops"]) == 3
+    for op in stats["ops"]:
+        assert op["count"] == 5
+        assert op["min_us"] <= op["p50_us"] <= op["p99_us"]
+        assert sum(count for _, count in op["buckets"]) == 5
+    np.testing.assert_allclose(gmod.get_output(0).numpy(), np.exp(x_data) + 1.0, rtol=1e-5)
+
+    gmod.reset_sampling_stats()
+    gmod.set_sampling_interval(0)
+    gmod.run(x=x_data)
+    assert gmod.get_sampling_stats()["ops"] == []
+
+
 if __name__ == "__main__":
     test_graph_simple()
     test_load_unexpected_params()
+    test_load_params_from_file()
+    test_graph_concurrent_branches()
+    test_graph_sampling_profiler()
@@ -0,0 +1,99 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+import numpy as np
+
+import tvm
+import tvm.testing
+from tvm import relay
+from tvm.contrib import graph_executor, pipeline_executor
+
+
+def get_network():
+    x = relay.var("x", shape=(1, 16))
+    w0 = relay.var("w0", shape=(16, 16))
+    w1 = relay.var("w1", shape=(16, 16))
+    y = relay.nn.relu(relay.nn.dense(x, w0))
+    z = relay.nn.dense(y, w1)
+    # x is used again by the last stage and has to flow through the pipeline.
+    out = relay.add(relay.sigmoid(z), x)
+    out = relay.nn.softmax(out)
+    params = {
+        "w0": np.random.uniform(size=(16, 16)).astype("float32"),
+        "w1": np.random.uniform(size=(16, 16)).astype("float32"),
+    }
+    func = relay.Function([x, w0, w1], out)
+    return tvm.IRModule.from_expr(func), params
+
+
+def test_partition():
+    mod, params = get_network()
+    stages, input_names = pipeline_executor.partition(mod, num_stages=3, params=params)
+    assert len(stages) == 3
+    assert input_names[0] == ["x"]
+    # x is live across both cuts.
+    for sid in range(1, 3):
+        assert len(input_names[sid]) == 2
+        assert all(name.startswith("pipeline_in_") for name in input_names[sid])
+
+
+@tvm.testing.requires_llvm
+def test_pipeline():
+    mod, params = get_network()
+    dev = tvm.cpu(0)
+    lib = relay.build(mod, target="llvm", params=params)
+    reference = graph_executor.GraphModule(lib["default"](dev))
+
+    pipe = pipeline_executor.build(mod, "llvm", dev, num_stages=3, params=params, queue_depth=2)
+    assert pipe.num_stages == 3
+
+    inputs = [np.random.uniform(size=(1, 16)).astype("float32") for _ in range(8)]
+    for data in inputs:
+        pipe.run(x=data)
+    for data in inputs:
+        reference.run(x=data)
+        out = pipe.get_output()
+        tvm.testing.assert_allclose(out[0].numpy(), reference.get_output(0).numpy(), rtol=1e-5)
+
+    stats = pipe.get_stage_stats()
+    assert [s["num_runs"] for s in stats] == [len(inputs)] * 3
+    pipe.reset_stage_stats()
+    assert all(s["num_runs"] == 0 for s in pipe.get_stage_stats())
+
+
+@tvm.testing.requires_llvm
+def test_pipeline_reshape_output():
+    x = relay.var("x", shape=(1, 16))
+    # Both stages end with a reshape, which alone would be built as a nop.
+    y = relay.reshape(relay.nn.softmax(x), (4, 4))
+    out = relay.reshape(relay.nn.softmax(y), (1, 16))
+    mod = tvm.IRModule.from_expr(relay.Function([x], out))
+    pipe = pipeline_executor.build(mod, "llvm", tvm.cpu(0), split_points=[2])
+
+    def softmax(data):
+        data = np.exp(data - data.max(axis=-1, keepdims=True))
+        return data / data.sum(axis=-1, keepdims=True)
+
+    data = np.random.uniform(size=(1, 16)).astype("float32")
+    pipe.run(x=data)
+    ref = softmax(softmax(data).reshape(4, 4)).reshape(1, 16)
+    tvm.testing.assert_allclose(pipe.get_output()[0].numpy(), ref, rtol=1e-5)
+
+
+if __name__ == "__main__":
+    test_partition()
+    test_pipeline()
+    test_pipeline_reshape_output()
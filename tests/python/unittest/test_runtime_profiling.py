@@ -18,9 +18,10 @@ import numpy as np
 import pytest
 from io import StringIO
 import csv
+import json
 
 import tvm.testing
-from tvm.runtime import profiler_vm
+from tvm.runtime import profiler_vm, profiling
 from tvm import relay
 from tvm.relay.testing import mlp
 from tvm.contrib.debugger import debug_executor
@@ -61,3 +62,74 @@ def test_graph_executor(target, dev):
     assert "fused_nn_softmax" in str(report)
     assert "Total" in str(report)
     assert "Hash" in str(report)
+
+
+@tvm.testing.requires_llvm
+def test_chrome_trace():
+    mod, params = mlp.get_workload(1)
+    data = np.random.rand(1, 1, 28, 28).astype("float32")
+    exe = relay.build(mod, "llvm", params=params)
+    gr = debug_executor.create(exe.get_graph_json(), exe.lib, tvm.cpu())
+
+    report = gr.profile(data=data)
+    trace = json.loads(report.chrome_trace())
+    ops = [e for e in trace["traceEvents"] if e["ph"] == "X" and e["cat"] == "op"]
+    assert len(ops) == len(report.calls)
+    assert any("fused_nn_softmax" in e["name"] for e in ops)
+    for event in ops:
+        assert event["dur"] >= 0
+        assert event["args"]["Device"] == "cpu0"
+
+    arr = tvm.nd.array(data)
+    with profiling.Trace() as trace:
+        arr.copyto(tvm.cpu())
+    events = json.loads(trace.json)["traceEvents"]
+    assert [e["name"] for e in events if e["ph"] == "X"] == ["DeviceCopy"]
+    assert events[0]["args"]["bytes"] == str(data.nbytes)
+
+
+@tvm.testing.requires_llvm
+def test_memory_usage():
+    mod, params = mlp.get_workload(1)
+    data = np.random.rand(1, 1, 28, 28).astype("float32")
+    exe = relay.build(mod, "llvm", params=params)
+    gr = debug_executor.create(exe.get_graph_json(), exe.lib, tvm.cpu())
+
+    report = gr.profile(data=data)
+    for call in report.calls:
+        assert call["Workspace (B)"].bytes >= 0
+        assert call["Peak Memory (B)"].bytes >= call["Live Tensors (B)"].bytes
+    device = report.device_metrics["cpu0"]
+    # The graph executor allocates its storage before profiling starts.
+    assert device["Live Tensors (B)"].bytes >= data.nbytes
+    assert device["Peak Memory (B)"].bytes >= max(
+        call["Peak Memory (B)"].bytes for call in report.calls
+    )
+    assert "Peak Memory (B)" in str(report)
+
+
+@tvm.testing.requires_llvm
+def test_perf_event_collector():
+    mod, params = mlp.get_workload(1)
+    data = np.random.rand(1, 1, 28, 28).astype("float32")
+    events = ["task-clock", "page-faults"]
+
+    exe = relay.build(mod, "llvm", params=params)
+    gr = debug_executor.create(exe.get_graph_json(), exe.lib, tvm.cpu())
+    try:
+        report = gr.profile(data=data, collectors=[profiling.PerfEventMetricCollector(events)])
+    except tvm.TVMError as err:
+        if "Cannot open perf event" not in str(err):
+            raise
+        pytest.skip("perf events are not available")
+    for call in report.calls:
+        assert all(event in call for event in events)
+    assert "task-clock" in str(report)
+
+    if profiler_vm.enabled():
+        vm_exe = relay.vm.compile(mod, "llvm", params=params)
+        vm = profiler_vm.VirtualMachineProfiler(vm_exe, tvm.cpu())
+        report = vm.profile(
+            data, func_name="main", collectors=[profiling.PerfEventMetricCollector(events)]
+        )
+        assert all("page-faults" in call for call in report.calls)
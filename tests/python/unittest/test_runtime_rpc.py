@@ -138,6 +138,55 @@ def test_rpc_large_array():
     np.testing.assert_equal(b.numpy(), b_np)
 
 
+@tvm.testing.requires_rpc
+def test_rpc_chunked_copy():
+    x = np.random.randint(0, 255, size=(1000, 1001)).astype("uint8")
+    server = rpc.Server()
+    remote = rpc.connect("127.0.0.1", server.port)
+    for chunk_bytes, window in [(1 << 30, 1), (4096, 1), (9999, 4), (65536, 16)]:
+        remote.set_copy_chunking(chunk_bytes, window)
+        r_cpu = tvm.nd.array(x, remote.cpu(0))
+        np.testing.assert_equal(r_cpu.numpy(), x)
+
+
+@tvm.testing.requires_rpc
+def test_rpc_start_call():
+    def check(remote):
+        fecho = remote.get_function("testing.echo")
+        raise_err = remote.get_function("testing.test_raise_error_callback")("RuntimeError")
+        waits = [remote.start_call(fecho, i) for i in range(8)]
+        failed = remote.start_call(raise_err)
+        assert fecho("sync") == "sync"
+        assert [wait() for wait in reversed(waits)] == list(reversed(range(8)))
+        with pytest.raises(RuntimeError):
+            failed()
+        assert remote.start_call(fecho, "xyz")() == "xyz"
+
+    server = rpc.Server()
+    check(rpc.LocalSession())
+    check(rpc.connect("127.0.0.1", server.port))
+
+
+@tvm.testing.requires_rpc
+@pytest.mark.skipif(
+    tvm.get_global_func("rpc.CreateShmClient", allow_missing=True) is None,
+    reason="shared memory RPC is only available on Linux",
+)
+def test_rpc_shm_session():
+    remote = rpc.ShmSession(capacity=1 << 16)
+    assert remote.get_function("testing.echo")("xyz") == "xyz"
+
+    # Copies larger than the rings.
+    x = np.random.randint(0, 255, size=(1000, 1001)).astype("uint8")
+    np.testing.assert_equal(tvm.nd.array(x, remote.cpu(0)).numpy(), x)
+
+    local, remote_arr = remote.shared_empty((4, 5), "float32")
+    local.copyfrom(np.arange(20, dtype="float32").reshape(4, 5))
+    np.testing.assert_equal(remote_arr.numpy(), local.numpy())
+    remote_arr.copyfrom(np.ones((4, 5), "float32"))
+    np.testing.assert_equal(local.numpy(), np.ones((4, 5), "float32"))
+
+
 @tvm.testing.requires_rpc
 def test_rpc_echo():
     def check(remote):
@@ -181,6 +181,59 @@ def test_buffer_load_store():
     assert not consistent_equal(sy, sz)
 
 
+def test_structural_hash_cache():
+    cache = tvm.ir.StructuralHashCache()
+
+    def consistent(x, y, map_free_vars=False):
+        equal = tvm.ir.structural_equal(x, y, map_free_vars)
+        assert equal == (cache(x, map_free_vars) == cache(y, map_free_vars))
+        return equal
+
+    x = te.var("x")
+    y = te.var("y")
+    assert consistent(x + 1, x + 1)
+    assert consistent(x + 1, y + 1, map_free_vars=True)
+    assert consistent(x - y, y - x, map_free_vars=True)
+    assert not consistent(x - y, x - x)
+    assert not consistent(x - y, x - x, map_free_vars=True)
+    # Free variables are hashed by position.
+    assert not tvm.ir.structural_equal(x + 1, y + 1)
+    assert cache(x + 1) == cache(y + 1)
+
+    n = te.size_var("n")
+    a = tvm.tir.decl_buffer((n,), name="a")
+    i = te.var("i")
+    j = te.var("j")
+    body = tvm.tir.BufferStore(a, tvm.tir.BufferLoad(a, [i]) + 1.0, [i])
+    loop_i = tvm.tir.For(i, 0, n, tvm.tir.ForKind.SERIAL, body)
+    body_j = tvm.tir.BufferStore(a, tvm.tir.BufferLoad(a, [j]) + 1.0, [j])
+    loop_j = tvm.tir.For(j, 0, n, tvm.tir.ForKind.SERIAL, body_j)
+    assert consistent(loop_i, loop_j)
+    assert consistent(
+        tvm.tir.PrimFunc([a.data], loop_i), tvm.tir.PrimFunc([a.data], loop_j), map_free_vars=True
+    )
+
+    # Modules are edited in place, their hash follows the edits.
+    mod = tvm.IRModule({"main": tvm.tir.PrimFunc([a.data], loop_i)})
+    before = cache(mod)
+    body_k = tvm.tir.BufferStore(a, tvm.tir.BufferLoad(a, [i]) + 2.0, [i])
+    func_k = tvm.tir.PrimFunc([a.data], tvm.tir.For(i, 0, n, tvm.tir.ForKind.SERIAL, body_k))
+    mod["main"] = func_k
+    assert cache(mod) != before
+    assert cache(mod) == cache(tvm.IRModule({"main": func_k}))
+
+    # Rewriting the loop only hashes the new nodes.
+    seq = tvm.tir.SeqStmt([loop_i] * 8)
+    cache(seq)
+    size = len(cache)
+    extent = tvm.tir.For(i, 0, n + 1, tvm.tir.ForKind.SERIAL, body)
+    assert cache(tvm.tir.SeqStmt([loop_i] * 7 + [extent])) != cache(seq)
+    assert len(cache) - size < 10
+
+    cache.clear()
+    assert len(cache) == 0
+
+
 if __name__ == "__main__":
     test_exprs()
     test_prim_func()
@@ -189,3 +242,4 @@ if __name__ == "__main__":
     test_env_func()
     test_stmt()
     test_buffer_load_store()
+    test_structural_hash_cache()